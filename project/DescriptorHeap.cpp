@@ -0,0 +1,47 @@
+#include "DescriptorHeap.h"
+#include <cassert>
+
+void DescriptorHeap::Initialize(const Microsoft::WRL::ComPtr<ID3D12Device>& deviceForHeap, const Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>& descriptorHeap) {
+	assert(deviceForHeap != nullptr);
+	assert(descriptorHeap != nullptr);
+	device = deviceForHeap;
+	heap = descriptorHeap;
+	const D3D12_DESCRIPTOR_HEAP_DESC heapDesc = heap->GetDesc();
+	type = heapDesc.Type;
+	allocator = std::make_unique<DescriptorAllocator>(heapDesc.NumDescriptors);
+	descriptorSize = device->GetDescriptorHandleIncrementSize(heapDesc.Type);
+	isShaderVisible = (heapDesc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) != 0;
+	cpuStart = heap->GetCPUDescriptorHandleForHeapStart();
+	if (isShaderVisible) {
+		gpuStart = heap->GetGPUDescriptorHandleForHeapStart();
+	}
+}
+
+DescriptorHandle DescriptorHeap::Allocate(uint32_t count) {
+	DescriptorHandle handle = allocator->Allocate(count);
+	assert(!handle.IsNull()); // ヒープが足りない
+	return handle;
+}
+
+void DescriptorHeap::CopyFrom(DescriptorHandle destination, const DescriptorHeap& source, DescriptorHandle sourceHandle) const {
+	assert(type == source.type);
+	assert(!source.isShaderVisible); // シェーダーから見えるヒープはコピー元にできない
+	const uint32_t count = source.allocator->GetCount(sourceHandle);
+	assert(count <= allocator->GetCount(destination));
+	device->CopyDescriptorsSimple(count, GetCPUHandle(destination), source.GetCPUHandle(sourceHandle), type);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeap::GetCPUHandle(DescriptorHandle handle, uint32_t offset) const {
+	assert(offset < allocator->GetCount(handle));
+	D3D12_CPU_DESCRIPTOR_HANDLE handleCPU = cpuStart;
+	handleCPU.ptr += SIZE_T(descriptorSize) * (allocator->GetIndex(handle) + offset);
+	return handleCPU;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorHeap::GetGPUHandle(DescriptorHandle handle, uint32_t offset) const {
+	assert(isShaderVisible);
+	assert(offset < allocator->GetCount(handle));
+	D3D12_GPU_DESCRIPTOR_HANDLE handleGPU = gpuStart;
+	handleGPU.ptr += UINT64(descriptorSize) * (allocator->GetIndex(handle) + offset);
+	return handleGPU;
+}
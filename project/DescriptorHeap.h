@@ -0,0 +1,61 @@
+#pragma once
+#include "Engine/Base/DescriptorAllocator.h"
+#include <d3d12.h>
+#include <memory>
+#include <wrl.h>
+
+/// <summary>
+/// ディスクリプタヒープと、その番号を管理するDescriptorAllocatorの組
+/// シェーダーから見えるヒープ(CBV_SRV_UAV、描画に使う)と見えないヒープ(RTV、DSV、ビューを作っておく置き場)を別々に持つ
+/// 見えるヒープはCPUから読むと遅く、コピー元にもできないので、ビューは置き場に作ってからCopyFromで見えるヒープへ写す
+/// </summary>
+class DescriptorHeap {
+public:
+	/// <summary>
+	/// 初期化
+	/// </summary>
+	/// <param name="device">デバイス</param>
+	/// <param name="descriptorHeap">CreateDescriptorHeapで作ったヒープ(数とシェーダーから見えるかはここから取る)</param>
+	void Initialize(const Microsoft::WRL::ComPtr<ID3D12Device>& device, const Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>& descriptorHeap);
+
+	/// <summary>
+	/// 連続したディスクリプタを確保する(ディスクリプタテーブルはcountにテーブルの大きさを渡す)
+	/// </summary>
+	DescriptorHandle Allocate(uint32_t count = 1);
+
+	/// <summary>
+	/// 解放する(番号はfenceValueをGPUが過ぎてから使い直す)
+	/// </summary>
+	void Free(DescriptorHandle handle, uint64_t fenceValue) { allocator->Free(handle, fenceValue); }
+
+	/// <summary>
+	/// GPUが終わった分の解放を反映する(フレームの初めに呼ぶ)
+	/// </summary>
+	void ReleaseCompleted(uint64_t completedFenceValue) { allocator->ReleaseCompleted(completedFenceValue); }
+
+	/// <summary>
+	/// 同じ種類のシェーダーから見えないヒープに作ったディスクリプタを、このヒープの確保した位置へコピーする
+	/// </summary>
+	/// <param name="destination">このヒープで確保したハンドル(sourceHandle以上の数)</param>
+	/// <param name="source">コピー元のヒープ(シェーダーから見えないもの)</param>
+	/// <param name="sourceHandle">sourceで確保したハンドル(全部をコピーする)</param>
+	void CopyFrom(DescriptorHandle destination, const DescriptorHeap& source, DescriptorHandle sourceHandle) const;
+
+	// ハンドルのoffset番目のディスクリプタのCPUハンドル(解放済みのハンドルならassertで止まる)
+	D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(DescriptorHandle handle, uint32_t offset = 0) const;
+	// ハンドルのoffset番目のディスクリプタのGPUハンドル(シェーダーから見えるヒープのみ)
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(DescriptorHandle handle, uint32_t offset = 0) const;
+
+	ID3D12DescriptorHeap* GetHeap() const { return heap.Get(); }
+	const DescriptorAllocator& GetAllocator() const { return *allocator; }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device> device;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+	std::unique_ptr<DescriptorAllocator> allocator;
+	D3D12_DESCRIPTOR_HEAP_TYPE type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	uint32_t descriptorSize = 0;
+	bool isShaderVisible = false;
+	D3D12_CPU_DESCRIPTOR_HANDLE cpuStart{};
+	D3D12_GPU_DESCRIPTOR_HANDLE gpuStart{};
+};
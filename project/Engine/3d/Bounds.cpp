@@ -0,0 +1,73 @@
+#include "Bounds.h"
+#include "Simd.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const Vector4& GetPosition(const Vector4* positions, size_t stride, size_t index) { return *reinterpret_cast<const Vector4*>(reinterpret_cast<const char*>(positions) + stride * index); }
+
+Vector3 Minimum(const Vector3& a, const Vector3& b) { return {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)}; }
+
+Vector3 Maximum(const Vector3& a, const Vector3& b) { return {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)}; }
+
+/// <summary>
+/// 位置の番号をgetIndexで取り出しながらAABBを求める
+/// </summary>
+template<typename GetIndex> AABB ReduceAABB(const Vector4* positions, size_t stride, size_t count, GetIndex getIndex) {
+	if (count == 0) {
+		return {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+	}
+#if ENGINE_USE_SSE
+	// xyzwをまとめて比べ、最後にxyzだけを取り出す
+	__m128 minimum = _mm_loadu_ps(&GetPosition(positions, stride, getIndex(0)).x);
+	__m128 maximum = minimum;
+	for (size_t i = 1; i < count; i++) {
+		__m128 position = _mm_loadu_ps(&GetPosition(positions, stride, getIndex(i)).x);
+		minimum = _mm_min_ps(minimum, position);
+		maximum = _mm_max_ps(maximum, position);
+	}
+	alignas(16) float minimumValues[4];
+	alignas(16) float maximumValues[4];
+	_mm_store_ps(minimumValues, minimum);
+	_mm_store_ps(maximumValues, maximum);
+	return {{minimumValues[0], minimumValues[1], minimumValues[2]}, {maximumValues[0], maximumValues[1], maximumValues[2]}};
+#else
+	const Vector4& first = GetPosition(positions, stride, getIndex(0));
+	AABB aabb = {{first.x, first.y, first.z}, {first.x, first.y, first.z}};
+	for (size_t i = 1; i < count; i++) {
+		const Vector4& position = GetPosition(positions, stride, getIndex(i));
+		aabb.minimum = Minimum(aabb.minimum, {position.x, position.y, position.z});
+		aabb.maximum = Maximum(aabb.maximum, {position.x, position.y, position.z});
+	}
+	return aabb;
+#endif
+}
+
+} // namespace
+
+AABB ComputeAABB(const Vector4* positions, size_t count, size_t stride) {
+	return ReduceAABB(positions, stride, count, [](size_t i) { return i; });
+}
+
+AABB ComputeAABB(const Vector4* positions, size_t stride, const uint32_t* indices, size_t indexCount) {
+	return ReduceAABB(positions, stride, indexCount, [indices](size_t i) { return size_t(indices[i]); });
+}
+
+Sphere ComputeBoundingSphere(const AABB& aabb, const Vector4* positions, size_t stride, const uint32_t* indices, size_t indexCount) {
+	Sphere sphere{GetCenter(aabb), 0.0f};
+	float maxSquaredDistance = 0.0f;
+	for (size_t i = 0; i < indexCount; i++) {
+		const Vector4& position = GetPosition(positions, stride, indices[i]);
+		Vector3 difference = Vector3{position.x, position.y, position.z} - sphere.center;
+		maxSquaredDistance = std::max(maxSquaredDistance, Dot(difference, difference));
+	}
+	sphere.radius = std::sqrt(maxSquaredDistance);
+	return sphere;
+}
+
+AABB MergeAABB(const AABB& a, const AABB& b) { return {Minimum(a.minimum, b.minimum), Maximum(a.maximum, b.maximum)}; }
+
+Vector3 GetCenter(const AABB& aabb) { return 0.5f * (aabb.minimum + aabb.maximum); }
+
+Vector3 GetExtent(const AABB& aabb) { return 0.5f * (aabb.maximum - aabb.minimum); }
@@ -0,0 +1,48 @@
+#pragma once
+#include "Vector3.h"
+#include "Vector4.h"
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// 軸に沿ったバウンディングボックス
+/// </summary>
+struct AABB {
+	Vector3 minimum;
+	Vector3 maximum;
+};
+
+/// <summary>
+/// バウンディングスフィア
+/// </summary>
+struct Sphere {
+	Vector3 center;
+	float radius;
+};
+
+/// <summary>
+/// 位置のAABBを求める(SSEが使えれば4成分まとめて最小値と最大値を取る)
+/// </summary>
+/// <param name="positions">先頭の位置(wは使わない)</param>
+/// <param name="count">位置の数(0なら原点の大きさのない箱)</param>
+/// <param name="stride">位置の間隔(バイト)</param>
+AABB ComputeAABB(const Vector4* positions, size_t count, size_t stride);
+
+/// <summary>
+/// インデックスが参照する位置のAABBを求める
+/// </summary>
+AABB ComputeAABB(const Vector4* positions, size_t stride, const uint32_t* indices, size_t indexCount);
+
+/// <summary>
+/// インデックスが参照する位置を囲む球を求める
+/// 中心はAABBの中心とし、半径は中心から一番遠い位置までとする
+/// </summary>
+/// <param name="aabb">同じ位置のAABB</param>
+Sphere ComputeBoundingSphere(const AABB& aabb, const Vector4* positions, size_t stride, const uint32_t* indices, size_t indexCount);
+
+// 2つのAABBを囲むAABB
+AABB MergeAABB(const AABB& a, const AABB& b);
+// AABBの中心
+Vector3 GetCenter(const AABB& aabb);
+// AABBの中心から各面までの距離
+Vector3 GetExtent(const AABB& aabb);
@@ -0,0 +1,167 @@
+#include "Frustum.h"
+#include "Simd.h"
+#include <cmath>
+
+namespace {
+
+// 平面の数
+const int kPlaneCount = 6;
+
+/// <summary>
+/// 4成分の平面の式を、法線が単位ベクトルになるように割る
+/// </summary>
+Plane MakeNormalizedPlane(float a, float b, float c, float d) {
+	float length = std::sqrt(a * a + b * b + c * c);
+	float inverseLength = length > 0.0f ? 1.0f / length : 0.0f;
+	return {{a * inverseLength, b * inverseLength, c * inverseLength}, d * inverseLength};
+}
+
+float SignedDistance(const Plane& plane, const Vector3& point) { return plane.normal.x * point.x + plane.normal.y * point.y + plane.normal.z * point.z + plane.distance; }
+
+#if ENGINE_USE_SSE
+/// <summary>
+/// 4つの球が、全ての平面の表側に掛かっているかを判定する
+/// </summary>
+/// <returns>掛かっているものの下位ビットが立ったマスク</returns>
+int TestPlanes4(const __m128 planes[kPlaneCount][4], __m128 centerX, __m128 centerY, __m128 centerZ, __m128 radius) {
+	__m128 isInside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+	for (int i = 0; i < kPlaneCount; i++) {
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, planes[i][0]), _mm_mul_ps(centerY, planes[i][1])), _mm_add_ps(_mm_mul_ps(centerZ, planes[i][2]), planes[i][3]));
+		isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+	}
+	return _mm_movemask_ps(isInside);
+}
+
+/// <summary>
+/// 平面の各成分を4レーンに並べる
+/// </summary>
+void BroadcastPlanes(const Frustum& frustum, __m128 planes[kPlaneCount][4]) {
+	for (int i = 0; i < kPlaneCount; i++) {
+		planes[i][0] = _mm_set1_ps(frustum.planes[i].normal.x);
+		planes[i][1] = _mm_set1_ps(frustum.planes[i].normal.y);
+		planes[i][2] = _mm_set1_ps(frustum.planes[i].normal.z);
+		planes[i][3] = _mm_set1_ps(frustum.planes[i].distance);
+	}
+}
+
+/// <summary>
+/// マスクの立っている番号を分岐せずに詰めて書き込む(書き込み先は4つ分空けておく)
+/// </summary>
+size_t AppendVisible(int mask, uint32_t first, uint32_t* visibleIndices, size_t visibleCount) {
+	for (uint32_t lane = 0; lane < 4; lane++) {
+		visibleIndices[visibleCount] = first + lane;
+		visibleCount += (mask >> lane) & 1;
+	}
+	return visibleCount;
+}
+#endif
+
+} // namespace
+
+Frustum MakeFrustum(const Matrix4x4& viewProjection) {
+	// 行ベクトルなので、クリップ座標の各成分は行列の列との内積になる
+	const auto& m = viewProjection.m;
+	Frustum frustum;
+	// w ± x, w ± y が左右と上下、z と w - z が近と遠
+	for (int axis = 0; axis < 2; axis++) {
+		frustum.planes[axis * 2 + 0] = MakeNormalizedPlane(m[0][3] + m[0][axis], m[1][3] + m[1][axis], m[2][3] + m[2][axis], m[3][3] + m[3][axis]);
+		frustum.planes[axis * 2 + 1] = MakeNormalizedPlane(m[0][3] - m[0][axis], m[1][3] - m[1][axis], m[2][3] - m[2][axis], m[3][3] - m[3][axis]);
+	}
+	frustum.planes[4] = MakeNormalizedPlane(m[0][2], m[1][2], m[2][2], m[3][2]);
+	frustum.planes[5] = MakeNormalizedPlane(m[0][3] - m[0][2], m[1][3] - m[1][2], m[2][3] - m[2][2], m[3][3] - m[3][2]);
+	return frustum;
+}
+
+bool IsVisible(const Frustum& frustum, const Sphere& sphere) {
+	for (const Plane& plane : frustum.planes) {
+		if (SignedDistance(plane, sphere.center) < -sphere.radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool IsVisible(const Frustum& frustum, const AABB& aabb) {
+	// 中心の距離に、法線方向へのAABBの広がりを足して判定する
+	Vector3 center = GetCenter(aabb);
+	Vector3 extent = GetExtent(aabb);
+	for (const Plane& plane : frustum.planes) {
+		float radius = std::abs(plane.normal.x) * extent.x + std::abs(plane.normal.y) * extent.y + std::abs(plane.normal.z) * extent.z;
+		if (SignedDistance(plane, center) < -radius) {
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t CullSpheres(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleIndices) {
+	size_t visibleCount = 0;
+	size_t i = 0;
+#if ENGINE_USE_SSE
+	__m128 planes[kPlaneCount][4];
+	BroadcastPlanes(frustum, planes);
+	for (; i + 4 <= count; i += 4) {
+		// Sphereはfloat4つ分なので、4つ読んで転置すればx, y, z, 半径ごとに並ぶ
+		__m128 x = _mm_loadu_ps(&spheres[i + 0].center.x);
+		__m128 y = _mm_loadu_ps(&spheres[i + 1].center.x);
+		__m128 z = _mm_loadu_ps(&spheres[i + 2].center.x);
+		__m128 radius = _mm_loadu_ps(&spheres[i + 3].center.x);
+		_MM_TRANSPOSE4_PS(x, y, z, radius);
+		visibleCount = AppendVisible(TestPlanes4(planes, x, y, z, radius), uint32_t(i), visibleIndices, visibleCount);
+	}
+#endif
+	for (; i < count; i++) {
+		visibleIndices[visibleCount] = uint32_t(i);
+		visibleCount += IsVisible(frustum, spheres[i]) ? 1 : 0;
+	}
+	return visibleCount;
+}
+
+size_t CullAABBs(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleIndices) {
+	size_t visibleCount = 0;
+	size_t i = 0;
+#if ENGINE_USE_SSE
+	__m128 planes[kPlaneCount][4];
+	__m128 absoluteNormals[kPlaneCount][3];
+	BroadcastPlanes(frustum, planes);
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000)));
+	for (int k = 0; k < kPlaneCount; k++) {
+		for (int axis = 0; axis < 3; axis++) {
+			absoluteNormals[k][axis] = _mm_andnot_ps(signMask, planes[k][axis]);
+		}
+	}
+	const __m128 half = _mm_set1_ps(0.5f);
+	for (; i + 4 <= count; i += 4) {
+		// AABBはfloat6つ分なので、(最小xyz, 最大x)と(最小z, 最大xyz)に分けて読み、それぞれ転置する
+		__m128 minimumX = _mm_loadu_ps(&aabbs[i + 0].minimum.x);
+		__m128 minimumY = _mm_loadu_ps(&aabbs[i + 1].minimum.x);
+		__m128 minimumZ = _mm_loadu_ps(&aabbs[i + 2].minimum.x);
+		__m128 unused0 = _mm_loadu_ps(&aabbs[i + 3].minimum.x);
+		_MM_TRANSPOSE4_PS(minimumX, minimumY, minimumZ, unused0);
+		__m128 unused1 = _mm_loadu_ps(&aabbs[i + 0].minimum.z);
+		__m128 maximumX = _mm_loadu_ps(&aabbs[i + 1].minimum.z);
+		__m128 maximumY = _mm_loadu_ps(&aabbs[i + 2].minimum.z);
+		__m128 maximumZ = _mm_loadu_ps(&aabbs[i + 3].minimum.z);
+		_MM_TRANSPOSE4_PS(unused1, maximumX, maximumY, maximumZ);
+
+		__m128 centerX = _mm_mul_ps(_mm_add_ps(minimumX, maximumX), half);
+		__m128 centerY = _mm_mul_ps(_mm_add_ps(minimumY, maximumY), half);
+		__m128 centerZ = _mm_mul_ps(_mm_add_ps(minimumZ, maximumZ), half);
+		__m128 extentX = _mm_mul_ps(_mm_sub_ps(maximumX, minimumX), half);
+		__m128 extentY = _mm_mul_ps(_mm_sub_ps(maximumY, minimumY), half);
+		__m128 extentZ = _mm_mul_ps(_mm_sub_ps(maximumZ, minimumZ), half);
+		__m128 isInside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (int k = 0; k < kPlaneCount; k++) {
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, planes[k][0]), _mm_mul_ps(centerY, planes[k][1])), _mm_add_ps(_mm_mul_ps(centerZ, planes[k][2]), planes[k][3]));
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(extentX, absoluteNormals[k][0]), _mm_mul_ps(extentY, absoluteNormals[k][1])), _mm_mul_ps(extentZ, absoluteNormals[k][2]));
+			isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+		}
+		visibleCount = AppendVisible(_mm_movemask_ps(isInside), uint32_t(i), visibleIndices, visibleCount);
+	}
+#endif
+	for (; i < count; i++) {
+		visibleIndices[visibleCount] = uint32_t(i);
+		visibleCount += IsVisible(frustum, aabbs[i]) ? 1 : 0;
+	}
+	return visibleCount;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "Bounds.h"
+#include "Matrix.h"
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// 平面(dot(normal, p) + distance が0以上の側を表とする)
+/// </summary>
+struct Plane {
+	Vector3 normal; // 単位法線
+	float distance;
+};
+
+/// <summary>
+/// 視錐台。6つの平面の法線はすべて内側を向く
+/// </summary>
+struct Frustum {
+	// 左, 右, 下, 上, 近, 遠
+	Plane planes[6];
+};
+
+/// <summary>
+/// ビュープロジェクション行列から、ワールド座標の視錐台を求める
+/// クリップ座標の -w <= x <= w, -w <= y <= w, 0 <= z <= w を平面に直したもの(MakePerspectiveFovMatrix, MakeOrthographicMatrixの範囲)
+/// </summary>
+Frustum MakeFrustum(const Matrix4x4& viewProjection);
+
+// 球が視錐台に掛かっているか(境界付近では外でも掛かっているとみなすことがある)
+bool IsVisible(const Frustum& frustum, const Sphere& sphere);
+// AABBが視錐台に掛かっているか(境界付近では外でも掛かっているとみなすことがある)
+bool IsVisible(const Frustum& frustum, const AABB& aabb);
+
+/// <summary>
+/// 視錐台に掛かっている球の番号を、先頭から順に詰めて書き込む
+/// SSEが使えれば4つずつ判定する
+/// </summary>
+/// <param name="frustum">視錐台</param>
+/// <param name="spheres">ワールド座標の球</param>
+/// <param name="count">球の数</param>
+/// <param name="visibleIndices">見える球の番号(count個書き込める大きさにする)</param>
+/// <returns>見える球の数</returns>
+size_t CullSpheres(const Frustum& frustum, const Sphere* spheres, size_t count, uint32_t* visibleIndices);
+
+/// <summary>
+/// 視錐台に掛かっているAABBの番号を、先頭から順に詰めて書き込む
+/// SSEが使えれば4つずつ判定する
+/// </summary>
+/// <param name="frustum">視錐台</param>
+/// <param name="aabbs">ワールド座標のAABB</param>
+/// <param name="count">AABBの数</param>
+/// <param name="visibleIndices">見えるAABBの番号(count個書き込める大きさにする)</param>
+/// <returns>見えるAABBの数</returns>
+size_t CullAABBs(const Frustum& frustum, const AABB* aabbs, size_t count, uint32_t* visibleIndices);
@@ -1,10 +1,24 @@
 #include "Matrix.h"
+#include "Simd.h"
 #include <assert.h>
 #include <cmath>
 #include <math.h>
 static const int kRowHeight = 20;
 static const int kColumnWidth = 60;
 static const float p = 3.1415f;
+
+#if ENGINE_USE_SSE
+// _mm_shuffle_psの並びを(x, y, z, w)の順で指定する
+#define MATRIX_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define MATRIX_SWIZZLE(a, x, y, z, w) MATRIX_SHUFFLE(a, a, x, y, z, w)
+
+// 2x2の行列(行優先で4成分に詰めたもの)の積 a * b
+static inline __m128 Multiply2x2(__m128 a, __m128 b) { return _mm_add_ps(_mm_mul_ps(a, MATRIX_SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(MATRIX_SWIZZLE(a, 1, 0, 3, 2), MATRIX_SWIZZLE(b, 2, 1, 2, 1))); }
+// 2x2の行列の余因子行列との積 adj(a) * b
+static inline __m128 AdjugateMultiply2x2(__m128 a, __m128 b) { return _mm_sub_ps(_mm_mul_ps(MATRIX_SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(MATRIX_SWIZZLE(a, 1, 1, 2, 2), MATRIX_SWIZZLE(b, 2, 3, 0, 1))); }
+// 2x2の行列と余因子行列の積 a * adj(b)
+static inline __m128 MultiplyAdjugate2x2(__m128 a, __m128 b) { return _mm_sub_ps(_mm_mul_ps(a, MATRIX_SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(MATRIX_SWIZZLE(a, 1, 0, 3, 2), MATRIX_SWIZZLE(b, 2, 1, 2, 1))); }
+#endif
 Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2) {
 	Matrix4x4 add{};
 	for (int i = 0; i < 4; i++) {
@@ -27,7 +41,20 @@ Matrix4x4 Subtract(const Matrix4x4& m1, const Matrix4x4& m2) {
 Matrix4x4 operator-(const Matrix4x4& m1, const Matrix4x4& m2) { return Subtract(m1, m2); };
 Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
 	Matrix4x4 multiply{};
-
+#if ENGINE_USE_SSE
+	// 結果の行iは、m2の各行にm1[i][k]を掛けて足したもの
+	__m128 row0 = _mm_loadu_ps(m2.m[0]);
+	__m128 row1 = _mm_loadu_ps(m2.m[1]);
+	__m128 row2 = _mm_loadu_ps(m2.m[2]);
+	__m128 row3 = _mm_loadu_ps(m2.m[3]);
+	for (int i = 0; i < 4; i++) {
+		__m128 result = _mm_mul_ps(_mm_set1_ps(m1.m[i][0]), row0);
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(m1.m[i][1]), row1));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(m1.m[i][2]), row2));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(m1.m[i][3]), row3));
+		_mm_storeu_ps(multiply.m[i], result);
+	}
+#else
 	// 各行と各列を掛け合わせる
 	for (int i = 0; i < 4; i++) {     // 行ループ
 		for (int j = 0; j < 4; j++) { // 列ループ
@@ -35,6 +62,7 @@ Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
 			multiply.m[i][j] = m1.m[i][0] * m2.m[0][j] + m1.m[i][1] * m2.m[1][j] + m1.m[i][2] * m2.m[2][j] + m1.m[i][3] * m2.m[3][j];
 		}
 	}
+#endif
 
 	return multiply;
 }
@@ -74,68 +102,135 @@ Vector3 MultiplyVector3(const Matrix4x4& m, const Vector3& v) {
 }
 Vector3 operator*(const Matrix4x4& m, const Vector3& v) { return MultiplyVector3(m, v); }
 Matrix4x4 Inverse(const Matrix4x4& m) {
-	float det =
-	    m.m[0][0] * m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[0][0] * m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[0][0] * m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[0][0] * m.m[1][3] * m.m[2][2] * m.m[3][1] -
-	    m.m[0][0] * m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[0][0] * m.m[1][1] * m.m[2][3] * m.m[3][2] - m.m[0][1] * m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[1][0] * m.m[2][3] * m.m[3][1] -
-	    m.m[0][3] * m.m[1][0] * m.m[2][1] * m.m[3][2] + m.m[0][3] * m.m[1][0] * m.m[2][2] * m.m[3][1] + m.m[0][2] * m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[1][0] * m.m[2][3] * m.m[3][2] +
-	    m.m[0][1] * m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] * m.m[3][2] - m.m[0][3] * m.m[1][2] * m.m[2][0] * m.m[3][1] -
-	    m.m[0][2] * m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] * m.m[3][2] - m.m[0][1] * m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[0][2] * m.m[1][3] * m.m[2][1] * m.m[3][0] -
-	    m.m[0][3] * m.m[1][1] * m.m[2][2] * m.m[3][0] + m.m[0][3] * m.m[1][2] * m.m[2][1] * m.m[3][0] + m.m[0][2] * m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[0][1] * m.m[1][3] * m.m[2][2] * m.m[3][0];
-
-	Matrix4x4 Inverse{};
-	Inverse.m[0][0] = 1 / det *
-	                  (m.m[1][1] * m.m[2][2] * m.m[3][3] + m.m[1][2] * m.m[2][3] * m.m[3][1] + m.m[1][3] * m.m[2][1] * m.m[3][2] - m.m[1][3] * m.m[2][2] * m.m[3][1] -
-	                   m.m[1][2] * m.m[2][1] * m.m[3][3] - m.m[1][1] * m.m[2][3] * m.m[3][2]);
-	Inverse.m[0][1] = 1 / det *
-	                  (-m.m[0][1] * m.m[2][2] * m.m[3][3] - m.m[0][2] * m.m[2][3] * m.m[3][1] - m.m[0][3] * m.m[2][1] * m.m[3][2] + m.m[0][3] * m.m[2][2] * m.m[3][1] +
-	                   m.m[0][2] * m.m[2][1] * m.m[3][3] + m.m[0][1] * m.m[2][3] * m.m[3][2]);
-	Inverse.m[0][2] = 1 / det *
-	                  (m.m[0][1] * m.m[1][2] * m.m[3][3] + m.m[0][2] * m.m[1][3] * m.m[3][1] + m.m[0][3] * m.m[1][1] * m.m[3][2] - m.m[0][3] * m.m[1][2] * m.m[3][1] -
-	                   m.m[0][2] * m.m[1][1] * m.m[3][3] - m.m[0][1] * m.m[1][3] * m.m[3][2]);
-	Inverse.m[0][3] = 1 / det *
-	                  (-m.m[0][1] * m.m[1][2] * m.m[2][3] - m.m[0][2] * m.m[1][3] * m.m[2][1] - m.m[0][3] * m.m[1][1] * m.m[2][2] + m.m[0][3] * m.m[1][2] * m.m[2][1] +
-	                   m.m[0][2] * m.m[1][1] * m.m[2][3] + m.m[0][1] * m.m[1][3] * m.m[2][2]);
-
-	Inverse.m[1][0] = 1 / det *
-	                  (-m.m[1][0] * m.m[2][2] * m.m[3][3] - m.m[1][2] * m.m[2][3] * m.m[3][0] - m.m[1][3] * m.m[2][0] * m.m[3][2] + m.m[1][3] * m.m[2][2] * m.m[3][0] +
-	                   m.m[1][2] * m.m[2][0] * m.m[3][3] + m.m[1][0] * m.m[2][3] * m.m[3][2]);
-	Inverse.m[1][1] = 1 / det *
-	                  (m.m[0][0] * m.m[2][2] * m.m[3][3] + m.m[0][2] * m.m[2][3] * m.m[3][0] + m.m[0][3] * m.m[2][0] * m.m[3][2] - m.m[0][3] * m.m[2][2] * m.m[3][0] -
-	                   m.m[0][2] * m.m[2][0] * m.m[3][3] - m.m[0][0] * m.m[2][3] * m.m[3][2]);
-	Inverse.m[1][2] = 1 / det *
-	                  (-m.m[0][0] * m.m[1][2] * m.m[3][3] - m.m[0][2] * m.m[1][3] * m.m[3][0] - m.m[0][3] * m.m[1][0] * m.m[3][2] + m.m[0][3] * m.m[1][2] * m.m[3][0] +
-	                   m.m[0][2] * m.m[1][0] * m.m[3][3] + m.m[0][0] * m.m[1][3] * m.m[3][2]);
-	Inverse.m[1][3] = 1 / det *
-	                  (m.m[0][0] * m.m[1][2] * m.m[2][3] + m.m[0][2] * m.m[1][3] * m.m[2][0] + m.m[0][3] * m.m[1][0] * m.m[2][2] - m.m[0][3] * m.m[1][2] * m.m[2][0] -
-	                   m.m[0][2] * m.m[1][0] * m.m[2][3] - m.m[0][0] * m.m[1][3] * m.m[2][2]);
-
-	Inverse.m[2][0] = 1 / det *
-	                  (m.m[1][0] * m.m[2][1] * m.m[3][3] + m.m[1][1] * m.m[2][3] * m.m[3][0] + m.m[1][3] * m.m[2][0] * m.m[3][1] - m.m[1][3] * m.m[2][1] * m.m[3][0] -
-	                   m.m[1][1] * m.m[2][0] * m.m[3][3] - m.m[1][0] * m.m[2][3] * m.m[3][1]);
-	Inverse.m[2][1] = 1 / det *
-	                  (-m.m[0][0] * m.m[2][1] * m.m[3][3] - m.m[0][1] * m.m[2][3] * m.m[3][0] - m.m[0][3] * m.m[2][0] * m.m[3][1] + m.m[0][3] * m.m[2][1] * m.m[3][0] +
-	                   m.m[0][1] * m.m[2][0] * m.m[3][3] + m.m[0][0] * m.m[2][3] * m.m[3][1]);
-	Inverse.m[2][2] = 1 / det *
-	                  (m.m[0][0] * m.m[1][1] * m.m[3][3] + m.m[0][1] * m.m[1][3] * m.m[3][0] + m.m[0][3] * m.m[1][0] * m.m[3][1] - m.m[0][3] * m.m[1][1] * m.m[3][0] -
-	                   m.m[0][1] * m.m[1][0] * m.m[3][3] - m.m[0][0] * m.m[1][3] * m.m[3][1]);
-	Inverse.m[2][3] = 1 / det *
-	                  (-m.m[0][0] * m.m[1][1] * m.m[2][3] - m.m[0][1] * m.m[1][3] * m.m[2][0] - m.m[0][3] * m.m[1][0] * m.m[2][1] + m.m[0][3] * m.m[1][1] * m.m[2][0] +
-	                   m.m[0][1] * m.m[1][0] * m.m[2][3] + m.m[0][0] * m.m[1][3] * m.m[2][1]);
-
-	Inverse.m[3][0] = 1 / det *
-	                  (-m.m[1][0] * m.m[2][1] * m.m[3][2] - m.m[1][1] * m.m[2][2] * m.m[3][0] - m.m[1][2] * m.m[2][0] * m.m[3][1] + m.m[1][2] * m.m[2][1] * m.m[3][0] +
-	                   m.m[1][1] * m.m[2][0] * m.m[3][2] + m.m[1][0] * m.m[2][2] * m.m[3][1]);
-	Inverse.m[3][1] = 1 / det *
-	                  (m.m[0][0] * m.m[2][1] * m.m[3][2] + m.m[0][1] * m.m[2][2] * m.m[3][0] + m.m[0][2] * m.m[2][0] * m.m[3][1] - m.m[0][2] * m.m[2][1] * m.m[3][0] -
-	                   m.m[0][1] * m.m[2][0] * m.m[3][2] - m.m[0][0] * m.m[2][2] * m.m[3][1]);
-	Inverse.m[3][2] = 1 / det *
-	                  (-m.m[0][0] * m.m[1][1] * m.m[3][2] - m.m[0][1] * m.m[1][2] * m.m[3][0] - m.m[0][2] * m.m[1][0] * m.m[3][1] + m.m[0][2] * m.m[1][1] * m.m[3][0] +
-	                   m.m[0][1] * m.m[1][0] * m.m[3][2] + m.m[0][0] * m.m[1][2] * m.m[3][1]);
-	Inverse.m[3][3] = 1 / det *
-	                  (m.m[0][0] * m.m[1][1] * m.m[2][2] + m.m[0][1] * m.m[1][2] * m.m[2][0] + m.m[0][2] * m.m[1][0] * m.m[2][1] - m.m[0][2] * m.m[1][1] * m.m[2][0] -
-	                   m.m[0][1] * m.m[1][0] * m.m[2][2] - m.m[0][0] * m.m[1][2] * m.m[2][1]);
-	return Inverse;
-};
+	Matrix4x4 inverse{};
+#if ENGINE_USE_SSE
+	// 2x2の小行列A, B, C, Dに分け、小行列の行列式と余因子行列を使い回して余因子展開する
+	__m128 row0 = _mm_loadu_ps(m.m[0]);
+	__m128 row1 = _mm_loadu_ps(m.m[1]);
+	__m128 row2 = _mm_loadu_ps(m.m[2]);
+	__m128 row3 = _mm_loadu_ps(m.m[3]);
+	__m128 a = _mm_movelh_ps(row0, row1);
+	__m128 b = _mm_movehl_ps(row1, row0);
+	__m128 c = _mm_movelh_ps(row2, row3);
+	__m128 d = _mm_movehl_ps(row3, row2);
+
+	// (|A|, |B|, |C|, |D|)
+	__m128 subDeterminants = _mm_sub_ps(_mm_mul_ps(MATRIX_SHUFFLE(row0, row2, 0, 2, 0, 2), MATRIX_SHUFFLE(row1, row3, 1, 3, 1, 3)),
+	                                    _mm_mul_ps(MATRIX_SHUFFLE(row0, row2, 1, 3, 1, 3), MATRIX_SHUFFLE(row1, row3, 0, 2, 0, 2)));
+	__m128 determinantA = MATRIX_SWIZZLE(subDeterminants, 0, 0, 0, 0);
+	__m128 determinantB = MATRIX_SWIZZLE(subDeterminants, 1, 1, 1, 1);
+	__m128 determinantC = MATRIX_SWIZZLE(subDeterminants, 2, 2, 2, 2);
+	__m128 determinantD = MATRIX_SWIZZLE(subDeterminants, 3, 3, 3, 3);
+
+	// 逆行列を 1/|M| * (X Y; Z W) としたときの、X, Y, Z, Wの余因子行列
+	__m128 adjugateDC = AdjugateMultiply2x2(d, c);
+	__m128 adjugateAB = AdjugateMultiply2x2(a, b);
+	__m128 x = _mm_sub_ps(_mm_mul_ps(determinantD, a), Multiply2x2(b, adjugateDC));
+	__m128 w = _mm_sub_ps(_mm_mul_ps(determinantA, d), Multiply2x2(c, adjugateAB));
+	__m128 y = _mm_sub_ps(_mm_mul_ps(determinantB, c), MultiplyAdjugate2x2(d, adjugateAB));
+	__m128 z = _mm_sub_ps(_mm_mul_ps(determinantC, b), MultiplyAdjugate2x2(a, adjugateDC));
+
+	// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+	__m128 trace = _mm_mul_ps(adjugateAB, MATRIX_SWIZZLE(adjugateDC, 0, 2, 1, 3));
+	trace = _mm_add_ps(trace, MATRIX_SWIZZLE(trace, 2, 3, 0, 1));
+	trace = _mm_add_ps(trace, MATRIX_SWIZZLE(trace, 1, 0, 3, 2));
+	__m128 determinant = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(determinantA, determinantD), _mm_mul_ps(determinantB, determinantC)), trace);
+	__m128 inverseDeterminant = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), determinant);
+	x = _mm_mul_ps(x, inverseDeterminant);
+	y = _mm_mul_ps(y, inverseDeterminant);
+	z = _mm_mul_ps(z, inverseDeterminant);
+	w = _mm_mul_ps(w, inverseDeterminant);
+
+	// 余因子行列から元の並びに戻しながら行に詰める
+	_mm_storeu_ps(inverse.m[0], MATRIX_SHUFFLE(x, y, 3, 1, 3, 1));
+	_mm_storeu_ps(inverse.m[1], MATRIX_SHUFFLE(x, y, 2, 0, 2, 0));
+	_mm_storeu_ps(inverse.m[2], MATRIX_SHUFFLE(z, w, 3, 1, 3, 1));
+	_mm_storeu_ps(inverse.m[3], MATRIX_SHUFFLE(z, w, 2, 0, 2, 0));
+#else
+	// 上2行と下2行から作る2x2の小行列式を使い回して余因子を求める(クラメルの公式)
+	float s0 = m.m[0][0] * m.m[1][1] - m.m[1][0] * m.m[0][1];
+	float s1 = m.m[0][0] * m.m[1][2] - m.m[1][0] * m.m[0][2];
+	float s2 = m.m[0][0] * m.m[1][3] - m.m[1][0] * m.m[0][3];
+	float s3 = m.m[0][1] * m.m[1][2] - m.m[1][1] * m.m[0][2];
+	float s4 = m.m[0][1] * m.m[1][3] - m.m[1][1] * m.m[0][3];
+	float s5 = m.m[0][2] * m.m[1][3] - m.m[1][2] * m.m[0][3];
+	float c5 = m.m[2][2] * m.m[3][3] - m.m[3][2] * m.m[2][3];
+	float c4 = m.m[2][1] * m.m[3][3] - m.m[3][1] * m.m[2][3];
+	float c3 = m.m[2][1] * m.m[3][2] - m.m[3][1] * m.m[2][2];
+	float c2 = m.m[2][0] * m.m[3][3] - m.m[3][0] * m.m[2][3];
+	float c1 = m.m[2][0] * m.m[3][2] - m.m[3][0] * m.m[2][2];
+	float c0 = m.m[2][0] * m.m[3][1] - m.m[3][0] * m.m[2][1];
+	float inverseDeterminant = 1.0f / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+	inverse.m[0][0] = (m.m[1][1] * c5 - m.m[1][2] * c4 + m.m[1][3] * c3) * inverseDeterminant;
+	inverse.m[0][1] = (-m.m[0][1] * c5 + m.m[0][2] * c4 - m.m[0][3] * c3) * inverseDeterminant;
+	inverse.m[0][2] = (m.m[3][1] * s5 - m.m[3][2] * s4 + m.m[3][3] * s3) * inverseDeterminant;
+	inverse.m[0][3] = (-m.m[2][1] * s5 + m.m[2][2] * s4 - m.m[2][3] * s3) * inverseDeterminant;
+	inverse.m[1][0] = (-m.m[1][0] * c5 + m.m[1][2] * c2 - m.m[1][3] * c1) * inverseDeterminant;
+	inverse.m[1][1] = (m.m[0][0] * c5 - m.m[0][2] * c2 + m.m[0][3] * c1) * inverseDeterminant;
+	inverse.m[1][2] = (-m.m[3][0] * s5 + m.m[3][2] * s2 - m.m[3][3] * s1) * inverseDeterminant;
+	inverse.m[1][3] = (m.m[2][0] * s5 - m.m[2][2] * s2 + m.m[2][3] * s1) * inverseDeterminant;
+	inverse.m[2][0] = (m.m[1][0] * c4 - m.m[1][1] * c2 + m.m[1][3] * c0) * inverseDeterminant;
+	inverse.m[2][1] = (-m.m[0][0] * c4 + m.m[0][1] * c2 - m.m[0][3] * c0) * inverseDeterminant;
+	inverse.m[2][2] = (m.m[3][0] * s4 - m.m[3][1] * s2 + m.m[3][3] * s0) * inverseDeterminant;
+	inverse.m[2][3] = (-m.m[2][0] * s4 + m.m[2][1] * s2 - m.m[2][3] * s0) * inverseDeterminant;
+	inverse.m[3][0] = (-m.m[1][0] * c3 + m.m[1][1] * c1 - m.m[1][2] * c0) * inverseDeterminant;
+	inverse.m[3][1] = (m.m[0][0] * c3 - m.m[0][1] * c1 + m.m[0][2] * c0) * inverseDeterminant;
+	inverse.m[3][2] = (-m.m[3][0] * s3 + m.m[3][1] * s1 - m.m[3][2] * s0) * inverseDeterminant;
+	inverse.m[3][3] = (m.m[2][0] * s3 - m.m[2][1] * s1 + m.m[2][2] * s0) * inverseDeterminant;
+#endif
+	return inverse;
+}
+Matrix4x4 InverseAffine(const Matrix4x4& m) {
+	// 3x3部分の逆行列は、行どうしの外積(余因子)を列に並べて行列式で割ったもの
+	// 平行移動は -t * (3x3部分の逆行列)
+	Matrix4x4 inverse{};
+#if ENGINE_USE_SSE
+	__m128 row0 = _mm_loadu_ps(m.m[0]);
+	__m128 row1 = _mm_loadu_ps(m.m[1]);
+	__m128 row2 = _mm_loadu_ps(m.m[2]);
+	// cross(a, b) = a.yzx * b.zxy - a.zxy * b.yzx (wは0になる)
+	__m128 column0 = _mm_sub_ps(_mm_mul_ps(MATRIX_SWIZZLE(row1, 1, 2, 0, 3), MATRIX_SWIZZLE(row2, 2, 0, 1, 3)), _mm_mul_ps(MATRIX_SWIZZLE(row1, 2, 0, 1, 3), MATRIX_SWIZZLE(row2, 1, 2, 0, 3)));
+	__m128 column1 = _mm_sub_ps(_mm_mul_ps(MATRIX_SWIZZLE(row2, 1, 2, 0, 3), MATRIX_SWIZZLE(row0, 2, 0, 1, 3)), _mm_mul_ps(MATRIX_SWIZZLE(row2, 2, 0, 1, 3), MATRIX_SWIZZLE(row0, 1, 2, 0, 3)));
+	__m128 column2 = _mm_sub_ps(_mm_mul_ps(MATRIX_SWIZZLE(row0, 1, 2, 0, 3), MATRIX_SWIZZLE(row1, 2, 0, 1, 3)), _mm_mul_ps(MATRIX_SWIZZLE(row0, 2, 0, 1, 3), MATRIX_SWIZZLE(row1, 1, 2, 0, 3)));
+	__m128 determinant = _mm_mul_ps(row0, column0);
+	determinant = _mm_add_ps(_mm_add_ps(MATRIX_SWIZZLE(determinant, 0, 0, 0, 0), MATRIX_SWIZZLE(determinant, 1, 1, 1, 1)), MATRIX_SWIZZLE(determinant, 2, 2, 2, 2));
+	__m128 inverseDeterminant = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+	column0 = _mm_mul_ps(column0, inverseDeterminant);
+	column1 = _mm_mul_ps(column1, inverseDeterminant);
+	column2 = _mm_mul_ps(column2, inverseDeterminant);
+	__m128 column3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+
+	__m128 translate = _mm_mul_ps(_mm_set1_ps(m.m[3][0]), column0);
+	translate = _mm_add_ps(translate, _mm_mul_ps(_mm_set1_ps(m.m[3][1]), column1));
+	translate = _mm_add_ps(translate, _mm_mul_ps(_mm_set1_ps(m.m[3][2]), column2));
+	translate = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), translate);
+	_mm_storeu_ps(inverse.m[0], column0);
+	_mm_storeu_ps(inverse.m[1], column1);
+	_mm_storeu_ps(inverse.m[2], column2);
+	_mm_storeu_ps(inverse.m[3], translate);
+#else
+	float cofactor00 = m.m[1][1] * m.m[2][2] - m.m[1][2] * m.m[2][1];
+	float cofactor01 = m.m[1][2] * m.m[2][0] - m.m[1][0] * m.m[2][2];
+	float cofactor02 = m.m[1][0] * m.m[2][1] - m.m[1][1] * m.m[2][0];
+	float inverseDeterminant = 1.0f / (m.m[0][0] * cofactor00 + m.m[0][1] * cofactor01 + m.m[0][2] * cofactor02);
+	inverse.m[0][0] = cofactor00 * inverseDeterminant;
+	inverse.m[1][0] = cofactor01 * inverseDeterminant;
+	inverse.m[2][0] = cofactor02 * inverseDeterminant;
+	inverse.m[0][1] = (m.m[2][1] * m.m[0][2] - m.m[2][2] * m.m[0][1]) * inverseDeterminant;
+	inverse.m[1][1] = (m.m[2][2] * m.m[0][0] - m.m[2][0] * m.m[0][2]) * inverseDeterminant;
+	inverse.m[2][1] = (m.m[2][0] * m.m[0][1] - m.m[2][1] * m.m[0][0]) * inverseDeterminant;
+	inverse.m[0][2] = (m.m[0][1] * m.m[1][2] - m.m[0][2] * m.m[1][1]) * inverseDeterminant;
+	inverse.m[1][2] = (m.m[0][2] * m.m[1][0] - m.m[0][0] * m.m[1][2]) * inverseDeterminant;
+	inverse.m[2][2] = (m.m[0][0] * m.m[1][1] - m.m[0][1] * m.m[1][0]) * inverseDeterminant;
+	for (int j = 0; j < 3; j++) {
+		inverse.m[3][j] = -(m.m[3][0] * inverse.m[0][j] + m.m[3][1] * inverse.m[1][j] + m.m[3][2] * inverse.m[2][j]);
+	}
+	inverse.m[3][3] = 1.0f;
+#endif
+	return inverse;
+}
 Matrix4x4 Transpose(const Matrix4x4& m) {
 	Matrix4x4 trancepose{};
 	for (int i = 0; i < 4; i++) {
@@ -205,45 +300,124 @@ Matrix4x4 MakeRotateZMatrix(float radiun) {
 }
 
 Matrix4x4 MakeRotateXYZMatrix(Vector3 rotate) {
-	Matrix4x4 XMatrix = MakeRotateXMatrix(rotate.x);
-	Matrix4x4 YMatrix = MakeRotateYMatrix(rotate.y);
-	Matrix4x4 ZMatrix = MakeRotateZMatrix(rotate.z);
-	Matrix4x4 XYZMatrix = Multiply(XMatrix, Multiply(YMatrix, ZMatrix));
+	AffineTransform rotateTransform = MakeAffineTransform({1.0f, 1.0f, 1.0f}, rotate, {0.0f, 0.0f, 0.0f});
+	return ToMatrix4x4(rotateTransform);
+}
+
+Matrix4x4 MakeAffineMatrix(Vector3 scale, Vector3 rotate, Vector3 translate) { return ToMatrix4x4(MakeAffineTransform(scale, rotate, translate)); }
+
+AffineTransform MakeAffineTransform(const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
+	float sinX = std::sin(rotate.x);
+	float cosX = std::cos(rotate.x);
+	float sinY = std::sin(rotate.y);
+	float cosY = std::cos(rotate.y);
+	float sinZ = std::sin(rotate.z);
+	float cosZ = std::cos(rotate.z);
+
+	// X軸回転 * Y軸回転 * Z軸回転を展開し、各行を拡大率で拡大する
+	AffineTransform transform;
+	transform.axisX = {scale.x * cosY * cosZ, scale.x * cosY * sinZ, scale.x * -sinY};
+	transform.axisY = {scale.y * (sinX * sinY * cosZ - cosX * sinZ), scale.y * (cosX * cosZ + sinX * sinY * sinZ), scale.y * sinX * cosY};
+	transform.axisZ = {scale.z * (cosX * sinY * cosZ + sinX * sinZ), scale.z * (cosX * sinY * sinZ - sinX * cosZ), scale.z * cosX * cosY};
+	transform.translate = translate;
+	return transform;
+}
+
+AffineTransform InverseRigid(const AffineTransform& transform) {
+	// 回転の逆は転置で、平行移動は -t * 転置した回転
+	const Vector3& x = transform.axisX;
+	const Vector3& y = transform.axisY;
+	const Vector3& z = transform.axisZ;
+	const Vector3& t = transform.translate;
+	AffineTransform inverse;
+	inverse.axisX = {x.x, y.x, z.x};
+	inverse.axisY = {x.y, y.y, z.y};
+	inverse.axisZ = {x.z, y.z, z.z};
+	inverse.translate = {-(t.x * x.x + t.y * x.y + t.z * x.z), -(t.x * y.x + t.y * y.y + t.z * y.z), -(t.x * z.x + t.y * z.y + t.z * z.z)};
+	return inverse;
+}
+
+AffineTransform Multiply(const AffineTransform& transform1, const AffineTransform& transform2) {
+	const Vector3& x = transform2.axisX;
+	const Vector3& y = transform2.axisY;
+	const Vector3& z = transform2.axisZ;
+	// 行ベクトルvをtransform2の3x3部分で回す
+	auto rotate = [&](const Vector3& v) { return Vector3{v.x * x.x + v.y * y.x + v.z * z.x, v.x * x.y + v.y * y.y + v.z * z.y, v.x * x.z + v.y * y.z + v.z * z.z}; };
+	AffineTransform multiply;
+	multiply.axisX = rotate(transform1.axisX);
+	multiply.axisY = rotate(transform1.axisY);
+	multiply.axisZ = rotate(transform1.axisZ);
+	multiply.translate = rotate(transform1.translate);
+	multiply.translate = {multiply.translate.x + transform2.translate.x, multiply.translate.y + transform2.translate.y, multiply.translate.z + transform2.translate.z};
+	return multiply;
+}
 
-	return XYZMatrix;
+Matrix4x4 Multiply(const AffineTransform& transform, const Matrix4x4& matrix) {
+	// 4列目が(0, 0, 0, 1)なので、行列の3行目は平行移動の行にだけ足せばよい
+	const Vector3* rows[4] = {&transform.axisX, &transform.axisY, &transform.axisZ, &transform.translate};
+	Matrix4x4 multiply{};
+#if ENGINE_USE_SSE
+	__m128 row0 = _mm_loadu_ps(matrix.m[0]);
+	__m128 row1 = _mm_loadu_ps(matrix.m[1]);
+	__m128 row2 = _mm_loadu_ps(matrix.m[2]);
+	for (int i = 0; i < 4; i++) {
+		__m128 result = _mm_mul_ps(_mm_set1_ps(rows[i]->x), row0);
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(rows[i]->y), row1));
+		result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(rows[i]->z), row2));
+		if (i == 3) {
+			result = _mm_add_ps(result, _mm_loadu_ps(matrix.m[3]));
+		}
+		_mm_storeu_ps(multiply.m[i], result);
+	}
+#else
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			multiply.m[i][j] = rows[i]->x * matrix.m[0][j] + rows[i]->y * matrix.m[1][j] + rows[i]->z * matrix.m[2][j] + (i == 3 ? matrix.m[3][j] : 0.0f);
+		}
+	}
+#endif
+	return multiply;
 }
 
-Matrix4x4 MakeAffineMatrix(Vector3 scale, Vector3 rotate, Vector3 translate) {
-	Matrix4x4 affineMatrix;
-	Matrix4x4 rotateMatrix = MakeRotateXYZMatrix(rotate);
-	affineMatrix.m[0][0] = scale.x * rotateMatrix.m[0][0];
-	affineMatrix.m[1][0] = scale.y * rotateMatrix.m[1][0];
-	affineMatrix.m[2][0] = scale.z * rotateMatrix.m[2][0];
-	affineMatrix.m[3][0] = translate.x;
-
-	affineMatrix.m[0][1] = scale.x * rotateMatrix.m[0][1];
-	affineMatrix.m[1][1] = scale.y * rotateMatrix.m[1][1];
-	affineMatrix.m[2][1] = scale.z * rotateMatrix.m[2][1];
-	affineMatrix.m[3][1] = translate.y;
-
-	affineMatrix.m[0][2] = scale.x * rotateMatrix.m[0][2];
-	affineMatrix.m[1][2] = scale.y * rotateMatrix.m[1][2];
-	affineMatrix.m[2][2] = scale.z * rotateMatrix.m[2][2];
-	affineMatrix.m[3][2] = translate.z;
-
-	affineMatrix.m[0][3] = 0.0f;
-	affineMatrix.m[1][3] = 0.0f;
-	affineMatrix.m[2][3] = scale.z * rotateMatrix.m[2][3];
-	affineMatrix.m[3][3] = 1.0f;
-	return affineMatrix;
+Matrix4x4 ToMatrix4x4(const AffineTransform& transform) {
+	Matrix4x4 matrix;
+	matrix.m[0][0] = transform.axisX.x;
+	matrix.m[0][1] = transform.axisX.y;
+	matrix.m[0][2] = transform.axisX.z;
+	matrix.m[0][3] = 0.0f;
+	matrix.m[1][0] = transform.axisY.x;
+	matrix.m[1][1] = transform.axisY.y;
+	matrix.m[1][2] = transform.axisY.z;
+	matrix.m[1][3] = 0.0f;
+	matrix.m[2][0] = transform.axisZ.x;
+	matrix.m[2][1] = transform.axisZ.y;
+	matrix.m[2][2] = transform.axisZ.z;
+	matrix.m[2][3] = 0.0f;
+	matrix.m[3][0] = transform.translate.x;
+	matrix.m[3][1] = transform.translate.y;
+	matrix.m[3][2] = transform.translate.z;
+	matrix.m[3][3] = 1.0f;
+	return matrix;
 }
 Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix) {
 	Vector3 result{};
 
+#if ENGINE_USE_SSE
+	// 各行にベクトルの成分を掛けて足し、xyzwをまとめて求める
+	__m128 sum = _mm_loadu_ps(matrix.m[3]);
+	sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(vector.x), _mm_loadu_ps(matrix.m[0])));
+	sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(vector.y), _mm_loadu_ps(matrix.m[1])));
+	sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(vector.z), _mm_loadu_ps(matrix.m[2])));
+	alignas(16) float values[4];
+	_mm_store_ps(values, sum);
+	result = {values[0], values[1], values[2]};
+	float w = values[3];
+#else
 	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + 1.0f * matrix.m[3][0];
 	result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] + 1.0f * matrix.m[3][1];
 	result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] + 1.0f * matrix.m[3][2];
 	float w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] + 1.0f * matrix.m[3][3];
+#endif
 
 	// wが0の場合の処理
 	if (w != 0.0f) {
@@ -258,6 +432,37 @@ Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix) {
 	}
 	return result;
 }
+AABB TransformAABB(const AABB& aabb, const Matrix4x4& matrix) {
+	// 行ベクトルに掛けるので、変換後の軸jの大きさは各軸の大きさ * |m[i][j]| の和になる
+	Vector3 center = GetCenter(aabb);
+	Vector3 extent = GetExtent(aabb);
+	const float* c = &center.x;
+	const float* e = &extent.x;
+	float newCenter[3];
+	float newExtent[3];
+	for (int j = 0; j < 3; j++) {
+		newCenter[j] = matrix.m[3][j];
+		newExtent[j] = 0.0f;
+		for (int i = 0; i < 3; i++) {
+			newCenter[j] += c[i] * matrix.m[i][j];
+			newExtent[j] += e[i] * std::fabs(matrix.m[i][j]);
+		}
+	}
+	return {{newCenter[0] - newExtent[0], newCenter[1] - newExtent[1], newCenter[2] - newExtent[2]}, {newCenter[0] + newExtent[0], newCenter[1] + newExtent[1], newCenter[2] + newExtent[2]}};
+}
+Sphere TransformSphere(const Sphere& sphere, const Matrix4x4& matrix) {
+	// 各軸の拡大率は行の長さ
+	float maxSquaredScale = 0.0f;
+	for (int i = 0; i < 3; i++) {
+		float squaredScale = matrix.m[i][0] * matrix.m[i][0] + matrix.m[i][1] * matrix.m[i][1] + matrix.m[i][2] * matrix.m[i][2];
+		maxSquaredScale = squaredScale > maxSquaredScale ? squaredScale : maxSquaredScale;
+	}
+	Vector3 center = {
+	    sphere.center.x * matrix.m[0][0] + sphere.center.y * matrix.m[1][0] + sphere.center.z * matrix.m[2][0] + matrix.m[3][0],
+	    sphere.center.x * matrix.m[0][1] + sphere.center.y * matrix.m[1][1] + sphere.center.z * matrix.m[2][1] + matrix.m[3][1],
+	    sphere.center.x * matrix.m[0][2] + sphere.center.y * matrix.m[1][2] + sphere.center.z * matrix.m[2][2] + matrix.m[3][2]};
+	return {center, sphere.radius * std::sqrt(maxSquaredScale)};
+}
 
 Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float zFar, float zNear) {
 	Matrix4x4 orthographicMatrix = {0};
@@ -1,4 +1,5 @@
 #pragma once
+#include"Bounds.h"
 #include"Vector3.h"
 /// <summary>
 /// 4x4の行列
@@ -17,6 +18,16 @@ struct Transforms {
 	Vector3 translate; // 平行移動
 };
 
+/// <summary>
+/// 4列目が(0, 0, 0, 1)の行列(アフィン変換)を、4列目を省いて持つ
+/// </summary>
+struct AffineTransform {
+	Vector3 axisX;     // 変換後のx軸(行列の0行目、拡大縮小を含む)
+	Vector3 axisY;     // 変換後のy軸(行列の1行目)
+	Vector3 axisZ;     // 変換後のz軸(行列の2行目)
+	Vector3 translate; // 平行移動(行列の3行目)
+};
+
 // 行列の加法
 Matrix4x4 Add(const Matrix4x4& m1, const Matrix4x4& m2);
 Matrix4x4 operator+(const Matrix4x4& m1, const Matrix4x4& m2);
@@ -32,6 +43,8 @@ Vector3 operator*(const Matrix4x4& m, const Vector3& v);
 
 // 逆行列
 Matrix4x4 Inverse(const Matrix4x4& m);
+// アフィン変換の逆行列(4列目が(0, 0, 0, 1)の行列のみ。Inverseより速い)
+Matrix4x4 InverseAffine(const Matrix4x4& m);
 // 転置行列
 Matrix4x4 Transpose(const Matrix4x4& m);
 // 単位行列の作成
@@ -52,9 +65,30 @@ Matrix4x4 MakeRotateZMatrix(float radiun);
 Matrix4x4 MakeRotateXYZMatrix(Vector3 radiun);
 // アフィン変換
 Matrix4x4 MakeAffineMatrix(Vector3 scale, Vector3 rotate, Vector3 translate);
+/// <summary>
+/// SRTからアフィン変換を作る(MakeAffineMatrixと同じ変換を、回転行列を掛け合わせずにsinとcosから直接組み立てる)
+/// </summary>
+AffineTransform MakeAffineTransform(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
+// 回転と平行移動だけのアフィン変換の逆変換(回転を転置し、平行移動を逆向きに回す。拡大縮小を含む場合はInverseAffineを使う)
+AffineTransform InverseRigid(const AffineTransform& transform);
+// アフィン変換の積(transform1の後にtransform2で変換する)
+AffineTransform Multiply(const AffineTransform& transform1, const AffineTransform& transform2);
+// アフィン変換と行列の積(ワールド変換にビュープロジェクション行列を掛けるときなど)
+Matrix4x4 Multiply(const AffineTransform& transform, const Matrix4x4& matrix);
+// 4x4の行列に直す
+Matrix4x4 ToMatrix4x4(const AffineTransform& transform);
 // 座標変換
 Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix);
 /// <summary>
+/// AABBを変換したものを囲むAABBを求める
+/// 8つの角を変換せずに、中心を変換し、各軸の大きさを行列の成分の絶対値で変換する(アフィン変換のみ)
+/// </summary>
+AABB TransformAABB(const AABB& aabb, const Matrix4x4& matrix);
+/// <summary>
+/// 球を変換したものを囲む球を求める(半径は一番大きい軸の拡大率で拡大する。アフィン変換のみ)
+/// </summary>
+Sphere TransformSphere(const Sphere& sphere, const Matrix4x4& matrix);
+/// <summary>
 /// 正射影行列を作る関数
 /// </summary>
 /// <param name="left">左端</param>
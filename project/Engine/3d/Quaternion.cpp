@@ -0,0 +1,162 @@
+#include "Quaternion.h"
+#include <cmath>
+
+namespace {
+
+// これより内積が大きい(近い)回転どうしは、Slerpでも線形補間で十分な精度になる
+const float kSlerpLinearThreshold = 0.9995f;
+
+/// <summary>
+/// ハミルトン積 a * b (ベクトルを q v q* で回すとき、bで回した後にaで回す)
+/// </summary>
+Quaternion HamiltonProduct(const Quaternion& a, const Quaternion& b) {
+	return {
+	    a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+	    a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+	    a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+	    a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+	};
+}
+
+} // namespace
+
+Quaternion MakeIdentityQuaternion() { return {0.0f, 0.0f, 0.0f, 1.0f}; }
+
+Quaternion Multiply(const Quaternion& q1, const Quaternion& q2) { return HamiltonProduct(q2, q1); }
+
+Quaternion Conjugate(const Quaternion& quaternion) { return {-quaternion.x, -quaternion.y, -quaternion.z, quaternion.w}; }
+
+Quaternion Inverse(const Quaternion& quaternion) {
+	float squaredLength = Dot(quaternion, quaternion);
+	if (squaredLength == 0.0f) {
+		return quaternion;
+	}
+	float inverseSquaredLength = 1.0f / squaredLength;
+	return {-quaternion.x * inverseSquaredLength, -quaternion.y * inverseSquaredLength, -quaternion.z * inverseSquaredLength, quaternion.w * inverseSquaredLength};
+}
+
+float Dot(const Quaternion& q1, const Quaternion& q2) { return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w; }
+
+float Length(const Quaternion& quaternion) { return std::sqrt(Dot(quaternion, quaternion)); }
+
+Quaternion Normalize(const Quaternion& quaternion) {
+	float length = Length(quaternion);
+	if (length == 0.0f) {
+		return MakeIdentityQuaternion();
+	}
+	float inverseLength = 1.0f / length;
+	return {quaternion.x * inverseLength, quaternion.y * inverseLength, quaternion.z * inverseLength, quaternion.w * inverseLength};
+}
+
+Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle) {
+	float sinHalf = std::sin(angle * 0.5f);
+	return {axis.x * sinHalf, axis.y * sinHalf, axis.z * sinHalf, std::cos(angle * 0.5f)};
+}
+
+Quaternion MakeRotateXYZQuaternion(const Vector3& rotate) {
+	float sinX = std::sin(rotate.x * 0.5f);
+	float cosX = std::cos(rotate.x * 0.5f);
+	float sinY = std::sin(rotate.y * 0.5f);
+	float cosY = std::cos(rotate.y * 0.5f);
+	float sinZ = std::sin(rotate.z * 0.5f);
+	float cosZ = std::cos(rotate.z * 0.5f);
+
+	// X軸, Y軸, Z軸の順に回すクォータニオンの積を展開したもの
+	return {
+	    cosZ * cosY * sinX - sinZ * cosX * sinY,
+	    cosZ * cosX * sinY + sinZ * cosY * sinX,
+	    sinZ * cosX * cosY - cosZ * sinX * sinY,
+	    cosZ * cosX * cosY + sinZ * sinX * sinY,
+	};
+}
+
+Vector3 RotateVector(const Vector3& vector, const Quaternion& quaternion) {
+	// v' = v + 2w(u x v) + 2u x (u x v) (uは虚部)
+	Vector3 u = {quaternion.x, quaternion.y, quaternion.z};
+	Vector3 t = 2.0f * Cross(u, vector);
+	return vector + quaternion.w * t + Cross(u, t);
+}
+
+Matrix4x4 MakeRotateMatrix(const Quaternion& quaternion) {
+	AffineTransform rotate = MakeAffineTransform({1.0f, 1.0f, 1.0f}, quaternion, {0.0f, 0.0f, 0.0f});
+	return ToMatrix4x4(rotate);
+}
+
+Quaternion MakeQuaternionFromMatrix(const Matrix4x4& matrix) {
+	const auto& m = matrix.m;
+	float trace = m[0][0] + m[1][1] + m[2][2];
+	// 0で割らないように、一番大きい成分から求める
+	if (trace > 0.0f) {
+		float s = 0.5f / std::sqrt(trace + 1.0f);
+		return {(m[1][2] - m[2][1]) * s, (m[2][0] - m[0][2]) * s, (m[0][1] - m[1][0]) * s, 0.25f / s};
+	}
+	if (m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+		float s = 2.0f * std::sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]);
+		return {0.25f * s, (m[1][0] + m[0][1]) / s, (m[2][0] + m[0][2]) / s, (m[1][2] - m[2][1]) / s};
+	}
+	if (m[1][1] > m[2][2]) {
+		float s = 2.0f * std::sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]);
+		return {(m[1][0] + m[0][1]) / s, 0.25f * s, (m[2][1] + m[1][2]) / s, (m[2][0] - m[0][2]) / s};
+	}
+	float s = 2.0f * std::sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]);
+	return {(m[2][0] + m[0][2]) / s, (m[2][1] + m[1][2]) / s, 0.25f * s, (m[0][1] - m[1][0]) / s};
+}
+
+Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, float t) {
+	Quaternion end = q1;
+	float dot = Dot(q0, q1);
+	if (dot < 0.0f) {
+		end = {-q1.x, -q1.y, -q1.z, -q1.w};
+		dot = -dot;
+	}
+	if (dot > kSlerpLinearThreshold) {
+		return Nlerp(q0, end, t);
+	}
+	float theta = std::acos(dot);
+	float inverseSin = 1.0f / std::sin(theta);
+	float scale0 = std::sin((1.0f - t) * theta) * inverseSin;
+	float scale1 = std::sin(t * theta) * inverseSin;
+	return {scale0 * q0.x + scale1 * end.x, scale0 * q0.y + scale1 * end.y, scale0 * q0.z + scale1 * end.z, scale0 * q0.w + scale1 * end.w};
+}
+
+Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, float t) {
+	float scale1 = Dot(q0, q1) < 0.0f ? -t : t;
+	float scale0 = 1.0f - t;
+	return Normalize({scale0 * q0.x + scale1 * q1.x, scale0 * q0.y + scale1 * q1.y, scale0 * q0.z + scale1 * q1.z, scale0 * q0.w + scale1 * q1.w});
+}
+
+void DecomposeSwingTwist(const Quaternion& quaternion, const Vector3& twistAxis, Quaternion& swing, Quaternion& twist) {
+	// 虚部を軸に射影したものがひねり。軸と直交する180度回転ではひねりは決まらないので回さない
+	Vector3 projection = Dot({quaternion.x, quaternion.y, quaternion.z}, twistAxis) * twistAxis;
+	twist = {projection.x, projection.y, projection.z, quaternion.w};
+	if (Dot(twist, twist) == 0.0f) {
+		twist = MakeIdentityQuaternion();
+	} else {
+		twist = Normalize(twist);
+	}
+	swing = Multiply(Conjugate(twist), quaternion);
+}
+
+AffineTransform MakeAffineTransform(const Vector3& scale, const Quaternion& rotate, const Vector3& translate) {
+	float x2 = rotate.x * 2.0f;
+	float y2 = rotate.y * 2.0f;
+	float z2 = rotate.z * 2.0f;
+	float xx = rotate.x * x2;
+	float yy = rotate.y * y2;
+	float zz = rotate.z * z2;
+	float xy = rotate.x * y2;
+	float xz = rotate.x * z2;
+	float yz = rotate.y * z2;
+	float wx = rotate.w * x2;
+	float wy = rotate.w * y2;
+	float wz = rotate.w * z2;
+
+	AffineTransform transform;
+	transform.axisX = {scale.x * (1.0f - yy - zz), scale.x * (xy + wz), scale.x * (xz - wy)};
+	transform.axisY = {scale.y * (xy - wz), scale.y * (1.0f - xx - zz), scale.y * (yz + wx)};
+	transform.axisZ = {scale.z * (xz + wy), scale.z * (yz - wx), scale.z * (1.0f - xx - yy)};
+	transform.translate = translate;
+	return transform;
+}
+
+Matrix4x4 MakeAffineMatrix(const QuaternionTransforms& transforms) { return ToMatrix4x4(MakeAffineTransform(transforms.scale, transforms.rotate, transforms.translate)); }
@@ -0,0 +1,76 @@
+#pragma once
+#include "Matrix.h"
+#include "Vector3.h"
+
+/// <summary>
+/// 回転を表すクォータニオン(x, y, zが虚部、wが実部)
+/// </summary>
+struct Quaternion {
+	float x, y, z, w;
+};
+
+/// <summary>
+/// 回転をクォータニオンで持つSRT
+/// </summary>
+struct QuaternionTransforms {
+	Vector3 scale;     // 拡大縮小
+	Quaternion rotate; // 回転(単位クォータニオン)
+	Vector3 translate; // 平行移動
+};
+
+// 回転しないクォータニオン
+Quaternion MakeIdentityQuaternion();
+/// <summary>
+/// クォータニオンの積。行列のMultiplyと同じく、q1で回転した後にq2で回転するクォータニオンを返す
+/// 単位クォータニオンどうしの積は単位クォータニオンになる(誤差が溜まる場合はNormalizeする)
+/// </summary>
+Quaternion Multiply(const Quaternion& q1, const Quaternion& q2);
+// 共役(単位クォータニオンでは逆回転)
+Quaternion Conjugate(const Quaternion& quaternion);
+// 逆クォータニオン
+Quaternion Inverse(const Quaternion& quaternion);
+// 内積
+float Dot(const Quaternion& q1, const Quaternion& q2);
+// 長さ
+float Length(const Quaternion& quaternion);
+// 正規化
+Quaternion Normalize(const Quaternion& quaternion);
+
+// 任意軸回転(axisは単位ベクトル)
+Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle);
+/// <summary>
+/// オイラー角からクォータニオンを作る(MakeRotateXYZMatrixと同じ、X, Y, Zの順の回転)
+/// </summary>
+Quaternion MakeRotateXYZQuaternion(const Vector3& rotate);
+// ベクトルを回転する(Transform(vector, MakeRotateMatrix(quaternion))と同じ)
+Vector3 RotateVector(const Vector3& vector, const Quaternion& quaternion);
+// 回転行列を作る
+Matrix4x4 MakeRotateMatrix(const Quaternion& quaternion);
+/// <summary>
+/// 回転行列からクォータニオンを作る(左上3x3が拡大縮小を含まない回転行列であること)
+/// </summary>
+Quaternion MakeQuaternionFromMatrix(const Matrix4x4& matrix);
+
+/// <summary>
+/// 球面線形補間。角速度が一定になる(近い回転どうしではNlerpに切り替える)
+/// 回り道をしないように、内積が負なら片方を反転してから補間する
+/// </summary>
+Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, float t);
+/// <summary>
+/// 線形補間して正規化する。Slerpより速いが、角速度は一定にならない(アニメーションのブレンド向け)
+/// </summary>
+Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, float t);
+
+/// <summary>
+/// 回転を、twistAxis周りのひねり(twist)とそれ以外の振り(swing)に分ける
+/// twistで回転した後にswingで回転すると元の回転になる(Multiply(twist, swing) == quaternion)
+/// </summary>
+/// <param name="quaternion">分ける回転</param>
+/// <param name="twistAxis">ひねりの軸(単位ベクトル)</param>
+/// <param name="swing">振り</param>
+/// <param name="twist">ひねり</param>
+void DecomposeSwingTwist(const Quaternion& quaternion, const Vector3& twistAxis, Quaternion& swing, Quaternion& twist);
+
+// クォータニオンの回転でアフィン変換を作る
+AffineTransform MakeAffineTransform(const Vector3& scale, const Quaternion& rotate, const Vector3& translate);
+Matrix4x4 MakeAffineMatrix(const QuaternionTransforms& transforms);
@@ -0,0 +1,51 @@
+#pragma once
+
+// SSEで計算するか(x64やSSE2が有効な環境では使う。0を定義するとスカラーの実装になる)
+#ifndef ENGINE_USE_SSE
+#if defined(_M_X64) || defined(__SSE2__)
+#define ENGINE_USE_SSE 1
+#else
+#define ENGINE_USE_SSE 0
+#endif
+#endif
+
+#if ENGINE_USE_SSE
+#include <emmintrin.h>
+
+/// <summary>
+/// 4つの角度のsinとcosをまとめて求める(|x| < 8192の範囲で誤差は1e-7程度)
+/// π/4ごとの区間に畳んでから多項式で近似する
+/// </summary>
+inline void SinCos(__m128 x, __m128& sin, __m128& cos) {
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(int(0x80000000)));
+	__m128 sinSign = _mm_and_ps(x, signMask);
+	x = _mm_andnot_ps(signMask, x);
+
+	// 区間の番号jを偶数に丸め、x - j * π/4 を3つに分けた定数で精度を落とさずに求める
+	__m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+	j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+	__m128 y = _mm_cvtepi32_ps(j);
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(0.78515625f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(2.4187564849853515625e-4f)));
+	x = _mm_sub_ps(x, _mm_mul_ps(y, _mm_set1_ps(3.77489497744594108e-8f)));
+
+	// 区間によって符号とsin/cosの多項式を入れ替える
+	sinSign = _mm_xor_ps(sinSign, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(4)), 29)));
+	__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, _mm_set1_epi32(2)), _mm_set1_epi32(4)), 29));
+	__m128 useSinPolynomial = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+
+	__m128 z = _mm_mul_ps(x, x);
+	__m128 cosPolynomial = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), z), _mm_set1_ps(-1.388731625493765e-3f));
+	cosPolynomial = _mm_add_ps(_mm_mul_ps(cosPolynomial, z), _mm_set1_ps(4.166664568298827e-2f));
+	cosPolynomial = _mm_mul_ps(_mm_mul_ps(cosPolynomial, z), z);
+	cosPolynomial = _mm_add_ps(_mm_sub_ps(cosPolynomial, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+	__m128 sinPolynomial = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), z), _mm_set1_ps(8.3321608736e-3f));
+	sinPolynomial = _mm_add_ps(_mm_mul_ps(sinPolynomial, z), _mm_set1_ps(-1.6666654611e-1f));
+	sinPolynomial = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sinPolynomial, z), x), x);
+
+	sin = _mm_or_ps(_mm_and_ps(useSinPolynomial, sinPolynomial), _mm_andnot_ps(useSinPolynomial, cosPolynomial));
+	cos = _mm_or_ps(_mm_and_ps(useSinPolynomial, cosPolynomial), _mm_andnot_ps(useSinPolynomial, sinPolynomial));
+	sin = _mm_xor_ps(sin, sinSign);
+	cos = _mm_xor_ps(cos, cosSign);
+}
+#endif
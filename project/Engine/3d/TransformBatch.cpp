@@ -0,0 +1,160 @@
+#include "TransformBatch.h"
+#include "Simd.h"
+#include <cmath>
+
+namespace {
+
+#if ENGINE_USE_SSE
+// SSEで一度に処理する要素数
+const size_t kLaneCount = 4;
+
+/// <summary>
+/// 4つのSRTからアフィン変換行列を作り、先頭からcount個をresultsに書き込む
+/// </summary>
+void MakeAffineMatrices4(const __m128 scale[3], const __m128 rotate[3], const __m128 translate[3], size_t count, Matrix4x4* results) {
+	__m128 sinX, cosX, sinY, cosY, sinZ, cosZ;
+	SinCos(rotate[0], sinX, cosX);
+	SinCos(rotate[1], sinY, cosY);
+	SinCos(rotate[2], sinZ, cosZ);
+
+	// MakeRotateXYZMatrix(X * Y * Z)を展開したもの
+	__m128 sinXsinY = _mm_mul_ps(sinX, sinY);
+	__m128 cosXsinY = _mm_mul_ps(cosX, sinY);
+	__m128 rows[3][4];
+	rows[0][0] = _mm_mul_ps(cosY, cosZ);
+	rows[0][1] = _mm_mul_ps(cosY, sinZ);
+	rows[0][2] = _mm_sub_ps(_mm_setzero_ps(), sinY);
+	rows[1][0] = _mm_sub_ps(_mm_mul_ps(sinXsinY, cosZ), _mm_mul_ps(cosX, sinZ));
+	rows[1][1] = _mm_add_ps(_mm_mul_ps(cosX, cosZ), _mm_mul_ps(sinXsinY, sinZ));
+	rows[1][2] = _mm_mul_ps(sinX, cosY);
+	rows[2][0] = _mm_add_ps(_mm_mul_ps(cosXsinY, cosZ), _mm_mul_ps(sinX, sinZ));
+	rows[2][1] = _mm_sub_ps(_mm_mul_ps(cosXsinY, sinZ), _mm_mul_ps(sinX, cosZ));
+	rows[2][2] = _mm_mul_ps(cosX, cosY);
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			rows[i][j] = _mm_mul_ps(rows[i][j], scale[i]);
+		}
+		rows[i][3] = _mm_setzero_ps();
+	}
+
+	// 成分ごとに4物体分並んでいるものを、物体ごとの行に並べ替える
+	__m128 translateRows[4] = {translate[0], translate[1], translate[2], _mm_set1_ps(1.0f)};
+	_MM_TRANSPOSE4_PS(rows[0][0], rows[0][1], rows[0][2], rows[0][3]);
+	_MM_TRANSPOSE4_PS(rows[1][0], rows[1][1], rows[1][2], rows[1][3]);
+	_MM_TRANSPOSE4_PS(rows[2][0], rows[2][1], rows[2][2], rows[2][3]);
+	_MM_TRANSPOSE4_PS(translateRows[0], translateRows[1], translateRows[2], translateRows[3]);
+	for (size_t k = 0; k < count; k++) {
+		_mm_storeu_ps(results[k].m[0], rows[0][k]);
+		_mm_storeu_ps(results[k].m[1], rows[1][k]);
+		_mm_storeu_ps(results[k].m[2], rows[2][k]);
+		_mm_storeu_ps(results[k].m[3], translateRows[k]);
+	}
+}
+#endif
+
+} // namespace
+
+void TransformPoints(const float* x, const float* y, const float* z, size_t count, const Matrix4x4& matrix, float* resultX, float* resultY, float* resultZ) {
+	const bool isAffine = matrix.m[0][3] == 0.0f && matrix.m[1][3] == 0.0f && matrix.m[2][3] == 0.0f && matrix.m[3][3] == 1.0f;
+	size_t i = 0;
+#if ENGINE_USE_SSE
+	__m128 m[4][4];
+	for (int row = 0; row < 4; row++) {
+		for (int column = 0; column < 4; column++) {
+			m[row][column] = _mm_set1_ps(matrix.m[row][column]);
+		}
+	}
+	for (; i + kLaneCount <= count; i += kLaneCount) {
+		__m128 px = _mm_loadu_ps(x + i);
+		__m128 py = _mm_loadu_ps(y + i);
+		__m128 pz = _mm_loadu_ps(z + i);
+		__m128 result[4];
+		for (int column = 0; column < (isAffine ? 3 : 4); column++) {
+			result[column] = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, m[0][column]), _mm_mul_ps(py, m[1][column])), _mm_mul_ps(pz, m[2][column])), m[3][column]);
+		}
+		if (!isAffine) {
+			// Transformと同じく、wが0の点は原点にする
+			__m128 isValid = _mm_cmpneq_ps(result[3], _mm_setzero_ps());
+			for (int column = 0; column < 3; column++) {
+				result[column] = _mm_and_ps(_mm_div_ps(result[column], result[3]), isValid);
+			}
+		}
+		_mm_storeu_ps(resultX + i, result[0]);
+		_mm_storeu_ps(resultY + i, result[1]);
+		_mm_storeu_ps(resultZ + i, result[2]);
+	}
+#endif
+	for (; i < count; i++) {
+		float px = x[i];
+		float py = y[i];
+		float pz = z[i];
+		float result[4];
+		for (int column = 0; column < 4; column++) {
+			result[column] = px * matrix.m[0][column] + py * matrix.m[1][column] + pz * matrix.m[2][column] + matrix.m[3][column];
+		}
+		if (!isAffine) {
+			for (int column = 0; column < 3; column++) {
+				result[column] = result[3] != 0.0f ? result[column] / result[3] : 0.0f;
+			}
+		}
+		resultX[i] = result[0];
+		resultY[i] = result[1];
+		resultZ[i] = result[2];
+	}
+}
+
+void MultiplyMatrices(const Matrix4x4* matrices, size_t count, const Matrix4x4& right, Matrix4x4* results) {
+#if ENGINE_USE_SSE
+	// 右の行列の行は全ての行列で共通なので1度だけ読む
+	__m128 row0 = _mm_loadu_ps(right.m[0]);
+	__m128 row1 = _mm_loadu_ps(right.m[1]);
+	__m128 row2 = _mm_loadu_ps(right.m[2]);
+	__m128 row3 = _mm_loadu_ps(right.m[3]);
+	for (size_t n = 0; n < count; n++) {
+		// 結果の行iは左の行列の行iだけで決まるので、同じ配列に書き込んでもよい
+		for (int i = 0; i < 4; i++) {
+			__m128 left = _mm_loadu_ps(matrices[n].m[i]);
+			__m128 result = _mm_mul_ps(_mm_shuffle_ps(left, left, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(left, left, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(left, left, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_shuffle_ps(left, left, _MM_SHUFFLE(3, 3, 3, 3)), row3));
+			_mm_storeu_ps(results[n].m[i], result);
+		}
+	}
+#else
+	for (size_t n = 0; n < count; n++) {
+		results[n] = Multiply(matrices[n], right);
+	}
+#endif
+}
+
+void MakeAffineMatrices(const TransformArrays& transforms, size_t count, Matrix4x4* results) {
+#if ENGINE_USE_SSE
+	const float* const sources[9] = {transforms.scaleX,  transforms.scaleY,     transforms.scaleZ,     transforms.rotateX,   transforms.rotateY,
+	                                 transforms.rotateZ, transforms.translateX, transforms.translateY, transforms.translateZ};
+	__m128 values[9];
+	size_t i = 0;
+	for (; i + kLaneCount <= count; i += kLaneCount) {
+		for (int k = 0; k < 9; k++) {
+			values[k] = _mm_loadu_ps(sources[k] + i);
+		}
+		MakeAffineMatrices4(values, values + 3, values + 6, kLaneCount, results + i);
+	}
+	if (i < count) {
+		// 端数は4要素に詰め直して同じ計算をする(位置によって結果が変わらないように)
+		alignas(16) float padded[9][kLaneCount] = {};
+		for (int k = 0; k < 9; k++) {
+			for (size_t lane = 0; lane < count - i; lane++) {
+				padded[k][lane] = sources[k][i + lane];
+			}
+			values[k] = _mm_load_ps(padded[k]);
+		}
+		MakeAffineMatrices4(values, values + 3, values + 6, count - i, results + i);
+	}
+#else
+	for (size_t i = 0; i < count; i++) {
+		results[i] = MakeAffineMatrix({transforms.scaleX[i], transforms.scaleY[i], transforms.scaleZ[i]}, {transforms.rotateX[i], transforms.rotateY[i], transforms.rotateZ[i]},
+		                              {transforms.translateX[i], transforms.translateY[i], transforms.translateZ[i]});
+	}
+#endif
+}
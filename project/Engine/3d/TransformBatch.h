@@ -0,0 +1,50 @@
+#pragma once
+#include "Matrix.h"
+#include <cstddef>
+
+/// <summary>
+/// 成分ごとの配列(SoA)で並べたSRT。i番目の要素がi番目の物体のSRT
+/// </summary>
+struct TransformArrays {
+	const float* scaleX;
+	const float* scaleY;
+	const float* scaleZ;
+	const float* rotateX;
+	const float* rotateY;
+	const float* rotateZ;
+	const float* translateX;
+	const float* translateY;
+	const float* translateZ;
+};
+
+/// <summary>
+/// 成分ごとの配列で並べた点をまとめて座標変換する(Transformと同じくwで割る。出力は入力と同じ配列でもよい)
+/// 行列の4列目が(0, 0, 0, 1)ならwでの割り算を省く
+/// </summary>
+/// <param name="x">入力のx成分</param>
+/// <param name="y">入力のy成分</param>
+/// <param name="z">入力のz成分</param>
+/// <param name="count">点の数</param>
+/// <param name="matrix">変換行列</param>
+/// <param name="resultX">出力のx成分</param>
+/// <param name="resultY">出力のy成分</param>
+/// <param name="resultZ">出力のz成分</param>
+void TransformPoints(const float* x, const float* y, const float* z, size_t count, const Matrix4x4& matrix, float* resultX, float* resultY, float* resultZ);
+
+/// <summary>
+/// 複数の行列に同じ行列を右から掛ける(ワールド行列にビュープロジェクション行列を掛けてWVPを作るときなど)
+/// </summary>
+/// <param name="matrices">左から掛ける行列</param>
+/// <param name="count">行列の数</param>
+/// <param name="right">右から掛ける行列</param>
+/// <param name="results">matrices[i] * right(matricesと同じ配列でもよい)</param>
+void MultiplyMatrices(const Matrix4x4* matrices, size_t count, const Matrix4x4& right, Matrix4x4* results);
+
+/// <summary>
+/// 複数のSRTからアフィン変換行列をまとめて作る(MakeAffineMatrixと同じ行列になる)
+/// SSEが使えれば4つずつsinとcosを求めて組み立てる(SinCosの精度が保てるのは回転角が|x| < 8192の範囲)
+/// </summary>
+/// <param name="transforms">SRTの配列</param>
+/// <param name="count">物体の数</param>
+/// <param name="results">ワールド行列</param>
+void MakeAffineMatrices(const TransformArrays& transforms, size_t count, Matrix4x4* results);
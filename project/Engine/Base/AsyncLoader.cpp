@@ -0,0 +1,98 @@
+#include "AsyncLoader.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+// 完了キューの長さ(満杯のときはワーカースレッドが空くまで待つ)
+const size_t kCompletedQueueCapacity = 1024;
+
+} // namespace
+
+AsyncLoader::AsyncLoader(uint32_t threadCount) : completedJobs(kCompletedQueueCapacity) {
+	if (threadCount == 0) {
+		// メインスレッドの分を残す
+		threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	}
+	states.push_back(AssetState::Invalid);
+	workers.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; i++) {
+		workers.emplace_back(&AsyncLoader::WorkerMain, this);
+	}
+}
+
+AsyncLoader::~AsyncLoader() {
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		isStopping = true;
+		jobs.clear();
+	}
+	jobCondition.notify_all();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+AssetHandle AsyncLoader::Enqueue(std::function<void()> load, std::function<void(AssetHandle)> onReady) {
+	AssetHandle handle = AssetHandle(states.size());
+	states.push_back(AssetState::Pending);
+	pendingCount++;
+	{
+		std::lock_guard<std::mutex> lock(jobMutex);
+		jobs.push_back({handle, std::move(load), std::move(onReady)});
+	}
+	jobCondition.notify_one();
+	return handle;
+}
+
+void AsyncLoader::WorkerMain() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			jobCondition.wait(lock, [this] { return isStopping || !jobs.empty(); });
+			if (isStopping) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job.load();
+		// 読み込み結果はonReadyが持っているので、loadは先に解放する
+		job.load = nullptr;
+		while (!completedJobs.TryPush(std::move(job))) {
+			// 終了するときはもう取り出されないので、読み込み結果を捨てて抜ける(待ち続けるとデストラクタのjoinが終わらない)
+			if (isStopping) {
+				return;
+			}
+			std::this_thread::yield();
+		}
+	}
+}
+
+uint32_t AsyncLoader::Update(uint32_t maxCount) {
+	uint32_t count = 0;
+	Job job;
+	while (count < maxCount && completedJobs.TryPop(job)) {
+		job.onReady(job.handle);
+		states[job.handle] = AssetState::Ready;
+		pendingCount--;
+		count++;
+	}
+	return count;
+}
+
+void AsyncLoader::WaitAll() {
+	while (pendingCount > 0) {
+		if (Update() == 0) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+AssetState AsyncLoader::GetState(AssetHandle handle) const {
+	if (handle >= states.size()) {
+		return AssetState::Invalid;
+	}
+	return states[handle];
+}
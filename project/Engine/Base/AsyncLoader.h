@@ -0,0 +1,93 @@
+#pragma once
+#include "LockFreeQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// アセットのハンドル(0は無効)
+using AssetHandle = uint32_t;
+static const AssetHandle kInvalidAssetHandle = 0;
+
+/// <summary>
+/// アセットの読み込み状態
+/// </summary>
+enum class AssetState {
+	Invalid, // 無効なハンドル
+	Pending, // 読み込み中(描画には代わりのものを使う)
+	Ready,   // 読み込みと転送が終わった
+};
+
+/// <summary>
+/// ワーカースレッドでアセットを読み込み、完成したものをフレームループに渡すローダー
+/// Requestはすぐにハンドルを返し、ファイルの読み込みと展開はワーカースレッドで行う
+/// 読み終えたアセットはロックフリーなキューに積まれ、Updateを呼んだスレッドで完了時の処理(GPUへの転送など)を行う
+/// Request, Update, GetStateは同じスレッド(メインスレッド)から呼ぶこと
+/// </summary>
+class AsyncLoader {
+public:
+	/// <param name="threadCount">ワーカースレッド数(0でハードウェアのスレッド数-1、最低1)</param>
+	explicit AsyncLoader(uint32_t threadCount = 0);
+	/// <summary>
+	/// 始まっていない読み込みは取り消し、ワーカースレッドの終了を待つ
+	/// </summary>
+	~AsyncLoader();
+	AsyncLoader(const AsyncLoader&) = delete;
+	AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+	/// <summary>
+	/// 読み込みを依頼する
+	/// </summary>
+	/// <param name="load">ワーカースレッドで実行する読み込み処理</param>
+	/// <param name="onReady">Updateで呼ばれる完了時の処理(読み込み結果を受け取る)</param>
+	/// <returns>アセットのハンドル</returns>
+	template<class T> AssetHandle Request(std::function<T()> load, std::function<void(AssetHandle, T&)> onReady) {
+		auto result = std::make_shared<T>();
+		return Enqueue([result, load = std::move(load)] { *result = load(); }, [result, onReady = std::move(onReady)](AssetHandle handle) { onReady(handle, *result); });
+	}
+
+	/// <summary>
+	/// 読み込みが終わったアセットの完了時の処理を呼ぶ(フレームの先頭で呼ぶ)
+	/// </summary>
+	/// <param name="maxCount">1回で処理する最大数(1フレームの転送量を抑える)</param>
+	/// <returns>処理した数</returns>
+	uint32_t Update(uint32_t maxCount = UINT32_MAX);
+
+	/// <summary>
+	/// 全ての読み込みが終わるまで待ち、完了時の処理を呼ぶ
+	/// </summary>
+	void WaitAll();
+
+	AssetState GetState(AssetHandle handle) const;
+	bool IsReady(AssetHandle handle) const { return GetState(handle) == AssetState::Ready; }
+	uint32_t GetPendingCount() const { return pendingCount; }
+
+private:
+	/// <summary>
+	/// 読み込み1件分
+	/// </summary>
+	struct Job {
+		AssetHandle handle;
+		std::function<void()> load;
+		std::function<void(AssetHandle)> onReady;
+	};
+
+	AssetHandle Enqueue(std::function<void()> load, std::function<void(AssetHandle)> onReady);
+	void WorkerMain();
+
+	std::vector<std::thread> workers;
+	// ワーカースレッドへの依頼(待機できるように条件変数で守る)
+	std::mutex jobMutex;
+	std::condition_variable jobCondition;
+	std::deque<Job> jobs;
+	std::atomic<bool> isStopping = false; // 完了キューが空くのを待つワーカースレッドはロックせずに読む
+	// 読み終えた依頼(ワーカースレッドからメインスレッドへ)
+	LockFreeQueue<Job> completedJobs;
+	std::vector<AssetState> states; // ハンドルごとの状態(0番は無効)
+	uint32_t pendingCount = 0;
+};
@@ -0,0 +1,49 @@
+#include "DescriptorAllocator.h"
+#include <cassert>
+
+DescriptorAllocator::DescriptorAllocator(uint32_t capacity) : allocator(capacity), slots(capacity) {}
+
+DescriptorHandle DescriptorAllocator::Allocate(uint32_t count) {
+	assert(count > 0);
+	TlsfAllocation allocation{};
+	if (!allocator.Allocate(count, 1, allocation)) {
+		return {};
+	}
+	Slot& slot = slots[allocation.offset];
+	slot.count = count;
+	slot.block = allocation.block;
+	slot.isAllocated = true;
+	return {uint32_t(allocation.offset), slot.generation};
+}
+
+void DescriptorAllocator::Free(DescriptorHandle handle, uint64_t fenceValue) {
+	assert(IsValid(handle));
+	assert(pendingFrees.empty() || pendingFrees.back().fenceValue <= fenceValue);
+	// 世代を進めて、このハンドルをすぐに無効にする
+	Slot& slot = slots[handle.index];
+	slot.isAllocated = false;
+	slot.generation++;
+	pendingFrees.push_back({{handle.index, slot.count, slot.block}, fenceValue});
+	pendingCount += slot.count;
+}
+
+void DescriptorAllocator::ReleaseCompleted(uint64_t completedFenceValue) {
+	// フェンスの値は積んだ順に大きくなるので、先頭から終わったものだけを返す
+	while (!pendingFrees.empty() && pendingFrees.front().fenceValue <= completedFenceValue) {
+		pendingCount -= uint32_t(pendingFrees.front().allocation.size);
+		allocator.Free(pendingFrees.front().allocation);
+		pendingFrees.pop_front();
+	}
+}
+
+bool DescriptorAllocator::IsValid(DescriptorHandle handle) const { return handle.index < slots.size() && slots[handle.index].isAllocated && slots[handle.index].generation == handle.generation; }
+
+uint32_t DescriptorAllocator::GetIndex(DescriptorHandle handle) const {
+	assert(IsValid(handle));
+	return handle.index;
+}
+
+uint32_t DescriptorAllocator::GetCount(DescriptorHandle handle) const {
+	assert(IsValid(handle));
+	return slots[handle.index].count;
+}
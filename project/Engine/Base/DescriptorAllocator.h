@@ -0,0 +1,82 @@
+#pragma once
+#include "TlsfAllocator.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/// <summary>
+/// ディスクリプタのハンドル(先頭の番号と世代)
+/// 解放すると世代が変わるので、解放後に使うとIsValidで分かる
+/// </summary>
+struct DescriptorHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+	bool IsNull() const { return index == UINT32_MAX; }
+};
+
+/// <summary>
+/// ディスクリプタヒープの番号を管理するアロケーター
+/// 連続した番号(ディスクリプタテーブル用)もTlsfAllocatorで一定時間で確保する
+/// 解放はフェンスの値と一緒に積んでおき、GPUがその値を過ぎてから番号を使い直す
+/// ヒープそのものには触らないので、デバイスなしで動かせる
+/// </summary>
+class DescriptorAllocator {
+public:
+	/// <param name="capacity">ヒープのディスクリプタの数</param>
+	explicit DescriptorAllocator(uint32_t capacity);
+
+	/// <summary>
+	/// 連続したディスクリプタを確保する
+	/// </summary>
+	/// <param name="count">数</param>
+	/// <returns>ハンドル(空きがなければIsNull)</returns>
+	DescriptorHandle Allocate(uint32_t count = 1);
+
+	/// <summary>
+	/// 解放する。ハンドルはすぐに無効になるが、番号はReleaseCompletedでfenceValueを過ぎるまで使い直さない
+	/// </summary>
+	/// <param name="fenceValue">最後にこのディスクリプタを使うコマンドの後にSignalするフェンスの値(呼ぶたびに同じか大きくすること)</param>
+	void Free(DescriptorHandle handle, uint64_t fenceValue);
+
+	/// <summary>
+	/// GPUが終わったフェンスの値までに解放したものを、使い直せるようにする(フレームの初めに呼ぶ)
+	/// </summary>
+	/// <param name="completedFenceValue">ID3D12Fence::GetCompletedValueの値</param>
+	void ReleaseCompleted(uint64_t completedFenceValue);
+
+	// 確保中のハンドルか(解放後や別の確保に使われた番号ならfalse)
+	bool IsValid(DescriptorHandle handle) const;
+	// ヒープの中の番号
+	uint32_t GetIndex(DescriptorHandle handle) const;
+	// 確保した数
+	uint32_t GetCount(DescriptorHandle handle) const;
+
+	uint32_t GetCapacity() const { return uint32_t(allocator.GetCapacity()); }
+	// 確保中と、解放してGPUを待っているディスクリプタの数
+	uint32_t GetUsedCount() const { return uint32_t(allocator.GetUsedSize()); }
+	uint32_t GetPendingCount() const { return pendingCount; }
+
+private:
+	/// <summary>
+	/// 番号ごとの状態(確保の先頭の番号だけが使う)
+	/// </summary>
+	struct Slot {
+		uint32_t generation = 0;
+		uint32_t count = 0;
+		uint32_t block = 0; // TlsfAllocatorのブロックの番号
+		bool isAllocated = false;
+	};
+
+	/// <summary>
+	/// GPUを待っている解放
+	/// </summary>
+	struct PendingFree {
+		TlsfAllocation allocation;
+		uint64_t fenceValue;
+	};
+
+	TlsfAllocator allocator;
+	std::vector<Slot> slots;
+	std::deque<PendingFree> pendingFrees;
+	uint32_t pendingCount = 0;
+};
@@ -0,0 +1,146 @@
+#include "HeapAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+HeapAllocator::HeapAllocator(uint64_t heapSize, HeapCreator createHeap, HeapReleaser releaseHeap) : heapSize(heapSize), createHeap(std::move(createHeap)), releaseHeap(std::move(releaseHeap)) { assert(heapSize > 0); }
+
+uint32_t HeapAllocator::CreateHeap(uint64_t size) {
+	// 消したヒープの番号があれば使い直す
+	uint32_t heapIndex = 0;
+	while (heapIndex < heaps.size() && heaps[heapIndex].allocator != nullptr) {
+		heapIndex++;
+	}
+	if (!createHeap(heapIndex, size)) {
+		return UINT32_MAX;
+	}
+	if (heapIndex == heaps.size()) {
+		heaps.emplace_back();
+	}
+	heaps[heapIndex].allocator = std::make_unique<TlsfAllocator>(size);
+	heaps[heapIndex].requestedSizes.clear();
+	return heapIndex;
+}
+
+bool HeapAllocator::AllocateFromHeap(uint32_t heapIndex, uint64_t size, uint64_t alignment, uint64_t requested, HeapAllocation& allocation) {
+	Heap& heap = heaps[heapIndex];
+	TlsfAllocation tlsfAllocation{};
+	if (!heap.allocator->Allocate(size, alignment, tlsfAllocation)) {
+		return false;
+	}
+	if (tlsfAllocation.block >= heap.requestedSizes.size()) {
+		heap.requestedSizes.resize(tlsfAllocation.block + 1, 0);
+	}
+	heap.requestedSizes[tlsfAllocation.block] = requested;
+	requestedSize += requested;
+	allocation = {heapIndex, tlsfAllocation.offset, tlsfAllocation.size, requested, tlsfAllocation.block};
+	return true;
+}
+
+bool HeapAllocator::Allocate(uint64_t size, uint64_t alignment, HeapAllocation& allocation, uint64_t requested) {
+	assert(size > 0);
+	if (requested == 0) {
+		requested = size;
+	}
+	assert(requested <= size);
+	// ヒープより大きいものは、それだけのヒープを作る(ヒープの先頭はどの単位にも揃っている)
+	if (size > heapSize) {
+		const uint32_t heapIndex = CreateHeap(size);
+		return heapIndex != UINT32_MAX && AllocateFromHeap(heapIndex, size, alignment, requested, allocation);
+	}
+	// 作った順に入るヒープを探す(入らないヒープはTlsfAllocatorのビットを見るだけで分かる)
+	for (uint32_t heapIndex = 0; heapIndex < heaps.size(); heapIndex++) {
+		if (heaps[heapIndex].allocator != nullptr && heaps[heapIndex].allocator->GetCapacity() == heapSize && AllocateFromHeap(heapIndex, size, alignment, requested, allocation)) {
+			return true;
+		}
+	}
+	const uint32_t heapIndex = CreateHeap(heapSize);
+	return heapIndex != UINT32_MAX && AllocateFromHeap(heapIndex, size, alignment, requested, allocation);
+}
+
+void HeapAllocator::Free(const HeapAllocation& allocation) {
+	assert(allocation.heapIndex < heaps.size() && heaps[allocation.heapIndex].allocator != nullptr);
+	Heap& heap = heaps[allocation.heapIndex];
+	requestedSize -= heap.requestedSizes[allocation.block];
+	heap.allocator->Free({allocation.offset, allocation.size, allocation.block});
+	// 大きいもの専用のヒープは使い直さないので、すぐに消す
+	if (heap.allocator->IsEmpty() && heap.allocator->GetCapacity() != heapSize) {
+		releaseHeap(allocation.heapIndex);
+		heap.allocator.reset();
+	}
+}
+
+void HeapAllocator::ReleaseEmptyHeaps(uint32_t keepCount) {
+	uint32_t keptCount = 0;
+	for (uint32_t heapIndex = 0; heapIndex < heaps.size(); heapIndex++) {
+		Heap& heap = heaps[heapIndex];
+		if (heap.allocator == nullptr || !heap.allocator->IsEmpty()) {
+			continue;
+		}
+		if (heap.allocator->GetCapacity() == heapSize && keptCount < keepCount) {
+			keptCount++;
+			continue;
+		}
+		releaseHeap(heapIndex);
+		heap.allocator.reset();
+	}
+}
+
+uint32_t HeapAllocator::Defragment(uint32_t maxMoves, uint64_t alignment, const MoveCallback& move) {
+	// 確保のあるヒープを使用量の少ない順に並べ、少ないものから多いものへ動かす
+	std::vector<uint32_t> heapOrder;
+	for (uint32_t heapIndex = 0; heapIndex < heaps.size(); heapIndex++) {
+		if (heaps[heapIndex].allocator != nullptr && !heaps[heapIndex].allocator->IsEmpty() && heaps[heapIndex].allocator->GetCapacity() == heapSize) {
+			heapOrder.push_back(heapIndex);
+		}
+	}
+	std::sort(heapOrder.begin(), heapOrder.end(), [this](uint32_t a, uint32_t b) { return heaps[a].allocator->GetUsedSize() < heaps[b].allocator->GetUsedSize(); });
+
+	uint32_t moveCount = 0;
+	std::vector<TlsfAllocation> sourceAllocations;
+	// 動かした先のヒープは移動元にしない(移動先はコピーが終わるまで中身がないので、同じ呼び出しの中でもう一度動かせない)
+	std::vector<uint8_t> hasReceived(heaps.size(), 0);
+	for (size_t source = 0; source + 1 < heapOrder.size() && moveCount < maxMoves; source++) {
+		const uint32_t sourceHeapIndex = heapOrder[source];
+		if (hasReceived[sourceHeapIndex]) {
+			continue;
+		}
+		heaps[sourceHeapIndex].allocator->GetAllocations(sourceAllocations);
+		for (const TlsfAllocation& sourceAllocation : sourceAllocations) {
+			if (moveCount >= maxMoves) {
+				break;
+			}
+			const uint64_t requested = heaps[sourceHeapIndex].requestedSizes[sourceAllocation.block];
+			// 一番使われているヒープから順に、入るところを探す
+			for (size_t destination = heapOrder.size() - 1; destination > source; destination--) {
+				HeapAllocation destinationAllocation{};
+				if (AllocateFromHeap(heapOrder[destination], sourceAllocation.size, alignment, requested, destinationAllocation)) {
+					const HeapAllocation sourceHeapAllocation{sourceHeapIndex, sourceAllocation.offset, sourceAllocation.size, requested, sourceAllocation.block};
+					move(sourceHeapAllocation, destinationAllocation);
+					Free(sourceHeapAllocation);
+					hasReceived[heapOrder[destination]] = 1;
+					moveCount++;
+					break;
+				}
+			}
+		}
+	}
+	return moveCount;
+}
+
+HeapStatistics HeapAllocator::GetStatistics() const {
+	HeapStatistics statistics{};
+	for (const Heap& heap : heaps) {
+		if (heap.allocator == nullptr) {
+			continue;
+		}
+		statistics.heapCount++;
+		statistics.allocationCount += heap.allocator->GetAllocationCount();
+		statistics.heapSize += heap.allocator->GetCapacity();
+		statistics.usedSize += heap.allocator->GetUsedSize();
+		statistics.largestFreeSize = (std::max)(statistics.largestFreeSize, heap.allocator->GetLargestFreeSize());
+	}
+	statistics.freeSize = statistics.heapSize - statistics.usedSize;
+	statistics.wastedSize = statistics.usedSize - requestedSize;
+	statistics.fragmentation = statistics.freeSize == 0 ? 0.0f : (1.0f - float(double(statistics.largestFreeSize) / double(statistics.freeSize))) * 100.0f;
+	return statistics;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include "TlsfAllocator.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/// <summary>
+/// HeapAllocatorで確保した範囲
+/// </summary>
+struct HeapAllocation {
+	uint32_t heapIndex;     // ヒープの番号
+	uint64_t offset;        // ヒープの中の位置
+	uint64_t size;          // 確保したバイト数
+	uint64_t requestedSize; // 実際に使うバイト数(sizeとの差は無駄になる)
+	uint32_t block;         // TlsfAllocatorのブロックの番号
+};
+
+/// <summary>
+/// ヒープの使用状況
+/// </summary>
+struct HeapStatistics {
+	uint32_t heapCount;
+	uint32_t allocationCount;
+	uint64_t heapSize;        // ヒープの合計
+	uint64_t usedSize;        // 確保した合計
+	uint64_t freeSize;        // 空きの合計
+	uint64_t largestFreeSize; // 1度に確保できる一番大きい空き
+	uint64_t wastedSize;      // 確保したが使われない分(大きさを揃えた分)
+	float fragmentation;      // 空きのうち、一番大きい空きに入っていない割合(%)
+};
+
+/// <summary>
+/// 同じ種類の大きなヒープをいくつか持ち、TlsfAllocatorでその中の範囲を切り出すアロケーター
+/// 入るヒープがなければcreateHeapで新しく作り、ヒープより大きいものはそれだけのヒープを作る
+/// 位置の管理だけを行い、ヒープの実体(ID3D12Heapなど)は呼び出し側がヒープの番号ごとに持つ
+/// </summary>
+class HeapAllocator {
+public:
+	/// <summary>
+	/// ヒープを作る処理(番号は空いたものを使い直すことがある)
+	/// </summary>
+	using HeapCreator = std::function<bool(uint32_t heapIndex, uint64_t size)>;
+	/// <summary>
+	/// ヒープを消す処理
+	/// </summary>
+	using HeapReleaser = std::function<void(uint32_t heapIndex)>;
+	/// <summary>
+	/// デフラグで範囲を動かす処理(移動先に作り直してコピーする)
+	/// </summary>
+	using MoveCallback = std::function<void(const HeapAllocation& source, const HeapAllocation& destination)>;
+
+	/// <param name="heapSize">ヒープ1つのバイト数</param>
+	/// <param name="createHeap">ヒープを作る処理</param>
+	/// <param name="releaseHeap">ヒープを消す処理</param>
+	HeapAllocator(uint64_t heapSize, HeapCreator createHeap, HeapReleaser releaseHeap);
+	HeapAllocator(const HeapAllocator&) = delete;
+	HeapAllocator& operator=(const HeapAllocator&) = delete;
+
+	/// <summary>
+	/// 範囲を確保する
+	/// </summary>
+	/// <param name="size">バイト数</param>
+	/// <param name="alignment">ヒープの中の位置の単位(2の累乗)</param>
+	/// <param name="allocation">確保した範囲</param>
+	/// <param name="requestedSize">実際に使うバイト数(0ならsizeと同じ。統計にだけ使う)</param>
+	/// <returns>確保できたか(ヒープを作れなければfalse)</returns>
+	bool Allocate(uint64_t size, uint64_t alignment, HeapAllocation& allocation, uint64_t requestedSize = 0);
+
+	/// <summary>
+	/// 範囲を解放する(ヒープは消さずに残す)
+	/// </summary>
+	void Free(const HeapAllocation& allocation);
+
+	/// <summary>
+	/// 何も確保していないヒープを消す
+	/// </summary>
+	/// <param name="keepCount">消さずに残すヒープの数</param>
+	void ReleaseEmptyHeaps(uint32_t keepCount = 1);
+
+	/// <summary>
+	/// 使用量の少ないヒープの範囲を、より使われているヒープの空きへ動かす(動かし終えたヒープはReleaseEmptyHeapsで消せる)
+	/// 移動元はmoveを呼んだ後に解放するので、GPUのコピーが終わるまで移動元のリソースとヒープを残し、
+	/// ReleaseEmptyHeapsもコピーが終わってから呼ぶこと
+	/// 1回の呼び出しで同じ範囲を2度動かすことはない(移動先になったヒープは移動元にしない)
+	/// </summary>
+	/// <param name="maxMoves">1回で動かす最大数(1フレームでコピーする量を抑える)</param>
+	/// <param name="alignment">移動先の位置の単位(2の累乗)</param>
+	/// <param name="move">範囲を動かす処理</param>
+	/// <returns>動かした数</returns>
+	uint32_t Defragment(uint32_t maxMoves, uint64_t alignment, const MoveCallback& move);
+
+	HeapStatistics GetStatistics() const;
+	uint64_t GetHeapSize() const { return heapSize; }
+
+private:
+	/// <summary>
+	/// ヒープ1つ分の管理
+	/// </summary>
+	struct Heap {
+		std::unique_ptr<TlsfAllocator> allocator; // 消したヒープはnullptr
+		std::vector<uint64_t> requestedSizes;     // TlsfAllocatorのブロックごとの実際に使うバイト数
+	};
+
+	// 新しいヒープを作る(作れなければUINT32_MAX)
+	uint32_t CreateHeap(uint64_t size);
+	// heapIndexのヒープから確保する
+	bool AllocateFromHeap(uint32_t heapIndex, uint64_t size, uint64_t alignment, uint64_t requestedSize, HeapAllocation& allocation);
+
+	std::vector<Heap> heaps;
+	uint64_t heapSize;
+	uint64_t requestedSize = 0; // 実際に使うバイト数の合計
+	HeapCreator createHeap;
+	HeapReleaser releaseHeap;
+};
@@ -0,0 +1,64 @@
+#include "LinearUploadAllocator.h"
+#include <algorithm>
+#include <cassert>
+
+namespace {
+
+// valueをalignmentの倍数に切り上げる(alignmentは2の累乗)
+uint64_t AlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+} // namespace
+
+LinearUploadAllocator::LinearUploadAllocator(uint32_t frameCount, size_t pageSize, PageAllocator allocatePage) : frames(frameCount), pageSize(pageSize), allocatePage(std::move(allocatePage)) {
+	assert(frameCount > 0);
+	assert(pageSize > 0);
+}
+
+void LinearUploadAllocator::BeginFrame(uint32_t index) {
+	assert(index < frames.size());
+	frameIndex = index;
+	frames[frameIndex].currentPage = 0;
+	frames[frameIndex].offset = 0;
+}
+
+UploadAllocation LinearUploadAllocator::Allocate(size_t size, size_t alignment) {
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	FrameContext& frame = frames[frameIndex];
+
+	// 今のページに入らなければ次のページへ進む(前のフレームで追加したページもここで使い直す)
+	for (; frame.currentPage < frame.pages.size(); frame.currentPage++, frame.offset = 0) {
+		const UploadPage& page = frame.pages[frame.currentPage];
+		const uint64_t offset = AlignUp(page.gpuAddress + frame.offset, alignment) - page.gpuAddress;
+		if (offset + size <= page.size) {
+			frame.offset = size_t(offset + size);
+			return {static_cast<char*>(page.cpuAddress) + offset, page.gpuAddress + offset};
+		}
+	}
+
+	// どのページにも入らなければ新しいページを足す(ページの先頭を揃えるため、単位の分だけ余分に取る)
+	UploadPage page = allocatePage((std::max)(pageSize, size + alignment - 1));
+	assert(page.cpuAddress != nullptr);
+	frame.pages.push_back(page);
+	frame.currentPage = frame.pages.size() - 1;
+	const uint64_t offset = AlignUp(page.gpuAddress, alignment) - page.gpuAddress;
+	assert(offset + size <= page.size);
+	frame.offset = size_t(offset + size);
+	return {static_cast<char*>(page.cpuAddress) + offset, page.gpuAddress + offset};
+}
+
+size_t LinearUploadAllocator::GetUsedSize() const {
+	const FrameContext& frame = frames[frameIndex];
+	size_t usedSize = frame.offset;
+	for (size_t i = 0; i < frame.currentPage && i < frame.pages.size(); i++) {
+		usedSize += frame.pages[i].size;
+	}
+	return usedSize;
+}
+
+size_t LinearUploadAllocator::GetPageCount() const {
+	size_t pageCount = 0;
+	for (const FrameContext& frame : frames) {
+		pageCount += frame.pages.size();
+	}
+	return pageCount;
+}
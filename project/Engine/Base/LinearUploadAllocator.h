@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+// 定数バッファとして参照するアドレスの単位(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENTと同じ)
+static const size_t kConstantBufferAlignment = 256;
+
+/// <summary>
+/// アップロード用のメモリのページ(CPUから書き込むアドレスとGPUから読むアドレス)
+/// </summary>
+struct UploadPage {
+	void* cpuAddress;
+	uint64_t gpuAddress;
+	size_t size; // バイト数
+};
+
+/// <summary>
+/// 切り出したアップロード用のメモリ
+/// </summary>
+struct UploadAllocation {
+	void* cpuAddress;    // 書き込むアドレス
+	uint64_t gpuAddress; // ルートCBVなどに渡すアドレス
+};
+
+/// <summary>
+/// フレームごとに使い捨てる定数などを、大きなアップロード用のページから前から順に切り出すアロケーター
+/// GPUが読み終わるまで上書きしないように、フレームの数だけページの組を持ち、BeginFrameで同じ番号の組をまとめて使い直す
+/// ページの確保はallocatePageに任せるので、GPUのない環境でも普通のメモリで動かせる
+/// </summary>
+class LinearUploadAllocator {
+public:
+	/// <summary>
+	/// ページを確保する処理(確保したページは呼び出し側が持ち続け、アロケーターより後に解放する)
+	/// </summary>
+	using PageAllocator = std::function<UploadPage(size_t size)>;
+
+	/// <param name="frameCount">同時に使うフレームの数(GPUが読んでいる途中のフレームを含む)</param>
+	/// <param name="pageSize">ページのバイト数(これより大きい確保は専用のページにする)</param>
+	/// <param name="allocatePage">ページを確保する処理</param>
+	LinearUploadAllocator(uint32_t frameCount, size_t pageSize, PageAllocator allocatePage);
+	LinearUploadAllocator(const LinearUploadAllocator&) = delete;
+	LinearUploadAllocator& operator=(const LinearUploadAllocator&) = delete;
+
+	/// <summary>
+	/// フレームの初めに呼び、そのフレームの番号のページを空にして使い直す
+	/// 前回同じ番号で切り出したメモリは、GPUが読み終わっていること(フェンスで待ってから呼ぶ)
+	/// </summary>
+	/// <param name="frameIndex">フレームの番号(0～frameCount-1)</param>
+	void BeginFrame(uint32_t frameIndex);
+
+	/// <summary>
+	/// 今のフレームのページからメモリを切り出す(足りなければページを追加する)
+	/// </summary>
+	/// <param name="size">バイト数</param>
+	/// <param name="alignment">GPUアドレスの単位(2の累乗)</param>
+	UploadAllocation Allocate(size_t size, size_t alignment = kConstantBufferAlignment);
+
+	/// <summary>
+	/// 定数バッファ1つ分を切り出して値を書き込む
+	/// </summary>
+	template<class T> UploadAllocation AllocateConstant(const T& value) {
+		UploadAllocation allocation = Allocate(sizeof(T), kConstantBufferAlignment);
+		std::memcpy(allocation.cpuAddress, &value, sizeof(T));
+		return allocation;
+	}
+
+	// 今のフレームで使ったバイト数(詰め物と、入りきらずに飛ばしたページの残りを含む)
+	size_t GetUsedSize() const;
+	// 全てのフレームのページの数
+	size_t GetPageCount() const;
+
+private:
+	/// <summary>
+	/// フレームごとのページと書き込み位置
+	/// </summary>
+	struct FrameContext {
+		std::vector<UploadPage> pages;
+		size_t currentPage = 0; // 書き込み中のページ
+		size_t offset = 0;      // 書き込み中のページの使った位置
+	};
+
+	std::vector<FrameContext> frames;
+	uint32_t frameIndex = 0;
+	size_t pageSize;
+	PageAllocator allocatePage;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/// <summary>
+/// 固定長のロックフリーなキュー(複数スレッドから追加・取り出しできる)
+/// 各要素に順番の番号を持たせ、追加と取り出しの位置をCASで進める
+/// </summary>
+/// <typeparam name="T">要素の型(ムーブできること)</typeparam>
+template<class T> class LockFreeQueue {
+public:
+	/// <param name="capacity">最大の要素数(2の累乗)</param>
+	explicit LockFreeQueue(size_t capacity) : cells(new Cell[capacity]), mask(capacity - 1) {
+		assert(capacity >= 2 && (capacity & (capacity - 1)) == 0 && "capacity must be a power of two");
+		for (size_t i = 0; i < capacity; i++) {
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+	LockFreeQueue(const LockFreeQueue&) = delete;
+	LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+	/// <summary>
+	/// 要素を追加する
+	/// </summary>
+	/// <returns>追加できたか(満杯ならfalse)</returns>
+	bool TryPush(T&& value) {
+		size_t position = pushPosition.load(std::memory_order_relaxed);
+		while (true) {
+			Cell& cell = cells[position & mask];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			ptrdiff_t difference = ptrdiff_t(sequence) - ptrdiff_t(position);
+			if (difference == 0) {
+				if (pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					cell.value = std::move(value);
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = pushPosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/// <summary>
+	/// 先頭の要素を取り出す
+	/// </summary>
+	/// <returns>取り出せたか(空ならfalse)</returns>
+	bool TryPop(T& value) {
+		size_t position = popPosition.load(std::memory_order_relaxed);
+		while (true) {
+			Cell& cell = cells[position & mask];
+			size_t sequence = cell.sequence.load(std::memory_order_acquire);
+			ptrdiff_t difference = ptrdiff_t(sequence) - ptrdiff_t(position + 1);
+			if (difference == 0) {
+				if (popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					value = std::move(cell.value);
+					cell.sequence.store(position + mask + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = popPosition.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	const size_t mask;
+	// 追加側と取り出し側が同じキャッシュラインを奪い合わないように離す
+	alignas(64) std::atomic<size_t> pushPosition{0};
+	alignas(64) std::atomic<size_t> popPosition{0};
+};
@@ -0,0 +1,78 @@
+#include "MappedFile.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(const std::string& filepath) {
+	Close();
+#ifdef _WIN32
+	// UTF-8のパスをワイド文字列に変換
+	int sizeNeeded = MultiByteToWideChar(CP_UTF8, 0, filepath.data(), (int)filepath.size(), nullptr, 0);
+	std::wstring widePath(sizeNeeded, 0);
+	MultiByteToWideChar(CP_UTF8, 0, filepath.data(), (int)filepath.size(), widePath.data(), sizeNeeded);
+
+	HANDLE file = CreateFileW(widePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER fileSize{};
+	GetFileSizeEx(file, &fileSize);
+	fileHandle = file;
+	size = size_t(fileSize.QuadPart);
+	isOpen = true;
+	// 空のファイルはマップできないので、空のデータとして扱う
+	if (size == 0) {
+		return true;
+	}
+	mappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle == nullptr) {
+		Close();
+		return false;
+	}
+	data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr) {
+		Close();
+		return false;
+	}
+	return true;
+#else
+	// マップできない環境ではファイル全体を一度に読み込む
+	FILE* file = std::fopen(filepath.c_str(), "rb");
+	if (file == nullptr) {
+		return false;
+	}
+	std::fseek(file, 0, SEEK_END);
+	long fileSize = std::ftell(file);
+	std::fseek(file, 0, SEEK_SET);
+	buffer.resize(size_t(fileSize > 0 ? fileSize : 0));
+	size = std::fread(buffer.data(), 1, buffer.size(), file);
+	std::fclose(file);
+	data = buffer.data();
+	isOpen = true;
+	return true;
+#endif
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+	if (data != nullptr) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle != nullptr) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != nullptr) {
+		CloseHandle(fileHandle);
+	}
+#endif
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+	data = nullptr;
+	size = 0;
+	isOpen = false;
+	buffer.clear();
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// 読み込み専用でメモリにマップしたファイル
+/// マップできない環境ではファイル全体をまとめて読み込む
+/// </summary>
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/// <summary>
+	/// ファイルを開いてマップする
+	/// </summary>
+	/// <param name="filepath">ファイルパス(UTF-8)</param>
+	/// <returns>開けたか</returns>
+	bool Open(const std::string& filepath);
+
+	/// <summary>
+	/// マップを解除してファイルを閉じる
+	/// </summary>
+	void Close();
+
+	bool IsOpen() const { return isOpen; }
+	const char* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	void* fileHandle = nullptr;    // ファイルハンドル
+	void* mappingHandle = nullptr; // マッピングハンドル
+	const char* data = nullptr;    // 先頭アドレス
+	size_t size = 0;               // ファイルサイズ
+	bool isOpen = false;
+	std::vector<char> buffer; // マップできない環境用の読み込み先
+};
@@ -0,0 +1,227 @@
+#include "TlsfAllocator.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace {
+
+// valueをalignmentの倍数に切り上げる(alignmentは2の累乗)
+uint64_t AlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+// 一番上の1のビットの位置
+uint32_t HighestBit(uint64_t value) { return 63 - uint32_t(std::countl_zero(value)); }
+
+} // namespace
+
+TlsfAllocator::TlsfAllocator(uint64_t capacity) : capacity(capacity) {
+	assert(capacity > 0);
+	for (uint32_t firstLevel = 0; firstLevel < kFirstLevelCount; firstLevel++) {
+		for (uint32_t secondLevel = 0; secondLevel < kSecondLevelCount; secondLevel++) {
+			freeLists[firstLevel][secondLevel] = kNone;
+		}
+	}
+	// 全体を1つの空きブロックにする
+	uint32_t block = NewBlock();
+	blocks[block] = {0, capacity, kNone, kNone, kNone, kNone, true};
+	InsertFreeBlock(block);
+}
+
+void TlsfAllocator::Mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) {
+	if (size < kSecondLevelCount) {
+		// 小さいものは1バイトごとに分ける
+		firstLevel = 0;
+		secondLevel = uint32_t(size);
+		return;
+	}
+	// [2^n, 2^(n+1))をkSecondLevelCount個に分ける
+	const uint32_t highestBit = HighestBit(size);
+	firstLevel = highestBit - kSecondLevelBits + 1;
+	secondLevel = uint32_t(size >> (highestBit - kSecondLevelBits)) - kSecondLevelCount;
+}
+
+bool TlsfAllocator::FindFreeBlock(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const {
+	// 区分の中で一番小さいものでも入るように、次の区分の先頭まで切り上げる
+	if (size >= kSecondLevelCount) {
+		const uint64_t round = (uint64_t(1) << (HighestBit(size) - kSecondLevelBits)) - 1;
+		if (size > UINT64_MAX - round) {
+			return false;
+		}
+		size += round;
+	}
+	Mapping(size, firstLevel, secondLevel);
+
+	// 同じ1段目でsecondLevel以上の区分、なければより大きい1段目から探す
+	uint32_t secondLevelBitmap = secondLevelBitmaps[firstLevel] & (UINT32_MAX << secondLevel);
+	if (secondLevelBitmap == 0) {
+		const uint64_t firstLevelBitmap = firstLevel + 1 < 64 ? this->firstLevelBitmap & (UINT64_MAX << (firstLevel + 1)) : 0;
+		if (firstLevelBitmap == 0) {
+			return false;
+		}
+		firstLevel = uint32_t(std::countr_zero(firstLevelBitmap));
+		secondLevelBitmap = secondLevelBitmaps[firstLevel];
+	}
+	secondLevel = uint32_t(std::countr_zero(secondLevelBitmap));
+	return true;
+}
+
+void TlsfAllocator::InsertFreeBlock(uint32_t block) {
+	uint32_t firstLevel, secondLevel;
+	Mapping(blocks[block].size, firstLevel, secondLevel);
+	uint32_t& head = freeLists[firstLevel][secondLevel];
+	blocks[block].isFree = true;
+	blocks[block].previousFree = kNone;
+	blocks[block].nextFree = head;
+	if (head != kNone) {
+		blocks[head].previousFree = block;
+	}
+	head = block;
+	firstLevelBitmap |= uint64_t(1) << firstLevel;
+	secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+}
+
+void TlsfAllocator::RemoveFreeBlock(uint32_t block) {
+	Block& removed = blocks[block];
+	if (removed.previousFree != kNone) {
+		blocks[removed.previousFree].nextFree = removed.nextFree;
+	} else {
+		uint32_t firstLevel, secondLevel;
+		Mapping(removed.size, firstLevel, secondLevel);
+		freeLists[firstLevel][secondLevel] = removed.nextFree;
+		if (removed.nextFree == kNone) {
+			// 区分が空になった
+			secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+			if (secondLevelBitmaps[firstLevel] == 0) {
+				firstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+			}
+		}
+	}
+	if (removed.nextFree != kNone) {
+		blocks[removed.nextFree].previousFree = removed.previousFree;
+	}
+	removed.isFree = false;
+}
+
+uint32_t TlsfAllocator::NewBlock() {
+	if (!unusedBlocks.empty()) {
+		uint32_t block = unusedBlocks.back();
+		unusedBlocks.pop_back();
+		return block;
+	}
+	blocks.push_back({});
+	return uint32_t(blocks.size() - 1);
+}
+
+void TlsfAllocator::Split(uint32_t block, uint64_t size) {
+	assert(size < blocks[block].size);
+	// NewBlockでblocksが伸びることがあるので、参照は後で取る
+	const uint32_t rest = NewBlock();
+	Block& front = blocks[block];
+	blocks[rest] = {front.offset + size, front.size - size, block, front.nextPhysical, kNone, kNone, false};
+	if (front.nextPhysical != kNone) {
+		blocks[front.nextPhysical].previousPhysical = rest;
+	}
+	front.size = size;
+	front.nextPhysical = rest;
+	InsertFreeBlock(rest);
+}
+
+void TlsfAllocator::MergeNext(uint32_t block) {
+	Block& front = blocks[block];
+	const uint32_t next = front.nextPhysical;
+	front.size += blocks[next].size;
+	front.nextPhysical = blocks[next].nextPhysical;
+	if (front.nextPhysical != kNone) {
+		blocks[front.nextPhysical].previousPhysical = block;
+	}
+	unusedBlocks.push_back(next);
+}
+
+void TlsfAllocator::Use(uint32_t block, uint64_t size, uint64_t alignment, TlsfAllocation& allocation) {
+	RemoveFreeBlock(block);
+	// 揃えるために飛ばす手前の分は、空きのまま残す
+	const uint64_t padding = AlignUp(blocks[block].offset, alignment) - blocks[block].offset;
+	if (padding != 0) {
+		Split(block, padding);
+		const uint32_t aligned = blocks[block].nextPhysical;
+		InsertFreeBlock(block);
+		RemoveFreeBlock(aligned);
+		block = aligned;
+	}
+	if (blocks[block].size > size) {
+		Split(block, size);
+	}
+	usedSize += size;
+	allocationCount++;
+	allocation = {blocks[block].offset, size, block};
+}
+
+bool TlsfAllocator::Allocate(uint64_t size, uint64_t alignment, TlsfAllocation& allocation) {
+	assert(size > 0);
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+	uint32_t firstLevel, secondLevel;
+	// まずは大きさだけで探し、先頭を揃えると入らなければ揃える分を足して探し直す
+	if (FindFreeBlock(size, firstLevel, secondLevel)) {
+		const uint32_t block = freeLists[firstLevel][secondLevel];
+		if (AlignUp(blocks[block].offset, alignment) - blocks[block].offset + size <= blocks[block].size) {
+			Use(block, size, alignment, allocation);
+			return true;
+		}
+	}
+	if (alignment > 1 && size <= UINT64_MAX - (alignment - 1) && FindFreeBlock(size + alignment - 1, firstLevel, secondLevel)) {
+		Use(freeLists[firstLevel][secondLevel], size, alignment, allocation);
+		return true;
+	}
+	// 切り上げると大きい区分にしか当たらないときのために、sizeと同じ区分の空きを順に調べる(ちょうどの大きさのヒープなど)
+	Mapping(size, firstLevel, secondLevel);
+	for (uint32_t block = freeLists[firstLevel][secondLevel]; block != kNone; block = blocks[block].nextFree) {
+		if (AlignUp(blocks[block].offset, alignment) - blocks[block].offset + size <= blocks[block].size) {
+			Use(block, size, alignment, allocation);
+			return true;
+		}
+	}
+	return false;
+}
+
+void TlsfAllocator::Free(const TlsfAllocation& allocation) {
+	uint32_t block = allocation.block;
+	assert(block < blocks.size() && !blocks[block].isFree && blocks[block].offset == allocation.offset && blocks[block].size == allocation.size);
+	usedSize -= blocks[block].size;
+	allocationCount--;
+	// 前後の空きとつなげる
+	const uint32_t next = blocks[block].nextPhysical;
+	if (next != kNone && blocks[next].isFree) {
+		RemoveFreeBlock(next);
+		MergeNext(block);
+	}
+	const uint32_t previous = blocks[block].previousPhysical;
+	if (previous != kNone && blocks[previous].isFree) {
+		RemoveFreeBlock(previous);
+		MergeNext(previous);
+		block = previous;
+	}
+	InsertFreeBlock(block);
+}
+
+void TlsfAllocator::GetAllocations(std::vector<TlsfAllocation>& allocations) const {
+	allocations.clear();
+	// 位置0のブロックは分けてもつなげても0番のままなので、そこから位置の順にたどる
+	for (uint32_t block = 0; block != kNone; block = blocks[block].nextPhysical) {
+		if (!blocks[block].isFree) {
+			allocations.push_back({blocks[block].offset, blocks[block].size, block});
+		}
+	}
+}
+
+uint64_t TlsfAllocator::GetLargestFreeSize() const {
+	if (firstLevelBitmap == 0) {
+		return 0;
+	}
+	// 一番大きい区分の空きのリストから探す
+	const uint32_t firstLevel = HighestBit(firstLevelBitmap);
+	const uint32_t secondLevel = 31 - uint32_t(std::countl_zero(secondLevelBitmaps[firstLevel]));
+	uint64_t largestFreeSize = 0;
+	for (uint32_t block = freeLists[firstLevel][secondLevel]; block != kNone; block = blocks[block].nextFree) {
+		largestFreeSize = (std::max)(largestFreeSize, blocks[block].size);
+	}
+	return largestFreeSize;
+}
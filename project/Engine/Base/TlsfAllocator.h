@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// TlsfAllocatorで確保した範囲
+/// </summary>
+struct TlsfAllocation {
+	uint64_t offset; // 先頭の位置(alignmentの倍数)
+	uint64_t size;   // バイト数
+	uint32_t block;  // 内部のブロックの番号(Freeに使う)
+};
+
+/// <summary>
+/// 0～capacityの範囲を切り分けるTLSF(Two-Level Segregated Fit)アロケーター
+/// 空き範囲を大きさの2段階の区分に分けて持ち、確保も解放もビット演算で区分を引くだけの一定時間で終わる
+/// メモリには触らず位置だけを管理するので、GPUのヒープのようにCPUから見えない領域にも使える
+/// </summary>
+class TlsfAllocator {
+public:
+	/// <param name="capacity">管理する範囲のバイト数</param>
+	explicit TlsfAllocator(uint64_t capacity);
+
+	/// <summary>
+	/// 範囲を確保する
+	/// </summary>
+	/// <param name="size">バイト数(0より大きいこと)</param>
+	/// <param name="alignment">先頭の位置の単位(2の累乗)</param>
+	/// <param name="allocation">確保した範囲</param>
+	/// <returns>確保できたか(入る空きがなければfalse)</returns>
+	bool Allocate(uint64_t size, uint64_t alignment, TlsfAllocation& allocation);
+
+	/// <summary>
+	/// 範囲を解放し、隣が空いていればつなげる
+	/// </summary>
+	void Free(const TlsfAllocation& allocation);
+
+	/// <summary>
+	/// 確保中の範囲を位置の順に並べる(デフラグで動かすものを選ぶのに使う)
+	/// </summary>
+	void GetAllocations(std::vector<TlsfAllocation>& allocations) const;
+
+	uint64_t GetCapacity() const { return capacity; }
+	uint64_t GetUsedSize() const { return usedSize; }
+	uint64_t GetFreeSize() const { return capacity - usedSize; }
+	// 1度に確保できる一番大きい空き(揃える分は考えない)
+	uint64_t GetLargestFreeSize() const;
+	uint32_t GetAllocationCount() const { return allocationCount; }
+	bool IsEmpty() const { return allocationCount == 0; }
+
+private:
+	// 2段目の区分の数(1段目の2の累乗の区間をいくつに分けるか)
+	static const uint32_t kSecondLevelBits = 4;
+	static const uint32_t kSecondLevelCount = 1 << kSecondLevelBits;
+	static const uint32_t kFirstLevelCount = 64 - kSecondLevelBits + 1;
+	static const uint32_t kNone = UINT32_MAX;
+
+	/// <summary>
+	/// 連続した範囲(空きか確保中)。位置の順と、空きなら同じ区分の空きのリストでつなぐ
+	/// </summary>
+	struct Block {
+		uint64_t offset;
+		uint64_t size;
+		uint32_t previousPhysical; // 位置が手前のブロック
+		uint32_t nextPhysical;     // 位置が後ろのブロック
+		uint32_t previousFree;     // 同じ区分の空きのリスト
+		uint32_t nextFree;
+		bool isFree;
+	};
+
+	// 大きさから区分を求める
+	static void Mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel);
+	// その区分の空きならどれでもsize以上になる区分を求める(見つからなければfalse)
+	bool FindFreeBlock(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const;
+	void InsertFreeBlock(uint32_t block);
+	void RemoveFreeBlock(uint32_t block);
+	uint32_t NewBlock();
+	// blockの先頭からsize分を残し、残りを後ろの空きブロックにする
+	void Split(uint32_t block, uint64_t size);
+	// blockと後ろのブロックをつなげる(後ろは消える)
+	void MergeNext(uint32_t block);
+	// 空きブロックblockから確保する
+	void Use(uint32_t block, uint64_t size, uint64_t alignment, TlsfAllocation& allocation);
+
+	uint64_t capacity;
+	uint64_t usedSize = 0;
+	uint32_t allocationCount = 0;
+	std::vector<Block> blocks;
+	std::vector<uint32_t> unusedBlocks; // 使っていないblocksの番号
+	// 区分ごとの空きのリストの先頭と、空きのある区分のビット
+	uint32_t freeLists[kFirstLevelCount][kSecondLevelCount];
+	uint64_t firstLevelBitmap = 0;
+	uint32_t secondLevelBitmaps[kFirstLevelCount] = {};
+};
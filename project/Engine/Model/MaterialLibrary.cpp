@@ -0,0 +1,183 @@
+#include "MaterialLibrary.h"
+#include "../Base/MappedFile.h"
+#include "TextScanner.h"
+#include <cassert>
+#include <filesystem>
+
+using namespace TextScanner;
+
+namespace {
+
+/// <summary>
+/// 同じファイルを指すパスが同じ文字列になるように正規化する
+/// </summary>
+std::string CanonicalizePath(const std::string& path) {
+	std::error_code error;
+	std::filesystem::path canonical = std::filesystem::weakly_canonical(std::filesystem::path(path), error);
+	if (error) {
+		return std::filesystem::path(path).lexically_normal().generic_string();
+	}
+	return canonical.generic_string();
+}
+
+/// <summary>
+/// map_*の行からファイル名を読む。-bm 1.0などのオプションは読み飛ばし、最後の語をファイル名とする
+/// </summary>
+const char* ReadTextureFilename(const char* p, const char* end, std::string_view& filename) {
+	filename = {};
+	while (true) {
+		std::string_view token;
+		p = ReadToken(p, end, token);
+		if (token.empty()) {
+			return p;
+		}
+		filename = token;
+	}
+}
+
+/// <summary>
+/// 色を読む(rgbの省略時はrと同じ値)
+/// </summary>
+const char* ParseColor(const char* p, const char* end, Vector3& color) {
+	p = ParseFloat(p, end, color.x);
+	p = SkipSpaces(p, end);
+	if (p < end && *p != '\n') {
+		p = ParseFloat(p, end, color.y);
+		p = ParseFloat(p, end, color.z);
+	} else {
+		color.y = color.x;
+		color.z = color.x;
+	}
+	return p;
+}
+
+// mtlに指定がない値
+const MaterialRecord kDefaultMaterial = {
+    {1.0f, 1.0f, 1.0f},
+    {0.0f, 0.0f, 0.0f},
+    0.0f, 1.0f, 2, kNoTexture, kNoTexture, kNoTexture, kNoTexture, kNoTexture
+};
+
+} // namespace
+
+MaterialLibrary::MaterialLibrary() {
+	// 0番はmtlに定義がないマテリアル用
+	materials.push_back(kDefaultMaterial);
+	materialNames.push_back("");
+}
+
+std::vector<uint32_t> MaterialLibrary::Load(const std::string& libraryPath) {
+	std::string canonicalPath = CanonicalizePath(libraryPath);
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = libraries.find(canonicalPath);
+	if (found != libraries.end()) {
+		return found->second;
+	}
+
+	MappedFile file;
+	bool isOpen = file.Open(libraryPath);
+	assert(isOpen && "Failed to open the MTL file");
+	(void)isOpen;
+
+	size_t separator = libraryPath.find_last_of("/\\");
+	std::string directoryPath = separator != std::string::npos ? libraryPath.substr(0, separator) : ".";
+	std::vector<uint32_t> libraryMaterials;
+	const char* p = file.GetData();
+	const char* end = p + file.GetSize();
+	while (p < end) {
+		std::string_view identifier;
+		p = ReadToken(p, end, identifier);
+		if (identifier == "newmtl") {
+			std::string_view name;
+			p = ReadRestOfLine(p, end, name);
+			libraryMaterials.push_back(uint32_t(materials.size()));
+			materials.push_back(kDefaultMaterial);
+			materialNames.push_back(std::string(name));
+		} else if (!libraryMaterials.empty()) {
+			MaterialRecord& material = materials.back();
+			if (identifier == "Kd") {
+				p = ParseColor(p, end, material.diffuseColor);
+			} else if (identifier == "Ks") {
+				p = ParseColor(p, end, material.specularColor);
+			} else if (identifier == "Ns") {
+				p = ParseFloat(p, end, material.shininess);
+			} else if (identifier == "d") {
+				p = ParseFloat(p, end, material.alpha);
+			} else if (identifier == "Tr") {
+				float transparency = 0.0f;
+				p = ParseFloat(p, end, transparency);
+				material.alpha = 1.0f - transparency;
+			} else if (identifier == "illum") {
+				p = ParseInt(p, end, material.illuminationModel);
+			} else if (identifier.substr(0, 4) == "map_" || identifier == "bump" || identifier == "norm") {
+				std::string_view textureFilename;
+				p = ReadTextureFilename(p, end, textureFilename);
+				if (!textureFilename.empty()) {
+					uint32_t texture = RegisterTexture(directoryPath + "/" + std::string(textureFilename));
+					if (identifier == "map_Kd") {
+						material.diffuseTexture = texture;
+					} else if (identifier == "map_Ks") {
+						material.specularTexture = texture;
+					} else if (identifier == "map_Ns") {
+						material.shininessTexture = texture;
+					} else if (identifier == "map_d") {
+						material.alphaTexture = texture;
+					} else if (identifier == "map_Bump" || identifier == "map_bump" || identifier == "bump" || identifier == "norm") {
+						material.normalTexture = texture;
+					}
+				}
+			}
+		}
+		p = SkipLine(p, end);
+	}
+
+	libraries.emplace(canonicalPath, libraryMaterials);
+	return libraryMaterials;
+}
+
+uint32_t MaterialLibrary::FindMaterial(const std::string& libraryPath, std::string_view name) {
+	std::vector<uint32_t> libraryMaterials = Load(libraryPath);
+	std::lock_guard<std::mutex> lock(mutex);
+	for (uint32_t materialId : libraryMaterials) {
+		if (materialNames[materialId] == name) {
+			return materialId;
+		}
+	}
+	return kDefaultMaterialId;
+}
+
+MaterialRecord MaterialLibrary::GetMaterial(uint32_t materialId) {
+	std::lock_guard<std::mutex> lock(mutex);
+	assert(materialId < materials.size());
+	return materials[materialId];
+}
+
+std::string MaterialLibrary::GetMaterialName(uint32_t materialId) {
+	std::lock_guard<std::mutex> lock(mutex);
+	assert(materialId < materialNames.size());
+	return materialNames[materialId];
+}
+
+std::string MaterialLibrary::GetTexturePath(uint32_t textureId) {
+	std::lock_guard<std::mutex> lock(mutex);
+	assert(textureId < texturePaths.size());
+	return texturePaths[textureId];
+}
+
+uint32_t MaterialLibrary::GetTextureCount() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return uint32_t(texturePaths.size());
+}
+
+uint32_t MaterialLibrary::RegisterTexture(const std::string& texturePath) {
+	auto [found, inserted] = textureLookup.emplace(CanonicalizePath(texturePath), uint32_t(texturePaths.size()));
+	if (inserted) {
+		texturePaths.push_back(texturePath);
+	}
+	return found->second;
+}
+
+MaterialLibrary& GetMaterialLibrary() {
+	static MaterialLibrary materialLibrary;
+	return materialLibrary;
+}
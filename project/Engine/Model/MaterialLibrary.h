@@ -0,0 +1,76 @@
+#pragma once
+#include "../3d/Vector3.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// テクスチャがないことを表す番号
+static const uint32_t kNoTexture = UINT32_MAX;
+// mtlに定義がないマテリアルに使う既定のマテリアルの番号
+static const uint32_t kDefaultMaterialId = 0;
+
+/// <summary>
+/// mtlのマテリアル。テクスチャはパスではなくMaterialLibraryのテクスチャ表の番号で持つ
+/// </summary>
+struct MaterialRecord {
+	Vector3 diffuseColor;       // Kd
+	Vector3 specularColor;      // Ks
+	float shininess;            // Ns
+	float alpha;                // d(Trなら1-Tr)
+	int32_t illuminationModel;  // illum
+	uint32_t diffuseTexture;    // map_Kd
+	uint32_t specularTexture;   // map_Ks
+	uint32_t shininessTexture;  // map_Ns
+	uint32_t alphaTexture;      // map_d
+	uint32_t normalTexture;     // map_Bump, bump, norm
+};
+
+/// <summary>
+/// 解析済みのmtlを正規化したパスで共有するキャッシュ
+/// 同じmtlを参照するモデルは同じマテリアル番号を使い、同じテクスチャは1つの番号にまとめる
+/// 複数のスレッドから呼び出せる
+/// </summary>
+class MaterialLibrary {
+public:
+	MaterialLibrary();
+
+	/// <summary>
+	/// mtlファイルを読み込む。読み込み済みなら解析せずに同じ結果を返す
+	/// </summary>
+	/// <param name="libraryPath">mtlファイルのパス(テクスチャのパスはこのディレクトリが基準)</param>
+	/// <returns>ファイル内のマテリアル番号(ファイル順)</returns>
+	std::vector<uint32_t> Load(const std::string& libraryPath);
+
+	/// <summary>
+	/// mtlから名前でマテリアルを探す(読み込んでいなければ読み込む)
+	/// </summary>
+	/// <param name="libraryPath">mtlファイルのパス</param>
+	/// <returns>マテリアル番号(見つからなければkDefaultMaterialId)</returns>
+	uint32_t FindMaterial(const std::string& libraryPath, std::string_view name);
+
+	MaterialRecord GetMaterial(uint32_t materialId);
+	std::string GetMaterialName(uint32_t materialId);
+	std::string GetTexturePath(uint32_t textureId);
+	uint32_t GetTextureCount();
+
+private:
+	/// <summary>
+	/// テクスチャを登録して番号を返す(同じファイルは同じ番号)
+	/// </summary>
+	uint32_t RegisterTexture(const std::string& texturePath);
+
+	std::mutex mutex;
+	std::unordered_map<std::string, std::vector<uint32_t>> libraries; // 正規化したmtlのパスからマテリアル番号
+	std::vector<MaterialRecord> materials;
+	std::vector<std::string> materialNames;
+	std::unordered_map<std::string, uint32_t> textureLookup; // 正規化したテクスチャのパスから番号
+	std::vector<std::string> texturePaths;
+};
+
+/// <summary>
+/// 全てのモデルで共有するマテリアルのキャッシュ
+/// </summary>
+MaterialLibrary& GetMaterialLibrary();
@@ -0,0 +1,351 @@
+#include "MeshCache.h"
+#include "MaterialLibrary.h"
+#include "ObjLoader.h"
+#include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+// クックドメッシュを置くディレクトリ
+const char* const kCookedMeshDirectory = "MeshCache";
+// 各ブロックの配置単位
+const uint64_t kBlockAlignment = 16;
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+/// <summary>
+/// パスから実装に依存しないハッシュ値を求める(FNV-1a)
+/// </summary>
+uint64_t HashPath(std::string_view path) {
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (char c : path) {
+		hash = (hash ^ uint8_t(c)) * 0x100000001B3ull;
+	}
+	return hash;
+}
+
+/// <summary>
+/// 元ファイルのサイズと更新時刻を取得する
+/// </summary>
+bool GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& writeTime) {
+	std::error_code error;
+	size = std::filesystem::file_size(sourcePath, error);
+	if (error) {
+		return false;
+	}
+	writeTime = int64_t(std::filesystem::last_write_time(sourcePath, error).time_since_epoch().count());
+	return !error;
+}
+
+} // namespace
+
+bool OpenUpToDateCookedMesh(const std::string& directoryPath, const std::string& filename, CookedMesh& cookedMesh) {
+	std::string sourcePath = directoryPath + "/" + filename;
+	uint64_t sourceSize = 0;
+	int64_t sourceWriteTime = 0;
+	if (!GetSourceStamp(sourcePath, sourceSize, sourceWriteTime)) {
+		return false;
+	}
+	if (!cookedMesh.Open(GetCookedMeshPath(directoryPath, filename))) {
+		return false;
+	}
+	const CookedMeshHeader& header = cookedMesh.GetHeader();
+	return header.sourceSize == sourceSize && header.sourceWriteTime == sourceWriteTime && cookedMesh.GetSourcePath() == sourcePath;
+}
+
+bool CookedMesh::Open(const std::string& cookedPath) {
+	header = nullptr;
+	if (!file.Open(cookedPath) || file.GetSize() < sizeof(CookedMeshHeader)) {
+		return false;
+	}
+	const CookedMeshHeader* fileHeader = reinterpret_cast<const CookedMeshHeader*>(file.GetData());
+	if (fileHeader->magic != kCookedMeshMagic || fileHeader->version != kCookedMeshVersion || fileHeader->vertexStride != sizeof(VertexData)) {
+		return false;
+	}
+	// 各ブロックがファイル内に収まっているか
+	uint64_t size = file.GetSize();
+	if (fileHeader->vertexOffset + uint64_t(fileHeader->vertexCount) * sizeof(VertexData) > size || fileHeader->indexOffset + uint64_t(fileHeader->indexCount) * sizeof(uint32_t) > size ||
+	    fileHeader->subMeshOffset + uint64_t(fileHeader->subMeshCount) * sizeof(CookedSubMesh) > size ||
+	    fileHeader->materialOffset + uint64_t(fileHeader->materialCount) * sizeof(CookedMaterial) > size || fileHeader->meshletOffset + uint64_t(fileHeader->meshletCount) * sizeof(MeshletData) > size ||
+	    fileHeader->meshletVertexOffset + uint64_t(fileHeader->meshletVertexCount) * sizeof(uint32_t) > size || fileHeader->meshletTriangleOffset + fileHeader->meshletTriangleCount > size ||
+	    fileHeader->lodOffset + uint64_t(fileHeader->lodCount) * sizeof(LodData) > size || fileHeader->lodSubMeshOffset + uint64_t(fileHeader->lodSubMeshCount) * sizeof(LodSubMeshData) > size ||
+	    fileHeader->stringOffset + fileHeader->stringSize > size) {
+		return false;
+	}
+	header = fileHeader;
+	return true;
+}
+
+std::span<const VertexData> CookedMesh::GetVertices() const { return {reinterpret_cast<const VertexData*>(file.GetData() + header->vertexOffset), header->vertexCount}; }
+
+std::span<const uint32_t> CookedMesh::GetIndices() const { return {reinterpret_cast<const uint32_t*>(file.GetData() + header->indexOffset), header->indexCount}; }
+
+std::span<const CookedSubMesh> CookedMesh::GetSubMeshes() const { return {reinterpret_cast<const CookedSubMesh*>(file.GetData() + header->subMeshOffset), header->subMeshCount}; }
+
+std::span<const CookedMaterial> CookedMesh::GetMaterials() const { return {reinterpret_cast<const CookedMaterial*>(file.GetData() + header->materialOffset), header->materialCount}; }
+
+std::span<const MeshletData> CookedMesh::GetMeshlets() const { return {reinterpret_cast<const MeshletData*>(file.GetData() + header->meshletOffset), header->meshletCount}; }
+
+std::span<const uint32_t> CookedMesh::GetMeshletVertices() const { return {reinterpret_cast<const uint32_t*>(file.GetData() + header->meshletVertexOffset), header->meshletVertexCount}; }
+
+std::span<const uint8_t> CookedMesh::GetMeshletTriangles() const { return {reinterpret_cast<const uint8_t*>(file.GetData() + header->meshletTriangleOffset), header->meshletTriangleCount}; }
+
+std::span<const LodData> CookedMesh::GetLods() const { return {reinterpret_cast<const LodData*>(file.GetData() + header->lodOffset), header->lodCount}; }
+
+std::span<const LodSubMeshData> CookedMesh::GetLodSubMeshes() const { return {reinterpret_cast<const LodSubMeshData*>(file.GetData() + header->lodSubMeshOffset), header->lodSubMeshCount}; }
+
+std::string_view CookedMesh::GetString(uint32_t offset, uint32_t length) const {
+	assert(uint64_t(offset) + length <= header->stringSize);
+	return std::string_view(file.GetData() + header->stringOffset + offset, length);
+}
+
+void CookedMesh::ExpandTables(ModelData& modelData) const {
+	modelData.subMeshes.clear();
+	modelData.subMeshes.reserve(header->subMeshCount);
+	for (const CookedSubMesh& subMesh : GetSubMeshes()) {
+		SubMeshData& subMeshData = modelData.subMeshes.emplace_back();
+		subMeshData.name = std::string(GetString(subMesh.nameOffset, subMesh.nameLength));
+		subMeshData.indexStart = subMesh.indexStart;
+		subMeshData.indexCount = subMesh.indexCount;
+		subMeshData.materialIndex = subMesh.materialIndex;
+		subMeshData.meshletStart = subMesh.meshletStart;
+		subMeshData.meshletCount = subMesh.meshletCount;
+		subMeshData.aabb = subMesh.aabb;
+		subMeshData.sphere = subMesh.sphere;
+	}
+	modelData.materials.clear();
+	modelData.materials.reserve(header->materialCount);
+	for (const CookedMaterial& material : GetMaterials()) {
+		MaterialData& materialData = modelData.materials.emplace_back();
+		materialData.name = std::string(GetString(material.nameOffset, material.nameLength));
+		materialData.libraryPath = std::string(GetString(material.libraryPathOffset, material.libraryPathLength));
+		materialData.materialId = materialData.libraryPath.empty() ? kDefaultMaterialId : GetMaterialLibrary().FindMaterial(materialData.libraryPath, materialData.name);
+	}
+	modelData.lods.assign(GetLods().begin(), GetLods().end());
+	modelData.lodSubMeshes.assign(GetLodSubMeshes().begin(), GetLodSubMeshes().end());
+	modelData.aabb = header->aabb;
+	modelData.sphere = header->sphere;
+}
+
+ModelData CookedMesh::ToModelData() const {
+	ModelData modelData;
+	ExpandTables(modelData);
+	modelData.vertices.assign(GetVertices().begin(), GetVertices().end());
+	modelData.indices.assign(GetIndices().begin(), GetIndices().end());
+	modelData.meshlets.assign(GetMeshlets().begin(), GetMeshlets().end());
+	modelData.meshletVertices.assign(GetMeshletVertices().begin(), GetMeshletVertices().end());
+	modelData.meshletTriangles.assign(GetMeshletTriangles().begin(), GetMeshletTriangles().end());
+	return modelData;
+}
+
+ModelAsset::ModelAsset(std::unique_ptr<CookedMesh> cookedMesh) : cookedMesh(std::move(cookedMesh)) { this->cookedMesh->ExpandTables(modelData); }
+
+std::span<const VertexData> ModelAsset::GetVertices() const { return cookedMesh ? cookedMesh->GetVertices() : std::span<const VertexData>(modelData.vertices); }
+
+std::span<const uint32_t> ModelAsset::GetIndices() const { return cookedMesh ? cookedMesh->GetIndices() : std::span<const uint32_t>(modelData.indices); }
+
+std::span<const MeshletData> ModelAsset::GetMeshlets() const { return cookedMesh ? cookedMesh->GetMeshlets() : std::span<const MeshletData>(modelData.meshlets); }
+
+std::span<const uint32_t> ModelAsset::GetMeshletVertices() const { return cookedMesh ? cookedMesh->GetMeshletVertices() : std::span<const uint32_t>(modelData.meshletVertices); }
+
+std::span<const uint8_t> ModelAsset::GetMeshletTriangles() const { return cookedMesh ? cookedMesh->GetMeshletTriangles() : std::span<const uint8_t>(modelData.meshletTriangles); }
+
+std::string GetCookedMeshPath(const std::string& directoryPath, const std::string& filename) {
+	std::string sourcePath = directoryPath + "/" + filename;
+	std::string stem = std::filesystem::path(filename).stem().string();
+	return std::format("{}/{}_{:016x}.mesh", kCookedMeshDirectory, stem, HashPath(sourcePath));
+}
+
+bool IsCookedMeshUpToDate(const std::string& directoryPath, const std::string& filename) {
+	CookedMesh cookedMesh;
+	return OpenUpToDateCookedMesh(directoryPath, filename, cookedMesh);
+}
+
+bool WriteCookedMesh(const std::string& directoryPath, const std::string& filename, const ModelData& modelData) {
+	std::string sourcePath = directoryPath + "/" + filename;
+	CookedMeshHeader header{};
+	header.magic = kCookedMeshMagic;
+	header.version = kCookedMeshVersion;
+	header.vertexStride = sizeof(VertexData);
+	if (!GetSourceStamp(sourcePath, header.sourceSize, header.sourceWriteTime)) {
+		return false;
+	}
+
+	// 文字列ブロック(先頭は元ファイルのパス)
+	std::string strings = sourcePath;
+	header.sourcePathLength = uint32_t(sourcePath.size());
+	auto appendString = [&strings](const std::string& value, uint32_t& offset, uint32_t& length) {
+		offset = uint32_t(strings.size());
+		length = uint32_t(value.size());
+		strings += value;
+	};
+	std::vector<CookedSubMesh> subMeshes(modelData.subMeshes.size());
+	for (size_t i = 0; i < subMeshes.size(); i++) {
+		const SubMeshData& subMesh = modelData.subMeshes[i];
+		subMeshes[i].indexStart = subMesh.indexStart;
+		subMeshes[i].indexCount = subMesh.indexCount;
+		subMeshes[i].materialIndex = subMesh.materialIndex;
+		subMeshes[i].meshletStart = subMesh.meshletStart;
+		subMeshes[i].meshletCount = subMesh.meshletCount;
+		subMeshes[i].aabb = subMesh.aabb;
+		subMeshes[i].sphere = subMesh.sphere;
+		appendString(subMesh.name, subMeshes[i].nameOffset, subMeshes[i].nameLength);
+	}
+	std::vector<CookedMaterial> materials(modelData.materials.size());
+	for (size_t i = 0; i < materials.size(); i++) {
+		appendString(modelData.materials[i].name, materials[i].nameOffset, materials[i].nameLength);
+		appendString(modelData.materials[i].libraryPath, materials[i].libraryPathOffset, materials[i].libraryPathLength);
+	}
+
+	// 各ブロックの配置を決める
+	header.vertexCount = uint32_t(modelData.vertices.size());
+	header.indexCount = uint32_t(modelData.indices.size());
+	header.subMeshCount = uint32_t(subMeshes.size());
+	header.materialCount = uint32_t(materials.size());
+	header.meshletCount = uint32_t(modelData.meshlets.size());
+	header.meshletVertexCount = uint32_t(modelData.meshletVertices.size());
+	header.meshletTriangleCount = uint32_t(modelData.meshletTriangles.size());
+	header.lodCount = uint32_t(modelData.lods.size());
+	header.lodSubMeshCount = uint32_t(modelData.lodSubMeshes.size());
+	header.vertexOffset = AlignUp(sizeof(CookedMeshHeader), kBlockAlignment);
+	header.indexOffset = AlignUp(header.vertexOffset + sizeof(VertexData) * modelData.vertices.size(), kBlockAlignment);
+	header.subMeshOffset = AlignUp(header.indexOffset + sizeof(uint32_t) * modelData.indices.size(), kBlockAlignment);
+	header.materialOffset = AlignUp(header.subMeshOffset + sizeof(CookedSubMesh) * header.subMeshCount, kBlockAlignment);
+	header.meshletOffset = AlignUp(header.materialOffset + sizeof(CookedMaterial) * header.materialCount, kBlockAlignment);
+	header.meshletVertexOffset = AlignUp(header.meshletOffset + sizeof(MeshletData) * header.meshletCount, kBlockAlignment);
+	header.meshletTriangleOffset = AlignUp(header.meshletVertexOffset + sizeof(uint32_t) * header.meshletVertexCount, kBlockAlignment);
+	header.lodOffset = AlignUp(header.meshletTriangleOffset + header.meshletTriangleCount, kBlockAlignment);
+	header.lodSubMeshOffset = AlignUp(header.lodOffset + sizeof(LodData) * header.lodCount, kBlockAlignment);
+	header.stringOffset = AlignUp(header.lodSubMeshOffset + sizeof(LodSubMeshData) * header.lodSubMeshCount, kBlockAlignment);
+	header.stringSize = strings.size();
+	header.aabb = modelData.aabb;
+	header.sphere = modelData.sphere;
+
+	std::vector<char> image(size_t(header.stringOffset + header.stringSize), 0);
+	std::memcpy(image.data(), &header, sizeof(header));
+	std::memcpy(image.data() + header.vertexOffset, modelData.vertices.data(), sizeof(VertexData) * modelData.vertices.size());
+	std::memcpy(image.data() + header.indexOffset, modelData.indices.data(), sizeof(uint32_t) * modelData.indices.size());
+	std::memcpy(image.data() + header.subMeshOffset, subMeshes.data(), sizeof(CookedSubMesh) * subMeshes.size());
+	std::memcpy(image.data() + header.materialOffset, materials.data(), sizeof(CookedMaterial) * materials.size());
+	std::memcpy(image.data() + header.meshletOffset, modelData.meshlets.data(), sizeof(MeshletData) * modelData.meshlets.size());
+	std::memcpy(image.data() + header.meshletVertexOffset, modelData.meshletVertices.data(), sizeof(uint32_t) * modelData.meshletVertices.size());
+	std::memcpy(image.data() + header.meshletTriangleOffset, modelData.meshletTriangles.data(), modelData.meshletTriangles.size());
+	std::memcpy(image.data() + header.lodOffset, modelData.lods.data(), sizeof(LodData) * modelData.lods.size());
+	std::memcpy(image.data() + header.lodSubMeshOffset, modelData.lodSubMeshes.data(), sizeof(LodSubMeshData) * modelData.lodSubMeshes.size());
+	std::memcpy(image.data() + header.stringOffset, strings.data(), strings.size());
+
+	// 書き込み途中のファイルを読まないように、一時ファイルに書いてから置き換える
+	std::error_code error;
+	std::filesystem::create_directories(kCookedMeshDirectory, error);
+	std::string cookedPath = GetCookedMeshPath(directoryPath, filename);
+	// 同じモデルを複数のスレッドで読み込んでも一時ファイルが重ならないように、スレッドごとに名前を変える
+	std::string temporaryPath = std::format("{}.{:x}.tmp", cookedPath, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			return false;
+		}
+		file.write(image.data(), std::streamsize(image.size()));
+		if (!file.good()) {
+			return false;
+		}
+	}
+	std::filesystem::rename(temporaryPath, cookedPath, error);
+	return !error;
+}
+
+ModelAsset LoadModelFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount, MeshOptimizationReport* optimizationReport) {
+	{
+		// 配列はマップしたまま参照する
+		auto cookedMesh = std::make_unique<CookedMesh>();
+		if (OpenUpToDateCookedMesh(directoryPath, filename, *cookedMesh)) {
+			return ModelAsset(std::move(cookedMesh));
+		}
+	}
+	ModelData modelData = LoadObjFile(directoryPath, filename, threadCount);
+	MeshOptimizationReport report = OptimizeMesh(modelData);
+	if (optimizationReport != nullptr) {
+		*optimizationReport = report;
+	}
+	BuildLods(modelData);
+	BuildMeshlets(modelData);
+	WriteCookedMesh(directoryPath, filename, modelData);
+	return ModelAsset(std::move(modelData));
+}
+
+bool ValidateCookedMesh(const std::string& directoryPath, const std::string& filename, std::string& report) {
+	report.clear();
+	CookedMesh cookedMesh;
+	if (!cookedMesh.Open(GetCookedMeshPath(directoryPath, filename))) {
+		report = "cooked mesh is missing or has an unknown format\n";
+		return false;
+	}
+	if (!IsCookedMeshUpToDate(directoryPath, filename)) {
+		report += "cooked mesh is older than the source\n";
+	}
+	ModelData source = LoadObjFile(directoryPath, filename, 0);
+	OptimizeMesh(source);
+	BuildLods(source);
+	BuildMeshlets(source);
+	ModelData cooked = cookedMesh.ToModelData();
+
+	if (source.vertices.size() != cooked.vertices.size()) {
+		report += std::format("vertex count: source {} cooked {}\n", source.vertices.size(), cooked.vertices.size());
+	} else {
+		for (size_t i = 0; i < source.vertices.size(); i++) {
+			if (std::memcmp(&source.vertices[i], &cooked.vertices[i], sizeof(VertexData)) != 0) {
+				report += std::format("first vertex mismatch at {}\n", i);
+				break;
+			}
+		}
+	}
+	if (source.indices != cooked.indices) {
+		report += std::format("index data differs (source {} cooked {})\n", source.indices.size(), cooked.indices.size());
+	}
+	if (source.subMeshes.size() != cooked.subMeshes.size()) {
+		report += std::format("submesh count: source {} cooked {}\n", source.subMeshes.size(), cooked.subMeshes.size());
+	} else {
+		for (size_t i = 0; i < source.subMeshes.size(); i++) {
+			const SubMeshData& a = source.subMeshes[i];
+			const SubMeshData& b = cooked.subMeshes[i];
+			if (a.name != b.name || a.indexStart != b.indexStart || a.indexCount != b.indexCount || a.materialIndex != b.materialIndex || a.meshletStart != b.meshletStart || a.meshletCount != b.meshletCount ||
+			    std::memcmp(&a.aabb, &b.aabb, sizeof(AABB)) != 0 || std::memcmp(&a.sphere, &b.sphere, sizeof(Sphere)) != 0) {
+				report += std::format("submesh {} differs ('{}' {}+{} material {})\n", i, b.name, b.indexStart, b.indexCount, b.materialIndex);
+			}
+		}
+	}
+	if (source.materials.size() != cooked.materials.size()) {
+		report += std::format("material count: source {} cooked {}\n", source.materials.size(), cooked.materials.size());
+	} else {
+		for (size_t i = 0; i < source.materials.size(); i++) {
+			const MaterialData& a = source.materials[i];
+			const MaterialData& b = cooked.materials[i];
+			if (a.name != b.name || a.libraryPath != b.libraryPath || a.materialId != b.materialId) {
+				report += std::format("material {}: source '{}' in '{}' cooked '{}' in '{}'\n", i, a.name, a.libraryPath, b.name, b.libraryPath);
+			}
+		}
+	}
+	if (source.meshlets.size() != cooked.meshlets.size()) {
+		report += std::format("meshlet count: source {} cooked {}\n", source.meshlets.size(), cooked.meshlets.size());
+	} else if (!source.meshlets.empty() && std::memcmp(source.meshlets.data(), cooked.meshlets.data(), sizeof(MeshletData) * source.meshlets.size()) != 0) {
+		report += "meshlet data differs\n";
+	}
+	if (source.lods.size() != cooked.lods.size() || (!source.lods.empty() && std::memcmp(source.lods.data(), cooked.lods.data(), sizeof(LodData) * source.lods.size()) != 0)) {
+		report += std::format("lod data differs (source {} cooked {} levels)\n", source.lods.size(), cooked.lods.size());
+	}
+	if (source.lodSubMeshes.size() != cooked.lodSubMeshes.size() ||
+	    (!source.lodSubMeshes.empty() && std::memcmp(source.lodSubMeshes.data(), cooked.lodSubMeshes.data(), sizeof(LodSubMeshData) * source.lodSubMeshes.size()) != 0)) {
+		report += "lod submesh ranges differ\n";
+	}
+	if (std::memcmp(&source.aabb, &cooked.aabb, sizeof(AABB)) != 0 || std::memcmp(&source.sphere, &cooked.sphere, sizeof(Sphere)) != 0) {
+		report += "model bounds differ\n";
+	}
+	if (source.meshletVertices != cooked.meshletVertices || source.meshletTriangles != cooked.meshletTriangles) {
+		report += "meshlet vertices or triangles differ\n";
+	}
+	return report.empty();
+}
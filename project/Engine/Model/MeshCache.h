@@ -0,0 +1,191 @@
+#pragma once
+#include "../Base/MappedFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "ModelData.h"
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+// クックドメッシュのファイル識別子とバージョン(形式を変えたら上げる)
+static const uint32_t kCookedMeshMagic = 0x4853454D; // "MESH"
+static const uint32_t kCookedMeshVersion = 7;
+
+/// <summary>
+/// クックドメッシュのファイルヘッダ
+/// ヘッダの後ろに頂点、インデックス、サブメッシュ表、マテリアル表、メッシュレット、LOD、文字列を並べる
+/// </summary>
+struct CookedMeshHeader {
+	uint32_t magic;         // ファイル識別子
+	uint32_t version;       // 形式のバージョン
+	uint32_t vertexStride;  // 1頂点のサイズ(VertexDataの変更検出用)
+	uint32_t vertexCount;   // 頂点数
+	uint32_t indexCount;    // インデックス数
+	uint32_t subMeshCount;  // サブメッシュ数
+	uint32_t materialCount; // マテリアル数
+	uint32_t meshletCount;  // メッシュレット数
+	uint32_t meshletVertexCount;
+	uint32_t meshletTriangleCount; // メッシュレットの三角形の要素数(三角形数 * 3)
+	uint32_t lodCount;             // LOD0を含むLODの数(0ならLODなし)
+	uint32_t lodSubMeshCount;
+	uint32_t sourcePathLength;
+	uint64_t sourceSize;     // 元ファイルのサイズ
+	int64_t sourceWriteTime; // 元ファイルの更新時刻
+	uint64_t vertexOffset;   // 各ブロックのファイル先頭からの位置
+	uint64_t indexOffset;
+	uint64_t subMeshOffset;
+	uint64_t materialOffset;
+	uint64_t meshletOffset;
+	uint64_t meshletVertexOffset;
+	uint64_t meshletTriangleOffset;
+	uint64_t lodOffset;
+	uint64_t lodSubMeshOffset;
+	uint64_t stringOffset;
+	uint64_t stringSize;
+	AABB aabb;     // モデル全体のバウンディングボックス
+	Sphere sphere; // モデル全体のバウンディングスフィア
+};
+
+/// <summary>
+/// サブメッシュ表の要素(名前は文字列ブロック内の位置で持つ)
+/// </summary>
+struct CookedSubMesh {
+	uint32_t indexStart;    // 開始インデックス
+	uint32_t indexCount;    // インデックス数
+	uint32_t materialIndex; // マテリアル表の番号
+	uint32_t meshletStart;  // 開始メッシュレット
+	uint32_t meshletCount;  // メッシュレット数
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	AABB aabb;              // バウンディングボックス
+	Sphere sphere;          // バウンディングスフィア
+};
+
+/// <summary>
+/// マテリアル表の要素(文字列は文字列ブロック内の位置で持つ)
+/// マテリアルの内容は持たず、開くときにmtlのパスと名前でMaterialLibraryから取得する
+/// </summary>
+struct CookedMaterial {
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	uint32_t libraryPathOffset;
+	uint32_t libraryPathLength;
+};
+
+/// <summary>
+/// マップしたクックドメッシュ。解析せずにファイル上の頂点とインデックスを参照する
+/// </summary>
+class CookedMesh {
+public:
+	/// <summary>
+	/// クックドメッシュを開く
+	/// </summary>
+	/// <param name="cookedPath">クックドメッシュのパス</param>
+	/// <returns>形式が正しく開けたか</returns>
+	bool Open(const std::string& cookedPath);
+
+	const CookedMeshHeader& GetHeader() const { return *header; }
+	// 各ブロックはマップしたファイルを直接指す(このオブジェクトが開いている間だけ有効)
+	std::span<const VertexData> GetVertices() const;
+	std::span<const uint32_t> GetIndices() const;
+	std::span<const CookedSubMesh> GetSubMeshes() const;
+	std::span<const CookedMaterial> GetMaterials() const;
+	std::span<const MeshletData> GetMeshlets() const;
+	std::span<const uint32_t> GetMeshletVertices() const;
+	std::span<const uint8_t> GetMeshletTriangles() const;
+	std::span<const LodData> GetLods() const;
+	std::span<const LodSubMeshData> GetLodSubMeshes() const;
+	std::string_view GetString(uint32_t offset, uint32_t length) const;
+	std::string_view GetSourcePath() const { return GetString(0, header->sourcePathLength); }
+
+	/// <summary>
+	/// サブメッシュ、マテリアル、LODの表と境界だけをModelDataに展開する(マテリアルはMaterialLibraryで解決する)
+	/// 頂点、インデックス、メッシュレットの配列は展開しない
+	/// </summary>
+	void ExpandTables(ModelData& modelData) const;
+
+	/// <summary>
+	/// 全てをModelDataにコピーして展開する
+	/// </summary>
+	ModelData ToModelData() const;
+
+private:
+	MappedFile file;
+	const CookedMeshHeader* header = nullptr;
+};
+
+/// <summary>
+/// LoadModelFileで読み込んだモデル
+/// クックドメッシュから読み込んだときは、頂点、インデックス、メッシュレットの配列をコピーせずにマップしたファイルから参照する
+/// (配列はこのオブジェクトが生きている間だけ有効なので、アップロードは破棄する前に行う)
+/// </summary>
+class ModelAsset {
+public:
+	ModelAsset() = default;
+	// 解析したモデルを持つ
+	explicit ModelAsset(ModelData&& modelData) : modelData(std::move(modelData)) {}
+	// 開いたクックドメッシュを持つ
+	explicit ModelAsset(std::unique_ptr<CookedMesh> cookedMesh);
+
+	std::span<const VertexData> GetVertices() const;
+	std::span<const uint32_t> GetIndices() const;
+	std::span<const MeshletData> GetMeshlets() const;
+	std::span<const uint32_t> GetMeshletVertices() const;
+	std::span<const uint8_t> GetMeshletTriangles() const;
+	const std::vector<SubMeshData>& GetSubMeshes() const { return modelData.subMeshes; }
+	const std::vector<MaterialData>& GetMaterials() const { return modelData.materials; }
+	const std::vector<LodData>& GetLods() const { return modelData.lods; }
+	const std::vector<LodSubMeshData>& GetLodSubMeshes() const { return modelData.lodSubMeshes; }
+	const AABB& GetAABB() const { return modelData.aabb; }
+	const Sphere& GetSphere() const { return modelData.sphere; }
+	// クックドメッシュをマップして参照しているか
+	bool IsMapped() const { return cookedMesh != nullptr; }
+
+private:
+	std::unique_ptr<CookedMesh> cookedMesh; // クックドメッシュから読み込んだときのみ
+	ModelData modelData;                    // 解析したときは全て、クックドメッシュのときは表と境界だけを持つ
+};
+
+/// <summary>
+/// 元ファイルに対応するクックドメッシュのパスを返す
+/// </summary>
+std::string GetCookedMeshPath(const std::string& directoryPath, const std::string& filename);
+
+/// <summary>
+/// クックドメッシュが存在し、元ファイルのサイズと更新時刻が一致しているか
+/// </summary>
+bool IsCookedMeshUpToDate(const std::string& directoryPath, const std::string& filename);
+
+/// <summary>
+/// 元ファイルと一致する最新のクックドメッシュを開く
+/// </summary>
+/// <param name="cookedMesh">開いたクックドメッシュ</param>
+/// <returns>最新のものが開けたか</returns>
+bool OpenUpToDateCookedMesh(const std::string& directoryPath, const std::string& filename, CookedMesh& cookedMesh);
+
+/// <summary>
+/// モデルデータをクックドメッシュとして書き出す
+/// </summary>
+/// <returns>書き出せたか</returns>
+bool WriteCookedMesh(const std::string& directoryPath, const std::string& filename, const ModelData& modelData);
+
+/// <summary>
+/// モデルを読み込む関数
+/// 最新のクックドメッシュがあればそれをマップして配列をコピーせずに参照し、なければobjを解析し、
+/// 頂点キャッシュとオーバードローの最適化(OptimizeMesh)とLODの生成(BuildLods)、メッシュレットの生成(BuildMeshlets)をしてからクックドメッシュを書き出す
+/// </summary>
+/// <param name="directoryPath">ディレクトリパス</param>
+/// <param name="filename">ファイル名</param>
+/// <param name="threadCount">objの解析に使うスレッド数(0でハードウェアのスレッド数)</param>
+/// <param name="optimizationReport">クックしたときに最適化の結果を受け取る(クックドメッシュを使ったときは変更しない)</param>
+/// <returns>読み込んだモデル</returns>
+ModelAsset LoadModelFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount = 0, MeshOptimizationReport* optimizationReport = nullptr);
+
+/// <summary>
+/// クックドメッシュと元のobjを比較する(objはクック時と同じ最適化とLOD、メッシュレットの生成をしてから比較する)
+/// </summary>
+/// <param name="report">見つかった差分の説明</param>
+/// <returns>一致したか</returns>
+bool ValidateCookedMesh(const std::string& directoryPath, const std::string& filename, std::string& report);
@@ -0,0 +1,259 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+/// <summary>
+/// 三角形の面積で重み付けした法線(外積)と重心
+/// </summary>
+void GetTriangleNormalAndCentroid(const std::vector<VertexData>& vertices, const uint32_t* triangle, Vector3& normal, Vector3& centroid) {
+	const Vector4& p0 = vertices[triangle[0]].position;
+	const Vector4& p1 = vertices[triangle[1]].position;
+	const Vector4& p2 = vertices[triangle[2]].position;
+	normal = Cross(Vector3{p1.x - p0.x, p1.y - p0.y, p1.z - p0.z}, Vector3{p2.x - p0.x, p2.y - p0.y, p2.z - p0.z});
+	centroid = {(p0.x + p1.x + p2.x) / 3.0f, (p0.y + p1.y + p2.y) / 3.0f, (p0.z + p1.z + p2.z) / 3.0f};
+}
+
+} // namespace
+
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize) {
+	// 頂点がキャッシュに入った時刻。cacheSize回より前に入ったものは追い出されている
+	std::vector<uint32_t> cacheTimes(vertexCount, 0);
+	std::vector<bool> isReferenced(vertexCount, false);
+	uint32_t time = cacheSize + 1;
+	size_t transformCount = 0;
+	size_t referencedCount = 0;
+	for (size_t i = 0; i < indexCount; i++) {
+		uint32_t vertex = indices[i];
+		if (time - cacheTimes[vertex] > cacheSize) {
+			cacheTimes[vertex] = time++;
+			transformCount++;
+		}
+		if (!isReferenced[vertex]) {
+			isReferenced[vertex] = true;
+			referencedCount++;
+		}
+	}
+	VertexCacheStatistics statistics{0.0f, 0.0f};
+	if (indexCount >= 3) {
+		statistics.acmr = float(transformCount) / float(indexCount / 3);
+		statistics.atvr = float(transformCount) / float(referencedCount);
+	}
+	return statistics;
+}
+
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& clusterStarts) {
+	clusterStarts.clear();
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// 頂点ごとに、まだ出力していない三角形の数と、接する三角形の一覧
+	std::vector<uint32_t> liveCounts(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		liveCounts[indices[i]]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+		adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveCounts[vertex];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		adjacency[fillOffsets[indices[i]]++] = uint32_t(i / 3);
+	}
+
+	std::vector<uint32_t> cacheTimes(vertexCount, 0);
+	std::vector<bool> isEmitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds;   // 出力した頂点(行き詰まったときの次の候補)
+	std::vector<uint32_t> candidates; // 直前に出力した三角形の頂点
+	std::vector<uint32_t> output;
+	deadEnds.reserve(triangleCount * 3);
+	output.reserve(triangleCount * 3);
+	uint32_t time = kVertexCacheSize + 1;
+	size_t cursor = 0;
+	int64_t fanning = indices[0];
+	clusterStarts.push_back(0);
+	while (fanning >= 0) {
+		// 扇の中心の頂点に接する三角形を全て出力する
+		candidates.clear();
+		for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++) {
+			uint32_t triangle = adjacency[a];
+			if (isEmitted[triangle]) {
+				continue;
+			}
+			isEmitted[triangle] = true;
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t vertex = indices[triangle * 3 + k];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				liveCounts[vertex]--;
+				if (time - cacheTimes[vertex] > kVertexCacheSize) {
+					cacheTimes[vertex] = time++;
+				}
+			}
+		}
+
+		// 次の扇の中心は、扇を出力し終えてもキャッシュに残っている頂点のうち一番古いもの
+		int64_t next = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t vertex : candidates) {
+			if (liveCounts[vertex] == 0) {
+				continue;
+			}
+			int64_t priority = 0;
+			if (time - cacheTimes[vertex] + 2 * liveCounts[vertex] <= kVertexCacheSize) {
+				priority = time - cacheTimes[vertex];
+			}
+			if (priority > bestPriority) {
+				bestPriority = priority;
+				next = vertex;
+			}
+		}
+		if (next < 0) {
+			// 行き詰まったら、最近出力した頂点、それもなければ番号順に三角形が残っている頂点から続ける
+			while (!deadEnds.empty() && next < 0) {
+				uint32_t vertex = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveCounts[vertex] > 0) {
+					next = vertex;
+				}
+			}
+			for (; cursor < vertexCount && next < 0; cursor++) {
+				if (liveCounts[cursor] > 0) {
+					next = int64_t(cursor);
+				}
+			}
+			if (next >= 0) {
+				clusterStarts.push_back(uint32_t(output.size() / 3));
+			}
+		}
+		fanning = next;
+	}
+	assert(output.size() == triangleCount * 3);
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<VertexData>& vertices, const std::vector<uint32_t>& clusterStarts) {
+	const size_t triangleCount = indexCount / 3;
+	const size_t clusterCount = clusterStarts.size();
+	if (clusterCount <= 1) {
+		return;
+	}
+
+	// まとまりごとの法線と重心、メッシュ全体の重心(いずれも面積で重み付け)
+	std::vector<Vector3> clusterNormals(clusterCount, Vector3{0.0f, 0.0f, 0.0f});
+	std::vector<Vector3> clusterCentroids(clusterCount, Vector3{0.0f, 0.0f, 0.0f});
+	std::vector<float> clusterAreas(clusterCount, 0.0f);
+	Vector3 meshCentroid = {0.0f, 0.0f, 0.0f};
+	float meshArea = 0.0f;
+	for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+		size_t end = cluster + 1 < clusterCount ? clusterStarts[cluster + 1] : triangleCount;
+		for (size_t triangle = clusterStarts[cluster]; triangle < end; triangle++) {
+			Vector3 normal, centroid;
+			GetTriangleNormalAndCentroid(vertices, indices + triangle * 3, normal, centroid);
+			float area = Length(normal);
+			clusterNormals[cluster] = clusterNormals[cluster] + normal;
+			clusterCentroids[cluster] = clusterCentroids[cluster] + area * centroid;
+			clusterAreas[cluster] += area;
+		}
+		meshCentroid = meshCentroid + clusterCentroids[cluster];
+		meshArea += clusterAreas[cluster];
+	}
+	if (meshArea <= 0.0f) {
+		return;
+	}
+	meshCentroid = (1.0f / meshArea) * meshCentroid;
+
+	// 中心から離れて外を向いているまとまりほど他を隠しやすいので先に描く
+	// 面の向き(表が時計回りか)はモデルによるので、全体として外を向く符号に合わせる
+	std::vector<float> occlusions(clusterCount, 0.0f);
+	float orientation = 0.0f;
+	for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+		if (clusterAreas[cluster] <= 0.0f) {
+			continue;
+		}
+		Vector3 centroid = (1.0f / clusterAreas[cluster]) * clusterCentroids[cluster];
+		occlusions[cluster] = Dot(centroid - meshCentroid, Normalize(clusterNormals[cluster]));
+		orientation += occlusions[cluster] * clusterAreas[cluster];
+	}
+	float sign = orientation >= 0.0f ? 1.0f : -1.0f;
+	std::vector<uint32_t> order(clusterCount);
+	for (uint32_t i = 0; i < clusterCount; i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sign * occlusions[a] > sign * occlusions[b]; });
+
+	std::vector<uint32_t> sorted;
+	sorted.reserve(triangleCount * 3);
+	for (uint32_t cluster : order) {
+		size_t end = cluster + 1 < clusterCount ? clusterStarts[cluster + 1] : triangleCount;
+		sorted.insert(sorted.end(), indices + size_t(clusterStarts[cluster]) * 3, indices + end * 3);
+	}
+	std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+void OptimizeVertexFetch(ModelData& modelData) {
+	std::vector<uint32_t> remap(modelData.vertices.size(), UINT32_MAX);
+	std::vector<VertexData> vertices;
+	vertices.reserve(modelData.vertices.size());
+	for (uint32_t& index : modelData.indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = uint32_t(vertices.size());
+			vertices.push_back(modelData.vertices[index]);
+		}
+		index = remap[index];
+	}
+	// どの三角形からも使われていない頂点は後ろに残す
+	for (size_t i = 0; i < modelData.vertices.size(); i++) {
+		if (remap[i] == UINT32_MAX) {
+			vertices.push_back(modelData.vertices[i]);
+		}
+	}
+	modelData.vertices = std::move(vertices);
+}
+
+MeshOptimizationReport OptimizeMesh(ModelData& modelData) {
+	MeshOptimizationReport report{};
+	report.before = AnalyzeVertexCache(modelData.indices.data(), modelData.indices.size(), modelData.vertices.size());
+
+	std::vector<SubMeshData> ranges = modelData.subMeshes;
+	if (ranges.empty()) {
+		ranges.push_back({"", 0, uint32_t(modelData.indices.size()), 0, 0, 0, {}, {}}); // 全体を1つの範囲として扱う
+	}
+	// サブメッシュが使う頂点だけに詰めた番号で最適化する(サブメッシュごとに頂点数分の作業領域を作らないため)
+	std::vector<uint32_t> localIndices(modelData.vertices.size(), UINT32_MAX);
+	std::vector<uint32_t> globalIndices;
+	std::vector<uint32_t> rangeIndices;
+	std::vector<uint32_t> clusterStarts;
+	for (const SubMeshData& range : ranges) {
+		uint32_t* indices = modelData.indices.data() + range.indexStart;
+		globalIndices.clear();
+		rangeIndices.resize(range.indexCount);
+		for (uint32_t i = 0; i < range.indexCount; i++) {
+			uint32_t& local = localIndices[indices[i]];
+			if (local == UINT32_MAX) {
+				local = uint32_t(globalIndices.size());
+				globalIndices.push_back(indices[i]);
+			}
+			rangeIndices[i] = local;
+		}
+		OptimizeVertexCache(rangeIndices.data(), rangeIndices.size(), globalIndices.size(), clusterStarts);
+		for (uint32_t i = 0; i < range.indexCount; i++) {
+			indices[i] = globalIndices[rangeIndices[i]];
+		}
+		for (uint32_t global : globalIndices) {
+			localIndices[global] = UINT32_MAX;
+		}
+		OptimizeOverdraw(indices, range.indexCount, modelData.vertices, clusterStarts);
+		report.clusterCount += uint32_t(clusterStarts.size());
+	}
+	OptimizeVertexFetch(modelData);
+
+	report.after = AnalyzeVertexCache(modelData.indices.data(), modelData.indices.size(), modelData.vertices.size());
+	return report;
+}
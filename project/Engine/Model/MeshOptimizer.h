@@ -0,0 +1,54 @@
+#pragma once
+#include "ModelData.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 最適化と評価に使う頂点キャッシュのサイズ
+static const uint32_t kVertexCacheSize = 16;
+
+/// <summary>
+/// 頂点キャッシュの効率
+/// </summary>
+struct VertexCacheStatistics {
+	float acmr; // 三角形あたりの頂点シェーダーの実行回数(0.5に近いほど良い)
+	float atvr; // 頂点あたりの頂点シェーダーの実行回数(1に近いほど良い)
+};
+
+/// <summary>
+/// OptimizeMeshの結果
+/// </summary>
+struct MeshOptimizationReport {
+	VertexCacheStatistics before;
+	VertexCacheStatistics after;
+	uint32_t clusterCount; // オーバードロー削減のために並べ替えた三角形のまとまりの数
+};
+
+/// <summary>
+/// FIFOの頂点キャッシュを模擬して効率を求める
+/// </summary>
+VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = kVertexCacheSize);
+
+/// <summary>
+/// 三角形を頂点キャッシュに残りやすい順に並べ替える(Tipsify)
+/// </summary>
+/// <param name="clusterStarts">キャッシュの流れが途切れた位置(三角形の番号)。オーバードローの並べ替えの単位になる</param>
+void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& clusterStarts);
+
+/// <summary>
+/// 外側を向いたまとまりが先に描画されるように、三角形のまとまりを並べ替える
+/// まとまりの中の順序は変えないので、頂点キャッシュの効率はほぼ保たれる
+/// </summary>
+/// <param name="clusterStarts">OptimizeVertexCacheが返したまとまりの開始位置</param>
+void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<VertexData>& vertices, const std::vector<uint32_t>& clusterStarts);
+
+/// <summary>
+/// 頂点をインデックスで最初に使われる順に並べ替え、インデックスを付け直す
+/// </summary>
+void OptimizeVertexFetch(ModelData& modelData);
+
+/// <summary>
+/// サブメッシュごとに頂点キャッシュとオーバードローの最適化をし、最後に頂点の並びを最適化する
+/// サブメッシュの範囲とマテリアルは変わらない
+/// </summary>
+MeshOptimizationReport OptimizeMesh(ModelData& modelData);
@@ -0,0 +1,457 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+// 境界の辺を保つための二次誤差の重み
+const double kBorderWeight = 10.0;
+// 縮約で三角形の法線の向きがこれより変わる(変化前後の内積がこれを下回る)場合は縮約しない
+const double kMinNormalDot = 0.25;
+// 元の面に対して裏を向いた三角形が、縮約でさらに裏を向いてよい量(元の面の向きとの内積の変化。入力の誤差を見込む)
+const double kSurfaceDotTolerance = 0.01;
+// 三角形数がこの比より減らなかったLODは作らない
+const float kMinLodReduction = 0.95f;
+
+/// <summary>
+/// 平面からの距離の二乗の和を表す二次誤差(平面ax+by+cz+d=0の係数の積を重み付きで足したもの)
+/// </summary>
+struct Quadric {
+	double a2, b2, c2, ab, ac, bc, ad, bd, cd, d2;
+	double weight;
+};
+
+void AddPlaneQuadric(Quadric& quadric, const Vector3& normal, const Vector3& point, double weight) {
+	double a = normal.x;
+	double b = normal.y;
+	double c = normal.z;
+	double d = -(a * point.x + b * point.y + c * point.z);
+	quadric.a2 += weight * a * a;
+	quadric.b2 += weight * b * b;
+	quadric.c2 += weight * c * c;
+	quadric.ab += weight * a * b;
+	quadric.ac += weight * a * c;
+	quadric.bc += weight * b * c;
+	quadric.ad += weight * a * d;
+	quadric.bd += weight * b * d;
+	quadric.cd += weight * c * d;
+	quadric.d2 += weight * d * d;
+	quadric.weight += weight;
+}
+
+void AddQuadric(Quadric& quadric, const Quadric& other) {
+	quadric.a2 += other.a2;
+	quadric.b2 += other.b2;
+	quadric.c2 += other.c2;
+	quadric.ab += other.ab;
+	quadric.ac += other.ac;
+	quadric.bc += other.bc;
+	quadric.ad += other.ad;
+	quadric.bd += other.bd;
+	quadric.cd += other.cd;
+	quadric.d2 += other.d2;
+	quadric.weight += other.weight;
+}
+
+/// <summary>
+/// 点から平面までの距離の二乗の重み付き平均
+/// </summary>
+double EvaluateQuadric(const Quadric& quadric, const Vector3& point) {
+	if (quadric.weight <= 0.0) {
+		return 0.0;
+	}
+	double x = point.x;
+	double y = point.y;
+	double z = point.z;
+	double error = quadric.a2 * x * x + quadric.b2 * y * y + quadric.c2 * z * z + 2.0 * (quadric.ab * x * y + quadric.ac * x * z + quadric.bc * y * z) +
+	               2.0 * (quadric.ad * x + quadric.bd * y + quadric.cd * z) + quadric.d2;
+	return std::max(error, 0.0) / quadric.weight;
+}
+
+uint64_t GetEdgeKey(uint32_t a, uint32_t b) { return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a; }
+
+/// <summary>
+/// 辺の縮約の候補(from の位置を to の位置に寄せる)
+/// </summary>
+struct Collapse {
+	uint32_t from;
+	uint32_t to;
+	double error; // 距離の二乗
+};
+
+} // namespace
+
+float SimplifyMesh(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float maxError, std::vector<uint32_t>& result) {
+	result.clear();
+	const size_t inputTriangleCount = indexCount / 3;
+	if (inputTriangleCount == 0) {
+		return 0.0f;
+	}
+
+	// 範囲が使う頂点だけに詰めた番号にする
+	std::vector<uint32_t> globalIndices(indices, indices + inputTriangleCount * 3);
+	std::sort(globalIndices.begin(), globalIndices.end());
+	globalIndices.erase(std::unique(globalIndices.begin(), globalIndices.end()), globalIndices.end());
+	const uint32_t vertexCount = uint32_t(globalIndices.size());
+	std::vector<uint32_t> corners(inputTriangleCount * 3);
+	for (size_t i = 0; i < corners.size(); i++) {
+		corners[i] = uint32_t(std::lower_bound(globalIndices.begin(), globalIndices.end(), indices[i]) - globalIndices.begin());
+	}
+	std::vector<Vector3> positions(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; i++) {
+		const Vector4& position = vertices[globalIndices[i]].position;
+		positions[i] = {position.x, position.y, position.z};
+	}
+
+	// 同じ位置の頂点(UVや法線が違うだけのもの)を1つの位置として扱う。positionIdsは位置の代表の頂点
+	std::vector<uint32_t> order(vertexCount);
+	std::iota(order.begin(), order.end(), 0u);
+	auto lessPosition = [&](uint32_t a, uint32_t b) {
+		const Vector3& pa = positions[a];
+		const Vector3& pb = positions[b];
+		if (pa.x != pb.x) {
+			return pa.x < pb.x;
+		}
+		if (pa.y != pb.y) {
+			return pa.y < pb.y;
+		}
+		return pa.z < pb.z;
+	};
+	std::stable_sort(order.begin(), order.end(), lessPosition);
+	std::vector<uint32_t> positionIds(vertexCount);
+	for (uint32_t i = 0; i < vertexCount; i++) {
+		positionIds[order[i]] = (i > 0 && !lessPosition(order[i - 1], order[i])) ? positionIds[order[i - 1]] : order[i];
+	}
+
+	// 位置ごとの二次誤差(接する三角形の平面を面積で重み付けしたもの)と、元の面の向き(面積で重み付けした法線の和)
+	std::vector<Quadric> quadrics(vertexCount, Quadric{});
+	std::vector<Vector3> surfaceNormals(vertexCount, Vector3{0.0f, 0.0f, 0.0f});
+	for (size_t triangle = 0; triangle < inputTriangleCount; triangle++) {
+		const Vector3& p0 = positions[corners[triangle * 3]];
+		Vector3 normal = Cross(positions[corners[triangle * 3 + 1]] - p0, positions[corners[triangle * 3 + 2]] - p0);
+		float area = Length(normal);
+		if (area == 0.0f) {
+			continue;
+		}
+		for (uint32_t k = 0; k < 3; k++) {
+			AddPlaneQuadric(quadrics[positionIds[corners[triangle * 3 + k]]], Normalize(normal), p0, area);
+			surfaceNormals[positionIds[corners[triangle * 3 + k]]] = surfaceNormals[positionIds[corners[triangle * 3 + k]]] + normal;
+		}
+	}
+
+	// 境界の辺には、三角形に垂直で辺を含む平面を足して、境界が内側に動かないようにする
+	std::vector<uint64_t> edgeKeys;
+	auto collectEdges = [&]() {
+		edgeKeys.clear();
+		for (size_t i = 0; i < corners.size(); i += 3) {
+			for (uint32_t k = 0; k < 3; k++) {
+				edgeKeys.push_back(GetEdgeKey(positionIds[corners[i + k]], positionIds[corners[i + (k + 1) % 3]]));
+			}
+		}
+		std::sort(edgeKeys.begin(), edgeKeys.end());
+	};
+	auto countEdge = [&](uint32_t a, uint32_t b) {
+		auto range = std::equal_range(edgeKeys.begin(), edgeKeys.end(), GetEdgeKey(a, b));
+		return size_t(range.second - range.first);
+	};
+	collectEdges();
+	for (size_t triangle = 0; triangle < inputTriangleCount; triangle++) {
+		const Vector3& p0 = positions[corners[triangle * 3]];
+		Vector3 normal = Normalize(Cross(positions[corners[triangle * 3 + 1]] - p0, positions[corners[triangle * 3 + 2]] - p0));
+		for (uint32_t k = 0; k < 3; k++) {
+			uint32_t a = positionIds[corners[triangle * 3 + k]];
+			uint32_t b = positionIds[corners[triangle * 3 + (k + 1) % 3]];
+			if (countEdge(a, b) != 1) {
+				continue;
+			}
+			Vector3 edge = positions[b] - positions[a];
+			double length = Length(edge);
+			Vector3 borderNormal = Normalize(Cross(edge, normal));
+			AddPlaneQuadric(quadrics[a], borderNormal, positions[a], kBorderWeight * length * length);
+			AddPlaneQuadric(quadrics[b], borderNormal, positions[a], kBorderWeight * length * length);
+		}
+	}
+
+	const size_t targetTriangleCount = targetIndexCount / 3;
+	const double maxErrorSquared = double(maxError) * double(maxError);
+	double resultErrorSquared = 0.0;
+	size_t triangleCount = inputTriangleCount;
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+	std::vector<bool> isTouched(vertexCount); // この回の縮約で消えた、または寄せられた位置
+	std::vector<bool> isPinned(vertexCount);  // この回の縮約で動かせない位置
+	std::vector<uint32_t> wedgeRemap(vertexCount);
+	std::vector<std::pair<uint32_t, uint32_t>> wedgePairs;
+	std::iota(wedgeRemap.begin(), wedgeRemap.end(), 0u);
+
+	// fromの全ての頂点(UVなどが違うもの)を、同じ三角形にあるtoの頂点に寄せられるか調べ、その対応と消える三角形の数を返す
+	auto canCollapse = [&](uint32_t from, uint32_t to, size_t& removedCount) {
+		// 境界やシームは、境界の辺に沿ってのみ動かせる(シームは頂点の対応が決まらなければ動かせない)
+		size_t fromEdgeCount = countEdge(from, to);
+		if (fromEdgeCount == 0 || fromEdgeCount > 2) {
+			return false;
+		}
+		wedgePairs.clear();
+		removedCount = 0;
+		bool isBorder = false;
+		for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++) {
+			const uint32_t* triangle = &corners[size_t(adjacency[a]) * 3];
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t other = positionIds[triangle[k]];
+				size_t edgeCount = other != from ? countEdge(from, other) : 0;
+				if (edgeCount > 2) {
+					return false; // 3つ以上の三角形が共有する辺に接する位置は動かさない
+				}
+				isBorder = isBorder || edgeCount == 1;
+			}
+		}
+		if (isBorder && fromEdgeCount != 1) {
+			return false;
+		}
+		for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++) {
+			const uint32_t* triangle = &corners[size_t(adjacency[a]) * 3];
+			uint32_t fromWedge = UINT32_MAX;
+			uint32_t toWedge = UINT32_MAX;
+			for (uint32_t k = 0; k < 3; k++) {
+				if (positionIds[triangle[k]] == from) {
+					fromWedge = triangle[k];
+				} else if (positionIds[triangle[k]] == to) {
+					toWedge = triangle[k];
+				}
+			}
+			if (toWedge == UINT32_MAX) {
+				continue;
+			}
+			removedCount++;
+			for (const auto& pair : wedgePairs) {
+				if (pair.first == fromWedge && pair.second != toWedge) {
+					return false;
+				}
+			}
+			wedgePairs.push_back({fromWedge, toWedge});
+		}
+		for (uint32_t a = adjacencyOffsets[from]; a < adjacencyOffsets[from + 1]; a++) {
+			const uint32_t* triangle = &corners[size_t(adjacency[a]) * 3];
+			Vector3 before[3];
+			Vector3 after[3];
+			bool hasTo = false;
+			uint32_t fromWedge = UINT32_MAX;
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t position = positionIds[triangle[k]];
+				hasTo = hasTo || position == to;
+				fromWedge = position == from ? triangle[k] : fromWedge;
+				before[k] = positions[triangle[k]];
+				after[k] = position == from ? positions[to] : before[k];
+			}
+			if (hasTo) {
+				continue;
+			}
+			// 残る三角形の頂点にも、toの頂点の対応がなければならない
+			bool isMapped = false;
+			for (const auto& pair : wedgePairs) {
+				isMapped = isMapped || pair.first == fromWedge;
+			}
+			if (!isMapped) {
+				return false;
+			}
+			// 裏返ったり大きく傾いたりする三角形ができないか
+			Vector3 normalBefore = Cross(before[1] - before[0], before[2] - before[0]);
+			Vector3 normalAfter = Cross(after[1] - after[0], after[2] - after[0]);
+			if (double(Dot(normalBefore, normalAfter)) < kMinNormalDot * double(Length(normalBefore)) * double(Length(normalAfter))) {
+				return false;
+			}
+			// 1回ごとの傾きは小さくても、縮約を重ねると元の面に対して裏返ることがあるので、元の面の向きとも比べる
+			// (入力の時点で裏を向いている極小の三角形などは、この縮約でさらに裏を向くのでなければ止めない)
+			Vector3 surfaceNormal = surfaceNormals[from] + surfaceNormals[to];
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t position = positionIds[triangle[k]];
+				surfaceNormal = position != from && position != to ? surfaceNormal + surfaceNormals[position] : surfaceNormal;
+			}
+			double surfaceLength = Length(surfaceNormal);
+			double lengthBefore = Length(normalBefore);
+			double lengthAfter = Length(normalAfter);
+			if (surfaceLength > 0.0 && lengthBefore > 0.0 && lengthAfter > 0.0) {
+				double surfaceDotBefore = Dot(surfaceNormal, normalBefore) / (surfaceLength * lengthBefore);
+				double surfaceDotAfter = Dot(surfaceNormal, normalAfter) / (surfaceLength * lengthAfter);
+				if (surfaceDotAfter < 0.0 && surfaceDotAfter < surfaceDotBefore - kSurfaceDotTolerance) {
+					return false;
+				}
+			}
+		}
+		return removedCount > 0;
+	};
+
+	while (triangleCount > targetTriangleCount) {
+		// 位置ごとの接する三角形の一覧と、辺を共有する三角形の数
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0u);
+		for (uint32_t corner : corners) {
+			adjacencyOffsets[positionIds[corner] + 1]++;
+		}
+		std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+		adjacency.resize(corners.size());
+		std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t i = 0; i < corners.size(); i++) {
+			adjacency[fillOffsets[positionIds[corners[i]]]++] = uint32_t(i / 3);
+		}
+		collectEdges();
+
+		// 辺ごとに、両方の向きの縮約を候補にする(共有される辺の重複は並べ替えた後に除く)
+		collapses.clear();
+		for (size_t i = 0; i < corners.size(); i += 3) {
+			for (uint32_t k = 0; k < 3; k++) {
+				uint32_t a = positionIds[corners[i + k]];
+				uint32_t b = positionIds[corners[i + (k + 1) % 3]];
+				if (a == b) {
+					continue;
+				}
+				collapses.push_back({a, b, EvaluateQuadric(quadrics[a], positions[b])});
+				collapses.push_back({b, a, EvaluateQuadric(quadrics[b], positions[a])});
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+			if (a.error != b.error) {
+				return a.error < b.error;
+			}
+			return a.from != b.from ? a.from < b.from : a.to < b.to;
+		});
+		collapses.erase(std::unique(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.from == b.from && a.to == b.to; }), collapses.end());
+
+		// 誤差の小さい順に、互いに重ならない縮約をまとめて行う
+		std::fill(isTouched.begin(), isTouched.end(), false);
+		std::fill(isPinned.begin(), isPinned.end(), false);
+		size_t collapseGoal = std::max<size_t>((triangleCount - targetTriangleCount) / 2, 1);
+		size_t collapseCount = 0;
+		for (const Collapse& collapse : collapses) {
+			if (collapse.error > maxErrorSquared || collapseCount >= collapseGoal) {
+				break;
+			}
+			size_t removedCount = 0;
+			if (isTouched[collapse.from] || isTouched[collapse.to] || isPinned[collapse.from] || !canCollapse(collapse.from, collapse.to, removedCount)) {
+				continue;
+			}
+			for (const auto& pair : wedgePairs) {
+				wedgeRemap[pair.first] = pair.second;
+			}
+			AddQuadric(quadrics[collapse.to], quadrics[collapse.from]);
+			surfaceNormals[collapse.to] = surfaceNormals[collapse.to] + surfaceNormals[collapse.from];
+			isTouched[collapse.from] = true;
+			isTouched[collapse.to] = true;
+			// fromの周りの位置は裏返りの判定に使ったので、同じ回では動かさない(寄せる先にはなってよい)
+			for (uint32_t a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1]; a++) {
+				for (uint32_t k = 0; k < 3; k++) {
+					isPinned[positionIds[corners[size_t(adjacency[a]) * 3 + k]]] = true;
+				}
+			}
+			resultErrorSquared = std::max(resultErrorSquared, collapse.error);
+			collapseCount++;
+			if (triangleCount - std::min(triangleCount, removedCount) <= targetTriangleCount) {
+				triangleCount -= std::min(triangleCount, removedCount);
+				break;
+			}
+			triangleCount -= removedCount;
+		}
+		if (collapseCount == 0) {
+			break;
+		}
+
+		// 頂点を付け替え、つぶれた三角形を取り除く
+		size_t writeIndex = 0;
+		for (size_t i = 0; i < corners.size(); i += 3) {
+			uint32_t c0 = wedgeRemap[corners[i]];
+			uint32_t c1 = wedgeRemap[corners[i + 1]];
+			uint32_t c2 = wedgeRemap[corners[i + 2]];
+			if (positionIds[c0] == positionIds[c1] || positionIds[c1] == positionIds[c2] || positionIds[c2] == positionIds[c0]) {
+				continue;
+			}
+			corners[writeIndex++] = c0;
+			corners[writeIndex++] = c1;
+			corners[writeIndex++] = c2;
+		}
+		corners.resize(writeIndex);
+		triangleCount = corners.size() / 3;
+		std::iota(wedgeRemap.begin(), wedgeRemap.end(), 0u);
+	}
+
+	// 結果は頂点キャッシュに合わせて並べる
+	std::vector<uint32_t> clusterStarts;
+	OptimizeVertexCache(corners.data(), corners.size(), vertexCount, clusterStarts);
+	result.resize(corners.size());
+	for (size_t i = 0; i < corners.size(); i++) {
+		result[i] = globalIndices[corners[i]];
+	}
+	return float(std::sqrt(resultErrorSquared));
+}
+
+void BuildLods(ModelData& modelData, uint32_t maxLodCount, float triangleRatio, float maxRelativeError) {
+	assert(maxLodCount >= 1 && maxLodCount <= kMaxLodCount);
+	// 作り直すときは、LOD0より後ろのインデックスを捨てる
+	if (!modelData.lods.empty()) {
+		modelData.indices.resize(modelData.lods[0].indexCount);
+	}
+	modelData.lods.clear();
+	modelData.lodSubMeshes.clear();
+
+	std::vector<LodSubMeshData> ranges;
+	for (const SubMeshData& subMesh : modelData.subMeshes) {
+		ranges.push_back({subMesh.indexStart, subMesh.indexCount});
+	}
+	if (ranges.empty()) {
+		ranges.push_back({0, uint32_t(modelData.indices.size())});
+	}
+	modelData.lods.push_back({0, uint32_t(modelData.indices.size()), 0, 0.0f});
+	modelData.lodSubMeshes = ranges;
+	if (modelData.vertices.empty()) {
+		return;
+	}
+
+	// 誤差の上限はモデルの大きさに対する比で決める
+	Vector3 minimum = {modelData.vertices[0].position.x, modelData.vertices[0].position.y, modelData.vertices[0].position.z};
+	Vector3 maximum = minimum;
+	for (const VertexData& vertex : modelData.vertices) {
+		minimum = {std::min(minimum.x, vertex.position.x), std::min(minimum.y, vertex.position.y), std::min(minimum.z, vertex.position.z)};
+		maximum = {std::max(maximum.x, vertex.position.x), std::max(maximum.y, vertex.position.y), std::max(maximum.z, vertex.position.z)};
+	}
+	const float maxError = maxRelativeError * Length(maximum - minimum);
+
+	std::vector<uint32_t> simplified;
+	for (uint32_t level = 1; level < maxLodCount; level++) {
+		const LodData& previous = modelData.lods.back();
+		// 誤差は前のLOD以上にして、番号順に増えるようにする
+		LodData lod{uint32_t(modelData.indices.size()), 0, uint32_t(modelData.lodSubMeshes.size()), previous.error};
+		for (const LodSubMeshData& range : ranges) {
+			size_t targetIndexCount = size_t(float(range.indexCount / 3) * std::pow(triangleRatio, float(level))) * 3;
+			float error = SimplifyMesh(modelData.vertices, modelData.indices.data() + range.indexStart, range.indexCount, targetIndexCount, maxError, simplified);
+			lod.error = std::max(lod.error, error);
+			modelData.lodSubMeshes.push_back({uint32_t(modelData.indices.size()), uint32_t(simplified.size())});
+			modelData.indices.insert(modelData.indices.end(), simplified.begin(), simplified.end());
+		}
+		lod.indexCount = uint32_t(modelData.indices.size()) - lod.indexStart;
+		if (float(lod.indexCount) > float(previous.indexCount) * kMinLodReduction) {
+			// 誤差の上限のためにほとんど減らせなかった
+			modelData.indices.resize(lod.indexStart);
+			modelData.lodSubMeshes.resize(lod.subMeshStart);
+			break;
+		}
+		modelData.lods.push_back(lod);
+	}
+}
+
+float GetAllowedLodError(float pixelError, float distance, float scale, float fovY, float viewportHeight) {
+	// 距離distanceで画面の高さに映る範囲は2 * distance * tan(fovY / 2)
+	float worldPerPixel = 2.0f * distance * std::tan(fovY * 0.5f) / viewportHeight;
+	return pixelError * worldPerPixel / std::max(scale, 1e-6f);
+}
+
+uint32_t SelectLod(const std::vector<LodData>& lods, float allowedError) {
+	assert(lods.size() <= kMaxLodCount);
+	uint32_t lod = 0;
+	for (uint32_t i = 1; i < lods.size(); i++) {
+		lod = lods[i].error <= allowedError ? i : lod;
+	}
+	return lod;
+}
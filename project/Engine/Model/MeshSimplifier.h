@@ -0,0 +1,48 @@
+#pragma once
+#include "ModelData.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LOD0を含むLODの最大数
+static const uint32_t kMaxLodCount = 8;
+
+/// <summary>
+/// 二次誤差(QEM)で辺を縮約して三角形を減らす
+/// 頂点は作らずに既存の頂点へ寄せるので、結果は同じ頂点バッファを参照する
+/// UVや法線が分かれている頂点(シーム)はシームに沿ってのみ動かし、穴や面の境界は境界に沿ってのみ動かす
+/// </summary>
+/// <param name="vertices">頂点</param>
+/// <param name="indices">三角形のインデックス</param>
+/// <param name="indexCount">インデックス数</param>
+/// <param name="targetIndexCount">目標のインデックス数</param>
+/// <param name="maxError">許容する誤差(モデル座標での距離)。これを超える縮約はしない</param>
+/// <param name="result">減らした三角形のインデックス</param>
+/// <returns>結果の誤差(モデル座標での距離)</returns>
+float SimplifyMesh(const std::vector<VertexData>& vertices, const uint32_t* indices, size_t indexCount, size_t targetIndexCount, float maxError, std::vector<uint32_t>& result);
+
+/// <summary>
+/// サブメッシュごとに三角形を減らしたLODを作り、インデックスの後ろに追加する
+/// LODnの目標の三角形数はLOD0のtriangleRatio^n倍で、誤差の上限で減らせなくなったらそこで止める
+/// </summary>
+/// <param name="maxLodCount">LOD0を含むLODの最大数(kMaxLodCount以下)</param>
+/// <param name="triangleRatio">1つ前のLODに対する三角形数の比</param>
+/// <param name="maxRelativeError">許容する誤差(モデルのバウンディングボックスの対角線に対する比)</param>
+void BuildLods(ModelData& modelData, uint32_t maxLodCount = 4, float triangleRatio = 0.5f, float maxRelativeError = 0.02f);
+
+/// <summary>
+/// 画面上で許容する誤差(ピクセル)を、モデル座標での誤差に直す
+/// </summary>
+/// <param name="pixelError">許容する画面上の誤差(ピクセル)</param>
+/// <param name="distance">カメラからモデルまでの距離</param>
+/// <param name="scale">モデルの拡大率(軸ごとに違う場合は最大のもの)</param>
+/// <param name="fovY">縦の視野角(ラジアン)</param>
+/// <param name="viewportHeight">ビューポートの高さ(ピクセル)</param>
+float GetAllowedLodError(float pixelError, float distance, float scale, float fovY, float viewportHeight);
+
+/// <summary>
+/// 誤差がallowedError以下の中で一番粗いLODを選ぶ
+/// LODの誤差は番号順に増えるので、LODの最大数(kMaxLodCount)回の比較で決まる
+/// </summary>
+/// <returns>LODの番号(LODがなければ0)</returns>
+uint32_t SelectLod(const std::vector<LodData>& lods, float allowedError);
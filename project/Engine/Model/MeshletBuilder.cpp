@@ -0,0 +1,248 @@
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// 法線コーンの広がりがこれより大きい(軸との内積の最小値が小さい)メッシュレットは向きでカリングしない
+const float kMinConeDot = 0.1f;
+
+Vector3 GetPosition(const std::vector<VertexData>& vertices, uint32_t index) {
+	const Vector4& position = vertices[index].position;
+	return {position.x, position.y, position.z};
+}
+
+/// <summary>
+/// 頂点と三角形を持たないメッシュレット(境界と法線コーンはComputeMeshletBoundsで求める)
+/// </summary>
+MeshletData MakeEmptyMeshlet(uint32_t vertexOffset, uint32_t triangleOffset) {
+	MeshletData meshlet{};
+	meshlet.vertexOffset = vertexOffset;
+	meshlet.vertexCount = 0;
+	meshlet.triangleOffset = triangleOffset;
+	meshlet.triangleCount = 0;
+	meshlet.center = {0.0f, 0.0f, 0.0f};
+	meshlet.radius = 0.0f;
+	meshlet.coneApex = {0.0f, 0.0f, 0.0f};
+	meshlet.coneAxis = {0.0f, 0.0f, 0.0f};
+	meshlet.coneCutoff = 1.0f;
+	return meshlet;
+}
+
+} // namespace
+
+void BuildMeshlets(const uint32_t* indices, size_t indexCount, const std::vector<VertexData>& vertices, std::vector<MeshletData>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles) {
+	const size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// 範囲が使う頂点だけに詰めた番号にする(範囲ごとに全頂点数分の作業領域を作らないため)
+	std::vector<uint32_t> globalIndices(indices, indices + triangleCount * 3);
+	std::sort(globalIndices.begin(), globalIndices.end());
+	globalIndices.erase(std::unique(globalIndices.begin(), globalIndices.end()), globalIndices.end());
+	const size_t vertexCount = globalIndices.size();
+	std::vector<uint32_t> localIndices(triangleCount * 3);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		localIndices[i] = uint32_t(std::lower_bound(globalIndices.begin(), globalIndices.end(), indices[i]) - globalIndices.begin());
+	}
+
+	// 頂点ごとに、まだメッシュレットに入れていない三角形の数と、接する三角形の一覧
+	std::vector<uint32_t> liveCounts(vertexCount, 0);
+	for (uint32_t local : localIndices) {
+		liveCounts[local]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+		adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + liveCounts[vertex];
+	}
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t i = 0; i < triangleCount * 3; i++) {
+		adjacency[fillOffsets[localIndices[i]]++] = uint32_t(i / 3);
+	}
+
+	// 頂点が今のメッシュレットに入っているか(meshletMarksが今のメッシュレットの番号と一致するか)と、その中の番号
+	std::vector<uint32_t> meshletMarks(vertexCount, UINT32_MAX);
+	std::vector<uint8_t> meshletSlots(vertexCount, 0);
+	std::vector<uint32_t> meshletLocals; // 今のメッシュレットの頂点(詰めた番号)
+	std::vector<bool> isEmitted(triangleCount, false);
+	MeshletData meshlet = MakeEmptyMeshlet(uint32_t(meshletVertices.size()), uint32_t(meshletTriangles.size()));
+	uint32_t meshletNumber = 0;
+
+	// 新しく増える頂点が少なく、残りの三角形が少ない頂点を使う(メッシュレットの境界を増やさない)三角形ほど良い
+	auto getExtraVertexCount = [&](uint32_t triangle) {
+		uint32_t extra = 0;
+		for (uint32_t k = 0; k < 3; k++) {
+			extra += meshletMarks[localIndices[triangle * 3 + k]] != meshletNumber ? 1 : 0;
+		}
+		return extra;
+	};
+	int64_t best = -1;
+	uint32_t bestExtra = 0;
+	uint32_t bestLive = 0;
+	auto considerTriangles = [&](uint32_t vertex) {
+		for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++) {
+			uint32_t triangle = adjacency[a];
+			if (isEmitted[triangle]) {
+				continue;
+			}
+			uint32_t extra = getExtraVertexCount(triangle);
+			uint32_t live = liveCounts[localIndices[triangle * 3]] + liveCounts[localIndices[triangle * 3 + 1]] + liveCounts[localIndices[triangle * 3 + 2]];
+			if (best < 0 || extra < bestExtra || (extra == bestExtra && (live < bestLive || (live == bestLive && triangle < best)))) {
+				best = triangle;
+				bestExtra = extra;
+				bestLive = live;
+			}
+		}
+	};
+	auto finishMeshlet = [&]() {
+		ComputeMeshletBounds(meshlet, vertices, meshletVertices, meshletTriangles);
+		meshlets.push_back(meshlet);
+		meshlet = MakeEmptyMeshlet(uint32_t(meshletVertices.size()), uint32_t(meshletTriangles.size()));
+		meshletLocals.clear();
+		meshletNumber++;
+	};
+
+	size_t cursor = 0;
+	int64_t lastTriangle = -1;
+	for (size_t emitted = 0; emitted < triangleCount; emitted++) {
+		// 直前の三角形の隣から選び、新しい頂点が必要ならメッシュレット内の全ての頂点に接する三角形からも探す
+		best = -1;
+		if (lastTriangle >= 0) {
+			for (uint32_t k = 0; k < 3; k++) {
+				considerTriangles(localIndices[lastTriangle * 3 + k]);
+			}
+		}
+		if (best < 0 || bestExtra > 0) {
+			for (uint32_t local : meshletLocals) {
+				considerTriangles(local);
+			}
+		}
+		if (best < 0) {
+			// つながった三角形がなければ、インデックス順で次の三角形から続ける
+			while (isEmitted[cursor]) {
+				cursor++;
+			}
+			best = int64_t(cursor);
+			bestExtra = getExtraVertexCount(uint32_t(cursor));
+		}
+
+		if (meshlet.vertexCount + bestExtra > kMeshletMaxVertices || meshlet.triangleCount == kMeshletMaxTriangles) {
+			finishMeshlet();
+		}
+
+		uint32_t triangle = uint32_t(best);
+		isEmitted[triangle] = true;
+		for (uint32_t k = 0; k < 3; k++) {
+			uint32_t local = localIndices[triangle * 3 + k];
+			liveCounts[local]--;
+			if (meshletMarks[local] != meshletNumber) {
+				meshletMarks[local] = meshletNumber;
+				meshletSlots[local] = uint8_t(meshlet.vertexCount++);
+				meshletVertices.push_back(globalIndices[local]);
+				meshletLocals.push_back(local);
+			}
+			meshletTriangles.push_back(meshletSlots[local]);
+		}
+		meshlet.triangleCount++;
+		lastTriangle = triangle;
+	}
+	finishMeshlet();
+}
+
+MeshletReport BuildMeshlets(ModelData& modelData) {
+	modelData.meshlets.clear();
+	modelData.meshletVertices.clear();
+	modelData.meshletTriangles.clear();
+	if (modelData.subMeshes.empty()) {
+		size_t indexCount = modelData.lods.empty() ? modelData.indices.size() : modelData.lods[0].indexCount;
+		BuildMeshlets(modelData.indices.data(), indexCount, modelData.vertices, modelData.meshlets, modelData.meshletVertices, modelData.meshletTriangles);
+	}
+	for (SubMeshData& subMesh : modelData.subMeshes) {
+		subMesh.meshletStart = uint32_t(modelData.meshlets.size());
+		BuildMeshlets(modelData.indices.data() + subMesh.indexStart, subMesh.indexCount, modelData.vertices, modelData.meshlets, modelData.meshletVertices, modelData.meshletTriangles);
+		subMesh.meshletCount = uint32_t(modelData.meshlets.size()) - subMesh.meshletStart;
+	}
+
+	MeshletReport report{uint32_t(modelData.meshlets.size()), 0.0f, 0.0f};
+	if (report.meshletCount > 0) {
+		report.averageVertexCount = float(modelData.meshletVertices.size()) / float(report.meshletCount);
+		report.averageTriangleCount = float(modelData.meshletTriangles.size() / 3) / float(report.meshletCount);
+	}
+	return report;
+}
+
+void ComputeMeshletBounds(MeshletData& meshlet, const std::vector<VertexData>& vertices, const std::vector<uint32_t>& meshletVertices, const std::vector<uint8_t>& meshletTriangles) {
+	assert(meshlet.vertexCount > 0);
+	const uint32_t* meshletIndices = meshletVertices.data() + meshlet.vertexOffset;
+	const uint8_t* triangles = meshletTriangles.data() + meshlet.triangleOffset;
+
+	// バウンディングスフィアは頂点のAABBの中心から一番遠い頂点までとする
+	Vector3 minimum = GetPosition(vertices, meshletIndices[0]);
+	Vector3 maximum = minimum;
+	for (uint32_t i = 1; i < meshlet.vertexCount; i++) {
+		Vector3 position = GetPosition(vertices, meshletIndices[i]);
+		minimum = {std::min(minimum.x, position.x), std::min(minimum.y, position.y), std::min(minimum.z, position.z)};
+		maximum = {std::max(maximum.x, position.x), std::max(maximum.y, position.y), std::max(maximum.z, position.z)};
+	}
+	meshlet.center = 0.5f * (minimum + maximum);
+	meshlet.radius = 0.0f;
+	for (uint32_t i = 0; i < meshlet.vertexCount; i++) {
+		meshlet.radius = std::max(meshlet.radius, Length(GetPosition(vertices, meshletIndices[i]) - meshlet.center));
+	}
+
+	// 法線コーンの軸は三角形の法線の平均、広がりは軸と一番離れた法線までの角度
+	std::vector<Vector3> normals;
+	normals.reserve(meshlet.triangleCount);
+	Vector3 normalSum = {0.0f, 0.0f, 0.0f};
+	for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++) {
+		Vector3 p0 = GetPosition(vertices, meshletIndices[triangles[triangle * 3]]);
+		Vector3 p1 = GetPosition(vertices, meshletIndices[triangles[triangle * 3 + 1]]);
+		Vector3 p2 = GetPosition(vertices, meshletIndices[triangles[triangle * 3 + 2]]);
+		Vector3 normal = Cross(p1 - p0, p2 - p0);
+		if (Length(normal) == 0.0f) {
+			// 面積のない三角形は描画されないので向きに含めない
+			normals.push_back({0.0f, 0.0f, 0.0f});
+			continue;
+		}
+		normals.push_back(Normalize(normal));
+		normalSum = normalSum + normals.back();
+	}
+	meshlet.coneApex = meshlet.center;
+	meshlet.coneAxis = Normalize(normalSum);
+	meshlet.coneCutoff = 1.0f;
+	if (Length(normalSum) == 0.0f) {
+		return;
+	}
+	float minDot = 1.0f;
+	for (const Vector3& normal : normals) {
+		if (Length(normal) > 0.0f) {
+			minDot = std::min(minDot, Dot(meshlet.coneAxis, normal));
+		}
+	}
+	if (minDot <= kMinConeDot) {
+		return;
+	}
+
+	// 全ての三角形の面より裏側になるまで、中心から軸の逆向きに頂点を下げる
+	float maxDistance = 0.0f;
+	for (uint32_t triangle = 0; triangle < meshlet.triangleCount; triangle++) {
+		if (Length(normals[triangle]) == 0.0f) {
+			continue;
+		}
+		Vector3 p0 = GetPosition(vertices, meshletIndices[triangles[triangle * 3]]);
+		float distance = Dot(meshlet.center - p0, normals[triangle]) / Dot(meshlet.coneAxis, normals[triangle]);
+		maxDistance = std::max(maxDistance, distance);
+	}
+	meshlet.coneApex = meshlet.center - maxDistance * meshlet.coneAxis;
+	meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+bool IsMeshletBackfacing(const MeshletData& meshlet, const Vector3& cameraPosition) {
+	if (meshlet.coneCutoff >= 1.0f) {
+		return false;
+	}
+	return Dot(Normalize(meshlet.coneApex - cameraPosition), meshlet.coneAxis) >= meshlet.coneCutoff;
+}
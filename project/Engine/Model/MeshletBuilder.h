@@ -0,0 +1,47 @@
+#pragma once
+#include "ModelData.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// メッシュレット1つあたりの頂点数と三角形数の上限
+static const uint32_t kMeshletMaxVertices = 64;
+static const uint32_t kMeshletMaxTriangles = 124;
+
+/// <summary>
+/// BuildMeshletsの結果
+/// </summary>
+struct MeshletReport {
+	uint32_t meshletCount;
+	float averageVertexCount;   // メッシュレットあたりの平均頂点数
+	float averageTriangleCount; // メッシュレットあたりの平均三角形数
+};
+
+/// <summary>
+/// インデックスの範囲をメッシュレットに分ける
+/// 直前に追加した三角形と辺や頂点を共有する三角形から、新しい頂点が少ないものを優先して追加する
+/// 同じ入力からは常に同じ結果になる
+/// </summary>
+/// <param name="indices">三角形のインデックス</param>
+/// <param name="indexCount">インデックス数</param>
+/// <param name="vertices">頂点(バウンディングスフィアと法線コーンの計算に使う)</param>
+/// <param name="meshlets">作ったメッシュレットを末尾に追加する</param>
+/// <param name="meshletVertices">メッシュレットの頂点を末尾に追加する</param>
+/// <param name="meshletTriangles">メッシュレットの三角形を末尾に追加する</param>
+void BuildMeshlets(const uint32_t* indices, size_t indexCount, const std::vector<VertexData>& vertices, std::vector<MeshletData>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles);
+
+/// <summary>
+/// サブメッシュごとにメッシュレットを作り、modelDataのメッシュレットとサブメッシュの範囲を設定する
+/// </summary>
+MeshletReport BuildMeshlets(ModelData& modelData);
+
+/// <summary>
+/// メッシュレットのバウンディングスフィアと法線コーンを求める
+/// </summary>
+void ComputeMeshletBounds(MeshletData& meshlet, const std::vector<VertexData>& vertices, const std::vector<uint32_t>& meshletVertices, const std::vector<uint8_t>& meshletTriangles);
+
+/// <summary>
+/// カメラからメッシュレットの全ての三角形が裏向きに見えるか
+/// 三角形の表はCross(p1 - p0, p2 - p0)の向き(左手座標系で時計回りが表のとき外向き)とする
+/// </summary>
+bool IsMeshletBackfacing(const MeshletData& meshlet, const Vector3& cameraPosition);
@@ -0,0 +1,90 @@
+#pragma once
+#include "../3d/Bounds.h"
+#include "../3d/Screen.h"
+#include "../3d/Vector3.h"
+#include "../3d/Vector4.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// 頂点データ
+/// </summary>
+struct VertexData {
+	Vector4 position;
+	Vector2 texcoord;
+	Vector3 normal;
+};
+
+/// <summary>
+/// モデルが使うマテリアル。内容はMaterialLibraryで共有する
+/// </summary>
+struct MaterialData {
+	std::string name;        // usemtlで指定された名前
+	std::string libraryPath; // 定義されているmtlファイルのパス(定義がなければ空)
+	uint32_t materialId;     // MaterialLibraryのマテリアル番号
+};
+
+/// <summary>
+/// 頂点とインデックスを共有するモデルの一部分(o/gとusemtlの組ごと)
+/// </summary>
+struct SubMeshData {
+	std::string name;       // o/gで指定された名前
+	uint32_t indexStart;    // 開始インデックス
+	uint32_t indexCount;    // インデックス数
+	uint32_t materialIndex; // materialsの番号
+	uint32_t meshletStart;  // 開始メッシュレット(BuildMeshletsで設定する)
+	uint32_t meshletCount;  // メッシュレット数
+	AABB aabb;              // LOD0の三角形が使う頂点のバウンディングボックス
+	Sphere sphere;          // LOD0の三角形が使う頂点のバウンディングスフィア
+};
+
+/// <summary>
+/// 三角形のまとまり(メッシュレット)。まとまりごとのカリングに使う
+/// </summary>
+struct MeshletData {
+	uint32_t vertexOffset;   // meshletVertices内の開始位置
+	uint32_t vertexCount;    // 頂点数
+	uint32_t triangleOffset; // meshletTriangles内の開始位置(1三角形につき3要素)
+	uint32_t triangleCount;  // 三角形数
+	Vector3 center;          // バウンディングスフィアの中心
+	float radius;            // バウンディングスフィアの半径
+	Vector3 coneApex;        // 法線コーンの頂点
+	Vector3 coneAxis;        // 法線コーンの軸(三角形の表の向きの平均)
+	float coneCutoff;        // 法線コーンの広がりのsin(1なら向きによるカリングはしない)
+};
+
+/// <summary>
+/// 詳細度(LOD)ごとのインデックスの範囲。LOD0は元のメッシュで、LOD1以降のインデックスはLOD0の後ろに並ぶ
+/// </summary>
+struct LodData {
+	uint32_t indexStart;   // 開始インデックス
+	uint32_t indexCount;   // インデックス数
+	uint32_t subMeshStart; // lodSubMeshesの開始位置(サブメッシュと同じ数だけ並ぶ)
+	float error;           // 元のメッシュからの誤差(モデル座標での距離)
+};
+
+/// <summary>
+/// あるLODでのサブメッシュのインデックスの範囲(マテリアルはsubMeshesと同じ)
+/// </summary>
+struct LodSubMeshData {
+	uint32_t indexStart;
+	uint32_t indexCount;
+};
+
+/// <summary>
+/// モデルの読み込み結果
+/// </summary>
+struct ModelData {
+	std::vector<VertexData> vertices;         // 頂点データ(重複のない頂点)
+	std::vector<uint32_t> indices;            // インデックスデータ(3つで1つの三角形、LOD1以降を含む)
+	std::vector<SubMeshData> subMeshes;       // サブメッシュ(マテリアル順に並び、同じマテリアルのインデックスは連続する)
+	std::vector<MaterialData> materials;      // マテリアル表
+	std::vector<MeshletData> meshlets;        // メッシュレット(サブメッシュ順)
+	std::vector<uint32_t> meshletVertices;    // メッシュレットの頂点(verticesの番号)
+	std::vector<uint8_t> meshletTriangles;    // メッシュレットの三角形(メッシュレット内の頂点の番号)
+	std::vector<LodData> lods;                // 詳細度(BuildLodsで作る。空ならLOD0のみ)
+	std::vector<LodSubMeshData> lodSubMeshes; // LODごとのサブメッシュの範囲
+	AABB aabb;                                // モデル全体のバウンディングボックス(ComputeModelBoundsで求める)
+	Sphere sphere;                            // モデル全体のバウンディングスフィア
+};
@@ -0,0 +1,577 @@
+#include "ObjLoader.h"
+#include "../Base/MappedFile.h"
+#include "MaterialLibrary.h"
+#include "TextScanner.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+using namespace TextScanner;
+
+namespace {
+
+// 分割して読み込む際の1チャンクの最小サイズ(これより小さいファイルは分割しない)
+const size_t kMinChunkSize = 1024 * 1024;
+// チャンク内の相対参照を表す値の基準(負の値で保持する)
+const int32_t kRelativeIndexBias = 1 << 30;
+// 参照がないことを表す値
+const int32_t kNoIndex = -1;
+
+/// <summary>
+/// 面の1頂点が参照する要素の番号
+/// 解析直後は「0:なし、正:ファイル先頭からの1始まりの番号、負:チャンク内の相対参照」、
+/// 解決後は結合した要素配列の0始まりの番号(kNoIndexはなし)
+/// </summary>
+struct ObjCorner {
+	int32_t position;
+	int32_t texcoord;
+	int32_t normal;
+};
+
+/// <summary>
+/// グループ(o/g)かマテリアル(usemtl)の切り替え
+/// </summary>
+struct ObjGroupChange {
+	uint32_t faceIndex;    // 切り替え後の最初の面(チャンク内の番号)
+	std::string_view name; // 切り替え後の名前
+	bool isMaterial;       // usemtlならtrue、o/gならfalse
+};
+
+/// <summary>
+/// 行単位で区切ったファイルの一部分の解析結果
+/// </summary>
+struct ObjChunk {
+	std::vector<Vector4> positions;    // 頂点位置
+	std::vector<Vector3> normals;      // 法線ベクトル
+	std::vector<Vector2> texcoords;    // テクスチャ座標
+	std::vector<ObjCorner> corners;    // 面の頂点(多角形のまま)
+	std::vector<uint32_t> faceSizes;   // 面ごとの頂点数
+	std::vector<ObjCorner> triangles;  // 三角形分割後の面の頂点(3つで1つの三角形)
+	std::vector<ObjGroupChange> groupChanges;        // o/g/usemtlの切り替え(ファイル順)
+	std::vector<std::string_view> materialFilenames; // mtllibで指定されたファイル
+	int32_t positionBase = 0;          // このチャンクより前にある要素の数
+	int32_t texcoordBase = 0;
+	int32_t normalBase = 0;
+};
+
+/// <summary>
+/// 面の頂点の要素番号を1つ読む。負の番号はその時点の要素数からの相対参照
+/// </summary>
+const char* ParseElementIndex(const char* p, const char* end, size_t elementCount, int32_t& index) {
+	int32_t value = 0;
+	p = ParseInt(p, end, value);
+	if (value < 0) {
+		// チャンク内での1始まりの番号に直して、結合後に前のチャンクの要素数を足す
+		value = int32_t(elementCount) + value + 1 - kRelativeIndexBias;
+	}
+	index = value;
+	return p;
+}
+
+/// <summary>
+/// 面の頂点を1つ読む(v, v/vt, v//vn, v/vt/vn)
+/// </summary>
+const char* ParseCorner(const char* p, const char* end, const ObjChunk& chunk, ObjCorner& corner) {
+	corner = {0, 0, 0};
+	p = ParseElementIndex(p, end, chunk.positions.size(), corner.position);
+	if (p < end && *p == '/') {
+		++p;
+		if (p < end && *p != '/') {
+			p = ParseElementIndex(p, end, chunk.texcoords.size(), corner.texcoord);
+		}
+		if (p < end && *p == '/') {
+			++p;
+			p = ParseElementIndex(p, end, chunk.normals.size(), corner.normal);
+		}
+	}
+	return p;
+}
+
+/// <summary>
+/// [p, end)の行を解析する。endは行頭かファイル末尾であること
+/// </summary>
+void ParseObjChunk(const char* p, const char* end, ObjChunk& chunk) {
+	while (p < end) {
+		std::string_view identifier;
+		p = ReadToken(p, end, identifier);
+		if (identifier == "v") { // 頂点位置
+			Vector4 position;
+			p = ParseFloat(p, end, position.x);
+			p = ParseFloat(p, end, position.y);
+			p = ParseFloat(p, end, position.z);
+			position.x *= -1; // X軸を反転
+
+			position.w = 1.0f; // Homogeneous coordinate
+			chunk.positions.push_back(position);
+		} else if (identifier == "vt") { // テクスチャ座標
+			Vector2 texcoord;
+			p = ParseFloat(p, end, texcoord.x);
+			p = ParseFloat(p, end, texcoord.y);
+			texcoord.x = 1.0f - texcoord.x; // X軸はそのまま
+			texcoord.y = 1.0f - texcoord.y; // Y軸を反転
+			chunk.texcoords.push_back(texcoord);
+		} else if (identifier == "vn") { // 法線ベクトル
+			Vector3 normal;
+			p = ParseFloat(p, end, normal.x);
+			p = ParseFloat(p, end, normal.y);
+			p = ParseFloat(p, end, normal.z);
+			normal.x *= -1; // X軸を反転
+			chunk.normals.push_back(normal);
+		} else if (identifier == "f") { // 面情報
+			// 任意の頂点数の多角形。三角形分割は要素の結合後に行う
+			uint32_t faceSize = 0;
+			while (true) {
+				p = SkipSpaces(p, end);
+				if (p >= end || !(IsDigit(*p) || *p == '-' || *p == '+')) {
+					break;
+				}
+				ObjCorner corner;
+				p = ParseCorner(p, end, chunk, corner);
+				chunk.corners.push_back(corner);
+				faceSize++;
+			}
+			if (faceSize < 3) {
+				// 面にならないものは捨てる
+				chunk.corners.resize(chunk.corners.size() - faceSize);
+			} else {
+				chunk.faceSizes.push_back(faceSize);
+			}
+		} else if (identifier == "o" || identifier == "g" || identifier == "usemtl") {
+			ObjGroupChange change{uint32_t(chunk.faceSizes.size()), {}, identifier == "usemtl"};
+			p = ReadRestOfLine(p, end, change.name);
+			chunk.groupChanges.push_back(change);
+		} else if (identifier == "mtllib") {
+			std::string_view materialFilename;
+			p = ReadToken(p, end, materialFilename);
+			chunk.materialFilenames.push_back(materialFilename);
+		}
+		p = SkipLine(p, end);
+	}
+}
+
+/// <summary>
+/// 解析時の要素番号を、結合した要素配列の0始まりの番号に直す
+/// </summary>
+int32_t ResolveElementIndex(int32_t index, int32_t base, size_t elementCount) {
+	if (index == 0) {
+		return kNoIndex;
+	}
+	int32_t resolved = index > 0 ? index - 1 : base + index + kRelativeIndexBias - 1;
+	assert(resolved >= 0 && size_t(resolved) < elementCount && "OBJ face refers to a missing element");
+	(void)elementCount;
+	return resolved;
+}
+
+/// <summary>
+/// 多角形を三角形に分割する
+/// 凸多角形は扇状に分割し、凹多角形は耳刈り取り法で分割する(頂点の並び順=表裏は保つ)
+/// </summary>
+/// <param name="scratch">作業用の配列(面ごとに確保しないよう使い回す)</param>
+void TriangulatePolygon(const ObjCorner* corners, uint32_t cornerCount, const std::vector<Vector4>& positions, std::vector<ObjCorner>& triangles, std::vector<uint32_t>& scratch) {
+	if (cornerCount == 3) {
+		triangles.insert(triangles.end(), corners, corners + 3);
+		return;
+	}
+	// Newell法で多角形の法線を求め、一番大きい成分の軸を落として2次元に投影する
+	Vector3 normal = {0.0f, 0.0f, 0.0f};
+	for (uint32_t i = 0; i < cornerCount; i++) {
+		const Vector4& current = positions[corners[i].position];
+		const Vector4& next = positions[corners[(i + 1) % cornerCount].position];
+		normal.x += (current.y - next.y) * (current.z + next.z);
+		normal.y += (current.z - next.z) * (current.x + next.x);
+		normal.z += (current.x - next.x) * (current.y + next.y);
+	}
+	// 落とす軸の後ろの2軸を巡回順に使う(X:(y,z)、Y:(z,x)、Z:(x,y))と、投影した面積の符号が法線のその成分の符号と一致する
+	float absX = fabsf(normal.x), absY = fabsf(normal.y), absZ = fabsf(normal.z);
+	int32_t axis = absX >= absY && absX >= absZ ? 0 : absY >= absZ ? 1 : 2;
+	int32_t axisU = (axis + 1) % 3;
+	int32_t axisV = (axis + 2) % 3;
+	float sign = (&normal.x)[axis] >= 0.0f ? 1.0f : -1.0f;
+	auto project = [&](uint32_t corner, float& u, float& v) {
+		const float* position = &positions[corners[corner].position].x;
+		u = position[axisU];
+		v = position[axisV];
+	};
+	// 投影した三角形の向き(多角形と同じ向きなら正)
+	auto orientation = [&](uint32_t a, uint32_t b, uint32_t c) {
+		float ax, ay, bx, by, cx, cy;
+		project(a, ax, ay);
+		project(b, bx, by);
+		project(c, cx, cy);
+		return sign * ((bx - ax) * (cy - ay) - (by - ay) * (cx - ax));
+	};
+
+	// 全ての頂点で同じ向きに曲がっていれば凸なので扇状に分割する
+	bool isConvex = true;
+	for (uint32_t i = 0; i < cornerCount && isConvex; i++) {
+		isConvex = orientation(i, (i + 1) % cornerCount, (i + 2) % cornerCount) >= 0.0f;
+	}
+	if (isConvex) {
+		for (uint32_t i = 1; i + 1 < cornerCount; i++) {
+			triangles.push_back(corners[0]);
+			triangles.push_back(corners[i]);
+			triangles.push_back(corners[i + 1]);
+		}
+		return;
+	}
+
+	// 耳刈り取り法。残っている頂点は前後の頂点の番号でつないだ輪で持ち(scratchの前半が次、後半が前)、耳を切り取るたびに定数時間で外す
+	scratch.resize(size_t(cornerCount) * 2);
+	uint32_t* next = scratch.data();
+	uint32_t* prev = scratch.data() + cornerCount;
+	for (uint32_t i = 0; i < cornerCount; i++) {
+		next[i] = (i + 1) % cornerCount;
+		prev[i] = (i + cornerCount - 1) % cornerCount;
+	}
+	auto isInside = [&](uint32_t point, uint32_t a, uint32_t b, uint32_t c) {
+		return orientation(a, b, point) >= 0.0f && orientation(b, c, point) >= 0.0f && orientation(c, a, point) >= 0.0f;
+	};
+	uint32_t remaining = cornerCount;
+	uint32_t current = 0;
+	uint32_t attempts = 0;
+	while (remaining > 3) {
+		uint32_t a = prev[current], b = current, c = next[current];
+		bool isEar = orientation(a, b, c) > 0.0f;
+		for (uint32_t other = next[c]; other != a && isEar; other = next[other]) {
+			isEar = !isInside(other, a, b, c);
+		}
+		// 一周しても耳が見つからない(自己交差や縮退)ときはそのまま切り取る
+		if (isEar || attempts >= remaining) {
+			triangles.push_back(corners[a]);
+			triangles.push_back(corners[b]);
+			triangles.push_back(corners[c]);
+			next[a] = c;
+			prev[c] = a;
+			remaining--;
+			attempts = 0;
+		} else {
+			attempts++;
+		}
+		current = c;
+	}
+	// 残りの3つは元の番号の小さい順から出す
+	uint32_t first = (std::min)({prev[current], current, next[current]});
+	triangles.push_back(corners[first]);
+	triangles.push_back(corners[next[first]]);
+	triangles.push_back(corners[next[next[first]]]);
+}
+
+/// <summary>
+/// チャンクの面の要素番号を解決し、三角形に分割する
+/// </summary>
+void TriangulateChunk(ObjChunk& chunk, const std::vector<Vector4>& positions, size_t texcoordCount, size_t normalCount) {
+	for (ObjCorner& corner : chunk.corners) {
+		corner.position = ResolveElementIndex(corner.position, chunk.positionBase, positions.size());
+		corner.texcoord = ResolveElementIndex(corner.texcoord, chunk.texcoordBase, texcoordCount);
+		corner.normal = ResolveElementIndex(corner.normal, chunk.normalBase, normalCount);
+		assert(corner.position != kNoIndex && "OBJ face corner has no position");
+	}
+	chunk.triangles.reserve(chunk.corners.size() * 2);
+	std::vector<uint32_t> scratch;
+	const ObjCorner* face = chunk.corners.data();
+	for (uint32_t faceSize : chunk.faceSizes) {
+		TriangulatePolygon(face, faceSize, positions, chunk.triangles, scratch);
+		face += faceSize;
+	}
+}
+
+/// <summary>
+/// 法線が指定されていない頂点に、接する三角形の面積で重み付けした法線を設定する
+/// </summary>
+void GenerateMissingNormals(ModelData& modelData, const std::vector<bool>& needsNormal) {
+	for (size_t i = 0; i < modelData.vertices.size(); i++) {
+		if (needsNormal[i]) {
+			modelData.vertices[i].normal = {0.0f, 0.0f, 0.0f};
+		}
+	}
+	for (size_t i = 0; i + 2 < modelData.indices.size(); i += 3) {
+		uint32_t index0 = modelData.indices[i], index1 = modelData.indices[i + 1], index2 = modelData.indices[i + 2];
+		const Vector4& p0 = modelData.vertices[index0].position;
+		const Vector4& p1 = modelData.vertices[index1].position;
+		const Vector4& p2 = modelData.vertices[index2].position;
+		Vector3 faceNormal = Cross(Vector3{p1.x - p0.x, p1.y - p0.y, p1.z - p0.z}, Vector3{p2.x - p0.x, p2.y - p0.y, p2.z - p0.z});
+		for (uint32_t index : {index0, index1, index2}) {
+			if (needsNormal[index]) {
+				modelData.vertices[index].normal = modelData.vertices[index].normal + faceNormal;
+			}
+		}
+	}
+	for (size_t i = 0; i < modelData.vertices.size(); i++) {
+		if (needsNormal[i]) {
+			modelData.vertices[i].normal = Normalize(modelData.vertices[i].normal);
+		}
+	}
+}
+
+/// <summary>
+/// 面の頂点を(位置, UV, 法線)の組で重複排除し、固有頂点とインデックスを作る
+/// 開番地法のハッシュ表をファイル順に引くので、結果は常に同じ順序になる
+/// </summary>
+void DeduplicateCorners(const std::vector<ObjChunk>& chunks, size_t cornerCount, std::vector<ObjCorner>& uniqueCorners, std::vector<uint32_t>& indices) {
+	// 負荷率が0.5以下になる2の累乗のサイズ
+	size_t tableSize = 16;
+	while (tableSize < cornerCount * 2) {
+		tableSize *= 2;
+	}
+	const size_t mask = tableSize - 1;
+	std::vector<uint32_t> table(tableSize, UINT32_MAX); // 固有頂点の番号(UINT32_MAXは空き)
+
+	indices.reserve(cornerCount);
+	for (const ObjChunk& chunk : chunks) {
+		for (const ObjCorner& corner : chunk.triangles) {
+			uint64_t hash = uint64_t(uint32_t(corner.position)) * 0x9E3779B97F4A7C15ull;
+			hash ^= uint64_t(uint32_t(corner.texcoord)) * 0xC2B2AE3D27D4EB4Full;
+			hash ^= uint64_t(uint32_t(corner.normal)) * 0x165667B19E3779F9ull;
+			size_t slot = size_t(hash ^ (hash >> 29)) & mask;
+			while (true) {
+				uint32_t vertexIndex = table[slot];
+				if (vertexIndex == UINT32_MAX) {
+					// 初めて現れた組なので固有頂点に追加
+					vertexIndex = uint32_t(uniqueCorners.size());
+					table[slot] = vertexIndex;
+					uniqueCorners.push_back(corner);
+					indices.push_back(vertexIndex);
+					break;
+				}
+				const ObjCorner& unique = uniqueCorners[vertexIndex];
+				if (unique.position == corner.position && unique.texcoord == corner.texcoord && unique.normal == corner.normal) {
+					indices.push_back(vertexIndex);
+					break;
+				}
+				slot = (slot + 1) & mask;
+			}
+		}
+	}
+}
+
+/// <summary>
+/// 三角形をo/gとusemtlの組ごとのサブメッシュに分け、マテリアル順に並べ替える
+/// 組の切り替えはチャンクをまたいで引き継ぐ。usemtlがない面はマテリアル表の先頭を使う
+/// </summary>
+void BuildSubMeshes(const std::vector<ObjChunk>& chunks, ModelData& modelData) {
+	std::unordered_map<std::string, uint32_t> materialLookup;
+	for (uint32_t i = 0; i < modelData.materials.size(); i++) {
+		materialLookup.emplace(modelData.materials[i].name, i); // 同じ名前なら先に読み込んだmtlを使う
+	}
+	auto findMaterial = [&](std::string_view name) {
+		if (name.empty() && !modelData.materials.empty()) {
+			return 0u;
+		}
+		auto found = materialLookup.find(std::string(name));
+		if (found != materialLookup.end()) {
+			return found->second;
+		}
+		// mtlにないマテリアルは既定のマテリアルで追加する
+		uint32_t materialIndex = uint32_t(modelData.materials.size());
+		modelData.materials.push_back({std::string(name), {}, kDefaultMaterialId});
+		materialLookup.emplace(std::string(name), materialIndex);
+		return materialIndex;
+	};
+
+	// 三角形ごとに、属するサブメッシュの番号を求める
+	std::unordered_map<std::string, uint32_t> subMeshLookup; // "グループ名\nマテリアル名"からサブメッシュの番号
+	std::vector<uint32_t> triangleSubMeshes;
+	triangleSubMeshes.reserve(modelData.indices.size() / 3);
+	std::string_view groupName;
+	std::string_view materialName;
+	uint32_t subMeshIndex = 0;
+	bool needsLookup = true;
+	for (const ObjChunk& chunk : chunks) {
+		size_t changeIndex = 0;
+		for (uint32_t faceIndex = 0; faceIndex <= chunk.faceSizes.size(); faceIndex++) {
+			for (; changeIndex < chunk.groupChanges.size() && chunk.groupChanges[changeIndex].faceIndex == faceIndex; changeIndex++) {
+				const ObjGroupChange& change = chunk.groupChanges[changeIndex];
+				(change.isMaterial ? materialName : groupName) = change.name;
+				needsLookup = true;
+			}
+			if (faceIndex == chunk.faceSizes.size()) {
+				break;
+			}
+			if (needsLookup) {
+				std::string key = std::string(groupName) + '\n' + std::string(materialName);
+				auto [found, inserted] = subMeshLookup.emplace(key, uint32_t(modelData.subMeshes.size()));
+				if (inserted) {
+					modelData.subMeshes.push_back({std::string(groupName), 0, 0, findMaterial(materialName), 0, 0, {}, {}}); // メッシュレットと境界は後で求める
+				}
+				subMeshIndex = found->second;
+				needsLookup = false;
+			}
+			// n角形はn-2個の三角形になる
+			triangleSubMeshes.insert(triangleSubMeshes.end(), chunk.faceSizes[faceIndex] - 2, subMeshIndex);
+		}
+	}
+	assert(triangleSubMeshes.size() * 3 == modelData.indices.size());
+
+	// サブメッシュをマテリアル順に並べ(同じマテリアルの中では最初に現れた順)、三角形を詰め直す
+	std::vector<uint32_t> order(modelData.subMeshes.size());
+	for (uint32_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return modelData.subMeshes[a].materialIndex < modelData.subMeshes[b].materialIndex; });
+	for (uint32_t subMesh : triangleSubMeshes) {
+		modelData.subMeshes[subMesh].indexCount += 3;
+	}
+	uint32_t indexStart = 0;
+	for (uint32_t subMesh : order) {
+		modelData.subMeshes[subMesh].indexStart = indexStart;
+		indexStart += modelData.subMeshes[subMesh].indexCount;
+	}
+	std::vector<uint32_t> writeOffsets(modelData.subMeshes.size());
+	for (uint32_t i = 0; i < modelData.subMeshes.size(); i++) {
+		writeOffsets[i] = modelData.subMeshes[i].indexStart;
+	}
+	std::vector<uint32_t> indices(modelData.indices.size());
+	for (size_t triangle = 0; triangle < triangleSubMeshes.size(); triangle++) {
+		uint32_t& offset = writeOffsets[triangleSubMeshes[triangle]];
+		std::memcpy(&indices[offset], &modelData.indices[triangle * 3], sizeof(uint32_t) * 3);
+		offset += 3;
+	}
+	modelData.indices = std::move(indices);
+
+	std::vector<SubMeshData> subMeshes;
+	subMeshes.reserve(order.size());
+	for (uint32_t subMesh : order) {
+		subMeshes.push_back(std::move(modelData.subMeshes[subMesh]));
+	}
+	modelData.subMeshes = std::move(subMeshes);
+}
+
+/// <summary>
+/// チャンクごとの処理をスレッドに割り振って実行する(1チャンクなら呼び出し元で実行)
+/// </summary>
+template<class Function> void RunChunks(size_t chunkCount, Function function) {
+	if (chunkCount == 1) {
+		function(size_t(0));
+		return;
+	}
+	std::vector<std::thread> workers;
+	workers.reserve(chunkCount - 1);
+	for (size_t chunkIndex = 1; chunkIndex < chunkCount; chunkIndex++) {
+		workers.emplace_back(function, chunkIndex);
+	}
+	function(size_t(0));
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+/// <summary>
+/// チャンクの要素配列をファイル順に連結する
+/// </summary>
+template<class T> std::vector<T> ConcatChunks(const std::vector<ObjChunk>& chunks, std::vector<T> ObjChunk::* member) {
+	size_t total = 0;
+	for (const ObjChunk& chunk : chunks) {
+		total += (chunk.*member).size();
+	}
+	std::vector<T> result;
+	result.reserve(total);
+	for (const ObjChunk& chunk : chunks) {
+		result.insert(result.end(), (chunk.*member).begin(), (chunk.*member).end());
+	}
+	return result;
+}
+
+} // namespace
+
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount) {
+	ModelData modelData;
+
+	MappedFile file;
+	bool isOpen = file.Open(directoryPath + "/" + filename);
+	assert(isOpen && "Failed to open the OBJ file");
+	(void)isOpen;
+
+	const char* begin = file.GetData();
+	const char* end = begin + file.GetSize();
+
+	// 行の途中で切れないようにファイルを分割する
+	if (threadCount == 0) {
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	size_t chunkCount = std::clamp(file.GetSize() / kMinChunkSize, size_t(1), size_t(threadCount));
+	std::vector<const char*> boundaries(chunkCount + 1);
+	boundaries[0] = begin;
+	for (size_t chunkIndex = 1; chunkIndex < chunkCount; chunkIndex++) {
+		const char* split = begin + file.GetSize() * chunkIndex / chunkCount;
+		boundaries[chunkIndex] = std::max(SkipLine(split, end), boundaries[chunkIndex - 1]);
+	}
+	boundaries[chunkCount] = end;
+
+	// 各チャンクを並列に解析する
+	std::vector<ObjChunk> chunks(chunkCount);
+	RunChunks(chunkCount, [&](size_t chunkIndex) { ParseObjChunk(boundaries[chunkIndex], boundaries[chunkIndex + 1], chunks[chunkIndex]); });
+
+	// 要素をファイル順に連結し、各チャンクより前にある要素の数を累積和で求める
+	std::vector<Vector4> positions = ConcatChunks(chunks, &ObjChunk::positions);
+	std::vector<Vector2> texcoords = ConcatChunks(chunks, &ObjChunk::texcoords);
+	std::vector<Vector3> normals = ConcatChunks(chunks, &ObjChunk::normals);
+	int32_t positionBase = 0, texcoordBase = 0, normalBase = 0;
+	for (ObjChunk& chunk : chunks) {
+		chunk.positionBase = positionBase;
+		chunk.texcoordBase = texcoordBase;
+		chunk.normalBase = normalBase;
+		positionBase += int32_t(chunk.positions.size());
+		texcoordBase += int32_t(chunk.texcoords.size());
+		normalBase += int32_t(chunk.normals.size());
+	}
+
+	// 面の要素番号の解決と三角形分割を並列に行う
+	RunChunks(chunkCount, [&](size_t chunkIndex) { TriangulateChunk(chunks[chunkIndex], positions, texcoords.size(), normals.size()); });
+	size_t cornerCount = 0;
+	for (const ObjChunk& chunk : chunks) {
+		cornerCount += chunk.triangles.size();
+	}
+
+	// 同じ要素の組を参照する面の頂点は1つの頂点にまとめる
+	std::vector<ObjCorner> uniqueCorners;
+	DeduplicateCorners(chunks, cornerCount, uniqueCorners, modelData.indices);
+
+	// 要素へのIndexから、実際の要素の値を取得して、頂点を構築する
+	// UVがなければ0、法線がなければ周囲の面から求める
+	modelData.vertices.reserve(uniqueCorners.size());
+	std::vector<bool> needsNormal(uniqueCorners.size(), false);
+	bool hasMissingNormal = false;
+	for (size_t i = 0; i < uniqueCorners.size(); i++) {
+		const ObjCorner& corner = uniqueCorners[i];
+		Vector2 texcoord = corner.texcoord != kNoIndex ? texcoords[corner.texcoord] : Vector2{0.0f, 0.0f};
+		Vector3 normal = corner.normal != kNoIndex ? normals[corner.normal] : Vector3{0.0f, 0.0f, 0.0f};
+		modelData.vertices.push_back({positions[corner.position], texcoord, normal});
+		needsNormal[i] = corner.normal == kNoIndex;
+		hasMissingNormal |= needsNormal[i];
+	}
+	if (hasMissingNormal) {
+		GenerateMissingNormals(modelData, needsNormal);
+	}
+
+	// mtllibで指定された全てのマテリアルを共有のキャッシュから取得し、面をサブメッシュに分ける
+	MaterialLibrary& materialLibrary = GetMaterialLibrary();
+	for (const ObjChunk& chunk : chunks) {
+		for (std::string_view materialFilename : chunk.materialFilenames) {
+			std::string libraryPath = directoryPath + "/" + std::string(materialFilename);
+			for (uint32_t materialId : materialLibrary.Load(libraryPath)) {
+				modelData.materials.push_back({materialLibrary.GetMaterialName(materialId), libraryPath, materialId});
+			}
+		}
+	}
+	BuildSubMeshes(chunks, modelData);
+	ComputeModelBounds(modelData);
+
+	return modelData;
+}
+
+void ComputeModelBounds(ModelData& modelData) {
+	// positionはVertexDataの先頭にある
+	const Vector4* positions = reinterpret_cast<const Vector4*>(modelData.vertices.data());
+	const size_t stride = sizeof(VertexData);
+	const size_t indexCount = modelData.lods.empty() ? modelData.indices.size() : modelData.lods[0].indexCount;
+	for (SubMeshData& subMesh : modelData.subMeshes) {
+		const uint32_t* indices = modelData.indices.data() + subMesh.indexStart;
+		subMesh.aabb = ComputeAABB(positions, stride, indices, subMesh.indexCount);
+		subMesh.sphere = ComputeBoundingSphere(subMesh.aabb, positions, stride, indices, subMesh.indexCount);
+	}
+	modelData.aabb = ComputeAABB(positions, stride, modelData.indices.data(), indexCount);
+	modelData.sphere = ComputeBoundingSphere(modelData.aabb, positions, stride, modelData.indices.data(), indexCount);
+}
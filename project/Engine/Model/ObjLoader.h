@@ -0,0 +1,27 @@
+#pragma once
+#include "ModelData.h"
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// objファイルを読み込む関数
+/// ファイルをメモリマップし、行や語ごとに文字列を作らずに直接数値を読み取る
+/// 大きなファイルは行単位のチャンクに分けて並列に解析し、ファイル順に結合する
+/// (スレッド数によらず結果は同一)
+/// 面は任意の頂点数の多角形を三角形に分割し、v, v/vt, v//vn, v/vt/vnと負の番号での参照を受け付ける
+/// UVがない頂点は(0, 0)、法線がない頂点は周囲の面から求めた法線になる
+/// o/gとusemtlの組ごとにサブメッシュを作り、マテリアル表はmtllibで指定された全てのmtlから作る
+/// (mtlはMaterialLibraryで共有するので、同じmtlを参照するモデルは同じマテリアルとテクスチャを使う)
+/// バウンディングボックスとバウンディングスフィアはモデル全体とサブメッシュごとに求める
+/// </summary>
+/// <param name="directoryPath">ディレクトリパス</param>
+/// <param name="filename">ファイル名</param>
+/// <param name="threadCount">解析に使うスレッド数(0でハードウェアのスレッド数)</param>
+/// <returns>モデルデータ</returns>
+ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename, uint32_t threadCount = 1);
+
+/// <summary>
+/// モデル全体とサブメッシュごとのバウンディングボックスとバウンディングスフィアを求める
+/// LOD0の三角形が使う頂点だけを囲む(LOD1以降は同じ頂点の一部を使うので、同じ範囲に収まる)
+/// </summary>
+void ComputeModelBounds(ModelData& modelData);
@@ -0,0 +1,134 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/// <summary>
+/// テキスト形式のアセットを文字列を生成せずに解析するための関数群
+/// 全ての関数は[p, end)の範囲を読み、読み終えた位置を返す
+/// </summary>
+namespace TextScanner {
+
+// 行内の空白か
+inline bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+// 数字か
+inline bool IsDigit(char c) { return unsigned(c - '0') < 10u; }
+
+/// <summary>
+/// 行内の空白を読み飛ばす
+/// </summary>
+inline const char* SkipSpaces(const char* p, const char* end) {
+	while (p < end && IsSpace(*p)) {
+		++p;
+	}
+	return p;
+}
+
+/// <summary>
+/// 次の行の先頭まで読み飛ばす
+/// </summary>
+inline const char* SkipLine(const char* p, const char* end) {
+	const char* newline = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+	return newline != nullptr ? newline + 1 : end;
+}
+
+/// <summary>
+/// 空白区切りの語を1つ読む
+/// </summary>
+/// <param name="token">読んだ語(元のバッファを指す)</param>
+inline const char* ReadToken(const char* p, const char* end, std::string_view& token) {
+	p = SkipSpaces(p, end);
+	const char* begin = p;
+	while (p < end && *p != '\n' && !IsSpace(*p)) {
+		++p;
+	}
+	token = std::string_view(begin, size_t(p - begin));
+	return p;
+}
+
+/// <summary>
+/// 行末までの残りを前後の空白を除いて読む
+/// </summary>
+inline const char* ReadRestOfLine(const char* p, const char* end, std::string_view& rest) {
+	p = SkipSpaces(p, end);
+	const char* begin = p;
+	while (p < end && *p != '\n') {
+		++p;
+	}
+	const char* last = p;
+	while (last > begin && IsSpace(last[-1])) {
+		--last;
+	}
+	rest = std::string_view(begin, size_t(last - begin));
+	return p;
+}
+
+/// <summary>
+/// 整数を読む
+/// </summary>
+inline const char* ParseInt(const char* p, const char* end, int32_t& value) {
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		++p;
+	}
+	int32_t result = 0;
+	while (p < end && IsDigit(*p)) {
+		result = result * 10 + (*p - '0');
+		++p;
+	}
+	value = negative ? -result : result;
+	return p;
+}
+
+/// <summary>
+/// 浮動小数点数を読む
+/// 仮数がfloatで正確に表せる桁数なら1回の乗除算で求め(正しく丸められる)、
+/// それ以外はstd::from_charsに任せるので、どちらでも標準の変換と同じ値になる
+/// </summary>
+inline const char* ParseFloat(const char* p, const char* end, float& value) {
+	// floatで正確に表せる10の累乗
+	static constexpr float kPowersOf10[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+	static constexpr uint64_t kMaxExactMantissa = uint64_t(1) << 24;
+
+	p = SkipSpaces(p, end);
+	if (p < end && *p == '+') {
+		++p; // from_charsは'+'を受け付けないので先に読み飛ばす
+	}
+	const char* start = p;
+	bool negative = false;
+	if (p < end && *p == '-') {
+		negative = true;
+		++p;
+	}
+	uint64_t mantissa = 0;
+	int32_t digits = 0;   // 有効桁数
+	int32_t exponent = 0; // 10の指数
+	while (p < end && IsDigit(*p)) {
+		mantissa = mantissa * 10 + uint64_t(*p - '0');
+		digits += mantissa != 0;
+		++p;
+	}
+	if (p < end && *p == '.') {
+		++p;
+		while (p < end && IsDigit(*p)) {
+			mantissa = mantissa * 10 + uint64_t(*p - '0');
+			digits += mantissa != 0;
+			--exponent;
+			++p;
+		}
+	}
+	bool fastPath = digits <= 18 && p != start + negative && mantissa <= kMaxExactMantissa && exponent >= -10 && (p >= end || (*p != 'e' && *p != 'E'));
+	if (fastPath) {
+		float result = float(mantissa);
+		result = exponent < 0 ? result / kPowersOf10[-exponent] : result;
+		value = negative ? -result : result;
+		return p;
+	}
+	// 指数表記や桁数の多い数値は標準の変換に任せる
+	std::from_chars_result parsed = std::from_chars(start, end, value);
+	return parsed.ptr;
+}
+
+} // namespace TextScanner
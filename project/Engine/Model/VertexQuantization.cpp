@@ -0,0 +1,146 @@
+#include "VertexQuantization.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// UNORM16とSNORM16の最大値
+const float kUnorm16Max = 65535.0f;
+const float kSnorm16Max = 32767.0f;
+
+float SignNotZero(float value) { return value >= 0.0f ? 1.0f : -1.0f; }
+
+uint16_t QuantizeUnorm16(float value) { return uint16_t(std::lround(std::clamp(value, 0.0f, 1.0f) * kUnorm16Max)); }
+
+int16_t QuantizeSnorm16(float value) { return int16_t(std::lround(std::clamp(value, -1.0f, 1.0f) * kSnorm16Max)); }
+
+// D3DのSNORMと同じく-32768は-1にする
+float DequantizeSnorm16(int16_t value) { return std::max(float(value) / kSnorm16Max, -1.0f); }
+
+} // namespace
+
+uint16_t FloatToHalf(float value) {
+	uint32_t bits = 0;
+	std::memcpy(&bits, &value, sizeof(bits));
+	uint16_t sign = uint16_t((bits >> 16) & 0x8000);
+	uint32_t absBits = bits & 0x7FFFFFFF;
+	if (absBits >= 0x7F800000) {
+		// 無限大とNaN
+		return uint16_t(sign | 0x7C00 | (absBits > 0x7F800000 ? 0x0200 : 0));
+	}
+	if (absBits >= 0x477FF000) {
+		// 65520以上は丸めると範囲外
+		return uint16_t(sign | 0x7C00);
+	}
+	if (absBits < 0x38800000) {
+		// 2^-14未満は非正規化数(2^-24単位で丸める。2の累乗倍なので乗算は正確)
+		float absValue = 0.0f;
+		std::memcpy(&absValue, &absBits, sizeof(absValue));
+		return uint16_t(sign | uint16_t(std::nearbyint(absValue * 16777216.0f)));
+	}
+	// 仮数の下位13ビットを最近接偶数丸めで落とし、指数の基準を127から15に直す
+	uint32_t rounded = absBits + 0x0FFF + ((absBits >> 13) & 1);
+	return uint16_t(sign | ((rounded - 0x38000000) >> 13));
+}
+
+float HalfToFloat(uint16_t half) {
+	uint32_t sign = uint32_t(half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1F;
+	uint32_t mantissa = half & 0x03FF;
+	if (exponent == 0) {
+		float value = float(mantissa) / 16777216.0f;
+		return sign != 0 ? -value : value;
+	}
+	uint32_t bits = exponent == 31 ? (sign | 0x7F800000 | (mantissa << 13)) : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+	float value = 0.0f;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+void EncodeOctahedralNormal(const Vector3& normal, int16_t encoded[2]) {
+	float length = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+	if (length == 0.0f) {
+		encoded[0] = 0;
+		encoded[1] = 0;
+		return;
+	}
+	// 八面体に写し、下半分(z<0)は外側の三角形に折り返す
+	float u = normal.x / length;
+	float v = normal.y / length;
+	if (normal.z < 0.0f) {
+		float foldedU = (1.0f - std::fabs(v)) * SignNotZero(u);
+		float foldedV = (1.0f - std::fabs(u)) * SignNotZero(v);
+		u = foldedU;
+		v = foldedV;
+	}
+	encoded[0] = QuantizeSnorm16(u);
+	encoded[1] = QuantizeSnorm16(v);
+}
+
+Vector3 DecodeOctahedralNormal(const int16_t encoded[2]) {
+	Vector3 normal = {DequantizeSnorm16(encoded[0]), DequantizeSnorm16(encoded[1]), 0.0f};
+	normal.z = 1.0f - std::fabs(normal.x) - std::fabs(normal.y);
+	if (normal.z < 0.0f) {
+		float x = normal.x;
+		normal.x = (1.0f - std::fabs(normal.y)) * SignNotZero(x);
+		normal.y = (1.0f - std::fabs(x)) * SignNotZero(normal.y);
+	}
+	return Normalize(normal);
+}
+
+QuantizationBounds ComputeQuantizationBounds(std::span<const VertexData> vertices) {
+	AABB aabb = ComputeAABB(reinterpret_cast<const Vector4*>(vertices.data()), vertices.size(), sizeof(VertexData));
+	return {aabb.minimum, aabb.maximum - aabb.minimum};
+}
+
+PackedVertexData PackVertex(const VertexData& vertex, const QuantizationBounds& bounds) {
+	PackedVertexData packed{};
+	const float* position = &vertex.position.x;
+	const float* minimum = &bounds.minimum.x;
+	const float* extent = &bounds.extent.x;
+	for (int32_t axis = 0; axis < 3; axis++) {
+		packed.position[axis] = extent[axis] > 0.0f ? QuantizeUnorm16((position[axis] - minimum[axis]) / extent[axis]) : 0;
+	}
+	packed.position[3] = uint16_t(kUnorm16Max);
+	packed.texcoord[0] = FloatToHalf(vertex.texcoord.x);
+	packed.texcoord[1] = FloatToHalf(vertex.texcoord.y);
+	EncodeOctahedralNormal(vertex.normal, packed.normal);
+	return packed;
+}
+
+VertexData UnpackVertex(const PackedVertexData& packed, const QuantizationBounds& bounds) {
+	VertexData vertex{};
+	vertex.position.x = bounds.minimum.x + float(packed.position[0]) / kUnorm16Max * bounds.extent.x;
+	vertex.position.y = bounds.minimum.y + float(packed.position[1]) / kUnorm16Max * bounds.extent.y;
+	vertex.position.z = bounds.minimum.z + float(packed.position[2]) / kUnorm16Max * bounds.extent.z;
+	vertex.position.w = float(packed.position[3]) / kUnorm16Max;
+	vertex.texcoord = {HalfToFloat(packed.texcoord[0]), HalfToFloat(packed.texcoord[1])};
+	vertex.normal = DecodeOctahedralNormal(packed.normal);
+	return vertex;
+}
+
+QuantizationErrorReport PackVertices(std::span<const VertexData> vertices, QuantizationBounds& bounds, std::vector<PackedVertexData>& packedVertices) {
+	bounds = ComputeQuantizationBounds(vertices);
+	packedVertices.resize(vertices.size());
+	QuantizationErrorReport report{};
+	// 1/2ステップに、展開時の浮動小数点数の丸め(座標の大きさに比例)を加えたもの
+	Vector3 farthest = {std::max(std::fabs(bounds.minimum.x), std::fabs(bounds.minimum.x + bounds.extent.x)), std::max(std::fabs(bounds.minimum.y), std::fabs(bounds.minimum.y + bounds.extent.y)),
+	                    std::max(std::fabs(bounds.minimum.z), std::fabs(bounds.minimum.z + bounds.extent.z))};
+	report.positionErrorBound = 0.5f / kUnorm16Max * Length(bounds.extent) + 2.0f * std::numeric_limits<float>::epsilon() * Length(farthest);
+	for (size_t i = 0; i < vertices.size(); i++) {
+		const VertexData& vertex = vertices[i];
+		packedVertices[i] = PackVertex(vertex, bounds);
+		VertexData unpacked = UnpackVertex(packedVertices[i], bounds);
+
+		Vector3 positionDifference = {unpacked.position.x - vertex.position.x, unpacked.position.y - vertex.position.y, unpacked.position.z - vertex.position.z};
+		report.maxPositionError = std::max(report.maxPositionError, Length(positionDifference));
+		report.maxTexcoordError = std::max({report.maxTexcoordError, std::fabs(unpacked.texcoord.x - vertex.texcoord.x), std::fabs(unpacked.texcoord.y - vertex.texcoord.y)});
+		if (Length(vertex.normal) > 0.0f) {
+			float cosine = std::clamp(Dot(Normalize(vertex.normal), unpacked.normal), -1.0f, 1.0f);
+			report.maxNormalErrorDegrees = std::max(report.maxNormalErrorDegrees, std::acos(cosine) * 180.0f / 3.14159265f);
+		}
+	}
+	return report;
+}
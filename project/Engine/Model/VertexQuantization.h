@@ -0,0 +1,65 @@
+#pragma once
+#include "ModelData.h"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// <summary>
+/// 圧縮した頂点データ(16バイト、VertexDataは36バイト)
+/// </summary>
+struct PackedVertexData {
+	uint16_t position[4]; // バウンディングボックス内の位置(UNORM16、wは常に1)
+	uint16_t texcoord[2]; // 半精度浮動小数点数
+	int16_t normal[2];    // 八面体に写した法線(SNORM16)
+};
+
+/// <summary>
+/// 位置の圧縮に使うバウンディングボックス(位置 = minimum + 圧縮値 * extent)
+/// </summary>
+struct QuantizationBounds {
+	Vector3 minimum;
+	Vector3 extent;
+};
+
+/// <summary>
+/// 圧縮で生じた誤差(元の頂点と展開した頂点の差の最大値)
+/// </summary>
+struct QuantizationErrorReport {
+	float maxPositionError;      // 位置の誤差(距離)
+	float positionErrorBound;    // 位置の誤差の上限(各軸で1/2ステップと展開時の丸め)
+	float maxTexcoordError;      // UVの誤差(各成分の差)
+	float maxNormalErrorDegrees; // 法線の角度の誤差(度)
+};
+
+// 半精度浮動小数点数への変換(最近接偶数丸め、範囲外は無限大)
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t half);
+
+/// <summary>
+/// 単位ベクトルを八面体に写して2成分のSNORM16にする
+/// </summary>
+void EncodeOctahedralNormal(const Vector3& normal, int16_t encoded[2]);
+Vector3 DecodeOctahedralNormal(const int16_t encoded[2]);
+
+/// <summary>
+/// 頂点の位置を囲むバウンディングボックスを求める
+/// </summary>
+QuantizationBounds ComputeQuantizationBounds(std::span<const VertexData> vertices);
+
+/// <summary>
+/// 頂点を1つ圧縮する
+/// </summary>
+PackedVertexData PackVertex(const VertexData& vertex, const QuantizationBounds& bounds);
+
+/// <summary>
+/// 圧縮した頂点を展開する(シェーダーでの展開と同じ計算)
+/// </summary>
+VertexData UnpackVertex(const PackedVertexData& packed, const QuantizationBounds& bounds);
+
+/// <summary>
+/// 全ての頂点を圧縮し、誤差を調べる
+/// </summary>
+/// <param name="bounds">位置の圧縮に使ったバウンディングボックス(描画時に位置を戻すのに使う)</param>
+/// <param name="packedVertices">圧縮した頂点</param>
+/// <returns>誤差</returns>
+QuantizationErrorReport PackVertices(std::span<const VertexData> vertices, QuantizationBounds& bounds, std::vector<PackedVertexData>& packedVertices);
@@ -0,0 +1,59 @@
+#include "InstanceBatcher.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+void InstanceBatcher::Clear() {
+	requests.clear();
+	batches.clear();
+	instanceTransformIndices.clear();
+}
+
+void InstanceBatcher::Add(uint32_t meshId, uint32_t materialId, uint32_t transformIndex) { requests.push_back({(uint64_t(meshId) << 32) | materialId, transformIndex}); }
+
+void InstanceBatcher::Build() {
+	// 組ごとの数を数える(同じ組の要求は続けて来ることが多いので、直前と同じ組なら表を引かない)
+	batches.clear();
+	batchLookup.clear();
+	requestBatchIndices.resize(requests.size());
+	uint64_t previousKey = 0;
+	uint32_t previousBatch = UINT32_MAX;
+	for (size_t i = 0; i < requests.size(); i++) {
+		const uint64_t key = requests[i].key;
+		if (previousBatch == UINT32_MAX || key != previousKey) {
+			auto [found, isInserted] = batchLookup.try_emplace(key, uint32_t(batches.size()));
+			if (isInserted) {
+				batches.push_back({uint32_t(key >> 32), uint32_t(key), 0, 0});
+			}
+			previousKey = key;
+			previousBatch = found->second;
+		}
+		batches[previousBatch].instanceCount++;
+		requestBatchIndices[i] = previousBatch;
+	}
+
+	// まとまりをメッシュ, マテリアルの順に並べて開始位置を決め、要求を追加した順にそれぞれの位置へ書き込む
+	std::sort(batches.begin(), batches.end(), [](const InstanceBatch& a, const InstanceBatch& b) { return a.meshId != b.meshId ? a.meshId < b.meshId : a.materialId < b.materialId; });
+	uint32_t firstInstance = 0;
+	for (InstanceBatch& batch : batches) {
+		batch.firstInstance = firstInstance;
+		firstInstance += batch.instanceCount;
+	}
+	batchCursors.resize(batches.size());
+	for (const InstanceBatch& batch : batches) {
+		batchCursors[batchLookup[(uint64_t(batch.meshId) << 32) | batch.materialId]] = batch.firstInstance;
+	}
+	instanceTransformIndices.resize(requests.size());
+	for (size_t i = 0; i < requests.size(); i++) {
+		instanceTransformIndices[batchCursors[requestBatchIndices[i]]++] = requests[i].transformIndex;
+	}
+}
+
+void InstanceBatcher::PackInstances(const void* source, size_t sourceStride, TransformationMatrix* destination) const {
+	assert(sourceStride >= sizeof(TransformationMatrix));
+	const char* base = static_cast<const char*>(source);
+	for (size_t i = 0; i < instanceTransformIndices.size(); i++) {
+		// アップロード用のバッファは書き込み結合なので、memcpyで順に書く
+		std::memcpy(destination + i, base + sourceStride * instanceTransformIndices[i], sizeof(TransformationMatrix));
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "TransformStorage.h"
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// 同じメッシュとマテリアルで描くインスタンスのまとまり。1回のDrawIndexedInstancedで描く
+/// </summary>
+struct InstanceBatch {
+	uint32_t meshId;
+	uint32_t materialId;
+	uint32_t firstInstance; // インスタンスのバッファでの開始位置
+	uint32_t instanceCount;
+};
+
+/// <summary>
+/// 描画要求を同じメッシュとマテリアルの組ごとにまとめ、インスタンスごとのTransformationMatrixを組の順に詰める
+/// 使い方: Clear → Add → Build → PackInstances → GetBatchesの順に描く
+/// </summary>
+class InstanceBatcher {
+public:
+	void Clear();
+	/// <summary>
+	/// 描画要求を追加する
+	/// </summary>
+	/// <param name="meshId">メッシュの番号</param>
+	/// <param name="materialId">マテリアルの番号</param>
+	/// <param name="transformIndex">PackInstancesに渡す変換行列の番号</param>
+	void Add(uint32_t meshId, uint32_t materialId, uint32_t transformIndex);
+
+	/// <summary>
+	/// 描画要求をメッシュ, マテリアルの順に並べてまとめる(同じ組の中では追加した順)
+	/// </summary>
+	void Build();
+
+	// Buildで作ったまとまり
+	const std::vector<InstanceBatch>& GetBatches() const { return batches; }
+	// インスタンスの数
+	size_t GetInstanceCount() const { return instanceTransformIndices.size(); }
+	// インスタンスごとの変換行列の番号(バッファに詰める順)
+	const std::vector<uint32_t>& GetInstanceTransformIndices() const { return instanceTransformIndices; }
+
+	/// <summary>
+	/// インスタンスの順に変換行列を詰めて書き込む(StructuredBufferとしてシェーダーから読む)
+	/// </summary>
+	/// <param name="source">番号0の変換行列の位置</param>
+	/// <param name="sourceStride">変換行列の間隔(バイト)</param>
+	/// <param name="destination">GetInstanceCount()個書き込める位置</param>
+	void PackInstances(const void* source, size_t sourceStride, TransformationMatrix* destination) const;
+
+private:
+	/// <summary>
+	/// 描画要求(keyはメッシュとマテリアルを並べたもの)
+	/// </summary>
+	struct DrawRequest {
+		uint64_t key;
+		uint32_t transformIndex;
+	};
+
+	std::vector<DrawRequest> requests;
+	std::vector<InstanceBatch> batches;
+	// 作業領域(keyからbatchesの番号、描画要求ごとのbatchesの番号、まとまりごとの書き込み位置)
+	std::unordered_map<uint64_t, uint32_t> batchLookup;
+	std::vector<uint32_t> requestBatchIndices;
+	std::vector<uint32_t> batchCursors;
+	std::vector<uint32_t> instanceTransformIndices;
+};
@@ -0,0 +1,325 @@
+#include "OcclusionBuffer.h"
+#include "../3d/Simd.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+// タイルの大きさ(ピクセル)
+const uint32_t kTileWidth = 8;
+const uint32_t kTileHeight = 4;
+const uint32_t kTileSize = kTileWidth * kTileHeight;
+// これより小さいwの頂点は近クリップ面の手前とみなす
+const float kMinClipW = 1e-5f;
+// Hi-Zで調べるセルの数(縦横それぞれこの数未満になる段まで上がる)
+const uint32_t kMaxHierarchySpan = 4;
+
+// 2次元の1次式 x * dx + y * dy + c
+struct LinearFunction {
+	float dx, dy, c;
+};
+
+/// <summary>
+/// 辺abの左右を表す1次式(三角形abcの面積が正のとき、内側で正になる)
+/// </summary>
+LinearFunction MakeEdgeFunction(float ax, float ay, float bx, float by) {
+	LinearFunction edge;
+	edge.dx = -(by - ay);
+	edge.dy = bx - ax;
+	edge.c = -(edge.dx * ax + edge.dy * ay);
+	return edge;
+}
+
+} // namespace
+
+void OcclusionBuffer::Initialize(uint32_t width, uint32_t height) {
+	assert(width > 0 && height > 0);
+	this->width = width;
+	this->height = height;
+	tileCountX = (width + kTileWidth - 1) / kTileWidth;
+	tileCountY = (height + kTileHeight - 1) / kTileHeight;
+	depths.assign(size_t(tileCountX) * tileCountY * kTileSize, 1.0f);
+
+	// 1x1になるまで縦横半分ずつの段を作る
+	hierarchy.clear();
+	hierarchyWidths.clear();
+	hierarchyHeights.clear();
+	uint32_t levelWidth = tileCountX;
+	uint32_t levelHeight = tileCountY;
+	while (true) {
+		hierarchy.emplace_back(size_t(levelWidth) * levelHeight, 1.0f);
+		hierarchyWidths.push_back(levelWidth);
+		hierarchyHeights.push_back(levelHeight);
+		if (levelWidth == 1 && levelHeight == 1) {
+			break;
+		}
+		levelWidth = (levelWidth + 1) / 2;
+		levelHeight = (levelHeight + 1) / 2;
+	}
+}
+
+void OcclusionBuffer::Clear() { std::fill(depths.begin(), depths.end(), 1.0f); }
+
+void OcclusionBuffer::RenderTriangles(const Vector4* positions, size_t vertexCount, size_t stride, const uint32_t* indices, size_t indexCount, const Matrix4x4& worldViewProjection) {
+	assert(width > 0 && indexCount % 3 == 0);
+	// 頂点は三角形ごとではなく1度だけ画面座標に変換する
+	const float halfWidth = float(width) * 0.5f;
+	const float halfHeight = float(height) * 0.5f;
+	const auto& m = worldViewProjection.m;
+	screenVertices.resize(vertexCount);
+	const char* source = reinterpret_cast<const char*>(positions);
+	for (size_t i = 0; i < vertexCount; i++) {
+		const Vector4& position = *reinterpret_cast<const Vector4*>(source + stride * i);
+		float clipX = position.x * m[0][0] + position.y * m[1][0] + position.z * m[2][0] + m[3][0];
+		float clipY = position.x * m[0][1] + position.y * m[1][1] + position.z * m[2][1] + m[3][1];
+		float clipZ = position.x * m[0][2] + position.y * m[1][2] + position.z * m[2][2] + m[3][2];
+		float clipW = position.x * m[0][3] + position.y * m[1][3] + position.z * m[2][3] + m[3][3];
+		ScreenVertex& vertex = screenVertices[i];
+		vertex.isClipped = clipW < kMinClipW || clipZ < 0.0f;
+		float inverseW = vertex.isClipped ? 0.0f : 1.0f / clipW;
+		vertex.x = (clipX * inverseW + 1.0f) * halfWidth;
+		vertex.y = (1.0f - clipY * inverseW) * halfHeight;
+		vertex.z = clipZ * inverseW;
+	}
+	for (size_t i = 0; i < indexCount; i += 3) {
+		RenderTriangle(screenVertices[indices[i]], screenVertices[indices[i + 1]], screenVertices[indices[i + 2]]);
+	}
+}
+
+void OcclusionBuffer::RenderOccluder(const ModelData& modelData, uint32_t lod, const Matrix4x4& worldViewProjection) {
+	uint32_t indexStart = 0;
+	uint32_t indexCount = uint32_t(modelData.indices.size());
+	if (!modelData.lods.empty()) {
+		assert(lod < modelData.lods.size());
+		indexStart = modelData.lods[lod].indexStart;
+		indexCount = modelData.lods[lod].indexCount;
+	}
+	if (modelData.vertices.empty() || indexCount == 0) {
+		return;
+	}
+	RenderTriangles(&modelData.vertices[0].position, modelData.vertices.size(), sizeof(VertexData), modelData.indices.data() + indexStart, indexCount, worldViewProjection);
+}
+
+void OcclusionBuffer::RenderTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2) {
+	// 近クリップ面をまたぐ三角形は切り分けずに描かない(遮蔽物が減るだけなので、隠れていない物体を消すことはない)
+	if (v0.isClipped || v1.isClipped || v2.isClipped) {
+		return;
+	}
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+	if (!(std::abs(area) > 0.0f)) {
+		return;
+	}
+	// 遮蔽物は両面とも描く。向きをそろえて面積を正にする
+	const ScreenVertex& a = v0;
+	const ScreenVertex& b = area > 0.0f ? v1 : v2;
+	const ScreenVertex& c = area > 0.0f ? v2 : v1;
+	area = std::abs(area);
+
+	// ピクセル全体が内側にあるピクセルだけを描く
+	int minX = (std::max)(int(std::ceil((std::min)({a.x, b.x, c.x}))), 0);
+	int minY = (std::max)(int(std::ceil((std::min)({a.y, b.y, c.y}))), 0);
+	int maxX = (std::min)(int(std::floor((std::max)({a.x, b.x, c.x}))) - 1, int(width) - 1);
+	int maxY = (std::min)(int(std::floor((std::max)({a.y, b.y, c.y}))) - 1, int(height) - 1);
+	if (minX > maxX || minY > maxY) {
+		return;
+	}
+
+	LinearFunction edges[3] = {MakeEdgeFunction(b.x, b.y, c.x, c.y), MakeEdgeFunction(c.x, c.y, a.x, a.y), MakeEdgeFunction(a.x, a.y, b.x, b.y)};
+	// 深度はピクセル内で一番奥の値を書く(三角形の頂点の一番奥を超えないようにする)
+	float inverseArea = 1.0f / area;
+	LinearFunction depth;
+	depth.dx = (edges[0].dx * a.z + edges[1].dx * b.z + edges[2].dx * c.z) * inverseArea;
+	depth.dy = (edges[0].dy * a.z + edges[1].dy * b.z + edges[2].dy * c.z) * inverseArea;
+	depth.c = (edges[0].c * a.z + edges[1].c * b.z + edges[2].c * c.z) * inverseArea + 0.5f * (std::abs(depth.dx) + std::abs(depth.dy));
+	const float maxDepth = (std::max)({a.z, b.z, c.z});
+	// ピクセルの中心で、ピクセルの角まで内側に入っているかを判定できるように、辺を内側へずらす
+	for (LinearFunction& edge : edges) {
+		edge.c -= 0.5f * (std::abs(edge.dx) + std::abs(edge.dy));
+	}
+
+#if ENGINE_USE_SSE
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 maxDepths = _mm_set1_ps(maxDepth);
+	__m128 edgeDx[3];
+	for (int k = 0; k < 3; k++) {
+		edgeDx[k] = _mm_set1_ps(edges[k].dx);
+	}
+	const __m128 depthDx = _mm_set1_ps(depth.dx);
+	for (int y = minY; y <= maxY; y++) {
+		float centerY = float(y) + 0.5f;
+		__m128 edgeRows[3];
+		for (int k = 0; k < 3; k++) {
+			edgeRows[k] = _mm_set1_ps(edges[k].dy * centerY + edges[k].c);
+		}
+		__m128 depthRow = _mm_set1_ps(depth.dy * centerY + depth.c);
+		float* row = depths.data() + (size_t(y) / kTileHeight * tileCountX) * kTileSize + (size_t(y) % kTileHeight) * kTileWidth;
+		for (int x = minX & ~3; x <= maxX; x += 4) {
+			__m128 centerX = _mm_add_ps(_mm_set1_ps(float(x)), laneOffsets);
+			__m128 isInside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeDx[0], centerX), edgeRows[0]), zero);
+			isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeDx[1], centerX), edgeRows[1]), zero));
+			isInside = _mm_and_ps(isInside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(edgeDx[2], centerX), edgeRows[2]), zero));
+			if (_mm_movemask_ps(isInside) == 0) {
+				continue;
+			}
+			float* destination = row + (size_t(x) / kTileWidth) * kTileSize + size_t(x) % kTileWidth;
+			__m128 current = _mm_loadu_ps(destination);
+			__m128 z = _mm_min_ps(_mm_add_ps(_mm_mul_ps(depthDx, centerX), depthRow), maxDepths);
+			z = _mm_min_ps(z, current);
+			_mm_storeu_ps(destination, _mm_or_ps(_mm_and_ps(isInside, z), _mm_andnot_ps(isInside, current)));
+		}
+	}
+#else
+	for (int y = minY; y <= maxY; y++) {
+		float centerY = float(y) + 0.5f;
+		float* row = depths.data() + (size_t(y) / kTileHeight * tileCountX) * kTileSize + (size_t(y) % kTileHeight) * kTileWidth;
+		for (int x = minX; x <= maxX; x++) {
+			float centerX = float(x) + 0.5f;
+			bool isInside = true;
+			for (const LinearFunction& edge : edges) {
+				isInside = isInside && edge.dx * centerX + edge.dy * centerY + edge.c >= 0.0f;
+			}
+			if (!isInside) {
+				continue;
+			}
+			float& destination = row[(size_t(x) / kTileWidth) * kTileSize + size_t(x) % kTileWidth];
+			destination = (std::min)({destination, depth.dx * centerX + depth.dy * centerY + depth.c, maxDepth});
+		}
+	}
+#endif
+}
+
+void OcclusionBuffer::BuildHierarchy() {
+	// 0段目はタイル内の一番奥の深度
+	std::vector<float>& tiles = hierarchy[0];
+	for (size_t tile = 0; tile < tiles.size(); tile++) {
+		const float* tileDepths = depths.data() + tile * kTileSize;
+#if ENGINE_USE_SSE
+		__m128 maximum = _mm_loadu_ps(tileDepths);
+		for (uint32_t i = 4; i < kTileSize; i += 4) {
+			maximum = _mm_max_ps(maximum, _mm_loadu_ps(tileDepths + i));
+		}
+		maximum = _mm_max_ps(maximum, _mm_shuffle_ps(maximum, maximum, _MM_SHUFFLE(1, 0, 3, 2)));
+		maximum = _mm_max_ps(maximum, _mm_shuffle_ps(maximum, maximum, _MM_SHUFFLE(2, 3, 0, 1)));
+		tiles[tile] = _mm_cvtss_f32(maximum);
+#else
+		tiles[tile] = *std::max_element(tileDepths, tileDepths + kTileSize);
+#endif
+	}
+	// 上の段は下の段の2x2の一番奥
+	for (size_t level = 1; level < hierarchy.size(); level++) {
+		const std::vector<float>& lower = hierarchy[level - 1];
+		const uint32_t lowerWidth = hierarchyWidths[level - 1];
+		const uint32_t lowerHeight = hierarchyHeights[level - 1];
+		for (uint32_t y = 0; y < hierarchyHeights[level]; y++) {
+			for (uint32_t x = 0; x < hierarchyWidths[level]; x++) {
+				uint32_t x0 = x * 2;
+				uint32_t y0 = y * 2;
+				uint32_t x1 = (std::min)(x0 + 1, lowerWidth - 1);
+				uint32_t y1 = (std::min)(y0 + 1, lowerHeight - 1);
+				hierarchy[level][size_t(y) * hierarchyWidths[level] + x] =
+				    (std::max)({lower[size_t(y0) * lowerWidth + x0], lower[size_t(y0) * lowerWidth + x1], lower[size_t(y1) * lowerWidth + x0], lower[size_t(y1) * lowerWidth + x1]});
+			}
+		}
+	}
+}
+
+bool OcclusionBuffer::IsRectVisible(int minX, int minY, int maxX, int maxY, float depth) const {
+	// 矩形が数セルに収まる段まで上がり、その段のセルの一番奥と比べる
+	uint32_t cellMinX = uint32_t(minX) / kTileWidth;
+	uint32_t cellMinY = uint32_t(minY) / kTileHeight;
+	uint32_t cellMaxX = uint32_t(maxX) / kTileWidth;
+	uint32_t cellMaxY = uint32_t(maxY) / kTileHeight;
+	size_t level = 0;
+	while ((cellMaxX - cellMinX >= kMaxHierarchySpan || cellMaxY - cellMinY >= kMaxHierarchySpan) && level + 1 < hierarchy.size()) {
+		cellMinX /= 2;
+		cellMinY /= 2;
+		cellMaxX /= 2;
+		cellMaxY /= 2;
+		level++;
+	}
+	const std::vector<float>& cells = hierarchy[level];
+	const uint32_t levelWidth = hierarchyWidths[level];
+	for (uint32_t y = cellMinY; y <= cellMaxY; y++) {
+		for (uint32_t x = cellMinX; x <= cellMaxX; x++) {
+			if (depth <= cells[size_t(y) * levelWidth + x]) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool OcclusionBuffer::IsVisible(const AABB& aabb, const Matrix4x4& worldViewProjection) const {
+	// 8つの角をクリップ座標に変換する(各軸の最小と最大を行に掛けたものを足し合わせる)
+	float minimumX = 1e30f;
+	float minimumY = 1e30f;
+	float maximumX = -1e30f;
+	float maximumY = -1e30f;
+	float nearestDepth = 1e30f;
+#if ENGINE_USE_SSE
+	const auto& m = worldViewProjection.m;
+	__m128 axisX[2] = {_mm_mul_ps(_mm_set1_ps(aabb.minimum.x), _mm_loadu_ps(m[0])), _mm_mul_ps(_mm_set1_ps(aabb.maximum.x), _mm_loadu_ps(m[0]))};
+	__m128 axisY[2] = {_mm_mul_ps(_mm_set1_ps(aabb.minimum.y), _mm_loadu_ps(m[1])), _mm_mul_ps(_mm_set1_ps(aabb.maximum.y), _mm_loadu_ps(m[1]))};
+	__m128 axisZ[2] = {_mm_add_ps(_mm_mul_ps(_mm_set1_ps(aabb.minimum.z), _mm_loadu_ps(m[2])), _mm_loadu_ps(m[3])),
+	                   _mm_add_ps(_mm_mul_ps(_mm_set1_ps(aabb.maximum.z), _mm_loadu_ps(m[2])), _mm_loadu_ps(m[3]))};
+	alignas(16) float corners[8][4];
+	for (int k = 0; k < 8; k++) {
+		_mm_store_ps(corners[k], _mm_add_ps(_mm_add_ps(axisX[k & 1], axisY[(k >> 1) & 1]), axisZ[(k >> 2) & 1]));
+	}
+#else
+	float corners[8][4];
+	for (int k = 0; k < 8; k++) {
+		Vector3 corner = {k & 1 ? aabb.maximum.x : aabb.minimum.x, k & 2 ? aabb.maximum.y : aabb.minimum.y, k & 4 ? aabb.maximum.z : aabb.minimum.z};
+		for (int column = 0; column < 4; column++) {
+			corners[k][column] = corner.x * worldViewProjection.m[0][column] + corner.y * worldViewProjection.m[1][column] + corner.z * worldViewProjection.m[2][column] + worldViewProjection.m[3][column];
+		}
+	}
+#endif
+	for (const float* corner : corners) {
+		// 近クリップ面をまたぐ物体は隠れているか分からないので見えるとする
+		if (corner[3] < kMinClipW || corner[2] < 0.0f) {
+			return true;
+		}
+		float inverseW = 1.0f / corner[3];
+		float x = corner[0] * inverseW;
+		float y = corner[1] * inverseW;
+		minimumX = (std::min)(minimumX, x);
+		maximumX = (std::max)(maximumX, x);
+		minimumY = (std::min)(minimumY, y);
+		maximumY = (std::max)(maximumY, y);
+		nearestDepth = (std::min)(nearestDepth, corner[2] * inverseW);
+	}
+
+	// 矩形が掛かるピクセルの範囲(画面外なら見えない)
+	const float halfWidth = float(width) * 0.5f;
+	const float halfHeight = float(height) * 0.5f;
+	float pixelMinX = std::floor((minimumX + 1.0f) * halfWidth);
+	float pixelMaxX = std::floor((maximumX + 1.0f) * halfWidth);
+	float pixelMinY = std::floor((1.0f - maximumY) * halfHeight);
+	float pixelMaxY = std::floor((1.0f - minimumY) * halfHeight);
+	if (pixelMaxX < 0.0f || pixelMaxY < 0.0f || pixelMinX >= float(width) || pixelMinY >= float(height)) {
+		return false;
+	}
+	int minX = (std::max)(int(pixelMinX), 0);
+	int minY = (std::max)(int(pixelMinY), 0);
+	int maxX = (std::min)(int(pixelMaxX), int(width) - 1);
+	int maxY = (std::min)(int(pixelMaxY), int(height) - 1);
+	return IsRectVisible(minX, minY, maxX, maxY, nearestDepth);
+}
+
+size_t OcclusionBuffer::FilterVisible(const AABB* aabbs, const Matrix4x4& viewProjection, uint32_t* indices, size_t count) const {
+	size_t visibleCount = 0;
+	for (size_t i = 0; i < count; i++) {
+		uint32_t index = indices[i];
+		indices[visibleCount] = index;
+		visibleCount += IsVisible(aabbs[index], viewProjection) ? 1 : 0;
+	}
+	return visibleCount;
+}
+
+float OcclusionBuffer::GetDepth(uint32_t x, uint32_t y) const {
+	assert(x < width && y < height);
+	return depths[(size_t(y) / kTileHeight * tileCountX + x / kTileWidth) * kTileSize + (y % kTileHeight) * kTileWidth + x % kTileWidth];
+}
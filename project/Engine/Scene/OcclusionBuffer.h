@@ -0,0 +1,87 @@
+#pragma once
+#include "../3d/Bounds.h"
+#include "../3d/Matrix.h"
+#include "../Model/ModelData.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// 遮蔽物の深度をCPUで低解像度に描き、その奥に隠れる物体を描画前に取り除く(オクルージョンカリング)
+/// 深度は8x4ピクセルのタイルごとに連続して並べ、4ピクセルずつ描く
+/// 遮蔽物はピクセル全体を覆う部分だけを、ピクセル内で一番奥の深度で描くので、見える物体を隠れていると判定することはない
+/// 使い方: Clear → RenderTriangles/RenderOccluder → BuildHierarchy → IsVisible/FilterVisible
+/// </summary>
+class OcclusionBuffer {
+public:
+	/// <summary>
+	/// 解像度を決める(画面と同じ縦横比の低い解像度にする)
+	/// </summary>
+	void Initialize(uint32_t width, uint32_t height);
+	uint32_t GetWidth() const { return width; }
+	uint32_t GetHeight() const { return height; }
+
+	// 深度を一番奥(1.0)で埋める
+	void Clear();
+
+	/// <summary>
+	/// 遮蔽物の三角形を描く(近クリップ面をまたぐ三角形は描かない)
+	/// </summary>
+	/// <param name="positions">先頭の位置(wは使わない)</param>
+	/// <param name="vertexCount">位置の数</param>
+	/// <param name="stride">位置の間隔(バイト)</param>
+	/// <param name="indices">3つで1つの三角形</param>
+	/// <param name="indexCount">インデックス数</param>
+	/// <param name="worldViewProjection">WVP</param>
+	void RenderTriangles(const Vector4* positions, size_t vertexCount, size_t stride, const uint32_t* indices, size_t indexCount, const Matrix4x4& worldViewProjection);
+	/// <summary>
+	/// モデルの指定したLODを遮蔽物として描く(LODがなければ元のメッシュ)
+	/// </summary>
+	void RenderOccluder(const ModelData& modelData, uint32_t lod, const Matrix4x4& worldViewProjection);
+
+	// タイルごとの一番奥の深度から、階層的な深度(Hi-Z)を作る
+	void BuildHierarchy();
+
+	/// <summary>
+	/// 物体が遮蔽物に隠れていないか(画面に映る矩形と一番手前の深度をHi-Zと比べる)
+	/// </summary>
+	/// <param name="aabb">物体のAABB</param>
+	/// <param name="worldViewProjection">aabbの座標からクリップ座標への変換(ワールド座標のAABBならビュープロジェクション行列)</param>
+	bool IsVisible(const AABB& aabb, const Matrix4x4& worldViewProjection) const;
+
+	/// <summary>
+	/// 番号の並びから隠れている物体を取り除き、前に詰める(視錐台カリングの結果をそのまま渡せる)
+	/// </summary>
+	/// <param name="aabbs">ワールド座標のAABB(indicesの値で参照する)</param>
+	/// <param name="viewProjection">ビュープロジェクション行列</param>
+	/// <param name="indices">物体の番号</param>
+	/// <param name="count">番号の数</param>
+	/// <returns>見える物体の数</returns>
+	size_t FilterVisible(const AABB* aabbs, const Matrix4x4& viewProjection, uint32_t* indices, size_t count) const;
+
+	// 1ピクセルの深度(検証用)
+	float GetDepth(uint32_t x, uint32_t y) const;
+
+private:
+	/// <summary>
+	/// 画面座標に変換した頂点
+	/// </summary>
+	struct ScreenVertex {
+		float x, y, z;    // ピクセル座標とz/w
+		bool isClipped;   // 近クリップ面より手前にある
+	};
+
+	void RenderTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2);
+	// ピクセルの矩形(端を含む)に、depthより奥の遮蔽物しかないか
+	bool IsRectVisible(int minX, int minY, int maxX, int maxY, float depth) const;
+
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t tileCountX = 0;
+	uint32_t tileCountY = 0;
+	std::vector<float> depths;                 // タイルごとに並べた深度
+	std::vector<std::vector<float>> hierarchy; // Hi-Z(0段目がタイルごと、1段ごとに縦横半分)
+	std::vector<uint32_t> hierarchyWidths;
+	std::vector<uint32_t> hierarchyHeights;
+	std::vector<ScreenVertex> screenVertices;  // 作業領域
+};
@@ -0,0 +1,74 @@
+#include "SceneHierarchy.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+uint32_t SceneHierarchy::Add(int32_t parent, const Transforms& transforms) {
+	uint32_t index = uint32_t(GetCount());
+	// 親を子より前に置くことで、先頭からなめれば親のワールド変換が必ず先に求まる
+	assert(parent == kNoParent || (parent >= 0 && uint32_t(parent) < index));
+	parents.push_back(parent);
+	localTransforms.push_back(MakeAffineTransform(transforms.scale, transforms.rotate, transforms.translate));
+	worldTransforms.push_back(localTransforms.back());
+	isDirty.push_back(0);
+	isChanged.push_back(0);
+	MarkDirty(index);
+	return index;
+}
+
+void SceneHierarchy::Reserve(size_t count) {
+	parents.reserve(count);
+	localTransforms.reserve(count);
+	worldTransforms.reserve(count);
+	isDirty.reserve(count);
+	isChanged.reserve(count);
+}
+
+void SceneHierarchy::Clear() {
+	parents.clear();
+	localTransforms.clear();
+	worldTransforms.clear();
+	isDirty.clear();
+	isChanged.clear();
+	firstDirty = 0;
+	firstChanged = 0;
+}
+
+void SceneHierarchy::SetLocal(uint32_t index, const Transforms& transforms) { SetLocal(index, MakeAffineTransform(transforms.scale, transforms.rotate, transforms.translate)); }
+
+void SceneHierarchy::SetLocal(uint32_t index, const AffineTransform& transform) {
+	assert(index < GetCount());
+	localTransforms[index] = transform;
+	MarkDirty(index);
+}
+
+void SceneHierarchy::MarkDirty(uint32_t index) {
+	isDirty[index] = 1;
+	firstDirty = (std::min)(firstDirty, size_t(index));
+}
+
+size_t SceneHierarchy::Update() {
+	const size_t count = GetCount();
+	// 前回ワールド変換が変わった物体のうち、今回なめない範囲のフラグを下ろす
+	const size_t clearEnd = (std::min)(firstDirty, count);
+	if (firstChanged < clearEnd) {
+		std::memset(isChanged.data() + firstChanged, 0, clearEnd - firstChanged);
+	}
+
+	// 親は子より前にあるので、親の変更フラグとワールド変換はこの時点で今回のものになっている
+	size_t updatedCount = 0;
+	for (size_t i = firstDirty; i < count; i++) {
+		const int32_t parent = parents[i];
+		const bool isParentChanged = parent != kNoParent && isChanged[parent];
+		const uint8_t changed = isDirty[i] | uint8_t(isParentChanged);
+		isChanged[i] = changed;
+		isDirty[i] = 0;
+		if (changed) {
+			worldTransforms[i] = parent == kNoParent ? localTransforms[i] : Multiply(localTransforms[i], worldTransforms[parent]);
+			updatedCount++;
+		}
+	}
+	firstChanged = firstDirty;
+	firstDirty = count;
+	return updatedCount;
+}
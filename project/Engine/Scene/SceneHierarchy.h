@@ -0,0 +1,56 @@
+#pragma once
+#include "../3d/Matrix.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// 親子関係のある物体のワールド変換を、親の番号の配列で平らに持つ
+/// 親は必ず子より前の番号にする(追加した順がそのまま親から子への順になる)ので、
+/// 先頭から1回なめるだけで、変更のあった部分木のワールド変換を計算し直せる
+/// </summary>
+class SceneHierarchy {
+public:
+	// 親のない物体の親の番号
+	static const int32_t kNoParent = -1;
+
+	/// <summary>
+	/// 物体を追加する
+	/// </summary>
+	/// <param name="parent">親の番号(追加済みの物体か、kNoParent)</param>
+	/// <param name="transforms">親から見たSRT</param>
+	/// <returns>物体の番号(0から順に振る)</returns>
+	uint32_t Add(int32_t parent, const Transforms& transforms);
+	void Reserve(size_t count);
+	void Clear();
+	size_t GetCount() const { return parents.size(); }
+	int32_t GetParent(uint32_t index) const { return parents[index]; }
+
+	// 親から見た変換を変更する(子孫も含めて、次のUpdateでワールド変換を計算し直す)
+	void SetLocal(uint32_t index, const Transforms& transforms);
+	void SetLocal(uint32_t index, const AffineTransform& transform);
+	const AffineTransform& GetLocal(uint32_t index) const { return localTransforms[index]; }
+
+	/// <summary>
+	/// 変更のあった物体とその子孫のワールド変換を計算する
+	/// </summary>
+	/// <returns>計算し直した物体の数</returns>
+	size_t Update();
+
+	// 最後のUpdateで求めたワールド変換
+	const AffineTransform& GetWorld(uint32_t index) const { return worldTransforms[index]; }
+	Matrix4x4 GetWorldMatrix(uint32_t index) const { return ToMatrix4x4(worldTransforms[index]); }
+	// 最後のUpdateでワールド変換が変わったか(GPUへ書き込む物体を選ぶときなど)
+	bool IsWorldChanged(uint32_t index) const { return isChanged[index] != 0; }
+
+private:
+	void MarkDirty(uint32_t index);
+
+	std::vector<int32_t> parents;
+	std::vector<AffineTransform> localTransforms;
+	std::vector<AffineTransform> worldTransforms;
+	std::vector<uint8_t> isDirty;   // 親から見た変換を変更したか
+	std::vector<uint8_t> isChanged; // 最後のUpdateでワールド変換が変わったか
+	size_t firstDirty = 0;          // 変更のあった一番前の物体(なければGetCount())
+	size_t firstChanged = 0;        // isChangedが立っているかもしれない一番前の物体
+};
@@ -0,0 +1,159 @@
+#include "TransformStorage.h"
+#include "../3d/TransformBatch.h"
+#include <cassert>
+#include <cstring>
+
+uint32_t TransformStorage::Add(const Transforms& transforms) {
+	uint32_t index = uint32_t(GetCount());
+	scaleX.push_back(transforms.scale.x);
+	scaleY.push_back(transforms.scale.y);
+	scaleZ.push_back(transforms.scale.z);
+	rotateX.push_back(transforms.rotate.x);
+	rotateY.push_back(transforms.rotate.y);
+	rotateZ.push_back(transforms.rotate.z);
+	translateX.push_back(transforms.translate.x);
+	translateY.push_back(transforms.translate.y);
+	translateZ.push_back(transforms.translate.z);
+	worldMatrices.push_back(MakeIdentity4x4());
+	isDirty.push_back(0);
+	localMatrixSlots.push_back(-1);
+	MarkDirty(index);
+	return index;
+}
+
+void TransformStorage::Reserve(size_t count) {
+	for (std::vector<float>* component : {&scaleX, &scaleY, &scaleZ, &rotateX, &rotateY, &rotateZ, &translateX, &translateY, &translateZ}) {
+		component->reserve(count);
+	}
+	worldMatrices.reserve(count);
+	isDirty.reserve(count);
+	dirtyIndices.reserve(count);
+	localMatrixSlots.reserve(count);
+}
+
+void TransformStorage::Clear() {
+	for (std::vector<float>* component : {&scaleX, &scaleY, &scaleZ, &rotateX, &rotateY, &rotateZ, &translateX, &translateY, &translateZ}) {
+		component->clear();
+	}
+	worldMatrices.clear();
+	isDirty.clear();
+	dirtyIndices.clear();
+	localMatrixSlots.clear();
+	localMatrices.clear();
+	lastDestination = nullptr;
+}
+
+void TransformStorage::Set(uint32_t index, const Transforms& transforms) {
+	SetScale(index, transforms.scale);
+	SetRotate(index, transforms.rotate);
+	SetTranslate(index, transforms.translate);
+}
+
+void TransformStorage::SetScale(uint32_t index, const Vector3& scale) {
+	assert(index < GetCount());
+	if (scaleX[index] == scale.x && scaleY[index] == scale.y && scaleZ[index] == scale.z) {
+		return;
+	}
+	scaleX[index] = scale.x;
+	scaleY[index] = scale.y;
+	scaleZ[index] = scale.z;
+	MarkDirty(index);
+}
+
+void TransformStorage::SetRotate(uint32_t index, const Vector3& rotate) {
+	assert(index < GetCount());
+	if (rotateX[index] == rotate.x && rotateY[index] == rotate.y && rotateZ[index] == rotate.z) {
+		return;
+	}
+	rotateX[index] = rotate.x;
+	rotateY[index] = rotate.y;
+	rotateZ[index] = rotate.z;
+	MarkDirty(index);
+}
+
+void TransformStorage::SetTranslate(uint32_t index, const Vector3& translate) {
+	assert(index < GetCount());
+	if (translateX[index] == translate.x && translateY[index] == translate.y && translateZ[index] == translate.z) {
+		return;
+	}
+	translateX[index] = translate.x;
+	translateY[index] = translate.y;
+	translateZ[index] = translate.z;
+	MarkDirty(index);
+}
+
+Transforms TransformStorage::Get(uint32_t index) const {
+	assert(index < GetCount());
+	return {{scaleX[index], scaleY[index], scaleZ[index]}, {rotateX[index], rotateY[index], rotateZ[index]}, {translateX[index], translateY[index], translateZ[index]}};
+}
+
+void TransformStorage::SetLocalMatrix(uint32_t index, const Matrix4x4& localMatrix) {
+	assert(index < GetCount());
+	if (localMatrixSlots[index] < 0) {
+		localMatrixSlots[index] = int32_t(localMatrices.size());
+		localMatrices.push_back(localMatrix);
+	} else {
+		localMatrices[localMatrixSlots[index]] = localMatrix;
+	}
+	MarkDirty(index);
+}
+
+void TransformStorage::MarkDirty(uint32_t index) {
+	if (!isDirty[index]) {
+		isDirty[index] = 1;
+		dirtyIndices.push_back(index);
+	}
+}
+
+size_t TransformStorage::Update(const Matrix4x4& viewProjection, void* destination, size_t stride) {
+	assert(destination != nullptr && stride >= sizeof(TransformationMatrix));
+	const size_t count = GetCount();
+	const size_t dirtyCount = dirtyIndices.size();
+	const bool isAllDirty = dirtyCount == count;
+
+	// 変更のあった物体のワールド行列を求める(全てなら配列をそのまま、一部なら詰めてから計算する)
+	if (isAllDirty) {
+		TransformArrays arrays{scaleX.data(), scaleY.data(), scaleZ.data(), rotateX.data(), rotateY.data(), rotateZ.data(), translateX.data(), translateY.data(), translateZ.data()};
+		MakeAffineMatrices(arrays, count, worldMatrices.data());
+	} else if (dirtyCount > 0) {
+		const std::vector<float>* components[9] = {&scaleX, &scaleY, &scaleZ, &rotateX, &rotateY, &rotateZ, &translateX, &translateY, &translateZ};
+		for (int k = 0; k < 9; k++) {
+			gathered[k].resize(dirtyCount);
+			for (size_t i = 0; i < dirtyCount; i++) {
+				gathered[k][i] = (*components[k])[dirtyIndices[i]];
+			}
+		}
+		TransformArrays arrays{gathered[0].data(), gathered[1].data(), gathered[2].data(), gathered[3].data(), gathered[4].data(), gathered[5].data(), gathered[6].data(), gathered[7].data(), gathered[8].data()};
+		gatheredWorlds.resize(dirtyCount);
+		MakeAffineMatrices(arrays, dirtyCount, gatheredWorlds.data());
+		for (size_t i = 0; i < dirtyCount; i++) {
+			worldMatrices[dirtyIndices[i]] = gatheredWorlds[i];
+		}
+	}
+
+	// カメラか書き込み先が変わったら全ての物体、そうでなければ変更のあった物体だけWVPを書き込む
+	const bool isFullUpdate = isAllDirty || destination != lastDestination || stride != lastStride || std::memcmp(&viewProjection, &lastViewProjection, sizeof(Matrix4x4)) != 0;
+	const size_t writeCount = isFullUpdate ? count : dirtyCount;
+	gatheredWvps.resize(writeCount);
+	MultiplyMatrices(isFullUpdate ? worldMatrices.data() : gatheredWorlds.data(), writeCount, viewProjection, gatheredWvps.data());
+	char* base = static_cast<char*>(destination);
+	for (size_t i = 0; i < writeCount; i++) {
+		uint32_t index = isFullUpdate ? uint32_t(i) : dirtyIndices[i];
+		if (localMatrixSlots[index] >= 0) {
+			gatheredWvps[i] = Multiply(localMatrices[localMatrixSlots[index]], gatheredWvps[i]);
+		}
+		// アップロード用のバッファは書き込み結合なので、WVPとワールド行列を順に書く
+		TransformationMatrix* output = reinterpret_cast<TransformationMatrix*>(base + stride * index);
+		std::memcpy(&output->WVP, &gatheredWvps[i], sizeof(Matrix4x4));
+		std::memcpy(&output->world, &worldMatrices[index], sizeof(Matrix4x4));
+	}
+
+	for (uint32_t index : dirtyIndices) {
+		isDirty[index] = 0;
+	}
+	dirtyIndices.clear();
+	lastDestination = destination;
+	lastStride = stride;
+	lastViewProjection = viewProjection;
+	return writeCount;
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "../3d/Matrix.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// 1物体分の変換行列(シェーダーのTransformationMatrixと同じ並び)
+/// </summary>
+struct TransformationMatrix {
+	Matrix4x4 WVP;
+	Matrix4x4 world;
+};
+
+/// <summary>
+/// 多数の物体のSRTを成分ごとの配列(SoA)で持ち、変更のあった物体の行列だけをまとめて計算する
+/// 計算したWVPとワールド行列は、アップロード用のバッファなどに物体の番号順に詰めて書き込む
+/// </summary>
+class TransformStorage {
+public:
+	/// <summary>
+	/// 物体を追加する
+	/// </summary>
+	/// <returns>物体の番号(0から順に振る)</returns>
+	uint32_t Add(const Transforms& transforms);
+	void Reserve(size_t count);
+	void Clear();
+	size_t GetCount() const { return isDirty.size(); }
+
+	// SRTを変更する(値が変わった物体だけ、次のUpdateで行列を計算し直す)
+	void Set(uint32_t index, const Transforms& transforms);
+	void SetScale(uint32_t index, const Vector3& scale);
+	void SetRotate(uint32_t index, const Vector3& rotate);
+	void SetTranslate(uint32_t index, const Vector3& translate);
+	Transforms Get(uint32_t index) const;
+
+	/// <summary>
+	/// WVPにだけ掛ける、モデル座標の変換を設定する(量子化した頂点の展開など。ワールド行列には含めない)
+	/// WVP = localMatrix * world * viewProjection
+	/// </summary>
+	void SetLocalMatrix(uint32_t index, const Matrix4x4& localMatrix);
+
+	/// <summary>
+	/// 変更のあった物体のワールド行列とWVPを計算し、destinationに書き込む
+	/// ビュープロジェクション行列か書き込み先が前回と違えば、全ての物体のWVPを書き込む
+	/// </summary>
+	/// <param name="viewProjection">ビュープロジェクション行列</param>
+	/// <param name="destination">物体0のTransformationMatrixを書き込む位置</param>
+	/// <param name="stride">物体ごとの間隔(バイト。定数バッファとして使うなら256の倍数)</param>
+	/// <returns>書き込んだ物体の数</returns>
+	size_t Update(const Matrix4x4& viewProjection, void* destination, size_t stride = sizeof(TransformationMatrix));
+
+	// 最後のUpdateで求めたワールド行列
+	const Matrix4x4& GetWorldMatrix(uint32_t index) const { return worldMatrices[index]; }
+
+private:
+	void MarkDirty(uint32_t index);
+
+	// SRTの成分ごとの配列
+	std::vector<float> scaleX, scaleY, scaleZ;
+	std::vector<float> rotateX, rotateY, rotateZ;
+	std::vector<float> translateX, translateY, translateZ;
+	std::vector<Matrix4x4> worldMatrices;
+	std::vector<uint8_t> isDirty;          // 物体ごとの変更フラグ
+	std::vector<uint32_t> dirtyIndices;    // 変更のあった物体(変更した順)
+	std::vector<int32_t> localMatrixSlots; // localMatricesの番号(なければ-1)
+	std::vector<Matrix4x4> localMatrices;
+	// 変更のあった物体だけを詰めて計算するための作業領域
+	std::vector<float> gathered[9];
+	std::vector<Matrix4x4> gatheredWorlds;
+	std::vector<Matrix4x4> gatheredWvps;
+	// 前回のUpdateの書き込み先とビュープロジェクション行列
+	void* lastDestination = nullptr;
+	size_t lastStride = 0;
+	Matrix4x4 lastViewProjection{};
+};
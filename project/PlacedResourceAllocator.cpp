@@ -0,0 +1,222 @@
+#include "PlacedResourceAllocator.h"
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+namespace {
+
+// ヒープの番号と位置から、デフラグで動かすリソースを引くためのキー
+uint64_t GetLocationKey(const HeapAllocation& allocation) { return (uint64_t(allocation.heapIndex) << 40) | allocation.offset; }
+
+} // namespace
+
+PlacedResource::PlacedResource(PlacedResource&& other) noexcept : allocator(other.allocator), index(other.index), generation(other.generation) { other.allocator = nullptr; }
+
+PlacedResource& PlacedResource::operator=(PlacedResource&& other) noexcept {
+	if (this != &other) {
+		Reset();
+		allocator = other.allocator;
+		index = other.index;
+		generation = other.generation;
+		other.allocator = nullptr;
+	}
+	return *this;
+}
+
+void PlacedResource::Reset() {
+	if (allocator != nullptr) {
+		allocator->Release(index, generation);
+		allocator = nullptr;
+	}
+}
+
+const Microsoft::WRL::ComPtr<ID3D12Resource>& PlacedResource::GetResource() const {
+	static const Microsoft::WRL::ComPtr<ID3D12Resource> kNullResource;
+	return allocator != nullptr ? allocator->GetPlacement(index, generation).resource : kNullResource;
+}
+
+PlacedResourceAllocator::~PlacedResourceAllocator() { assert(placementCount == 0); }
+
+void PlacedResourceAllocator::Initialize(const Microsoft::WRL::ComPtr<ID3D12Device>& device, uint64_t heapSize) {
+	assert(device != nullptr);
+	this->device = device;
+	this->heapSize = heapSize;
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options{};
+	HRESULT hr = device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options));
+	assert(SUCCEEDED(hr));
+	isResourceHeapTier2 = options.ResourceHeapTier >= D3D12_RESOURCE_HEAP_TIER_2;
+}
+
+D3D12_HEAP_FLAGS PlacedResourceAllocator::GetHeapFlags(const D3D12_RESOURCE_DESC& resourceDesc) const {
+	// Tier2なら全ての種類を同じヒープに置ける
+	if (isResourceHeapTier2) {
+		return D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+	}
+	if (resourceDesc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+		return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+	}
+	if (resourceDesc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) {
+		return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+	}
+	return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+}
+
+size_t PlacedResourceAllocator::GetPool(const D3D12_HEAP_PROPERTIES& heapProperties, D3D12_HEAP_FLAGS flags) {
+	for (size_t poolIndex = 0; poolIndex < pools.size(); poolIndex++) {
+		const HeapPool& pool = *pools[poolIndex];
+		if (pool.properties.Type == heapProperties.Type && pool.properties.CPUPageProperty == heapProperties.CPUPageProperty && pool.properties.MemoryPoolPreference == heapProperties.MemoryPoolPreference && pool.flags == flags) {
+			return poolIndex;
+		}
+	}
+	// プールはHeapAllocatorの処理から参照するので、動かないようにunique_ptrで持つ
+	pools.push_back(std::make_unique<HeapPool>());
+	HeapPool* pool = pools.back().get();
+	pool->properties = heapProperties;
+	pool->flags = flags;
+	pool->allocator = std::make_unique<HeapAllocator>(
+	    heapSize,
+	    [this, pool](uint32_t heapIndex, uint64_t size) {
+		    D3D12_HEAP_DESC heapDesc{};
+		    heapDesc.SizeInBytes = size;
+		    heapDesc.Properties = pool->properties;
+		    heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+		    heapDesc.Flags = pool->flags;
+		    Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+		    if (FAILED(device->CreateHeap(&heapDesc, IID_PPV_ARGS(&heap)))) {
+			    return false;
+		    }
+		    if (heapIndex >= pool->heaps.size()) {
+			    pool->heaps.resize(heapIndex + 1);
+		    }
+		    pool->heaps[heapIndex] = heap;
+		    return true;
+	    },
+	    [pool](uint32_t heapIndex) { pool->heaps[heapIndex] = nullptr; });
+	return pools.size() - 1;
+}
+
+PlacedResource PlacedResourceAllocator::CreateResource(const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& resourceDesc, D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue) {
+	assert(device != nullptr);
+	// レンダーターゲットと深度以外の小さいテクスチャは4KB単位で置けるので、まずはそれで大きさを調べる
+	D3D12_RESOURCE_DESC desc = resourceDesc;
+	D3D12_RESOURCE_ALLOCATION_INFO info{};
+	if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER && !(desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) && desc.SampleDesc.Count <= 1) {
+		desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+		info = device->GetResourceAllocationInfo(0, 1, &desc);
+	}
+	if (info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT) {
+		desc.Alignment = 0;
+		info = device->GetResourceAllocationInfo(0, 1, &desc);
+	}
+	// MSAAのリソース(4MB単位)は使っていないので、ヒープは64KB単位で作る
+	assert(info.Alignment <= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+
+	const size_t poolIndex = GetPool(heapProperties, GetHeapFlags(desc));
+	HeapPool& pool = *pools[poolIndex];
+	// バッファは指定したバイト数だけを使うので、64KBに揃えた残りは無駄として数える
+	const uint64_t requestedSize = desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER ? (std::min)(desc.Width, info.SizeInBytes) : info.SizeInBytes;
+	HeapAllocation allocation{};
+	bool isAllocated = pool.allocator->Allocate(info.SizeInBytes, info.Alignment, allocation, requestedSize);
+	assert(isAllocated);
+	if (!isAllocated) {
+		return {};
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
+	HRESULT hr = device->CreatePlacedResource(pool.heaps[allocation.heapIndex].Get(), allocation.offset, &desc, initialState, clearValue, IID_PPV_ARGS(&resource));
+	assert(SUCCEEDED(hr));
+	if (FAILED(hr)) {
+		pool.allocator->Free(allocation);
+		return {};
+	}
+
+	// 解放した置き場所があれば使い直す(世代は解放したときに進めてある)
+	uint32_t index = uint32_t(placements.size());
+	if (!freePlacementIndices.empty()) {
+		index = freePlacementIndices.back();
+		freePlacementIndices.pop_back();
+	} else {
+		placements.push_back({});
+	}
+	Placement& placement = placements[index];
+	placement.resource = resource;
+	placement.poolIndex = poolIndex;
+	placement.allocation = allocation;
+	placement.desc = desc;
+	placement.hasClearValue = clearValue != nullptr;
+	placement.clearValue = clearValue != nullptr ? *clearValue : D3D12_CLEAR_VALUE{};
+	placementCount++;
+	return PlacedResource(this, index, placement.generation);
+}
+
+const PlacedResourceAllocator::Placement& PlacedResourceAllocator::GetPlacement(uint32_t index, uint32_t generation) const {
+	assert(index < placements.size() && placements[index].generation == generation && placements[index].resource != nullptr);
+	return placements[index];
+}
+
+void PlacedResourceAllocator::Release(uint32_t index, uint32_t generation) {
+	assert(index < placements.size() && placements[index].generation == generation && placements[index].resource != nullptr);
+	Placement& placement = placements[index];
+	pools[placement.poolIndex]->allocator->Free(placement.allocation);
+	placement.resource = nullptr;
+	placement.generation++;
+	freePlacementIndices.push_back(index);
+	placementCount--;
+}
+
+uint32_t PlacedResourceAllocator::Defragment(uint32_t maxMoves, const std::function<void(const Microsoft::WRL::ComPtr<ID3D12Resource>& source, ID3D12Resource* destination)>& move) {
+	uint32_t moveCount = 0;
+	for (size_t poolIndex = 0; poolIndex < pools.size() && moveCount < maxMoves; poolIndex++) {
+		HeapPool& pool = *pools[poolIndex];
+		// CPUから書き込むヒープは、書き込み先のアドレスを呼び出し側が持っているので動かさない
+		if (pool.properties.Type != D3D12_HEAP_TYPE_DEFAULT) {
+			continue;
+		}
+		// 前回動かしたものをコピーし終えているので、空いたヒープを消す
+		pool.allocator->ReleaseEmptyHeaps();
+		// HeapAllocationから置き場所の番号を引けるようにする
+		std::unordered_map<uint64_t, uint32_t> placementIndices;
+		for (uint32_t index = 0; index < placements.size(); index++) {
+			if (placements[index].resource != nullptr && placements[index].poolIndex == poolIndex) {
+				placementIndices.emplace(GetLocationKey(placements[index].allocation), index);
+			}
+		}
+		moveCount += pool.allocator->Defragment(maxMoves - moveCount, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT, [&](const HeapAllocation& source, const HeapAllocation& destination) {
+			auto found = placementIndices.find(GetLocationKey(source));
+			assert(found != placementIndices.end());
+			const uint32_t index = found->second;
+			placementIndices.erase(found);
+			Placement& placement = placements[index];
+			Microsoft::WRL::ComPtr<ID3D12Resource> destinationResource = nullptr;
+			HRESULT hr = device->CreatePlacedResource(pool.heaps[destination.heapIndex].Get(), destination.offset, &placement.desc, D3D12_RESOURCE_STATE_COPY_DEST, placement.hasClearValue ? &placement.clearValue : nullptr, IID_PPV_ARGS(&destinationResource));
+			assert(SUCCEEDED(hr));
+			// ハンドルは置き場所の番号で引くので、置き場所を移動先に書き換えるだけで移動先を指す
+			Microsoft::WRL::ComPtr<ID3D12Resource> sourceResource = std::move(placement.resource);
+			placement.resource = destinationResource;
+			placement.allocation = destination;
+			// 動かした先の位置からも引けるようにしておく
+			placementIndices.emplace(GetLocationKey(destination), index);
+			move(sourceResource, destinationResource.Get());
+		});
+	}
+	return moveCount;
+}
+
+HeapStatistics PlacedResourceAllocator::GetStatistics() const {
+	HeapStatistics statistics{};
+	float fragmentedSize = 0.0f;
+	for (const std::unique_ptr<HeapPool>& pool : pools) {
+		const HeapStatistics poolStatistics = pool->allocator->GetStatistics();
+		statistics.heapCount += poolStatistics.heapCount;
+		statistics.allocationCount += poolStatistics.allocationCount;
+		statistics.heapSize += poolStatistics.heapSize;
+		statistics.usedSize += poolStatistics.usedSize;
+		statistics.freeSize += poolStatistics.freeSize;
+		statistics.largestFreeSize = (std::max)(statistics.largestFreeSize, poolStatistics.largestFreeSize);
+		statistics.wastedSize += poolStatistics.wastedSize;
+		fragmentedSize += poolStatistics.fragmentation * float(poolStatistics.freeSize);
+	}
+	// プールをまたいでは確保できないので、断片化はプールごとの値を空きの大きさで重み付けして平均する
+	statistics.fragmentation = statistics.freeSize == 0 ? 0.0f : fragmentedSize / float(statistics.freeSize);
+	return statistics;
+}
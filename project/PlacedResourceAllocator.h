@@ -0,0 +1,127 @@
+#pragma once
+#include "Engine/Base/HeapAllocator.h"
+#include <d3d12.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <wrl.h>
+
+class PlacedResourceAllocator;
+
+/// <summary>
+/// PlacedResourceAllocatorで作ったリソースのハンドル。破棄するとヒープの範囲を空きに戻す(GPUが使い終わってから破棄すること)
+/// デフラグで動かしたときは、動かした先のリソースを指す
+/// 番号と世代で置き場所を引くので、解放した後のハンドルや、同じ番号を使い直した別のリソースとは取り違えない
+/// </summary>
+class PlacedResource {
+public:
+	PlacedResource() = default;
+	PlacedResource(PlacedResource&& other) noexcept;
+	PlacedResource& operator=(PlacedResource&& other) noexcept;
+	PlacedResource(const PlacedResource&) = delete;
+	PlacedResource& operator=(const PlacedResource&) = delete;
+	~PlacedResource() { Reset(); }
+
+	/// <summary>
+	/// リソースを解放して範囲を空きに戻し、空のハンドルにする
+	/// </summary>
+	void Reset();
+
+	const Microsoft::WRL::ComPtr<ID3D12Resource>& GetResource() const;
+	ID3D12Resource* Get() const { return GetResource().Get(); }
+	ID3D12Resource* operator->() const { return Get(); }
+	bool IsNull() const { return allocator == nullptr; }
+
+private:
+	friend class PlacedResourceAllocator;
+	PlacedResource(PlacedResourceAllocator* allocator, uint32_t index, uint32_t generation) : allocator(allocator), index(index), generation(generation) {}
+
+	PlacedResourceAllocator* allocator = nullptr; // 空のハンドルはnullptr
+	uint32_t index = 0;                           // 置き場所の番号
+	uint32_t generation = 0;                      // 置き場所の世代
+};
+
+/// <summary>
+/// 大きなID3D12Heapから範囲を切り出してプレースドリソースを作るアロケーター
+/// ヒープはヒープのプロパティとリソースの種類ごとに分ける
+/// (リソースヒープのTier1では、バッファ、テクスチャ、レンダーターゲットと深度を同じヒープに置けない)
+/// </summary>
+class PlacedResourceAllocator {
+public:
+	// ヒープ1つのバイト数
+	static const uint64_t kDefaultHeapSize = 32 * 1024 * 1024;
+
+	PlacedResourceAllocator() = default;
+	// ハンドルがアロケーターを指すので、コピーも移動もしない
+	PlacedResourceAllocator(const PlacedResourceAllocator&) = delete;
+	PlacedResourceAllocator& operator=(const PlacedResourceAllocator&) = delete;
+	// 作ったリソースのハンドルは全て先に破棄しておくこと
+	~PlacedResourceAllocator();
+
+	/// <summary>
+	/// 初期化(リソースヒープのTierを調べる)
+	/// </summary>
+	void Initialize(const Microsoft::WRL::ComPtr<ID3D12Device>& device, uint64_t heapSize = kDefaultHeapSize);
+
+	/// <summary>
+	/// リソースを作る(CreateCommittedResourceの代わり)
+	/// </summary>
+	/// <returns>リソースのハンドル(作れなければ空)</returns>
+	PlacedResource CreateResource(const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& resourceDesc, D3D12_RESOURCE_STATES initialState, const D3D12_CLEAR_VALUE* clearValue);
+
+	/// <summary>
+	/// DEFAULTヒープのリソースを使用量の多いヒープへ寄せ、空いたヒープを消す
+	/// moveには移動元とCOPY_DEST状態で作った移動先が渡されるので、コピーを積んでビューを移動先で作り直す(ハンドルは移動先を指すようになる)
+	/// 移動元のリソースはGPUのコピーが終わるまで参照を持っておき、次の呼び出しはコピーが終わってから行うこと(空いたヒープはそこで消す)
+	/// </summary>
+	/// <param name="maxMoves">1回で動かす最大数</param>
+	/// <param name="move">リソースを動かす処理</param>
+	/// <returns>動かした数</returns>
+	uint32_t Defragment(uint32_t maxMoves, const std::function<void(const Microsoft::WRL::ComPtr<ID3D12Resource>& source, ID3D12Resource* destination)>& move);
+
+	// 全てのヒープの使用状況
+	HeapStatistics GetStatistics() const;
+
+private:
+	friend class PlacedResource;
+
+	/// <summary>
+	/// 同じプロパティとフラグのヒープの集まり
+	/// </summary>
+	struct HeapPool {
+		D3D12_HEAP_PROPERTIES properties;
+		D3D12_HEAP_FLAGS flags;
+		std::vector<Microsoft::WRL::ComPtr<ID3D12Heap>> heaps; // HeapAllocatorのヒープの番号ごと
+		std::unique_ptr<HeapAllocator> allocator;
+	};
+
+	/// <summary>
+	/// 作ったリソースの置き場所(PlacedResourceの番号ごと)
+	/// </summary>
+	struct Placement {
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource; // 解放した置き場所はnullptr
+		uint32_t generation;                             // 解放するたびに増やす
+		size_t poolIndex;
+		HeapAllocation allocation;
+		D3D12_RESOURCE_DESC desc; // デフラグで作り直すときに使う
+		bool hasClearValue;
+		D3D12_CLEAR_VALUE clearValue;
+	};
+
+	// プロパティとフラグが同じプールを探し、なければ作る
+	size_t GetPool(const D3D12_HEAP_PROPERTIES& heapProperties, D3D12_HEAP_FLAGS flags);
+	// リソースの種類とTierから、置けるヒープのフラグを決める
+	D3D12_HEAP_FLAGS GetHeapFlags(const D3D12_RESOURCE_DESC& resourceDesc) const;
+	// ハンドルの指す置き場所(解放済みのハンドルならassert)
+	const Placement& GetPlacement(uint32_t index, uint32_t generation) const;
+	// リソースの範囲を空きに戻す(PlacedResourceの破棄から呼ぶ)
+	void Release(uint32_t index, uint32_t generation);
+
+	Microsoft::WRL::ComPtr<ID3D12Device> device;
+	uint64_t heapSize = kDefaultHeapSize;
+	bool isResourceHeapTier2 = false;
+	std::vector<std::unique_ptr<HeapPool>> pools;
+	std::vector<Placement> placements;
+	std::vector<uint32_t> freePlacementIndices; // 使い直せるplacementsの番号
+	uint32_t placementCount = 0;                // 使っている置き場所の数
+};
@@ -0,0 +1,27 @@
+#include"Object3D.hlsli"
+
+
+struct TransformationMatrix
+{
+    float4x4 WVP;
+    float4x4 world;
+};
+// インスタンスごとの変換行列。SV_InstanceIDはStartInstanceLocationを含まないので、まとまりの先頭をルートSRVのアドレスで指す
+StructuredBuffer<TransformationMatrix> gInstanceTransformationMatrices : register(t1);
+
+struct VertexShaderInput
+{
+    float4 position : POSITION;
+    float2 texcoord : TEXCOORD0;
+    float3 normal : NORMAL;
+};
+
+VertexShaderOutput main(VertexShaderInput input, uint instanceId : SV_InstanceID)
+{
+    TransformationMatrix transformationMatrix = gInstanceTransformationMatrices[instanceId];
+    VertexShaderOutput output;
+    output.position = mul(input.position, transformationMatrix.WVP);
+    output.texcoord = input.texcoord;
+    output.normal = normalize(mul(input.normal, (float3x3) transformationMatrix.world));
+    return output;
+}
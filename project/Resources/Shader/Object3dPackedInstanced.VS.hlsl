@@ -0,0 +1,38 @@
+#include"Object3D.hlsli"
+
+
+struct TransformationMatrix
+{
+    float4x4 WVP; // 圧縮した位置(0～1)を元に戻す行列を含む
+    float4x4 world;
+};
+// インスタンスごとの変換行列。SV_InstanceIDはStartInstanceLocationを含まないので、まとまりの先頭をルートSRVのアドレスで指す
+StructuredBuffer<TransformationMatrix> gInstanceTransformationMatrices : register(t1);
+
+// PackedVertexDataに対応する入力
+struct VertexShaderInput
+{
+    float4 position : POSITION; // R16G16B16A16_UNORM
+    float2 texcoord : TEXCOORD0; // R16G16_FLOAT
+    float2 normal : NORMAL; // R16G16_SNORM(八面体に写した法線)
+};
+
+// 八面体に写した法線を単位ベクトルに戻す
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    float fold = saturate(-normal.z);
+    float2 signs = step(0.0f, normal.xy) * 2.0f - 1.0f; // 0は正として扱う
+    normal.xy -= signs * fold;
+    return normalize(normal);
+}
+
+VertexShaderOutput main(VertexShaderInput input, uint instanceId : SV_InstanceID)
+{
+    TransformationMatrix transformationMatrix = gInstanceTransformationMatrices[instanceId];
+    VertexShaderOutput output;
+    output.position = mul(input.position, transformationMatrix.WVP);
+    output.texcoord = input.texcoord;
+    output.normal = normalize(mul(DecodeOctahedralNormal(input.normal), (float3x3) transformationMatrix.world));
+    return output;
+}
@@ -0,0 +1,191 @@
+#include "Engine/Base/HeapAllocator.h"
+#include "Engine/Base/TlsfAllocator.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+// D3D12のプレースドリソースの位置の単位
+const uint64_t kPlacementAlignment = 64 * 1024;
+
+/// <summary>
+/// 空きを位置の順にstd::mapで持ち、先頭から探す確保(比較用)
+/// </summary>
+class FirstFitAllocator {
+public:
+	explicit FirstFitAllocator(uint64_t capacity) { freeRanges[0] = capacity; }
+
+	bool Allocate(uint64_t size, uint64_t& offset) {
+		for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it) {
+			if (it->second < size) {
+				continue;
+			}
+			offset = it->first;
+			if (it->second > size) {
+				freeRanges[it->first + size] = it->second - size;
+			}
+			freeRanges.erase(it);
+			return true;
+		}
+		return false;
+	}
+
+	void Free(uint64_t offset, uint64_t size) {
+		auto it = freeRanges.emplace(offset, size).first;
+		auto next = std::next(it);
+		if (next != freeRanges.end() && it->first + it->second == next->first) {
+			it->second += next->second;
+			freeRanges.erase(next);
+		}
+		if (it != freeRanges.begin()) {
+			auto previous = std::prev(it);
+			if (previous->first + previous->second == it->first) {
+				previous->second += it->second;
+				freeRanges.erase(it);
+			}
+		}
+	}
+
+private:
+	std::map<uint64_t, uint64_t> freeRanges; // 位置と大きさ
+};
+
+/// <summary>
+/// 1回あたりの時間(ナノ秒)を測る
+/// </summary>
+template<class Function> double MeasureNanoseconds(uint32_t count, Function function) {
+	return TestFramework::MeasureMilliseconds([&] { function(count); }) * 1000000.0 / double(count);
+}
+
+/// <summary>
+/// 半分ほど埋めた範囲で、ランダムに選んだ1つを解放して別の大きさで確保し直す1組の時間
+/// </summary>
+void BenchmarkSteadyState(uint32_t count, uint32_t liveCount) {
+	const uint64_t capacity = uint64_t(liveCount) * 4096;
+	std::mt19937 random(1);
+	std::uniform_int_distribution<uint64_t> sizeDistribution(1, 4096);
+	std::vector<uint64_t> sizes(count);
+	std::vector<uint32_t> slots(count);
+	for (uint32_t i = 0; i < count; i++) {
+		sizes[i] = sizeDistribution(random);
+		slots[i] = uint32_t(random() % liveCount);
+	}
+
+	TlsfAllocator tlsf(capacity);
+	std::vector<TlsfAllocation> tlsfAllocations(liveCount);
+	for (uint32_t i = 0; i < liveCount; i++) {
+		tlsf.Allocate(sizes[i], 1, tlsfAllocations[i]);
+	}
+	uint32_t failureCount = 0;
+	const double tlsfTime = MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			TlsfAllocation& allocation = tlsfAllocations[slots[i]];
+			tlsf.Free(allocation);
+			failureCount += tlsf.Allocate(sizes[i], 1, allocation) ? 0 : 1;
+		}
+	});
+	CHECK(failureCount == 0);
+
+	FirstFitAllocator firstFit(capacity);
+	std::vector<uint64_t> offsets(liveCount);
+	std::vector<uint64_t> liveSizes(sizes.begin(), sizes.begin() + liveCount);
+	for (uint32_t i = 0; i < liveCount; i++) {
+		firstFit.Allocate(liveSizes[i], offsets[i]);
+	}
+	// 空きの数に比例して遅くなるので、回数を減らして測る
+	const uint32_t firstFitCount = (std::min)(count, 100000u);
+	const double firstFitTime = MeasureNanoseconds(firstFitCount, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			const uint32_t slot = slots[i];
+			firstFit.Free(offsets[slot], liveSizes[slot]);
+			liveSizes[slot] = sizes[i];
+			failureCount += firstFit.Allocate(liveSizes[slot], offsets[slot]) ? 0 : 1;
+		}
+	});
+	CHECK(failureCount == 0);
+
+	std::printf("%6u live: TlsfAllocator %7.1f ns, first fit (std::map) %8.1f ns per Free+Allocate, TLSF used %.1f%%\n", liveCount, tlsfTime, firstFitTime,
+	            double(tlsf.GetUsedSize()) * 100.0 / double(capacity));
+}
+
+/// <summary>
+/// 32MBのヒープに64KB～4MBの範囲を確保、解放する時間と、半分以上を解放した後のデフラグの時間
+/// </summary>
+void BenchmarkHeapAllocator(uint32_t count) {
+	const uint64_t kHeapSize = 32 * 1024 * 1024;
+	const uint32_t kLiveCount = 512;
+	// ヒープの実体は作らず、位置の管理だけを測る
+	HeapAllocator allocator(kHeapSize, [](uint32_t, uint64_t) { return true; }, [](uint32_t) {});
+	std::mt19937 random(2);
+	std::uniform_int_distribution<uint64_t> sizeDistribution(1, 64);
+	std::vector<uint64_t> sizes(count);
+	std::vector<uint32_t> slots(count);
+	for (uint32_t i = 0; i < count; i++) {
+		sizes[i] = sizeDistribution(random) * kPlacementAlignment;
+		slots[i] = uint32_t(random() % kLiveCount);
+	}
+
+	std::vector<HeapAllocation> allocations(kLiveCount);
+	for (uint32_t i = 0; i < kLiveCount; i++) {
+		allocator.Allocate(sizes[i], kPlacementAlignment, allocations[i]);
+	}
+	uint32_t failureCount = 0;
+	const double time = MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			HeapAllocation& allocation = allocations[slots[i]];
+			allocator.Free(allocation);
+			failureCount += allocator.Allocate(sizes[i], kPlacementAlignment, allocation) ? 0 : 1;
+		}
+	});
+	CHECK(failureCount == 0);
+	HeapStatistics statistics = allocator.GetStatistics();
+	std::printf("HeapAllocator: %.1f ns per Free+Allocate, %u heaps, used %.1f%%\n", time, statistics.heapCount, double(statistics.usedSize) * 100.0 / double(statistics.heapSize));
+
+	// 6割を解放して散らばった空きを作り、何度かに分けてデフラグする
+	std::vector<HeapAllocation> liveAllocations;
+	for (const HeapAllocation& allocation : allocations) {
+		if (random() % 10 < 6) {
+			allocator.Free(allocation);
+		} else {
+			liveAllocations.push_back(allocation);
+		}
+	}
+	statistics = allocator.GetStatistics();
+	const uint32_t heapCountBefore = statistics.heapCount;
+	uint32_t moveCount = 0;
+	uint32_t callCount = 0;
+	const double defragmentTime = TestFramework::MeasureMilliseconds([&] {
+		uint32_t moved = 0;
+		do {
+			moved = allocator.Defragment(64, kPlacementAlignment, [](const HeapAllocation&, const HeapAllocation&) {});
+			allocator.ReleaseEmptyHeaps();
+			moveCount += moved;
+			callCount++;
+		} while (moved > 0);
+	});
+	statistics = allocator.GetStatistics();
+	CHECK(statistics.allocationCount == liveAllocations.size());
+	std::printf("Defragment: %u allocations, %u -> %u heaps, %u moves in %u calls, %.3f ms (%.2f us per move)\n", statistics.allocationCount, heapCountBefore, statistics.heapCount, moveCount,
+	            callCount, defragmentTime, moveCount > 0 ? defragmentTime * 1000.0 / double(moveCount) : 0.0);
+}
+
+} // namespace
+
+/// <summary>
+/// TlsfAllocatorとHeapAllocatorの確保、解放、デフラグの時間を測る
+/// 使い方: AllocatorBenchmark [回数(既定2000000)]
+/// </summary>
+int main(int argc, char** argv) {
+	const uint32_t count = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 2000000;
+	std::printf("%u iterations\n", count);
+	for (uint32_t liveCount : {1024u, 16384u}) {
+		BenchmarkSteadyState(count, liveCount);
+	}
+	BenchmarkHeapAllocator(count);
+	return TestFramework::Finish();
+}
@@ -0,0 +1,129 @@
+#include "Engine/Base/AsyncLoader.h"
+#include "TestFramework.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 完了キューの長さ(AsyncLoader.cppのkCompletedQueueCapacity)
+const uint32_t kCompletedQueueCapacity = 1024;
+
+/// <summary>
+/// 読み込みの結果がそれぞれのonReadyに渡り、onReadyはUpdateを呼んだスレッドで1回ずつ呼ばれる
+/// </summary>
+void TestRequestAndUpdate() {
+	const uint32_t kRequestCount = 200;
+	AsyncLoader loader(4);
+	const std::thread::id mainThread = std::this_thread::get_id();
+	std::vector<int> results(kRequestCount + 1, -1);
+	std::vector<int> readyCounts(kRequestCount + 1, 0);
+	int wrongThreadCount = 0;
+	std::vector<AssetHandle> handles;
+	for (uint32_t i = 0; i < kRequestCount; i++) {
+		handles.push_back(loader.Request<int>([i] { return int(i * i); }, [&](AssetHandle handle, int& value) {
+			results[handle] = value;
+			readyCounts[handle]++;
+			wrongThreadCount += std::this_thread::get_id() == mainThread ? 0 : 1;
+		}));
+	}
+	CHECK(loader.GetPendingCount() == kRequestCount);
+	CHECK(handles.front() != kInvalidAssetHandle);
+	CHECK(loader.GetState(kInvalidAssetHandle) == AssetState::Invalid);
+	CHECK(loader.GetState(handles.back() + 1) == AssetState::Invalid);
+
+	// 1回のUpdateで処理する数を抑えられる
+	while (loader.GetPendingCount() > 0) {
+		CHECK(loader.Update(10) <= 10);
+	}
+	loader.WaitAll();
+	CHECK(wrongThreadCount == 0);
+	for (uint32_t i = 0; i < kRequestCount; i++) {
+		CHECK(loader.IsReady(handles[i]));
+		CHECK(readyCounts[handles[i]] == 1);
+		CHECK(results[handles[i]] == int(i * i));
+	}
+	CHECK(loader.Update() == 0);
+}
+
+/// <summary>
+/// デストラクタが終わるまで待つ(終わらなければ失敗を表示して止める)
+/// </summary>
+void DestroyWithTimeout(std::unique_ptr<AsyncLoader> loader) {
+	std::atomic<bool> isDestroyed = false;
+	std::thread destroyer([&] {
+		loader.reset();
+		isDestroyed = true;
+	});
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (!isDestroyed && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	if (!CHECK(isDestroyed)) {
+		// ワーカースレッドがjoinで止まったまま戻らないので、ここで終える
+		std::printf("[FAILED] the destructor did not return\n");
+		const int result = TestFramework::Finish();
+		std::fflush(stdout);
+		std::_Exit(result);
+	}
+	destroyer.join();
+}
+
+/// <summary>
+/// 完了キューが満杯のまま(Updateを呼ばずに)壊しても、待っているワーカースレッドが抜けて終わる
+/// </summary>
+void TestShutdownWhileFull() {
+	auto loader = std::make_unique<AsyncLoader>(1);
+	std::atomic<uint32_t> loadCount = 0;
+	int readyCount = 0;
+	for (uint32_t i = 0; i < kCompletedQueueCapacity + 100; i++) {
+		loader->Request<int>(
+		    [&] {
+			    loadCount++;
+			    return 1;
+		    },
+		    [&](AssetHandle, int&) { readyCount++; });
+	}
+	// キューを満たした次の1件を読み終え、ワーカースレッドが空きを待つまで待つ
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while (loadCount < kCompletedQueueCapacity + 1 && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CHECK(loadCount == kCompletedQueueCapacity + 1);
+	DestroyWithTimeout(std::move(loader));
+	CHECK(readyCount == 0);
+}
+
+/// <summary>
+/// 始まっていない読み込みは取り消し、実行中の読み込みの終わりを待って壊す
+/// </summary>
+void TestShutdownWithPendingJobs() {
+	auto loader = std::make_unique<AsyncLoader>(1);
+	std::atomic<uint32_t> loadCount = 0;
+	for (uint32_t i = 0; i < 100; i++) {
+		loader->Request<int>(
+		    [&] {
+			    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			    loadCount++;
+			    return 1;
+		    },
+		    [](AssetHandle, int&) {});
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	DestroyWithTimeout(std::move(loader));
+	std::printf("  %u of 100 loads ran before the loader was destroyed\n", loadCount.load());
+	CHECK(loadCount >= 1 && loadCount < 100);
+}
+
+} // namespace
+
+int main() {
+	TestFramework::Run("results reach onReady on the thread that calls Update", TestRequestAndUpdate);
+	TestFramework::Run("destroying the loader while the completed queue is full", TestShutdownWhileFull);
+	TestFramework::Run("destroying the loader cancels jobs that have not started", TestShutdownWithPendingJobs);
+	return TestFramework::Finish();
+}
@@ -0,0 +1,80 @@
+#include "Engine/3d/Frustum.h"
+#include "TestFramework.h"
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// <summary>
+/// count個の球とAABBを、CullSpheres, CullAABBsとIsVisibleを1つずつ呼ぶループで判定する1回あたりの時間(ミリ秒)を測る
+/// </summary>
+void BenchmarkCulling(const Frustum& frustum, size_t count, uint32_t repeatCount) {
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	std::vector<Sphere> spheres(count);
+	std::vector<AABB> aabbs(count);
+	for (size_t i = 0; i < count; i++) {
+		const Vector3 center = {distribution(random) * 60.0f, distribution(random) * 60.0f, distribution(random) * 60.0f};
+		const float radius = std::fabs(distribution(random)) * 2.0f;
+		spheres[i] = {center, radius};
+		aabbs[i] = {center - Vector3{radius, radius * 0.5f, radius}, center + Vector3{radius, radius * 0.5f, radius}};
+	}
+	std::vector<uint32_t> visibleIndices(count);
+	size_t sphereCount = 0;
+	size_t aabbCount = 0;
+	size_t loopCount = 0;
+	const double scale = 1.0 / double(repeatCount);
+	const double sphereTime = TestFramework::MeasureMilliseconds([&] {
+		for (uint32_t r = 0; r < repeatCount; r++) {
+			sphereCount = CullSpheres(frustum, spheres.data(), count, visibleIndices.data());
+		}
+	}) * scale;
+	const double sphereLoopTime = TestFramework::MeasureMilliseconds([&] {
+		for (uint32_t r = 0; r < repeatCount; r++) {
+			loopCount = 0;
+			for (size_t i = 0; i < count; i++) {
+				visibleIndices[loopCount] = uint32_t(i);
+				loopCount += IsVisible(frustum, spheres[i]) ? 1 : 0;
+			}
+		}
+	}) * scale;
+	CHECK(loopCount == sphereCount);
+	const double aabbTime = TestFramework::MeasureMilliseconds([&] {
+		for (uint32_t r = 0; r < repeatCount; r++) {
+			aabbCount = CullAABBs(frustum, aabbs.data(), count, visibleIndices.data());
+		}
+	}) * scale;
+	const double aabbLoopTime = TestFramework::MeasureMilliseconds([&] {
+		for (uint32_t r = 0; r < repeatCount; r++) {
+			loopCount = 0;
+			for (size_t i = 0; i < count; i++) {
+				visibleIndices[loopCount] = uint32_t(i);
+				loopCount += IsVisible(frustum, aabbs[i]) ? 1 : 0;
+			}
+		}
+	}) * scale;
+	CHECK(loopCount == aabbCount);
+	std::printf("%8zu spheres: CullSpheres %8.3f ms, IsVisible loop %8.3f ms (%zu visible)\n", count, sphereTime, sphereLoopTime, sphereCount);
+	std::printf("%8zu AABBs:   CullAABBs   %8.3f ms, IsVisible loop %8.3f ms (%zu visible)\n", count, aabbTime, aabbLoopTime, aabbCount);
+}
+
+} // namespace
+
+/// <summary>
+/// 視錐台カリングの1回あたりの時間を、1万、10万、100万個で測る
+/// EngineにリンクしたCullingBenchmark(SSE)とEngineScalarにリンクしたCullingBenchmarkScalarを比べる
+/// 使い方: CullingBenchmark [100万個のときの回数(既定10)]
+/// </summary>
+int main(int argc, char** argv) {
+	const uint32_t repeatCount = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 10;
+	std::printf("ENGINE_USE_SSE=%d\n", ENGINE_USE_SSE);
+	const Matrix4x4 view = ToMatrix4x4(InverseRigid(MakeAffineTransform({1.0f, 1.0f, 1.0f}, {0.3f, 0.5f, 0.0f}, {0.0f, 0.0f, -10.0f})));
+	const Frustum frustum = MakeFrustum(Multiply(view, MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f)));
+	// 少ない数では回数を増やして、どれも同じくらいの時間を測る
+	BenchmarkCulling(frustum, 10000, repeatCount * 100);
+	BenchmarkCulling(frustum, 100000, repeatCount * 10);
+	BenchmarkCulling(frustum, 1000000, repeatCount);
+	return TestFramework::Finish();
+}
@@ -0,0 +1,192 @@
+#include "Engine/Base/DescriptorAllocator.h"
+#include "TestFramework.h"
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// <summary>
+/// 解放したハンドルは、同じ番号が別の確保に使われても無効のまま
+/// </summary>
+void TestStaleHandle() {
+	DescriptorAllocator allocator(16);
+	const DescriptorHandle handle = allocator.Allocate();
+	CHECK(allocator.IsValid(handle));
+	allocator.Free(handle, 1);
+	CHECK(!allocator.IsValid(handle));
+	allocator.ReleaseCompleted(1);
+
+	// 同じ番号を1つで使い直すと世代が変わる
+	const DescriptorHandle reused = allocator.Allocate();
+	CHECK(reused.index == handle.index);
+	CHECK(reused.generation != handle.generation);
+	CHECK(allocator.IsValid(reused));
+	CHECK(!allocator.IsValid(handle));
+	allocator.Free(reused, 2);
+	allocator.ReleaseCompleted(2);
+
+	// 連続した確保の途中の番号になっても無効のまま
+	const DescriptorHandle first = allocator.Allocate();
+	const DescriptorHandle second = allocator.Allocate();
+	allocator.Free(second, 3);
+	allocator.Free(first, 3);
+	allocator.ReleaseCompleted(3);
+	const DescriptorHandle range = allocator.Allocate(16);
+	CHECK(allocator.GetIndex(range) == 0);
+	CHECK(second.index > 0 && second.index < 16);
+	CHECK(!allocator.IsValid(second));
+	CHECK(!allocator.IsValid(first));
+	CHECK(allocator.IsValid(range));
+	CHECK(!allocator.IsValid(DescriptorHandle{}));
+}
+
+/// <summary>
+/// 解放した番号は、ReleaseCompletedにそのフェンスの値が来るまで使い直さない
+/// </summary>
+void TestReuseAfterFence() {
+	DescriptorAllocator allocator(8);
+	std::vector<DescriptorHandle> handles;
+	for (int i = 0; i < 8; i++) {
+		handles.push_back(allocator.Allocate());
+	}
+	CHECK(allocator.Allocate().IsNull());
+	allocator.Free(handles[2], 5);
+	allocator.Free(handles[6], 6);
+	CHECK(allocator.GetUsedCount() == 8);
+	CHECK(allocator.GetPendingCount() == 2);
+	CHECK(allocator.Allocate().IsNull());
+
+	allocator.ReleaseCompleted(4);
+	CHECK(allocator.GetPendingCount() == 2);
+	CHECK(allocator.Allocate().IsNull());
+
+	allocator.ReleaseCompleted(5);
+	CHECK(allocator.GetPendingCount() == 1);
+	const DescriptorHandle reused = allocator.Allocate();
+	CHECK(reused.index == handles[2].index);
+	CHECK(allocator.Allocate().IsNull());
+
+	allocator.ReleaseCompleted(6);
+	CHECK(allocator.GetPendingCount() == 0);
+	CHECK(allocator.Allocate().index == handles[6].index);
+	CHECK(allocator.GetUsedCount() == 8);
+}
+
+/// <summary>
+/// 連続した確保は、つながった空きがなければ失敗し、解放して空きがつながれば入る
+/// </summary>
+void TestContiguousRange() {
+	DescriptorAllocator allocator(32);
+	const DescriptorHandle a = allocator.Allocate(10);
+	const DescriptorHandle b = allocator.Allocate(12);
+	const DescriptorHandle c = allocator.Allocate(10);
+	CHECK(allocator.GetCount(a) == 10 && allocator.GetCount(b) == 12 && allocator.GetCount(c) == 10);
+	CHECK(allocator.GetIndex(b) == allocator.GetIndex(a) + 10);
+	CHECK(allocator.GetIndex(c) == allocator.GetIndex(b) + 12);
+	CHECK(allocator.Allocate().IsNull());
+
+	// aとcを解放しても、10より大きい連続した空きはない
+	allocator.Free(a, 1);
+	allocator.Free(c, 1);
+	allocator.ReleaseCompleted(1);
+	CHECK(allocator.GetUsedCount() == 12);
+	CHECK(allocator.Allocate(11).IsNull());
+	// bも解放すると全体がつながる
+	allocator.Free(b, 2);
+	allocator.ReleaseCompleted(2);
+	const DescriptorHandle all = allocator.Allocate(32);
+	CHECK(!all.IsNull() && allocator.GetIndex(all) == 0);
+}
+
+/// <summary>
+/// 2フレーム遅れてGPUが終わる想定でランダムに確保と解放を繰り返し、
+/// 確保中やGPUを待っている番号を重ねて渡さないことと、解放したハンドルが無効のままであることを確かめる
+/// </summary>
+void TestRandomFrames(uint32_t seed) {
+	const uint32_t kCapacity = 1024;
+	const uint64_t kFrameLatency = 2;
+	enum class State : uint8_t { Free, Allocated, Pending };
+	struct Range {
+		DescriptorHandle handle;
+		uint32_t count;
+		uint64_t fenceValue;
+	};
+
+	DescriptorAllocator allocator(kCapacity);
+	std::mt19937 random(seed);
+	std::vector<State> states(kCapacity, State::Free);
+	std::vector<Range> liveRanges;
+	std::deque<Range> pendingRanges;
+	std::vector<DescriptorHandle> freedHandles;
+	uint64_t fenceValue = 1;
+	int overlapCount = 0;
+	int staleCount = 0;
+	int failureCount = 0;
+	for (int frame = 0; frame < 3000; frame++) {
+		// GPUはkFrameLatencyフレーム前まで終わっている
+		const uint64_t completedValue = fenceValue > kFrameLatency ? fenceValue - kFrameLatency : 0;
+		allocator.ReleaseCompleted(completedValue);
+		while (!pendingRanges.empty() && pendingRanges.front().fenceValue <= completedValue) {
+			for (uint32_t i = 0; i < pendingRanges.front().count; i++) {
+				states[pendingRanges.front().handle.index + i] = State::Free;
+			}
+			pendingRanges.pop_front();
+		}
+
+		for (int operation = 0; operation < 40; operation++) {
+			if (liveRanges.empty() || random() % 2 == 0) {
+				const uint32_t count = random() % 8 == 0 ? 1 + uint32_t(random() % 32) : 1;
+				const DescriptorHandle handle = allocator.Allocate(count);
+				if (handle.IsNull()) {
+					failureCount++;
+					continue;
+				}
+				for (uint32_t i = 0; i < count; i++) {
+					overlapCount += states[handle.index + i] != State::Free ? 1 : 0;
+					states[handle.index + i] = State::Allocated;
+				}
+				liveRanges.push_back({handle, count, 0});
+			} else {
+				const size_t index = random() % liveRanges.size();
+				Range range = liveRanges[index];
+				liveRanges[index] = liveRanges.back();
+				liveRanges.pop_back();
+				allocator.Free(range.handle, fenceValue);
+				range.fenceValue = fenceValue;
+				for (uint32_t i = 0; i < range.count; i++) {
+					states[range.handle.index + i] = State::Pending;
+				}
+				pendingRanges.push_back(range);
+				freedHandles.push_back(range.handle);
+			}
+		}
+		for (const DescriptorHandle& handle : freedHandles) {
+			staleCount += allocator.IsValid(handle) ? 1 : 0;
+		}
+		if (freedHandles.size() > 256) {
+			freedHandles.erase(freedHandles.begin(), freedHandles.end() - 256);
+		}
+
+		uint32_t pendingCount = 0;
+		for (const Range& range : pendingRanges) {
+			pendingCount += range.count;
+		}
+		CHECK(allocator.GetPendingCount() == pendingCount);
+		fenceValue++;
+	}
+	CHECK(overlapCount == 0);
+	CHECK(staleCount == 0);
+	std::printf("  seed %u: %zu live, %zu pending, %d allocations did not fit\n", seed, liveRanges.size(), pendingRanges.size(), failureCount);
+}
+
+} // namespace
+
+int main() {
+	TestFramework::Run("freed handles stay invalid after their index is reused", TestStaleHandle);
+	TestFramework::Run("freed indices are reused only after the fence passes", TestReuseAfterFence);
+	TestFramework::Run("contiguous ranges", TestContiguousRange);
+	TestFramework::Run("random frames with the GPU two frames behind (seed 1)", [] { TestRandomFrames(1); });
+	TestFramework::Run("random frames with the GPU two frames behind (seed 2)", [] { TestRandomFrames(2); });
+	return TestFramework::Finish();
+}
@@ -0,0 +1,152 @@
+#include "Engine/3d/Frustum.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// <summary>
+/// (0, 2, -10)から少し見下ろして右を向いたカメラのビュー行列
+/// </summary>
+Matrix4x4 MakeView() { return ToMatrix4x4(InverseRigid(MakeAffineTransform({1.0f, 1.0f, 1.0f}, {0.3f, 0.5f, 0.0f}, {0.0f, 2.0f, -10.0f}))); }
+
+Matrix4x4 MakePerspective() { return Multiply(MakeView(), MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f)); }
+
+Matrix4x4 MakeOrthographic() { return Multiply(MakeView(), MakeOrthographicMatrix(-20.0f, 12.0f, 20.0f, -12.0f, 0.1f, 60.0f)); }
+
+/// <summary>
+/// 視錐台の周りにランダムな球とAABBを作る(AABBは球と同じ中心で、yだけ薄くする)
+/// </summary>
+void MakeBounds(uint32_t seed, size_t count, std::vector<Sphere>& spheres, std::vector<AABB>& aabbs) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	spheres.resize(count);
+	aabbs.resize(count);
+	for (size_t i = 0; i < count; i++) {
+		const Vector3 center = {distribution(random) * 60.0f, distribution(random) * 60.0f, distribution(random) * 60.0f};
+		const float radius = std::fabs(distribution(random)) * 2.0f;
+		spheres[i] = {center, radius};
+		aabbs[i] = {center - Vector3{radius, radius * 0.5f, radius}, center + Vector3{radius, radius * 0.5f, radius}};
+	}
+}
+
+/// <summary>
+/// CullSpheres, CullAABBsの結果が、IsVisibleを1つずつ呼んだ結果と番号まで一致する
+/// 4の倍数でない数では、4つずつの判定の後に残る端数も確かめる
+/// </summary>
+void TestBatchMatchesScalar(const Matrix4x4& viewProjection) {
+	const Frustum frustum = MakeFrustum(viewProjection);
+	const size_t counts[] = {0, 1, 2, 3, 4, 5, 6, 7, 9, 13, 1000, 1003, 65537};
+	std::vector<Sphere> spheres;
+	std::vector<AABB> aabbs;
+	size_t totalVisibleSpheres = 0;
+	size_t totalVisibleAABBs = 0;
+	size_t totalCount = 0;
+	for (size_t count : counts) {
+		MakeBounds(uint32_t(count) + 1, count, spheres, aabbs);
+		// 書き込み過ぎを見つけられるように、番号にならない値で埋めておく
+		std::vector<uint32_t> visibleIndices(count + 4, 0xffffffffu);
+		std::vector<uint32_t> expected;
+
+		const size_t sphereCount = CullSpheres(frustum, spheres.data(), count, visibleIndices.data());
+		for (size_t i = 0; i < count; i++) {
+			if (IsVisible(frustum, spheres[i])) {
+				expected.push_back(uint32_t(i));
+			}
+		}
+		CHECK(sphereCount == expected.size());
+		CHECK(std::equal(expected.begin(), expected.end(), visibleIndices.begin()));
+		totalVisibleSpheres += sphereCount;
+
+		std::fill(visibleIndices.begin(), visibleIndices.end(), 0xffffffffu);
+		expected.clear();
+		const size_t aabbCount = CullAABBs(frustum, aabbs.data(), count, visibleIndices.data());
+		for (size_t i = 0; i < count; i++) {
+			if (IsVisible(frustum, aabbs[i])) {
+				expected.push_back(uint32_t(i));
+			}
+		}
+		CHECK(aabbCount == expected.size());
+		CHECK(std::equal(expected.begin(), expected.end(), visibleIndices.begin()));
+		totalVisibleAABBs += aabbCount;
+		totalCount += count;
+	}
+	std::printf("  %zu bounds: %zu spheres and %zu AABBs visible\n", totalCount, totalVisibleSpheres, totalVisibleAABBs);
+	// どちらの側も十分に判定している
+	CHECK(totalVisibleSpheres > totalCount / 100 && totalVisibleSpheres < totalCount / 2);
+}
+
+/// <summary>
+/// IsVisibleを、クリップ座標で -w <= x <= w, -w <= y <= w, 0 <= z <= w を直接確かめた結果と比べる
+/// 点(半径0の球)は平面のすぐ近く以外で一致し、AABBは角が1つでも中にあれば見え、全ての角が1つの平面の裏にあれば見えない
+/// </summary>
+void TestMatchesClipSpace(const Matrix4x4& viewProjection) {
+	const Frustum frustum = MakeFrustum(viewProjection);
+	auto isInsideClip = [&](const Vector3& point) {
+		const auto& m = viewProjection.m;
+		float clip[4];
+		for (int j = 0; j < 4; j++) {
+			clip[j] = point.x * m[0][j] + point.y * m[1][j] + point.z * m[2][j] + m[3][j];
+		}
+		return clip[3] > 0.0f && std::fabs(clip[0]) <= clip[3] && std::fabs(clip[1]) <= clip[3] && clip[2] >= 0.0f && clip[2] <= clip[3];
+	};
+	auto isNearPlane = [&](const Vector3& point) {
+		for (const Plane& plane : frustum.planes) {
+			if (std::fabs(Dot(plane.normal, point) + plane.distance) < 1e-3f) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	int pointMismatchCount = 0;
+	int insideCount = 0;
+	for (int i = 0; i < 100000; i++) {
+		const Vector3 point = {distribution(random) * 60.0f, distribution(random) * 60.0f, distribution(random) * 60.0f};
+		const bool isInside = isInsideClip(point);
+		insideCount += isInside ? 1 : 0;
+		pointMismatchCount += isInside != IsVisible(frustum, Sphere{point, 0.0f}) && !isNearPlane(point) ? 1 : 0;
+	}
+	CHECK(pointMismatchCount == 0);
+	CHECK(insideCount > 0);
+
+	int aabbMismatchCount = 0;
+	for (int i = 0; i < 20000; i++) {
+		const Vector3 center = {distribution(random) * 60.0f, distribution(random) * 60.0f, distribution(random) * 60.0f};
+		const Vector3 extent = {std::fabs(distribution(random)) * 3.0f, std::fabs(distribution(random)) * 3.0f, std::fabs(distribution(random)) * 3.0f};
+		const AABB aabb = {center - extent, center + extent};
+		bool isCornerInside = false;
+		bool isOutsidePlane = false;
+		for (const Plane& plane : frustum.planes) {
+			int outsideCount = 0;
+			for (int k = 0; k < 8; k++) {
+				const Vector3 corner = {k & 1 ? aabb.maximum.x : aabb.minimum.x, k & 2 ? aabb.maximum.y : aabb.minimum.y, k & 4 ? aabb.maximum.z : aabb.minimum.z};
+				isCornerInside = isCornerInside || (isInsideClip(corner) && !isNearPlane(corner));
+				outsideCount += Dot(plane.normal, corner) + plane.distance < -1e-3f ? 1 : 0;
+			}
+			isOutsidePlane = isOutsidePlane || outsideCount == 8;
+		}
+		const bool isVisible = IsVisible(frustum, aabb);
+		aabbMismatchCount += (isCornerInside && !isVisible) || (isOutsidePlane && isVisible) ? 1 : 0;
+	}
+	CHECK(aabbMismatchCount == 0);
+}
+
+} // namespace
+
+/// <summary>
+/// 視錐台カリングを、1つずつの判定やクリップ座標での判定と比べる
+/// ENGINE_USE_SSEを1にしたEngineと0にしたEngineScalarの両方にリンクしてビルドし、どちらの実装も確かめる
+/// </summary>
+int main() {
+	std::printf("ENGINE_USE_SSE=%d\n", ENGINE_USE_SSE);
+	TestFramework::Run("batch culling matches IsVisible (perspective)", [] { TestBatchMatchesScalar(MakePerspective()); });
+	TestFramework::Run("batch culling matches IsVisible (orthographic)", [] { TestBatchMatchesScalar(MakeOrthographic()); });
+	TestFramework::Run("IsVisible matches the clip-space test (perspective)", [] { TestMatchesClipSpace(MakePerspective()); });
+	TestFramework::Run("IsVisible matches the clip-space test (orthographic)", [] { TestMatchesClipSpace(MakeOrthographic()); });
+	return TestFramework::Finish();
+}
@@ -0,0 +1,217 @@
+#include "Engine/Base/HeapAllocator.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+
+namespace {
+
+const uint64_t kPlacementAlignment = 64 * 1024;
+
+// 範囲が重ならず、位置の順に並んでいるか(allocationsは位置の順)
+bool IsSortedWithoutOverlap(const std::vector<TlsfAllocation>& allocations) {
+	for (size_t i = 1; i < allocations.size(); i++) {
+		if (allocations[i - 1].offset + allocations[i - 1].size > allocations[i].offset) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// 大きさと揃える単位をばらばらにして確保と解放を繰り返し、範囲が重ならず、全て解放すると全体が1つの空きに戻るか
+/// </summary>
+void TestTlsfRandom() {
+	std::mt19937_64 random(42);
+	int errorCount = 0;
+	for (int round = 0; round < 16; round++) {
+		const uint64_t capacity = uint64_t(1) << (20 + round % 8);
+		TlsfAllocator allocator(capacity);
+		std::vector<TlsfAllocation> live;
+		std::vector<TlsfAllocation> allocations;
+		for (int step = 0; step < 20000; step++) {
+			if (live.empty() || random() % 100 < 55) {
+				const uint64_t size = 1 + random() % (random() % 4 == 0 ? capacity / 16 : 4096);
+				const uint64_t alignment = uint64_t(1) << (random() % 17);
+				TlsfAllocation allocation{};
+				if (allocator.Allocate(size, alignment, allocation)) {
+					errorCount += (allocation.offset % alignment != 0 || allocation.offset + allocation.size > capacity || allocation.size != size) ? 1 : 0;
+					live.push_back(allocation);
+				}
+			} else {
+				const size_t i = random() % live.size();
+				allocator.Free(live[i]);
+				live[i] = live.back();
+				live.pop_back();
+			}
+			if (step % 997 == 0) {
+				// GetAllocationsは確保中の範囲をちょうど位置の順に返し、使用量はその合計
+				allocator.GetAllocations(allocations);
+				std::vector<TlsfAllocation> sorted = live;
+				std::sort(sorted.begin(), sorted.end(), [](const TlsfAllocation& a, const TlsfAllocation& b) { return a.offset < b.offset; });
+				uint64_t usedSize = 0;
+				for (size_t i = 0; i < allocations.size() && i < sorted.size(); i++) {
+					errorCount += (allocations[i].offset != sorted[i].offset || allocations[i].block != sorted[i].block) ? 1 : 0;
+					usedSize += allocations[i].size;
+				}
+				errorCount += (allocations.size() != live.size() || !IsSortedWithoutOverlap(allocations) || usedSize != allocator.GetUsedSize()) ? 1 : 0;
+			}
+		}
+		for (const TlsfAllocation& allocation : live) {
+			allocator.Free(allocation);
+		}
+		CHECK(allocator.IsEmpty() && allocator.GetUsedSize() == 0 && allocator.GetLargestFreeSize() == capacity);
+		TlsfAllocation whole{};
+		CHECK(allocator.Allocate(capacity, 1, whole) && whole.offset == 0);
+	}
+	CHECK(errorCount == 0);
+}
+
+/// <summary>
+/// HeapAllocatorの確保を、番号からたどれるように持つ(PlacedResourceAllocatorのリソースの代わり)
+/// </summary>
+class HeapAllocatorModel {
+public:
+	HeapAllocatorModel()
+	    : allocator(
+	          kHeapSize,
+	          [this](uint32_t heapIndex, uint64_t) {
+		          errorCount += createdHeaps.insert(heapIndex).second ? 0 : 1;
+		          return true;
+	          },
+	          [this](uint32_t heapIndex) {
+		          errorCount += createdHeaps.erase(heapIndex) == 1 ? 0 : 1;
+		          releasedHeapCount++;
+	          }) {}
+
+	static const uint64_t kHeapSize = 16 * 1024 * 1024;
+
+	void Allocate(uint64_t requestedSize) {
+		const uint64_t size = (requestedSize + kPlacementAlignment - 1) / kPlacementAlignment * kPlacementAlignment;
+		HeapAllocation allocation{};
+		if (!CHECK(allocator.Allocate(size, kPlacementAlignment, allocation, requestedSize))) {
+			return;
+		}
+		errorCount += (allocation.offset % kPlacementAlignment != 0 || createdHeaps.count(allocation.heapIndex) == 0 || allocation.requestedSize != requestedSize) ? 1 : 0;
+		live.push_back(allocation);
+		locations[{allocation.heapIndex, allocation.offset}] = live.size() - 1;
+	}
+
+	void Free(size_t i) {
+		allocator.Free(live[i]);
+		locations.erase({live[i].heapIndex, live[i].offset});
+		if (i != live.size() - 1) {
+			live[i] = live.back();
+			locations[{live[i].heapIndex, live[i].offset}] = i;
+		}
+		live.pop_back();
+	}
+
+	/// <summary>
+	/// デフラグする。移動先はGPUのコピーが終わるまで中身がないので、同じ呼び出しで移動先になった範囲が移動元になればエラー
+	/// </summary>
+	uint32_t Defragment(uint32_t maxMoves) {
+		std::set<std::pair<uint32_t, uint64_t>> destinations;
+		return allocator.Defragment(maxMoves, kPlacementAlignment, [&](const HeapAllocation& source, const HeapAllocation& destination) {
+			errorCount += destinations.count({source.heapIndex, source.offset});
+			destinations.insert({destination.heapIndex, destination.offset});
+			auto found = locations.find({source.heapIndex, source.offset});
+			if (found == locations.end()) {
+				errorCount++;
+				return;
+			}
+			const size_t i = found->second;
+			errorCount += (live[i].size != source.size || live[i].requestedSize != source.requestedSize || destination.size != source.size || destination.offset % kPlacementAlignment != 0 ||
+			               destination.heapIndex == source.heapIndex || createdHeaps.count(destination.heapIndex) == 0)
+			                  ? 1
+			                  : 0;
+			locations.erase(found);
+			live[i] = destination;
+			locations[{destination.heapIndex, destination.offset}] = i;
+		});
+	}
+
+	// 同じヒープの中で範囲が重ならないか
+	bool HasOverlap() const {
+		uint32_t heapIndex = UINT32_MAX;
+		uint64_t end = 0;
+		for (const auto& [location, i] : locations) {
+			if (location.first == heapIndex && location.second < end) {
+				return true;
+			}
+			heapIndex = location.first;
+			end = location.second + live[i].size;
+		}
+		return false;
+	}
+
+	HeapAllocator allocator;
+	std::vector<HeapAllocation> live;
+	std::map<std::pair<uint32_t, uint64_t>, size_t> locations; // (ヒープ, 位置)からliveの番号
+	std::set<uint32_t> createdHeaps;
+	int errorCount = 0;
+	int releasedHeapCount = 0;
+};
+
+/// <summary>
+/// ヒープより大きいものを混ぜて確保と解放を繰り返し、一部だけを残してからデフラグで寄せる
+/// 動かしたものは移動先を引けるように持ち直すので、同じ範囲を2度動かしたり、移動先を移動元にしたりすればエラーになる
+/// </summary>
+void TestHeapAllocatorRandom(uint64_t seed, uint32_t keepPercent, uint32_t maxMoves) {
+	std::mt19937_64 random(seed);
+	HeapAllocatorModel model;
+	for (int step = 0; step < 100000; step++) {
+		if (model.live.empty() || random() % 100 < 52) {
+			model.Allocate(1 + random() % (random() % 50 == 0 ? 40 * 1024 * 1024 : 2 * 1024 * 1024));
+		} else {
+			model.Free(random() % model.live.size());
+		}
+	}
+	CHECK(!model.HasOverlap());
+
+	std::shuffle(model.live.begin(), model.live.end(), random);
+	model.locations.clear();
+	for (size_t i = 0; i < model.live.size(); i++) {
+		model.locations[{model.live[i].heapIndex, model.live[i].offset}] = i;
+	}
+	const size_t keepCount = model.live.size() * keepPercent / 100;
+	while (model.live.size() > keepCount) {
+		model.Free(model.live.size() - 1);
+	}
+	model.allocator.ReleaseEmptyHeaps(0);
+
+	const HeapStatistics before = model.allocator.GetStatistics();
+	uint32_t totalMoveCount = 0;
+	for (uint32_t moveCount = 0; (moveCount = model.Defragment(maxMoves)) > 0;) {
+		totalMoveCount += moveCount;
+		// コピーが終わってから空いたヒープを消す
+		model.allocator.ReleaseEmptyHeaps(0);
+		CHECK(!model.HasOverlap());
+	}
+	const HeapStatistics after = model.allocator.GetStatistics();
+	std::printf("  defragment: %u moves, heaps %u -> %u, fragmentation %.1f%% -> %.1f%%\n", totalMoveCount, before.heapCount, after.heapCount, before.fragmentation, after.fragmentation);
+	CHECK(totalMoveCount > 0);
+	CHECK(after.heapCount < before.heapCount);
+	CHECK(after.usedSize == before.usedSize && after.wastedSize == before.wastedSize && after.allocationCount == before.allocationCount);
+
+	while (!model.live.empty()) {
+		model.Free(model.live.size() - 1);
+	}
+	model.allocator.ReleaseEmptyHeaps(0);
+	CHECK(model.allocator.GetStatistics().heapCount == 0 && model.createdHeaps.empty());
+	CHECK(model.errorCount == 0);
+}
+
+} // namespace
+
+int main() {
+	TestFramework::Run("TlsfAllocator random allocate and free", TestTlsfRandom);
+	TestFramework::Run("HeapAllocator random allocate, free and defragment", [] {
+		TestHeapAllocatorRandom(7, 20, 64);
+		TestHeapAllocatorRandom(8, 50, 1000);
+		TestHeapAllocatorRandom(9, 5, 1);
+		TestHeapAllocatorRandom(10, 35, 16);
+	});
+	return TestFramework::Finish();
+}
@@ -0,0 +1,55 @@
+#include "Engine/Scene/InstanceBatcher.h"
+#include "TestFramework.h"
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 1つのメッシュを描くのに要るDrawIndexedInstancedの数(テクスチャごとに分けたサブメッシュ)
+const size_t kDrawsPerMesh = 3;
+
+/// <summary>
+/// objectCount個の物体をpairCount通りのメッシュとマテリアルの組でまとめ、描画の数とClear→Add→Build→PackInstancesの時間を測る
+/// </summary>
+void BenchmarkBatching(uint32_t objectCount, uint32_t pairCount, uint32_t frameCount) {
+	std::mt19937 random(5);
+	std::vector<std::pair<uint32_t, uint32_t>> pairs(objectCount);
+	for (auto& pair : pairs) {
+		const uint32_t index = random() % pairCount;
+		pair = {index / 4, index % 4};
+	}
+	std::vector<TransformationMatrix> source(objectCount);
+	std::vector<TransformationMatrix> destination(objectCount);
+	InstanceBatcher batcher;
+	const double time = TestFramework::MeasureMilliseconds([&] {
+		for (uint32_t frame = 0; frame < frameCount; frame++) {
+			batcher.Clear();
+			for (uint32_t i = 0; i < objectCount; i++) {
+				batcher.Add(pairs[i].first, pairs[i].second, i);
+			}
+			batcher.Build();
+			batcher.PackInstances(source.data(), sizeof(TransformationMatrix), destination.data());
+		}
+	}) / double(frameCount);
+	CHECK(batcher.GetInstanceCount() == objectCount);
+	std::printf("%7u objects, %3u mesh/material pairs: %7zu -> %4zu draws, batch+pack %.3f ms\n", objectCount, pairCount, objectCount * kDrawsPerMesh, batcher.GetBatches().size() * kDrawsPerMesh,
+	            time);
+}
+
+} // namespace
+
+/// <summary>
+/// 物体ごとに描く場合とInstanceBatcherでまとめた場合の描画の数と、まとめる時間を測る
+/// 使い方: InstanceBatcherBenchmark [フレーム数(既定20)]
+/// </summary>
+int main(int argc, char** argv) {
+	const uint32_t frameCount = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 20;
+	std::printf("%u frames, %zu draws per mesh\n", frameCount, kDrawsPerMesh);
+	for (uint32_t objectCount : {1000u, 10000u, 100000u}) {
+		for (uint32_t pairCount : {1u, 16u, 256u}) {
+			BenchmarkBatching(objectCount, pairCount, frameCount);
+		}
+	}
+	return TestFramework::Finish();
+}
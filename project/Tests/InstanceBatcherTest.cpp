@@ -0,0 +1,165 @@
+#include "Engine/Scene/InstanceBatcher.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// <summary>
+/// まとまりがメッシュ, マテリアルの順に並び、数と開始位置が合っている
+/// </summary>
+void TestBatchOrder() {
+	InstanceBatcher batcher;
+	batcher.Clear();
+	// (メッシュ, マテリアル, 変換行列の番号)
+	const uint32_t requests[][3] = {{2, 1, 0}, {0, 3, 1}, {2, 0, 2}, {0, 3, 3}, {1, 1, 4}, {2, 1, 5}, {0, 0, 6}, {2, 1, 7}};
+	for (const auto& request : requests) {
+		batcher.Add(request[0], request[1], request[2]);
+	}
+	batcher.Build();
+
+	const InstanceBatch expected[] = {{0, 0, 0, 1}, {0, 3, 1, 2}, {1, 1, 3, 1}, {2, 0, 4, 1}, {2, 1, 5, 3}};
+	const std::vector<InstanceBatch>& batches = batcher.GetBatches();
+	CHECK(batches.size() == std::size(expected));
+	for (size_t i = 0; i < (std::min)(batches.size(), std::size(expected)); i++) {
+		CHECK(batches[i].meshId == expected[i].meshId && batches[i].materialId == expected[i].materialId);
+		CHECK(batches[i].firstInstance == expected[i].firstInstance && batches[i].instanceCount == expected[i].instanceCount);
+	}
+	// 同じ組の中では追加した順
+	const std::vector<uint32_t> expectedIndices = {6, 1, 3, 4, 2, 0, 5, 7};
+	CHECK(batcher.GetInstanceCount() == expectedIndices.size());
+	CHECK(batcher.GetInstanceTransformIndices() == expectedIndices);
+}
+
+/// <summary>
+/// ランダムな描画要求を、組ごとに追加した順で並べたstd::mapと比べる
+/// </summary>
+void TestRandomRequests(uint32_t seed) {
+	std::mt19937 random(seed);
+	InstanceBatcher batcher;
+	for (int trial = 0; trial < 50; trial++) {
+		const size_t count = random() % 5000;
+		const uint32_t meshCount = 1 + random() % 8;
+		const uint32_t materialCount = 1 + random() % 4;
+		std::vector<uint32_t> transformIndices(count);
+		for (size_t i = 0; i < count; i++) {
+			transformIndices[i] = uint32_t(i);
+		}
+		std::shuffle(transformIndices.begin(), transformIndices.end(), random);
+
+		std::map<std::pair<uint32_t, uint32_t>, std::vector<uint32_t>> expected;
+		batcher.Clear();
+		for (uint32_t transformIndex : transformIndices) {
+			const uint32_t meshId = random() % meshCount;
+			const uint32_t materialId = random() % materialCount;
+			batcher.Add(meshId, materialId, transformIndex);
+			expected[{meshId, materialId}].push_back(transformIndex);
+		}
+		batcher.Build();
+
+		const std::vector<InstanceBatch>& batches = batcher.GetBatches();
+		CHECK(batches.size() == expected.size());
+		CHECK(batcher.GetInstanceCount() == count);
+		size_t batchIndex = 0;
+		uint32_t firstInstance = 0;
+		for (const auto& [key, indices] : expected) {
+			if (batchIndex >= batches.size()) {
+				break;
+			}
+			const InstanceBatch& batch = batches[batchIndex++];
+			CHECK(batch.meshId == key.first && batch.materialId == key.second);
+			CHECK(batch.firstInstance == firstInstance && batch.instanceCount == indices.size());
+			CHECK(std::equal(indices.begin(), indices.end(), batcher.GetInstanceTransformIndices().begin() + batch.firstInstance));
+			firstInstance += uint32_t(indices.size());
+		}
+	}
+}
+
+/// <summary>
+/// 定数バッファの配置(256バイト間隔)の変換行列から、インスタンスの順にそのままのバイトを詰める
+/// </summary>
+void TestStridedPack() {
+	const size_t kStride = 256;
+	const uint32_t kCount = 10;
+	// 行列の間の詰め物も埋めておき、詰めた結果に混ざらないことを確かめる
+	std::vector<unsigned char> source(kStride * kCount, 0xcd);
+	for (uint32_t i = 0; i < kCount; i++) {
+		TransformationMatrix transform;
+		for (int row = 0; row < 4; row++) {
+			for (int column = 0; column < 4; column++) {
+				transform.WVP.m[row][column] = float(i * 100 + row * 4 + column);
+				transform.world.m[row][column] = -float(i * 100 + row * 4 + column);
+			}
+		}
+		std::memcpy(source.data() + kStride * i, &transform, sizeof(transform));
+	}
+
+	InstanceBatcher batcher;
+	batcher.Clear();
+	for (uint32_t i = 0; i < kCount; i++) {
+		// 奇数は別のマテリアルにして、順番を入れ替える
+		batcher.Add(0, i % 2, kCount - 1 - i);
+	}
+	batcher.Build();
+	std::vector<TransformationMatrix> destination(batcher.GetInstanceCount());
+	batcher.PackInstances(source.data(), kStride, destination.data());
+	const std::vector<uint32_t>& transformIndices = batcher.GetInstanceTransformIndices();
+	CHECK(destination.size() == kCount);
+	for (size_t i = 0; i < destination.size(); i++) {
+		CHECK(std::memcmp(&destination[i], source.data() + kStride * transformIndices[i], sizeof(TransformationMatrix)) == 0);
+	}
+	CHECK(transformIndices.front() == 9 && transformIndices.back() == 0);
+}
+
+/// <summary>
+/// Clearの後のBuildに、前のフレームの組が残らない(batchLookupを作り直す)
+/// </summary>
+void TestClearAndRebuild() {
+	InstanceBatcher batcher;
+	batcher.Clear();
+	batcher.Add(5, 0, 0);
+	batcher.Add(1, 2, 1);
+	batcher.Add(3, 3, 2);
+	batcher.Build();
+	CHECK(batcher.GetBatches().size() == 3);
+
+	// 前のフレームにあった組(1, 2)と、なかった組(0, 0)
+	batcher.Clear();
+	CHECK(batcher.GetBatches().empty() && batcher.GetInstanceCount() == 0);
+	batcher.Add(1, 2, 7);
+	batcher.Add(0, 0, 8);
+	batcher.Add(1, 2, 9);
+	batcher.Build();
+	const std::vector<InstanceBatch>& batches = batcher.GetBatches();
+	CHECK(batches.size() == 2);
+	if (batches.size() == 2) {
+		CHECK(batches[0].meshId == 0 && batches[0].materialId == 0 && batches[0].firstInstance == 0 && batches[0].instanceCount == 1);
+		CHECK(batches[1].meshId == 1 && batches[1].materialId == 2 && batches[1].firstInstance == 1 && batches[1].instanceCount == 2);
+	}
+	CHECK(batcher.GetInstanceTransformIndices() == std::vector<uint32_t>({8, 7, 9}));
+
+	// Clearせずに組み直しても同じ結果になる
+	batcher.Build();
+	CHECK(batcher.GetBatches().size() == 2);
+	CHECK(batcher.GetInstanceTransformIndices() == std::vector<uint32_t>({8, 7, 9}));
+
+	// 描画要求がなければ何も作らない
+	batcher.Clear();
+	batcher.Build();
+	CHECK(batcher.GetBatches().empty() && batcher.GetInstanceCount() == 0);
+}
+
+} // namespace
+
+int main() {
+	TestFramework::Run("batches are sorted by mesh and material", TestBatchOrder);
+	TestFramework::Run("random requests match a std::map reference (seed 1)", [] { TestRandomRequests(1); });
+	TestFramework::Run("random requests match a std::map reference (seed 2)", [] { TestRandomRequests(2); });
+	TestFramework::Run("packing from a 256-byte stride", TestStridedPack);
+	TestFramework::Run("Clear and Build reuse the lookup table", TestClearAndRebuild);
+	return TestFramework::Finish();
+}
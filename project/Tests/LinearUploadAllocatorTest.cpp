@@ -0,0 +1,196 @@
+#include "Engine/Base/LinearUploadAllocator.h"
+#include "TestFramework.h"
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+/// <summary>
+/// std::mallocでページを確保する偽のアップロードヒープ
+/// GPUアドレスは、わざと256の倍数からkBaseOffsetだけずらした位置から振る
+/// </summary>
+class FakePageBackend {
+public:
+	static const uint64_t kBaseOffset = 0x30;
+
+	FakePageBackend() = default;
+	FakePageBackend(const FakePageBackend&) = delete;
+	FakePageBackend& operator=(const FakePageBackend&) = delete;
+	~FakePageBackend() {
+		for (const UploadPage& page : pages) {
+			std::free(page.cpuAddress);
+		}
+	}
+
+	UploadPage Allocate(size_t size) {
+		UploadPage page = {std::malloc(size), nextGpuAddress + kBaseOffset, size};
+		pages.push_back(page);
+		// ページの間を空けて、ページをまたぐ切り出しを見つけやすくする
+		nextGpuAddress += (size + kBaseOffset + 0xffff) / 0x10000 * 0x10000 + 0x10000;
+		return page;
+	}
+
+	LinearUploadAllocator::PageAllocator GetPageAllocator() {
+		return [this](size_t size) { return Allocate(size); };
+	}
+
+	/// <summary>
+	/// 切り出したsizeバイトが1つのページに収まり、CPUとGPUのアドレスがページの先頭から同じだけ離れているか
+	/// </summary>
+	bool IsInsidePage(const UploadAllocation& allocation, size_t size) const {
+		for (const UploadPage& page : pages) {
+			if (allocation.gpuAddress >= page.gpuAddress && allocation.gpuAddress + size <= page.gpuAddress + page.size) {
+				const uint64_t offset = allocation.gpuAddress - page.gpuAddress;
+				return static_cast<char*>(allocation.cpuAddress) == static_cast<char*>(page.cpuAddress) + offset;
+			}
+		}
+		return false;
+	}
+
+	size_t GetCallCount() const { return pages.size(); }
+
+private:
+	std::vector<UploadPage> pages;
+	uint64_t nextGpuAddress = 0x10000000;
+};
+
+/// <summary>
+/// ページの先頭が256の倍数でなくても、GPUアドレスを指定した単位に揃える
+/// </summary>
+void TestUnalignedPageBase() {
+	FakePageBackend backend;
+	LinearUploadAllocator allocator(1, 4096, backend.GetPageAllocator());
+	allocator.BeginFrame(0);
+	uint64_t previousEnd = 0;
+	for (size_t size : {16, 1, 255, 256, 257, 100}) {
+		const UploadAllocation allocation = allocator.Allocate(size);
+		CHECK(allocation.gpuAddress % kConstantBufferAlignment == 0);
+		CHECK(allocation.gpuAddress >= previousEnd);
+		CHECK(backend.IsInsidePage(allocation, size));
+		previousEnd = allocation.gpuAddress + size;
+	}
+	// 小さい単位は前の確保のすぐ後ろに詰める
+	const UploadAllocation a = allocator.Allocate(3, 4);
+	const UploadAllocation b = allocator.Allocate(8, 16);
+	CHECK(a.gpuAddress % 4 == 0 && a.gpuAddress >= previousEnd && a.gpuAddress < previousEnd + 4);
+	CHECK(b.gpuAddress % 16 == 0 && b.gpuAddress >= a.gpuAddress + 3 && b.gpuAddress < a.gpuAddress + 3 + 16);
+	CHECK(backend.GetCallCount() == 1);
+
+	// 書き込んだ値がそのまま残る
+	const UploadAllocation constant = allocator.AllocateConstant(1.5f);
+	CHECK(constant.gpuAddress % kConstantBufferAlignment == 0);
+	CHECK(*static_cast<const float*>(constant.cpuAddress) == 1.5f);
+}
+
+/// <summary>
+/// ページより大きい確保は、揃える分を足した大きさの専用のページにする
+/// </summary>
+void TestOversizeAllocation() {
+	const size_t kPageSize = 4096;
+	FakePageBackend backend;
+	LinearUploadAllocator allocator(1, kPageSize, backend.GetPageAllocator());
+	allocator.BeginFrame(0);
+	allocator.Allocate(64);
+	CHECK(backend.GetCallCount() == 1);
+
+	const size_t kLargeSize = 10000;
+	const UploadAllocation large = allocator.Allocate(kLargeSize);
+	CHECK(backend.GetCallCount() == 2);
+	CHECK(large.gpuAddress % kConstantBufferAlignment == 0);
+	CHECK(backend.IsInsidePage(large, kLargeSize));
+	CHECK(allocator.GetPageCount() == 2);
+	// 使ったバイト数は、最初のページ全体と専用のページの使った分
+	CHECK(allocator.GetUsedSize() >= kPageSize + kLargeSize);
+
+	// ちょうどページの大きさの確保も入る
+	const UploadAllocation exact = allocator.Allocate(kPageSize);
+	CHECK(exact.gpuAddress % kConstantBufferAlignment == 0);
+	CHECK(backend.IsInsidePage(exact, kPageSize));
+	CHECK(backend.GetCallCount() == 3);
+}
+
+/// <summary>
+/// 今のページに入らなければ次のページへ進み、BeginFrameの後は同じページを先頭から使い直す
+/// </summary>
+void TestSkipToNextPage() {
+	const size_t kPageSize = 1024;
+	FakePageBackend backend;
+	LinearUploadAllocator allocator(1, kPageSize, backend.GetPageAllocator());
+	allocator.BeginFrame(0);
+	const UploadAllocation first = allocator.Allocate(600);
+	const UploadAllocation second = allocator.Allocate(600);
+	CHECK(backend.GetCallCount() == 2);
+	CHECK(backend.IsInsidePage(first, 600) && backend.IsInsidePage(second, 600));
+	// 2つ目のページへ進み、最初のページの残りは使ったものとして数える
+	CHECK(allocator.GetUsedSize() == kPageSize + (second.gpuAddress - (second.gpuAddress & ~uint64_t(0xffff)) - FakePageBackend::kBaseOffset) + 600);
+
+	allocator.BeginFrame(0);
+	CHECK(allocator.GetUsedSize() == 0);
+	CHECK(allocator.Allocate(600).gpuAddress == first.gpuAddress);
+	CHECK(allocator.Allocate(600).gpuAddress == second.gpuAddress);
+	// 2つ目のページの残りに入る(256の単位では入らないので4の単位で切り出す)
+	const UploadAllocation small = allocator.Allocate(200, 4);
+	CHECK(backend.IsInsidePage(small, 200) && small.gpuAddress > second.gpuAddress);
+	CHECK(backend.GetCallCount() == 2);
+	// どのページにも入らなければ新しいページを足す
+	allocator.Allocate(300);
+	CHECK(backend.GetCallCount() == 3);
+}
+
+/// <summary>
+/// 2フレーム分のページを使い回し、始めの2フレームの後はページを足さない
+/// 同時に使うフレームの切り出しは重ならない
+/// </summary>
+void TestSteadyState() {
+	FakePageBackend backend;
+	LinearUploadAllocator allocator(2, 65536, backend.GetPageAllocator());
+	struct Range {
+		uint64_t begin;
+		uint64_t end;
+	};
+	std::vector<Range> previousRanges;
+	size_t callCount = 0;
+	int overlapCount = 0;
+	int outsideCount = 0;
+	for (uint32_t frame = 0; frame < 12; frame++) {
+		allocator.BeginFrame(frame % 2);
+		std::vector<Range> ranges;
+		for (size_t i = 0; i < 600; i++) {
+			const size_t size = (i % 7) * 40 + 16;
+			const UploadAllocation allocation = allocator.Allocate(size);
+			outsideCount += backend.IsInsidePage(allocation, size) && allocation.gpuAddress % kConstantBufferAlignment == 0 ? 0 : 1;
+			ranges.push_back({allocation.gpuAddress, allocation.gpuAddress + size});
+		}
+		const UploadAllocation large = allocator.Allocate(200000);
+		outsideCount += backend.IsInsidePage(large, 200000) ? 0 : 1;
+		ranges.push_back({large.gpuAddress, large.gpuAddress + 200000});
+
+		// 同じフレームの中と、GPUがまだ読んでいるかもしれない1つ前のフレームとの重なり
+		std::vector<Range> liveRanges = ranges;
+		liveRanges.insert(liveRanges.end(), previousRanges.begin(), previousRanges.end());
+		for (size_t i = 0; i < liveRanges.size(); i++) {
+			for (size_t j = i + 1; j < liveRanges.size(); j++) {
+				overlapCount += liveRanges[i].end <= liveRanges[j].begin || liveRanges[j].end <= liveRanges[i].begin ? 0 : 1;
+			}
+		}
+		previousRanges = ranges;
+		if (frame == 1) {
+			callCount = backend.GetCallCount();
+		}
+	}
+	CHECK(overlapCount == 0);
+	CHECK(outsideCount == 0);
+	CHECK(backend.GetCallCount() == callCount);
+	CHECK(allocator.GetPageCount() == callCount);
+	std::printf("  %zu pages for 2 frames\n", callCount);
+}
+
+} // namespace
+
+int main() {
+	TestFramework::Run("GPU addresses are aligned even when the page base is not", TestUnalignedPageBase);
+	TestFramework::Run("an oversize request gets a dedicated page", TestOversizeAllocation);
+	TestFramework::Run("a full page skips to the next one", TestSkipToNextPage);
+	TestFramework::Run("pages are reused after BeginFrame", TestSteadyState);
+	return TestFramework::Finish();
+}
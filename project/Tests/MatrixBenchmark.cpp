@@ -0,0 +1,143 @@
+#include "Engine/3d/Matrix.h"
+#include "TestFramework.h"
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 結果を捨てられないように書き込む先
+volatile float sink;
+
+/// <summary>
+/// 1回あたりの時間(ナノ秒)を測る
+/// </summary>
+template<class Function> double MeasureNanoseconds(uint32_t count, Function function) {
+	return TestFramework::MeasureMilliseconds([&] { function(count); }) * 1000000.0 / double(count);
+}
+
+} // namespace
+
+/// <summary>
+/// 行列の積、逆行列、座標変換と、物体ごとのワールド行列とWVPの1回あたりの時間を測る
+/// EngineにリンクしたMatrixBenchmark(SSE)とEngineScalarにリンクしたMatrixBenchmarkScalarを比べる
+/// 使い方: MatrixBenchmark [回数(既定10000000)]
+/// </summary>
+int main(int argc, char** argv) {
+	const uint32_t count = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 10000000;
+	const uint32_t kMask = 1023;
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+	std::vector<Matrix4x4> matrices(kMask + 1);
+	std::vector<Matrix4x4> affines(kMask + 1);
+	for (uint32_t k = 0; k <= kMask; k++) {
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrices[k].m[i][j] = distribution(random) + (i == j ? 6.0f : 0.0f);
+			}
+		}
+		affines[k] = MakeAffineMatrix({distribution(random) + 3.0f, distribution(random) + 3.0f, distribution(random) + 3.0f}, {distribution(random), distribution(random), distribution(random)},
+		                              {distribution(random) * 10.0f, distribution(random), distribution(random)});
+	}
+
+	std::printf("ENGINE_USE_SSE=%d, %u iterations\n", ENGINE_USE_SSE, count);
+	std::printf("Multiply       %6.2f ns\n", MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			sink = Multiply(matrices[i & kMask], matrices[(i + 7) & kMask]).m[1][2];
+		}
+	}));
+	std::printf("Inverse        %6.2f ns\n", MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			sink = Inverse(matrices[i & kMask]).m[1][2];
+		}
+	}));
+	std::printf("Inverse affine %6.2f ns (Inverse of an affine matrix)\n", MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			sink = Inverse(affines[i & kMask]).m[3][2];
+		}
+	}));
+	std::printf("InverseAffine  %6.2f ns\n", MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			sink = InverseAffine(affines[i & kMask]).m[3][2];
+		}
+	}));
+	// 前の結果を次の入力にして、呼び出しどうしを重ねずに測る
+	std::printf("Transform      %6.2f ns\n", MeasureNanoseconds(count, [&](uint32_t n) {
+		Vector3 vector = {1.0f, 2.0f, 3.0f};
+		for (uint32_t i = 0; i < n; i++) {
+			vector = Transform(vector, affines[i & kMask]);
+			vector = {vector.x * 0.01f, vector.y * 0.01f, vector.z * 0.01f};
+		}
+		sink = vector.x;
+	}));
+
+	// 物体ごとのワールド行列とWVP(以前は物体ごとに3つの行列を掛け、カメラの逆行列も求め直していた)
+	std::vector<Vector3> scales(kMask + 1);
+	std::vector<Vector3> rotates(kMask + 1);
+	std::vector<Vector3> translates(kMask + 1);
+	for (uint32_t k = 0; k <= kMask; k++) {
+		scales[k] = {distribution(random) + 3.0f, distribution(random) + 3.0f, distribution(random) + 3.0f};
+		rotates[k] = {distribution(random), distribution(random), distribution(random)};
+		translates[k] = {distribution(random) * 10.0f, distribution(random), distribution(random)};
+	}
+	auto makeOldAffineMatrix = [](const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
+		Matrix4x4 rotateXYZ = Multiply(Multiply(MakeRotateXMatrix(rotate.x), MakeRotateYMatrix(rotate.y)), MakeRotateZMatrix(rotate.z));
+		return Multiply(Multiply(MakeScaleMatrix(scale), rotateXYZ), MakeTranslateMatrix(translate));
+	};
+	const Vector3 cameraRotate = {0.2f, 0.1f, 0.0f};
+	const Vector3 cameraTranslate = {0.0f, 0.0f, -10.0f};
+	std::printf("S*R*T matrices       %6.2f ns (MakeScaleMatrix, MakeRotateX/Y/ZMatrix, MakeTranslateMatrix)\n", MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			sink = makeOldAffineMatrix(scales[i & kMask], rotates[i & kMask], translates[i & kMask]).m[3][0];
+		}
+	}));
+	std::printf("MakeAffineTransform  %6.2f ns\n", MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			sink = MakeAffineTransform(scales[i & kMask], rotates[i & kMask], translates[i & kMask]).axisY.z;
+		}
+	}));
+	std::vector<AffineTransform> rigids(kMask + 1);
+	std::vector<Matrix4x4> rigidMatrices(kMask + 1);
+	for (uint32_t k = 0; k <= kMask; k++) {
+		rigids[k] = MakeAffineTransform({1.0f, 1.0f, 1.0f}, rotates[k], translates[k]);
+		rigidMatrices[k] = ToMatrix4x4(rigids[k]);
+	}
+	const double rigidTime = MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			sink = InverseRigid(rigids[i & kMask]).translate.x;
+		}
+	});
+	std::printf("InverseRigid         %6.2f ns (Inverse of the same matrix %.2f ns)\n", rigidTime, MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			sink = Inverse(rigidMatrices[i & kMask]).m[3][0];
+		}
+	}));
+	const Matrix4x4 projection = MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f);
+	const Matrix4x4 viewProjection = Multiply(ToMatrix4x4(InverseRigid(MakeAffineTransform({1.0f, 1.0f, 1.0f}, cameraRotate, cameraTranslate))), projection);
+	std::vector<AffineTransform> transforms(kMask + 1);
+	for (uint32_t k = 0; k <= kMask; k++) {
+		transforms[k] = MakeAffineTransform(scales[k], rotates[k], translates[k]);
+	}
+	std::printf("Multiply(Affine, M)  %6.2f ns\n", MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			sink = Multiply(transforms[i & kMask], viewProjection).m[1][2];
+		}
+	}));
+	const double oldTime = MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			const Matrix4x4 world = makeOldAffineMatrix(scales[i & kMask], rotates[i & kMask], translates[i & kMask]);
+			const Matrix4x4 view = Inverse(makeOldAffineMatrix({1.0f, 1.0f, 1.0f}, cameraRotate, cameraTranslate));
+			const Matrix4x4 wvp = Multiply(world, Multiply(view, MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f)));
+			sink = wvp.m[0][0] + world.m[1][1];
+		}
+	});
+	const double newTime = MeasureNanoseconds(count, [&](uint32_t n) {
+		for (uint32_t i = 0; i < n; i++) {
+			const AffineTransform world = MakeAffineTransform(scales[i & kMask], rotates[i & kMask], translates[i & kMask]);
+			const Matrix4x4 wvp = Multiply(world, viewProjection);
+			sink = wvp.m[0][0] + ToMatrix4x4(world).m[1][1];
+		}
+	});
+	std::printf("World + WVP          %6.2f ns -> %6.2f ns (per object: old path with the camera rebuilt, MakeAffineTransform with the camera shared)\n", oldTime, newTime);
+	return TestFramework::Finish();
+}
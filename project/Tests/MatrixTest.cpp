@@ -0,0 +1,399 @@
+#include "Engine/3d/Matrix.h"
+#include "Engine/3d/TransformBatch.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// <summary>
+/// 比較用の倍精度の4x4行列
+/// </summary>
+struct ReferenceMatrix {
+	double m[4][4];
+};
+
+ReferenceMatrix ToReference(const Matrix4x4& matrix) {
+	ReferenceMatrix reference;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			reference.m[i][j] = matrix.m[i][j];
+		}
+	}
+	return reference;
+}
+
+ReferenceMatrix ReferenceMultiply(const ReferenceMatrix& m1, const ReferenceMatrix& m2) {
+	ReferenceMatrix multiply{};
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			for (int k = 0; k < 4; k++) {
+				multiply.m[i][j] += m1.m[i][k] * m2.m[k][j];
+			}
+		}
+	}
+	return multiply;
+}
+
+// 部分ピボット選択付きのガウス・ジョルダン法で求めた逆行列
+ReferenceMatrix ReferenceInverse(const ReferenceMatrix& matrix) {
+	ReferenceMatrix m = matrix;
+	ReferenceMatrix inverse{};
+	for (int i = 0; i < 4; i++) {
+		inverse.m[i][i] = 1.0;
+	}
+	for (int column = 0; column < 4; column++) {
+		int pivot = column;
+		for (int row = column + 1; row < 4; row++) {
+			pivot = std::fabs(m.m[row][column]) > std::fabs(m.m[pivot][column]) ? row : pivot;
+		}
+		std::swap(m.m[column], m.m[pivot]);
+		std::swap(inverse.m[column], inverse.m[pivot]);
+		const double scale = 1.0 / m.m[column][column];
+		for (int j = 0; j < 4; j++) {
+			m.m[column][j] *= scale;
+			inverse.m[column][j] *= scale;
+		}
+		for (int row = 0; row < 4; row++) {
+			if (row == column) {
+				continue;
+			}
+			const double factor = m.m[row][column];
+			for (int j = 0; j < 4; j++) {
+				m.m[row][j] -= factor * m.m[column][j];
+				inverse.m[row][j] -= factor * inverse.m[column][j];
+			}
+		}
+	}
+	return inverse;
+}
+
+// 最大の成分に対する誤差の比
+double RelativeError(const Matrix4x4& actual, const ReferenceMatrix& expected) {
+	double error = 0.0;
+	double norm = 0.0;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			error = (std::max)(error, std::fabs(actual.m[i][j] - expected.m[i][j]));
+			norm = (std::max)(norm, std::fabs(expected.m[i][j]));
+		}
+	}
+	return error / (std::max)(norm, 1e-30);
+}
+
+/// <summary>
+/// テストに使う行列(乱数の行列、アフィン変換、ビュープロジェクション)
+/// </summary>
+struct Matrices {
+	std::vector<Matrix4x4> general; // 対角を大きくして条件数を抑えた乱数の行列
+	std::vector<Matrix4x4> affine;  // 拡大縮小、回転、平行移動を含むアフィン変換
+	std::vector<Matrix4x4> viewProjection;
+};
+
+Matrices MakeMatrices() {
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> distribution(-2.0f, 2.0f);
+	Matrices matrices;
+	for (int k = 0; k < 1000; k++) {
+		Matrix4x4 matrix;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				matrix.m[i][j] = distribution(random) + (i == j ? 6.0f : 0.0f);
+			}
+		}
+		matrices.general.push_back(matrix);
+		Vector3 scale = {distribution(random) + 3.0f, distribution(random) + 3.0f, distribution(random) + 3.0f};
+		Vector3 rotate = {distribution(random) * 2.0f, distribution(random) * 2.0f, distribution(random) * 2.0f};
+		Vector3 translate = {distribution(random) * 50.0f, distribution(random) * 50.0f, distribution(random) * 50.0f};
+		Matrix4x4 affine = MakeAffineMatrix(scale, rotate, translate);
+		matrices.affine.push_back(affine);
+		Matrix4x4 projection = MakePerspectiveFovMatrix(0.45f + distribution(random) * 0.1f, 16.0f / 9.0f, 0.1f, 100.0f);
+		matrices.viewProjection.push_back(Multiply(InverseAffine(MakeAffineMatrix({1.0f, 1.0f, 1.0f}, rotate, translate)), projection));
+	}
+	return matrices;
+}
+
+const Matrices& GetMatrices() {
+	static const Matrices matrices = MakeMatrices();
+	return matrices;
+}
+
+void TestMultiply() {
+	const Matrices& matrices = GetMatrices();
+	double maxError = 0.0;
+	for (size_t k = 0; k < matrices.general.size(); k++) {
+		const Matrix4x4& m1 = matrices.general[k];
+		const Matrix4x4& m2 = k % 2 == 0 ? matrices.general[(k + 1) % matrices.general.size()] : matrices.affine[k];
+		maxError = (std::max)(maxError, RelativeError(Multiply(m1, m2), ReferenceMultiply(ToReference(m1), ToReference(m2))));
+		maxError = (std::max)(maxError, RelativeError(m1 * m2, ReferenceMultiply(ToReference(m1), ToReference(m2))));
+	}
+	std::printf("  max relative error %.2e\n", maxError);
+	CHECK(maxError < 1e-6);
+}
+
+/// <summary>
+/// 逆行列の誤差は条件数に比例するので、条件数(最大ノルム)で割った誤差で比べる
+/// </summary>
+void TestInverse() {
+	const Matrices& matrices = GetMatrices();
+	double maxError = 0.0;
+	for (const std::vector<Matrix4x4>* group : {&matrices.general, &matrices.affine, &matrices.viewProjection}) {
+		for (const Matrix4x4& matrix : *group) {
+			const ReferenceMatrix expected = ReferenceInverse(ToReference(matrix));
+			double norm = 0.0;
+			double inverseNorm = 0.0;
+			for (int i = 0; i < 4; i++) {
+				for (int j = 0; j < 4; j++) {
+					norm = (std::max)(norm, double(std::fabs(matrix.m[i][j])));
+					inverseNorm = (std::max)(inverseNorm, std::fabs(expected.m[i][j]));
+				}
+			}
+			maxError = (std::max)(maxError, RelativeError(Inverse(matrix), expected) / (norm * inverseNorm));
+		}
+	}
+	std::printf("  max relative error / condition number %.2e\n", maxError);
+	CHECK(maxError < 1e-6);
+	CHECK(RelativeError(Inverse(MakeIdentity4x4()), ToReference(MakeIdentity4x4())) == 0.0);
+}
+
+void TestInverseAffine() {
+	const Matrices& matrices = GetMatrices();
+	double maxError = 0.0;
+	for (const Matrix4x4& matrix : matrices.affine) {
+		Matrix4x4 inverse = InverseAffine(matrix);
+		maxError = (std::max)(maxError, RelativeError(inverse, ReferenceInverse(ToReference(matrix))));
+		// 4列目は(0, 0, 0, 1)のまま
+		CHECK(inverse.m[0][3] == 0.0f && inverse.m[1][3] == 0.0f && inverse.m[2][3] == 0.0f && inverse.m[3][3] == 1.0f);
+	}
+	std::printf("  max relative error %.2e\n", maxError);
+	CHECK(maxError < 1e-5);
+}
+
+/// <summary>
+/// Transformは同次座標を求めてwで割る(透視投影を含む)
+/// </summary>
+void TestTransform() {
+	const Matrices& matrices = GetMatrices();
+	std::mt19937 random(2);
+	std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+	double maxError = 0.0;
+	for (const std::vector<Matrix4x4>* group : {&matrices.affine, &matrices.viewProjection}) {
+		for (const Matrix4x4& matrix : *group) {
+			const Vector3 vector = {distribution(random), distribution(random), distribution(random)};
+			double expected[4] = {};
+			for (int j = 0; j < 4; j++) {
+				expected[j] = double(vector.x) * matrix.m[0][j] + double(vector.y) * matrix.m[1][j] + double(vector.z) * matrix.m[2][j] + matrix.m[3][j];
+			}
+			if (std::fabs(expected[3]) < 1e-3) {
+				continue;
+			}
+			const Vector3 actual = Transform(vector, matrix);
+			const double scale = (std::max)({std::fabs(expected[0]), std::fabs(expected[1]), std::fabs(expected[2]), std::fabs(expected[3])}) / std::fabs(expected[3]);
+			maxError = (std::max)(maxError, std::fabs(actual.x - expected[0] / expected[3]) / scale);
+			maxError = (std::max)(maxError, std::fabs(actual.y - expected[1] / expected[3]) / scale);
+			maxError = (std::max)(maxError, std::fabs(actual.z - expected[2] / expected[3]) / scale);
+		}
+	}
+	std::printf("  max relative error %.2e\n", maxError);
+	CHECK(maxError < 2e-5);
+}
+
+/// <summary>
+/// 拡大縮小、X, Y, Z軸回転、平行移動の行列を倍精度で掛けた、以前のMakeAffineMatrixと同じ計算
+/// </summary>
+ReferenceMatrix ReferenceAffine(const Vector3& scale, const Vector3& rotate, const Vector3& translate) {
+	ReferenceMatrix rotateXYZ = ReferenceMultiply(ReferenceMultiply(ToReference(MakeRotateXMatrix(rotate.x)), ToReference(MakeRotateYMatrix(rotate.y))), ToReference(MakeRotateZMatrix(rotate.z)));
+	return ReferenceMultiply(ReferenceMultiply(ToReference(MakeScaleMatrix(scale)), rotateXYZ), ToReference(MakeTranslateMatrix(translate)));
+}
+
+/// <summary>
+/// sinとcosから直接組み立てたMakeAffineTransformを、3つの行列を掛ける以前の計算と比べる
+/// </summary>
+void TestMakeAffineTransform() {
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> distribution(-3.0f, 3.0f);
+	double maxError = 0.0;
+	for (int k = 0; k < 10000; k++) {
+		const Vector3 scale = {distribution(random) + 4.0f, distribution(random) + 4.0f, distribution(random) + 4.0f};
+		const Vector3 rotate = {distribution(random), distribution(random), distribution(random)};
+		const Vector3 translate = {distribution(random) * 10.0f, distribution(random), distribution(random)};
+		const ReferenceMatrix expected = ReferenceAffine(scale, rotate, translate);
+		maxError = (std::max)(maxError, RelativeError(ToMatrix4x4(MakeAffineTransform(scale, rotate, translate)), expected));
+		maxError = (std::max)(maxError, RelativeError(MakeAffineMatrix(scale, rotate, translate), expected));
+		maxError = (std::max)(maxError, RelativeError(MakeRotateXYZMatrix(rotate), ReferenceAffine({1.0f, 1.0f, 1.0f}, rotate, {0.0f, 0.0f, 0.0f})));
+	}
+	std::printf("  max relative error %.2e\n", maxError);
+	CHECK(maxError < 1e-6);
+}
+
+/// <summary>
+/// 回転と平行移動だけの変換のInverseRigidを、一般のInverseと比べる
+/// </summary>
+void TestInverseRigid() {
+	std::mt19937 random(4);
+	std::uniform_real_distribution<float> distribution(-3.0f, 3.0f);
+	double maxError = 0.0;
+	double maxInverseError = 0.0;
+	for (int k = 0; k < 10000; k++) {
+		const AffineTransform transform = MakeAffineTransform({1.0f, 1.0f, 1.0f}, {distribution(random), distribution(random), distribution(random)},
+		                                                      {distribution(random) * 20.0f, distribution(random) * 20.0f, distribution(random) * 20.0f});
+		const Matrix4x4 inverse = ToMatrix4x4(InverseRigid(transform));
+		maxError = (std::max)(maxError, RelativeError(inverse, ReferenceInverse(ToReference(ToMatrix4x4(transform)))));
+		maxInverseError = (std::max)(maxInverseError, RelativeError(inverse, ToReference(Inverse(ToMatrix4x4(transform)))));
+	}
+	std::printf("  max relative error %.2e (against Inverse %.2e)\n", maxError, maxInverseError);
+	CHECK(maxError < 1e-6);
+	CHECK(maxInverseError < 1e-5);
+}
+
+/// <summary>
+/// AffineTransformを掛けるMultiplyを、Matrix4x4に直して掛けたものと比べる
+/// </summary>
+void TestMultiplyAffineTransform() {
+	const Matrices& matrices = GetMatrices();
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> distribution(-3.0f, 3.0f);
+	double maxError = 0.0;
+	for (size_t k = 0; k < matrices.viewProjection.size(); k++) {
+		const AffineTransform world = MakeAffineTransform({distribution(random) + 4.0f, distribution(random) + 4.0f, distribution(random) + 4.0f},
+		                                                  {distribution(random), distribution(random), distribution(random)}, {distribution(random) * 10.0f, distribution(random), distribution(random)});
+		const AffineTransform parent = MakeAffineTransform({1.0f, 1.0f, 1.0f}, {distribution(random), distribution(random), distribution(random)}, {distribution(random), distribution(random), distribution(random)});
+		const Matrix4x4& viewProjection = matrices.viewProjection[k];
+		maxError = (std::max)(maxError, RelativeError(Multiply(world, viewProjection), ReferenceMultiply(ToReference(ToMatrix4x4(world)), ToReference(viewProjection))));
+		maxError = (std::max)(maxError, RelativeError(ToMatrix4x4(Multiply(world, parent)), ReferenceMultiply(ToReference(ToMatrix4x4(world)), ToReference(ToMatrix4x4(parent)))));
+	}
+	std::printf("  max relative error %.2e\n", maxError);
+	CHECK(maxError < 1e-6);
+}
+
+// まとめて計算する関数に渡す数(4つずつの計算と端数の両方を通る)
+const size_t kBatchCounts[] = {1, 3, 5, 7};
+
+/// <summary>
+/// TransformPointsを、1点ずつのTransformと比べる
+/// 透視投影ではwが0になる点(カメラと同じ深さ)も混ぜ、Transformと同じく原点になることを確かめる
+/// </summary>
+void TestTransformPoints() {
+	const Matrices& matrices = GetMatrices();
+	std::mt19937 random(6);
+	std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+	// ビュー行列を掛けない透視投影ではw = zなので、z = 0の点のwがちょうど0になる
+	const Matrix4x4 projection = MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f);
+	double maxError = 0.0;
+	int zeroWCount = 0;
+	for (size_t k = 0; k < 100; k++) {
+		for (const Matrix4x4* matrix : {&matrices.affine[k], &matrices.viewProjection[k], &projection}) {
+			for (size_t count : kBatchCounts) {
+				std::vector<float> x(count), y(count), z(count);
+				for (size_t i = 0; i < count; i++) {
+					x[i] = distribution(random);
+					y[i] = distribution(random);
+					z[i] = matrix == &projection && (i + k) % 3 == 0 ? 0.0f : distribution(random);
+				}
+				std::vector<float> resultX(count), resultY(count), resultZ(count);
+				TransformPoints(x.data(), y.data(), z.data(), count, *matrix, resultX.data(), resultY.data(), resultZ.data());
+				for (size_t i = 0; i < count; i++) {
+					const Vector3 expected = Transform({x[i], y[i], z[i]}, *matrix);
+					const double scale = (std::max)({1.0, double(std::fabs(expected.x)), double(std::fabs(expected.y)), double(std::fabs(expected.z))});
+					maxError = (std::max)(maxError, std::fabs(double(resultX[i]) - expected.x) / scale);
+					maxError = (std::max)(maxError, std::fabs(double(resultY[i]) - expected.y) / scale);
+					maxError = (std::max)(maxError, std::fabs(double(resultZ[i]) - expected.z) / scale);
+					if (matrix == &projection && z[i] == 0.0f) {
+						CHECK(resultX[i] == 0.0f && resultY[i] == 0.0f && resultZ[i] == 0.0f);
+						zeroWCount++;
+					}
+				}
+				// 出力を入力と同じ配列にしても同じ結果になる
+				TransformPoints(x.data(), y.data(), z.data(), count, *matrix, x.data(), y.data(), z.data());
+				CHECK(x == resultX && y == resultY && z == resultZ);
+			}
+		}
+	}
+	std::printf("  max relative error %.2e, %d points with w = 0\n", maxError, zeroWCount);
+	CHECK(maxError < 1e-5);
+	CHECK(zeroWCount > 0);
+}
+
+/// <summary>
+/// MultiplyMatricesを、1つずつのMultiplyと比べる
+/// </summary>
+void TestMultiplyMatrices() {
+	const Matrices& matrices = GetMatrices();
+	double maxError = 0.0;
+	for (size_t k = 0; k + 8 <= matrices.general.size(); k += 8) {
+		for (size_t count : kBatchCounts) {
+			const Matrix4x4& right = matrices.viewProjection[k];
+			std::vector<Matrix4x4> results(count);
+			MultiplyMatrices(matrices.affine.data() + k, count, right, results.data());
+			std::vector<Matrix4x4> inPlace(matrices.general.begin() + k, matrices.general.begin() + k + count);
+			MultiplyMatrices(inPlace.data(), count, right, inPlace.data());
+			for (size_t i = 0; i < count; i++) {
+				maxError = (std::max)(maxError, RelativeError(results[i], ToReference(Multiply(matrices.affine[k + i], right))));
+				maxError = (std::max)(maxError, RelativeError(inPlace[i], ToReference(Multiply(matrices.general[k + i], right))));
+			}
+		}
+	}
+	std::printf("  max relative error %.2e\n", maxError);
+	CHECK(maxError < 1e-6);
+}
+
+/// <summary>
+/// MakeAffineMatricesを、1つずつのMakeAffineMatrixと比べる
+/// SSEのsinとcos(SinCos)は|x| < 8192の範囲でしか精度がないので、回転はその範囲で試す
+/// </summary>
+void TestMakeAffineMatrices() {
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> distribution(-3.0f, 3.0f);
+	double maxError = 0.0;
+	for (float rotateRange : {1.0f, 100.0f, 8000.0f}) {
+		for (int trial = 0; trial < 200; trial++) {
+			for (size_t count : kBatchCounts) {
+				std::vector<float> components[9];
+				for (std::vector<float>& component : components) {
+					component.resize(count);
+				}
+				for (size_t i = 0; i < count; i++) {
+					for (int axis = 0; axis < 3; axis++) {
+						components[axis][i] = distribution(random) + 4.0f;
+						components[3 + axis][i] = distribution(random) / 3.0f * rotateRange;
+						components[6 + axis][i] = distribution(random) * 10.0f;
+					}
+				}
+				TransformArrays arrays{components[0].data(), components[1].data(), components[2].data(), components[3].data(), components[4].data(),
+				                       components[5].data(), components[6].data(), components[7].data(), components[8].data()};
+				std::vector<Matrix4x4> results(count);
+				MakeAffineMatrices(arrays, count, results.data());
+				for (size_t i = 0; i < count; i++) {
+					const Matrix4x4 expected = MakeAffineMatrix({components[0][i], components[1][i], components[2][i]}, {components[3][i], components[4][i], components[5][i]},
+					                                            {components[6][i], components[7][i], components[8][i]});
+					maxError = (std::max)(maxError, RelativeError(results[i], ToReference(expected)));
+				}
+			}
+		}
+	}
+	std::printf("  max relative error %.2e\n", maxError);
+	CHECK(maxError < 1e-6);
+}
+
+} // namespace
+
+/// <summary>
+/// 行列の積、逆行列、座標変換を倍精度の定義どおりの計算と比べる
+/// ENGINE_USE_SSEを1にしたEngineと0にしたEngineScalarの両方にリンクしてビルドし、どちらの実装も確かめる
+/// </summary>
+int main() {
+	std::printf("ENGINE_USE_SSE=%d\n", ENGINE_USE_SSE);
+	TestFramework::Run("Multiply", TestMultiply);
+	TestFramework::Run("Inverse", TestInverse);
+	TestFramework::Run("InverseAffine", TestInverseAffine);
+	TestFramework::Run("Transform", TestTransform);
+	TestFramework::Run("MakeAffineTransform matches scale * rotate * translate", TestMakeAffineTransform);
+	TestFramework::Run("InverseRigid matches Inverse", TestInverseRigid);
+	TestFramework::Run("Multiply with AffineTransform", TestMultiplyAffineTransform);
+	TestFramework::Run("TransformPoints matches Transform", TestTransformPoints);
+	TestFramework::Run("MultiplyMatrices matches Multiply", TestMultiplyMatrices);
+	TestFramework::Run("MakeAffineMatrices matches MakeAffineMatrix", TestMakeAffineMatrices);
+	return TestFramework::Finish();
+}
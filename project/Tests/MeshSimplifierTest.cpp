@@ -0,0 +1,185 @@
+#include "Engine/Model/MeshSimplifier.h"
+#include "TestFramework.h"
+#include <cmath>
+#include <set>
+
+namespace {
+
+const uint32_t kColumns = 24;
+const uint32_t kRows = 12;
+
+/// <summary>
+/// 経度kColumns、緯度kRowsの単位球。u=0とu=1の列は同じ位置でUVだけが違うシーム、極は列ごとにUVが違う頂点になる
+/// texcoordは(列/kColumns, 行/kRows)
+/// </summary>
+ModelData MakeSeamedSphere() {
+	ModelData modelData;
+	for (uint32_t y = 0; y <= kRows; y++) {
+		for (uint32_t x = 0; x <= kColumns; x++) {
+			// シームの両側がちょうど同じ位置になるように、最後の列は最初の列の角度で作る
+			float u = float(x % kColumns) * 6.2831853f / float(kColumns);
+			float v = float(y) * 3.14159265f / float(kRows);
+			Vector3 position = {std::cos(u) * std::sin(v), std::cos(v), std::sin(u) * std::sin(v)};
+			if (y == 0 || y == kRows) {
+				position = {0.0f, y == 0 ? 1.0f : -1.0f, 0.0f};
+			}
+			modelData.vertices.push_back({Vector4(position.x, position.y, position.z, 1.0f), {float(x) / float(kColumns), float(y) / float(kRows)}, position});
+		}
+	}
+	for (uint32_t y = 0; y < kRows; y++) {
+		for (uint32_t x = 0; x < kColumns; x++) {
+			uint32_t a = y * (kColumns + 1) + x, b = a + 1, c = a + kColumns + 1, d = c + 1;
+			// 極の行では片方の三角形が点につぶれるので作らない
+			if (y != 0) {
+				modelData.indices.insert(modelData.indices.end(), {a, c, b});
+			}
+			if (y != kRows - 1) {
+				modelData.indices.insert(modelData.indices.end(), {b, c, d});
+			}
+		}
+	}
+	return modelData;
+}
+
+Vector3 GetPosition(const ModelData& modelData, uint32_t index) {
+	const Vector4& position = modelData.vertices[index].position;
+	return {position.x, position.y, position.z};
+}
+
+/// <summary>
+/// 三角形が球の外を向いていれば1、内を向いていれば-1(面積がなければ0)
+/// </summary>
+int GetFacing(const ModelData& modelData, const uint32_t* triangle) {
+	Vector3 p0 = GetPosition(modelData, triangle[0]);
+	Vector3 p1 = GetPosition(modelData, triangle[1]);
+	Vector3 p2 = GetPosition(modelData, triangle[2]);
+	Vector3 normal = Cross(p1 - p0, p2 - p0);
+	if (Length(normal) < 1e-6f) {
+		return 0;
+	}
+	return Dot(normal, p0 + p1 + p2) > 0.0f ? 1 : -1;
+}
+
+/// <summary>
+/// 減らした三角形が裏返らず、シームの頂点は三角形のある側のUVのままで、シームの両側が同じ位置を使い続けるか
+/// </summary>
+void TestSimplifySeamedSphere() {
+	const ModelData modelData = MakeSeamedSphere();
+	const size_t indexCount = modelData.indices.size();
+	const int inputFacing = GetFacing(modelData, modelData.indices.data());
+	CHECK(inputFacing != 0);
+	std::vector<uint32_t> result;
+	for (float ratio : {0.5f, 0.25f, 0.1f}) {
+		const size_t targetIndexCount = size_t(float(indexCount / 3) * ratio) * 3;
+		const float error = SimplifyMesh(modelData.vertices, modelData.indices.data(), indexCount, targetIndexCount, 0.5f, result);
+		CHECK(!result.empty() && result.size() < indexCount && result.size() % 3 == 0);
+		CHECK(error >= 0.0f && error <= 0.5f);
+
+		size_t flippedCount = 0;
+		size_t wrongSideCount = 0;
+		std::set<uint32_t> firstColumnRows; // u=0の頂点を使う行
+		std::set<uint32_t> lastColumnRows;  // u=1の頂点を使う行
+		for (size_t i = 0; i < result.size(); i += 3) {
+			flippedCount += GetFacing(modelData, &result[i]) != inputFacing ? 1 : 0;
+			// シームはz=0、x>0の半円で、z>0の三角形はu=0側、z<0の三角形はu=1側の頂点を使う
+			const Vector3 center = GetPosition(modelData, result[i]) + GetPosition(modelData, result[i + 1]) + GetPosition(modelData, result[i + 2]);
+			for (uint32_t k = 0; k < 3; k++) {
+				const uint32_t column = result[i + k] % (kColumns + 1);
+				const uint32_t row = result[i + k] / (kColumns + 1);
+				if (row == 0 || row == kRows) {
+					continue;
+				}
+				if (column == 0) {
+					wrongSideCount += center.z < 0.0f ? 1 : 0;
+					firstColumnRows.insert(row);
+				} else if (column == kColumns) {
+					wrongSideCount += center.z > 0.0f ? 1 : 0;
+					lastColumnRows.insert(row);
+				}
+			}
+		}
+		CHECK(flippedCount == 0);
+		CHECK(wrongSideCount == 0);
+		// シームの頂点は両側を一緒に動かすので、片側だけ残って割れ目ができることはない
+		CHECK(!firstColumnRows.empty());
+		CHECK(firstColumnRows == lastColumnRows);
+		std::printf("  %zu -> %zu triangles, error %.4f, %zu seam rows kept\n", indexCount / 3, result.size() / 3, error, firstColumnRows.size());
+	}
+}
+
+/// <summary>
+/// BuildLodsのLODは番号順に三角形が減り、誤差が増える
+/// </summary>
+void TestBuildLods() {
+	ModelData modelData = MakeSeamedSphere();
+	const uint32_t indexCount = uint32_t(modelData.indices.size());
+	BuildLods(modelData, 4, 0.5f, 0.2f);
+	CHECK(modelData.lods.size() >= 3);
+	CHECK(modelData.lods[0].indexStart == 0 && modelData.lods[0].indexCount == indexCount && modelData.lods[0].error == 0.0f);
+	for (size_t i = 1; i < modelData.lods.size(); i++) {
+		const LodData& previous = modelData.lods[i - 1];
+		const LodData& lod = modelData.lods[i];
+		CHECK(lod.indexCount < previous.indexCount);
+		CHECK(lod.error >= previous.error);
+		CHECK(lod.indexStart == previous.indexStart + previous.indexCount);
+		std::printf("  LOD%zu: %u triangles, error %.4f\n", i, lod.indexCount / 3, lod.error);
+	}
+	CHECK(modelData.indices.size() == modelData.lods.back().indexStart + modelData.lods.back().indexCount);
+
+	// 作り直しても同じになる
+	const std::vector<LodData> lods = modelData.lods;
+	BuildLods(modelData, 4, 0.5f, 0.2f);
+	CHECK(modelData.lods.size() == lods.size());
+	for (size_t i = 0; i < lods.size() && i < modelData.lods.size(); i++) {
+		CHECK(modelData.lods[i].indexCount == lods[i].indexCount && modelData.lods[i].error == lods[i].error);
+	}
+}
+
+/// <summary>
+/// SelectLodは誤差が許容以下の中で一番粗いLODを選び、遠いほど粗いLODになる
+/// </summary>
+void TestSelectLod() {
+	const std::vector<LodData> lods = {{0, 300, 0, 0.0f}, {300, 150, 1, 0.01f}, {450, 75, 2, 0.02f}, {525, 36, 3, 0.08f}};
+	CHECK(SelectLod(lods, 0.0f) == 0);
+	CHECK(SelectLod(lods, 0.005f) == 0);
+	CHECK(SelectLod(lods, 0.01f) == 1);
+	CHECK(SelectLod(lods, 0.05f) == 2);
+	CHECK(SelectLod(lods, 0.08f) == 3);
+	CHECK(SelectLod(lods, 1.0f) == 3);
+	CHECK(SelectLod({}, 1.0f) == 0);
+	CHECK(SelectLod({lods[0]}, 1.0f) == 0);
+
+	// 許容する誤差は距離に比例し、拡大率に反比例する
+	const float fovY = 0.45f;
+	const float allowed = GetAllowedLodError(1.0f, 10.0f, 1.0f, fovY, 720.0f);
+	CHECK(std::fabs(allowed - 2.0f * 10.0f * std::tan(fovY * 0.5f) / 720.0f) < 1e-6f);
+	CHECK(std::fabs(GetAllowedLodError(1.0f, 20.0f, 1.0f, fovY, 720.0f) - allowed * 2.0f) < 1e-6f);
+	CHECK(std::fabs(GetAllowedLodError(1.0f, 10.0f, 2.0f, fovY, 720.0f) - allowed * 0.5f) < 1e-6f);
+
+	// 球のLODを遠ざけながら選ぶ
+	ModelData modelData = MakeSeamedSphere();
+	BuildLods(modelData, 4, 0.5f, 0.2f);
+	uint32_t previousLod = 0;
+	int decreaseCount = 0;
+	for (float distance = 1.0f; distance < 1000.0f; distance *= 1.5f) {
+		const float allowedError = GetAllowedLodError(1.0f, distance, 1.0f, fovY, 720.0f);
+		const uint32_t lod = SelectLod(modelData.lods, allowedError);
+		CHECK(modelData.lods[lod].error <= allowedError || lod == 0);
+		if (lod + 1 < modelData.lods.size()) {
+			CHECK(modelData.lods[lod + 1].error > allowedError);
+		}
+		decreaseCount += lod < previousLod ? 1 : 0;
+		previousLod = lod;
+	}
+	CHECK(decreaseCount == 0);
+	CHECK(previousLod == modelData.lods.size() - 1);
+}
+
+} // namespace
+
+int main() {
+	TestFramework::Run("simplifying a seamed sphere keeps seam UVs and does not flip triangles", TestSimplifySeamedSphere);
+	TestFramework::Run("BuildLods errors increase with the LOD", TestBuildLods);
+	TestFramework::Run("SelectLod picks the coarsest LOD within the allowed error", TestSelectLod);
+	return TestFramework::Finish();
+}
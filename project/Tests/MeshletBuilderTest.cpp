@@ -0,0 +1,173 @@
+#include "Engine/Model/MeshOptimizer.h"
+#include "Engine/Model/MeshletBuilder.h"
+#include "Engine/Model/ObjLoader.h"
+#include "TestFramework.h"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <set>
+
+namespace {
+
+using Triangle = std::array<uint32_t, 3>;
+
+/// <summary>
+/// (columns+1)×(rows+1)頂点の格子。isSphereなら球面に巻き付ける
+/// </summary>
+ModelData MakeGrid(uint32_t columns, uint32_t rows, bool isSphere) {
+	ModelData modelData;
+	for (uint32_t y = 0; y <= rows; y++) {
+		for (uint32_t x = 0; x <= columns; x++) {
+			Vector4 position(float(x), 0.0f, float(y), 1.0f);
+			if (isSphere) {
+				float u = float(x) * 6.2831853f / float(columns);
+				float v = 0.01f + float(y) * 3.12f / float(rows);
+				position = Vector4(std::cos(u) * std::sin(v), std::cos(v), std::sin(u) * std::sin(v), 1.0f);
+			}
+			modelData.vertices.push_back({position, {float(x), float(y)}, {0.0f, 1.0f, 0.0f}});
+		}
+	}
+	for (uint32_t y = 0; y < rows; y++) {
+		for (uint32_t x = 0; x < columns; x++) {
+			uint32_t a = y * (columns + 1) + x, b = a + 1, c = a + columns + 1, d = c + 1;
+			for (uint32_t index : {a, c, b, b, c, d}) {
+				modelData.indices.push_back(index);
+			}
+		}
+	}
+	return modelData;
+}
+
+Vector3 GetPosition(const ModelData& modelData, uint32_t index) {
+	const Vector4& position = modelData.vertices[index].position;
+	return {position.x, position.y, position.z};
+}
+
+/// <summary>
+/// メッシュレットが上限を守り、サブメッシュの三角形をちょうど1回ずつ覆い、境界球が頂点を囲むか
+/// </summary>
+void CheckMeshlets(const ModelData& modelData) {
+	CHECK(!modelData.meshlets.empty());
+	std::vector<SubMeshData> ranges = modelData.subMeshes;
+	if (ranges.empty()) {
+		ranges.push_back({"", 0, uint32_t(modelData.indices.size()), 0, 0, uint32_t(modelData.meshlets.size()), {}, {}});
+	}
+	for (const SubMeshData& range : ranges) {
+		std::multiset<Triangle> expected;
+		std::multiset<Triangle> actual;
+		for (uint32_t i = range.indexStart; i < range.indexStart + range.indexCount; i += 3) {
+			expected.insert({modelData.indices[i], modelData.indices[i + 1], modelData.indices[i + 2]});
+		}
+		int limitErrorCount = 0;
+		int sphereErrorCount = 0;
+		for (uint32_t m = range.meshletStart; m < range.meshletStart + range.meshletCount; m++) {
+			const MeshletData& meshlet = modelData.meshlets[m];
+			limitErrorCount += (meshlet.vertexCount == 0 || meshlet.vertexCount > kMeshletMaxVertices || meshlet.triangleCount == 0 || meshlet.triangleCount > kMeshletMaxTriangles) ? 1 : 0;
+			for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+				Triangle triangle;
+				for (uint32_t k = 0; k < 3; k++) {
+					uint8_t local = modelData.meshletTriangles[meshlet.triangleOffset + t * 3 + k];
+					limitErrorCount += local >= meshlet.vertexCount ? 1 : 0;
+					triangle[k] = modelData.meshletVertices[meshlet.vertexOffset + local];
+					sphereErrorCount += Length(GetPosition(modelData, triangle[k]) - meshlet.center) > meshlet.radius * 1.0001f + 1e-6f ? 1 : 0;
+				}
+				actual.insert(triangle);
+			}
+		}
+		CHECK(limitErrorCount == 0);
+		CHECK(sphereErrorCount == 0);
+		CHECK(expected == actual);
+	}
+}
+
+/// <summary>
+/// 法線コーンで裏向きと判定したメッシュレットは、どの三角形もカメラから裏を向いているか(カリングが安全か)
+/// </summary>
+/// <returns>裏向きと判定した割合</returns>
+float CheckBackfaceCulling(const ModelData& modelData) {
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> distribution(-20.0f, 20.0f);
+	int culledCount = 0;
+	int totalCount = 0;
+	int unsafeCount = 0;
+	for (int camera = 0; camera < 200; camera++) {
+		Vector3 cameraPosition = {distribution(random), distribution(random), distribution(random)};
+		for (const MeshletData& meshlet : modelData.meshlets) {
+			totalCount++;
+			if (!IsMeshletBackfacing(meshlet, cameraPosition)) {
+				continue;
+			}
+			culledCount++;
+			for (uint32_t t = 0; t < meshlet.triangleCount; t++) {
+				Vector3 p[3];
+				for (uint32_t k = 0; k < 3; k++) {
+					p[k] = GetPosition(modelData, modelData.meshletVertices[meshlet.vertexOffset + modelData.meshletTriangles[meshlet.triangleOffset + t * 3 + k]]);
+				}
+				Vector3 normal = Cross(p[1] - p[0], p[2] - p[0]);
+				if (Length(normal) > 0.0f && Dot(normal, p[0] - cameraPosition) < -1e-4f * Length(normal) * Length(p[0] - cameraPosition)) {
+					unsafeCount++;
+					break;
+				}
+			}
+		}
+	}
+	CHECK(unsafeCount == 0);
+	return float(culledCount) / float(totalCount);
+}
+
+void TestGrid(bool isSphere, bool isOptimized) {
+	ModelData modelData = MakeGrid(120, 80, isSphere);
+	if (isOptimized) {
+		OptimizeMesh(modelData);
+	}
+	MeshletReport report = BuildMeshlets(modelData);
+	CHECK(report.meshletCount == modelData.meshlets.size());
+	CheckMeshlets(modelData);
+	float culledRatio = CheckBackfaceCulling(modelData);
+	std::printf("  %u meshlets, %.1f vertices, %.1f triangles on average, %.1f%% culled by cone\n", report.meshletCount, report.averageVertexCount, report.averageTriangleCount, culledRatio * 100.0f);
+	// 格子は頂点を共有するので、頂点の上限に対して三角形を十分に詰められる
+	CHECK(report.averageTriangleCount > 70.0f);
+	if (isSphere) {
+		CHECK(culledRatio > 0.2f);
+	}
+}
+
+/// <summary>
+/// 同じ入力からは同じメッシュレットになる
+/// </summary>
+void TestDeterministic() {
+	ModelData a = MakeGrid(64, 64, true);
+	ModelData b = a;
+	BuildMeshlets(a);
+	BuildMeshlets(b);
+	CHECK(a.meshlets.size() == b.meshlets.size());
+	CHECK(std::memcmp(a.meshlets.data(), b.meshlets.data(), sizeof(MeshletData) * a.meshlets.size()) == 0);
+	CHECK(a.meshletVertices == b.meshletVertices);
+	CHECK(a.meshletTriangles == b.meshletTriangles);
+}
+
+void TestFence() {
+	ModelData modelData = LoadObjFile(ENGINE_RESOURCE_DIRECTORY, "fence.obj");
+	OptimizeMesh(modelData);
+	BuildMeshlets(modelData);
+	CheckMeshlets(modelData);
+	CheckBackfaceCulling(modelData);
+	uint32_t meshletCount = 0;
+	for (const SubMeshData& subMesh : modelData.subMeshes) {
+		CHECK(subMesh.meshletStart == meshletCount);
+		meshletCount += subMesh.meshletCount;
+	}
+	CHECK(meshletCount == modelData.meshlets.size());
+}
+
+} // namespace
+
+int main() {
+	TestFramework::Run("flat grid", [] { TestGrid(false, false); });
+	TestFramework::Run("sphere grid", [] { TestGrid(true, false); });
+	TestFramework::Run("sphere grid after OptimizeMesh", [] { TestGrid(true, true); });
+	TestFramework::Run("same input gives the same meshlets", TestDeterministic);
+	TestFramework::Run("fence.obj", TestFence);
+	return TestFramework::Finish();
+}
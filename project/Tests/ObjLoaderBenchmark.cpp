@@ -0,0 +1,148 @@
+#include "Engine/Model/ObjLoader.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+/// <summary>
+/// 以前のistringstreamで1行ずつ読む読み込み(比較用。三角形のv/vt/vnのみ対応で、インデックスを作らない)
+/// </summary>
+ModelData LoadObjFileWithStringStream(const std::string& directoryPath, const std::string& filename) {
+	ModelData modelData;
+	std::vector<Vector4> positions; // 頂点位置
+	std::vector<Vector3> normals;   // 法線ベクトル
+	std::vector<Vector2> texcoords; // テクスチャ座標
+	std::string line;
+
+	std::ifstream file(directoryPath + "/" + filename);
+	while (std::getline(file, line)) {
+		std::string identifier;
+		std::istringstream s(line);
+		s >> identifier;
+		if (identifier == "v") {
+			Vector4 position;
+			s >> position.x >> position.y >> position.z;
+			position.x *= -1;
+			position.w = 1.0f;
+			positions.push_back(position);
+		} else if (identifier == "vt") {
+			Vector2 texcoord;
+			s >> texcoord.x >> texcoord.y;
+			texcoord.x = 1.0f - texcoord.x;
+			texcoord.y = 1.0f - texcoord.y;
+			texcoords.push_back(texcoord);
+		} else if (identifier == "vn") {
+			Vector3 normal;
+			s >> normal.x >> normal.y >> normal.z;
+			normal.x *= -1;
+			normals.push_back(normal);
+		} else if (identifier == "f") {
+			for (int32_t faceVertex = 0; faceVertex < 3; faceVertex++) {
+				std::string vertexDefinition;
+				s >> vertexDefinition;
+				std::istringstream v(vertexDefinition);
+				uint32_t elementsIndices[3];
+				for (int32_t element = 0; element < 3; element++) {
+					std::string index;
+					std::getline(v, index, '/');
+					elementsIndices[element] = std::stoi(index);
+				}
+				modelData.vertices.push_back({positions[elementsIndices[0] - 1], texcoords[elementsIndices[1] - 1], normals[elementsIndices[2] - 1]});
+			}
+		}
+	}
+	return modelData;
+}
+
+/// <summary>
+/// 要素と三角形をelementCount個ずつ持つobjを書き出す
+/// </summary>
+void WriteGeneratedObj(const std::string& filepath, uint32_t elementCount) {
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> coordinate(-100.0f, 100.0f);
+	std::uniform_int_distribution<uint32_t> element(1, elementCount);
+	FILE* file = std::fopen(filepath.c_str(), "wb");
+	for (uint32_t i = 0; i < elementCount; i++) {
+		std::fprintf(file, "v %f %f %.9g\n", coordinate(random), coordinate(random), coordinate(random));
+	}
+	for (uint32_t i = 0; i < elementCount; i++) {
+		std::fprintf(file, "vt %f %f\n", coordinate(random) / 100.0f, coordinate(random) / 100.0f);
+	}
+	for (uint32_t i = 0; i < elementCount; i++) {
+		std::fprintf(file, "vn %.4f %.4f %e\n", coordinate(random) / 100.0f, coordinate(random) / 100.0f, coordinate(random) / 100.0f);
+	}
+	for (uint32_t i = 0; i < elementCount; i++) {
+		std::fprintf(file, "f");
+		for (int32_t corner = 0; corner < 3; corner++) {
+			std::fprintf(file, " %u/%u/%u", element(random), element(random), element(random));
+		}
+		std::fprintf(file, "\n");
+	}
+	std::fclose(file);
+}
+
+// インデックスを展開した頂点が以前の読み込みと同じか
+bool IsSameAsExpanded(const ModelData& indexed, const ModelData& expanded) {
+	if (indexed.indices.size() != expanded.vertices.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < indexed.indices.size(); i++) {
+		if (std::memcmp(&indexed.vertices[indexed.indices[i]], &expanded.vertices[i], sizeof(VertexData)) != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// スレッド数によらず同じ結果か
+bool IsSameModel(const ModelData& a, const ModelData& b) {
+	return a.vertices.size() == b.vertices.size() && a.indices == b.indices && std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(VertexData)) == 0;
+}
+
+} // namespace
+
+/// <summary>
+/// 生成した大きなobjで、以前のistringstreamの読み込みとLoadObjFileの速度(MB/s)を比べ、
+/// LoadObjFileのスレッド数を1から順に増やしたときの速度を測る
+/// 使い方: ObjLoaderBenchmark [要素数(既定200000)] [最大スレッド数(既定はハードウェアのスレッド数)]
+/// </summary>
+int main(int argc, char** argv) {
+	const uint32_t elementCount = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 200000;
+	const uint32_t maxThreadCount = argc > 2 ? uint32_t(std::strtoul(argv[2], nullptr, 10)) : (std::max)(1u, std::thread::hardware_concurrency());
+	const std::string directoryPath = std::filesystem::temp_directory_path().string();
+	const std::string filename = "ObjLoaderBenchmark.obj";
+	WriteGeneratedObj(directoryPath + "/" + filename, elementCount);
+	const double megabytes = double(std::filesystem::file_size(directoryPath + "/" + filename)) / (1024.0 * 1024.0);
+	std::printf("generated %s: %u triangles, %.1f MB\n", filename.c_str(), elementCount, megabytes);
+
+	ModelData expanded;
+	ModelData indexed;
+	double streamMilliseconds = TestFramework::MeasureMilliseconds([&] { expanded = LoadObjFileWithStringStream(directoryPath, filename); });
+	double scannerMilliseconds = TestFramework::MeasureMilliseconds([&] { indexed = LoadObjFile(directoryPath, filename, 1); });
+	std::printf("istringstream  %8.1f ms %8.1f MB/s\n", streamMilliseconds, megabytes / (streamMilliseconds / 1000.0));
+	std::printf("LoadObjFile    %8.1f ms %8.1f MB/s (x%.1f)\n", scannerMilliseconds, megabytes / (scannerMilliseconds / 1000.0), streamMilliseconds / scannerMilliseconds);
+	CHECK(IsSameAsExpanded(indexed, expanded));
+
+	// スレッド数ごとの速度(チャンクは1MB以上なので、小さいファイルでは指定より少ないスレッドで動く)
+	double singleThreadMilliseconds = scannerMilliseconds;
+	for (uint32_t threadCount = 1; threadCount <= maxThreadCount; threadCount++) {
+		ModelData parallel;
+		double milliseconds = TestFramework::MeasureMilliseconds([&] { parallel = LoadObjFile(directoryPath, filename, threadCount); });
+		if (threadCount == 1) {
+			singleThreadMilliseconds = milliseconds;
+		}
+		std::printf("threads %3u    %8.1f ms %8.1f MB/s (x%.2f)\n", threadCount, milliseconds, megabytes / (milliseconds / 1000.0), singleThreadMilliseconds / milliseconds);
+		CHECK(IsSameModel(parallel, indexed));
+	}
+
+	std::filesystem::remove(directoryPath + "/" + filename);
+	return TestFramework::Finish();
+}
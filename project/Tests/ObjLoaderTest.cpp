@@ -0,0 +1,123 @@
+#include "Engine/Model/ObjLoader.h"
+#include "TestFramework.h"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// <summary>
+/// 2次元の点(多角形の平面上の座標)
+/// </summary>
+struct Point2 {
+	float u;
+	float v;
+};
+
+// L字の六角形(面積3)と凹の八角形(面積7)
+const std::vector<Point2> kLShape = {{0, 0}, {2, 0}, {2, 1}, {1, 1}, {1, 2}, {0, 2}};
+const std::vector<Point2> kUShape = {{0, 0}, {3, 0}, {3, 3}, {2, 3}, {2, 1}, {1, 1}, {1, 3}, {0, 3}};
+
+// 多角形の面積(頂点の並びによらず正)
+float PolygonArea(const std::vector<Point2>& polygon) {
+	float area = 0.0f;
+	for (size_t i = 0; i < polygon.size(); i++) {
+		const Point2& a = polygon[i];
+		const Point2& b = polygon[(i + 1) % polygon.size()];
+		area += a.u * b.v - b.u * a.v;
+	}
+	return std::fabs(area) * 0.5f;
+}
+
+/// <summary>
+/// 多角形を1つの面として書いたobjを読み込む
+/// </summary>
+/// <param name="axis">面の法線の軸(0:X、1:Y、2:Z)。平面上の座標は残りの2軸に置く</param>
+/// <param name="isReversed">頂点を逆順に並べるか</param>
+ModelData LoadPolygon(const std::vector<Point2>& polygon, int axis, bool isReversed) {
+	const std::string directoryPath = std::filesystem::temp_directory_path().string();
+	const std::string filename = "ObjLoaderTestPolygon.obj";
+	FILE* file = std::fopen((directoryPath + "/" + filename).c_str(), "wb");
+	for (const Point2& point : polygon) {
+		float position[3] = {};
+		position[(axis + 1) % 3] = point.u;
+		position[(axis + 2) % 3] = point.v;
+		position[axis] = 0.5f;
+		std::fprintf(file, "v %g %g %g\n", position[0], position[1], position[2]);
+	}
+	std::fprintf(file, "f");
+	for (size_t i = 0; i < polygon.size(); i++) {
+		std::fprintf(file, " %zu", isReversed ? polygon.size() - i : i + 1);
+	}
+	std::fprintf(file, "\n");
+	std::fclose(file);
+	ModelData modelData = LoadObjFile(directoryPath, filename);
+	std::filesystem::remove(directoryPath + "/" + filename);
+	return modelData;
+}
+
+// 三角形の面積ベクトル(外積の半分)
+Vector3 TriangleAreaVector(const ModelData& modelData, size_t triangle) {
+	const Vector4& p0 = modelData.vertices[modelData.indices[triangle * 3]].position;
+	const Vector4& p1 = modelData.vertices[modelData.indices[triangle * 3 + 1]].position;
+	const Vector4& p2 = modelData.vertices[modelData.indices[triangle * 3 + 2]].position;
+	Vector3 cross = Cross(Vector3{p1.x - p0.x, p1.y - p0.y, p1.z - p0.z}, Vector3{p2.x - p0.x, p2.y - p0.y, p2.z - p0.z});
+	return {cross.x * 0.5f, cross.y * 0.5f, cross.z * 0.5f};
+}
+
+/// <summary>
+/// 凹多角形を各平面に置いて両方の向きで分割し、三角形が重ならず同じ向きで多角形を覆うかを確かめる
+/// (三角形の面積の和と、面積ベクトルの和の長さが、どちらも多角形の面積に一致する)
+/// </summary>
+void TestConcavePolygon(const std::vector<Point2>& polygon) {
+	const float expectedArea = PolygonArea(polygon);
+	for (int axis = 0; axis < 3; axis++) {
+		for (bool isReversed : {false, true}) {
+			ModelData modelData = LoadPolygon(polygon, axis, isReversed);
+			CHECK(modelData.indices.size() == (polygon.size() - 2) * 3);
+			float areaSum = 0.0f;
+			Vector3 areaVectorSum = {0.0f, 0.0f, 0.0f};
+			for (size_t triangle = 0; triangle < modelData.indices.size() / 3; triangle++) {
+				Vector3 areaVector = TriangleAreaVector(modelData, triangle);
+				areaSum += Length(areaVector);
+				areaVectorSum = areaVectorSum + areaVector;
+			}
+			if (!CHECK(std::fabs(areaSum - expectedArea) < 1e-4f) || !CHECK(std::fabs(Length(areaVectorSum) - expectedArea) < 1e-4f)) {
+				std::printf("  axis %d reversed %d: area sum %g, |area vector sum| %g, expected %g\n", axis, int(isReversed), areaSum, Length(areaVectorSum), expectedArea);
+			}
+			// 表裏は頂点の並びで決まるので、逆順にすると法線の軸の成分の符号が変わる
+			const float facing = (&areaVectorSum.x)[axis];
+			CHECK(std::fabs(std::fabs(facing) - expectedArea) < 1e-4f);
+		}
+	}
+}
+
+/// <summary>
+/// 同じ多角形を逆順に並べると、法線の向きだけが逆になる
+/// </summary>
+void TestWindingIsKept() {
+	for (int axis = 0; axis < 3; axis++) {
+		ModelData forward = LoadPolygon(kLShape, axis, false);
+		ModelData backward = LoadPolygon(kLShape, axis, true);
+		Vector3 forwardSum = {0.0f, 0.0f, 0.0f};
+		Vector3 backwardSum = {0.0f, 0.0f, 0.0f};
+		for (size_t triangle = 0; triangle < forward.indices.size() / 3; triangle++) {
+			forwardSum = forwardSum + TriangleAreaVector(forward, triangle);
+		}
+		for (size_t triangle = 0; triangle < backward.indices.size() / 3; triangle++) {
+			backwardSum = backwardSum + TriangleAreaVector(backward, triangle);
+		}
+		CHECK(Length(forwardSum + backwardSum) < 1e-4f);
+	}
+}
+
+} // namespace
+
+int main() {
+	TestFramework::Run("L-shaped hexagon in the YZ, ZX and XY planes", [] { TestConcavePolygon(kLShape); });
+	TestFramework::Run("U-shaped octagon in the YZ, ZX and XY planes", [] { TestConcavePolygon(kUShape); });
+	TestFramework::Run("reversed polygons flip the normal", TestWindingIsKept);
+	return TestFramework::Finish();
+}
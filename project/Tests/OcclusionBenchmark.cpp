@@ -0,0 +1,94 @@
+#include "Engine/3d/Frustum.h"
+#include "Engine/Scene/OcclusionBuffer.h"
+#include "TestFramework.h"
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 画面の1/4の解像度(main.cppと同じ)
+const uint32_t kBufferWidth = 320;
+const uint32_t kBufferHeight = 180;
+
+/// <summary>
+/// 遮蔽物にする箱の三角形(12枚)を追加する
+/// </summary>
+void AddBox(const AABB& box, std::vector<Vector4>& positions, std::vector<uint32_t>& indices) {
+	const uint32_t start = uint32_t(positions.size());
+	for (int k = 0; k < 8; k++) {
+		positions.push_back(Vector4(k & 1 ? box.maximum.x : box.minimum.x, k & 2 ? box.maximum.y : box.minimum.y, k & 4 ? box.maximum.z : box.minimum.z, 1.0f));
+	}
+	const uint32_t faces[12][3] = {{0, 1, 3}, {0, 3, 2}, {4, 6, 7}, {4, 7, 5}, {0, 4, 5}, {0, 5, 1}, {2, 3, 7}, {2, 7, 6}, {0, 2, 6}, {0, 6, 4}, {1, 5, 7}, {1, 7, 3}};
+	for (const auto& face : faces) {
+		for (uint32_t corner : face) {
+			indices.push_back(start + corner);
+		}
+	}
+}
+
+/// <summary>
+/// 柵のように並べた96枚の壁の奥にobjectCount個の箱を置き、視錐台カリング、ラスタライズ、Hi-Zの作成、遮蔽判定の1フレームあたりの時間を測る
+/// </summary>
+void BenchmarkFrame(uint32_t objectCount, uint32_t frameCount) {
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	std::vector<Vector4> positions;
+	std::vector<uint32_t> indices;
+	for (int row = 0; row < 6; row++) {
+		for (float x = -40.0f; x < 40.0f; x += 5.0f) {
+			const float z = 8.0f + 6.0f * float(row);
+			AddBox({{x, 0.0f, z}, {x + 4.0f, 3.0f, z + 0.2f}}, positions, indices);
+		}
+	}
+	const Matrix4x4 view = ToMatrix4x4(InverseRigid(MakeAffineTransform({1.0f, 1.0f, 1.0f}, {0.05f, 0.0f, 0.0f}, {0.0f, 1.5f, -5.0f})));
+	const Matrix4x4 viewProjection = Multiply(view, MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f));
+	const Frustum frustum = MakeFrustum(viewProjection);
+
+	std::vector<AABB> objects(objectCount);
+	for (AABB& object : objects) {
+		const Vector3 center = {distribution(random) * 80.0f - 40.0f, distribution(random) * 3.0f, 5.0f + distribution(random) * 45.0f};
+		const float size = 0.15f + distribution(random) * 0.4f;
+		object = {center - Vector3{size, size, size}, center + Vector3{size, size, size}};
+	}
+
+	OcclusionBuffer buffer;
+	buffer.Initialize(kBufferWidth, kBufferHeight);
+	std::vector<uint32_t> visibleIndices(objectCount);
+	size_t frustumCount = 0;
+	size_t visibleCount = 0;
+	double frustumTime = 0.0;
+	double rasterTime = 0.0;
+	double hierarchyTime = 0.0;
+	double testTime = 0.0;
+	for (uint32_t frame = 0; frame < frameCount; frame++) {
+		frustumTime += TestFramework::MeasureMilliseconds([&] { frustumCount = CullAABBs(frustum, objects.data(), objects.size(), visibleIndices.data()); });
+		rasterTime += TestFramework::MeasureMilliseconds([&] {
+			buffer.Clear();
+			buffer.RenderTriangles(positions.data(), positions.size(), sizeof(Vector4), indices.data(), indices.size(), viewProjection);
+		});
+		hierarchyTime += TestFramework::MeasureMilliseconds([&] { buffer.BuildHierarchy(); });
+		testTime += TestFramework::MeasureMilliseconds([&] { visibleCount = buffer.FilterVisible(objects.data(), viewProjection, visibleIndices.data(), frustumCount); });
+	}
+	const double scale = 1.0 / double(frameCount);
+	std::printf("%7u objects: %zu in frustum -> %zu visible (cull rate %.1f%%)\n", objectCount, frustumCount, visibleCount,
+	            frustumCount > 0 ? double(frustumCount - visibleCount) * 100.0 / double(frustumCount) : 0.0);
+	std::printf("  ms per frame: frustum %.3f, clear+raster (%zu triangles) %.3f, Hi-Z %.3f, occlusion test %.3f\n", frustumTime * scale, indices.size() / 3, rasterTime * scale,
+	            hierarchyTime * scale, testTime * scale);
+}
+
+} // namespace
+
+/// <summary>
+/// OcclusionBufferの1フレームあたりの時間と、視錐台カリングの後に取り除ける割合を測る
+/// EngineにリンクしたOcclusionBenchmark(SSE)とEngineScalarにリンクしたOcclusionBenchmarkScalarを比べる
+/// 使い方: OcclusionBenchmark [フレーム数(既定20)]
+/// </summary>
+int main(int argc, char** argv) {
+	const uint32_t frameCount = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 20;
+	std::printf("ENGINE_USE_SSE=%d, %ux%u buffer, %u frames\n", ENGINE_USE_SSE, kBufferWidth, kBufferHeight, frameCount);
+	for (uint32_t objectCount : {10000u, 100000u}) {
+		BenchmarkFrame(objectCount, frameCount);
+	}
+	return TestFramework::Finish();
+}
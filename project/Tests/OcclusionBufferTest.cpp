@@ -0,0 +1,307 @@
+#include "Engine/3d/Frustum.h"
+#include "Engine/Scene/OcclusionBuffer.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 画面の1/4の解像度(main.cppと同じ)
+const uint32_t kBufferWidth = 320;
+const uint32_t kBufferHeight = 180;
+
+/// <summary>
+/// 遮蔽物にする箱の三角形(12枚)を追加する
+/// </summary>
+void AddBox(const AABB& box, std::vector<Vector4>& positions, std::vector<uint32_t>& indices) {
+	const uint32_t start = uint32_t(positions.size());
+	for (int k = 0; k < 8; k++) {
+		positions.push_back(Vector4(k & 1 ? box.maximum.x : box.minimum.x, k & 2 ? box.maximum.y : box.minimum.y, k & 4 ? box.maximum.z : box.minimum.z, 1.0f));
+	}
+	const uint32_t faces[12][3] = {{0, 1, 3}, {0, 3, 2}, {4, 6, 7}, {4, 7, 5}, {0, 4, 5}, {0, 5, 1}, {2, 3, 7}, {2, 7, 6}, {0, 2, 6}, {0, 6, 4}, {1, 5, 7}, {1, 7, 3}};
+	for (const auto& face : faces) {
+		for (uint32_t corner : face) {
+			indices.push_back(start + corner);
+		}
+	}
+}
+
+AABB MakeBox(const Vector3& minimum, const Vector3& maximum) { return {minimum, maximum}; }
+
+// z = 3で画面全体を覆う壁
+// 三角形ごとにピクセル全体を覆う部分だけを描くので、前面の2枚の境目(対角線)に掛かるピクセルは描かれない
+// 対角線が画面の外を通るように、壁を左上へずらして置く
+const AABB kFullScreenWall = {{-60.0f, -4.0f, 3.0f}, {4.0f, 60.0f, 3.1f}};
+
+/// <summary>
+/// positionに置いてrotateだけ回したカメラのビュープロジェクション行列(回転なしなら+zを見る)
+/// </summary>
+Matrix4x4 MakeCamera(const Vector3& position, const Vector3& rotate) {
+	Matrix4x4 view = ToMatrix4x4(InverseRigid(MakeAffineTransform({1.0f, 1.0f, 1.0f}, rotate, position)));
+	return Multiply(view, MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f));
+}
+
+/// <summary>
+/// 遮蔽物の箱を描いてHi-Zを作る
+/// </summary>
+void RenderBoxes(OcclusionBuffer& buffer, const std::vector<AABB>& boxes, const Matrix4x4& viewProjection) {
+	std::vector<Vector4> positions;
+	std::vector<uint32_t> indices;
+	for (const AABB& box : boxes) {
+		AddBox(box, positions, indices);
+	}
+	buffer.Clear();
+	buffer.RenderTriangles(positions.data(), positions.size(), sizeof(Vector4), indices.data(), indices.size(), viewProjection);
+	buffer.BuildHierarchy();
+}
+
+/// <summary>
+/// 線分from→toが、toの手前でいずれかの箱に当たるか
+/// </summary>
+bool IsSegmentBlocked(const std::vector<AABB>& boxes, const Vector3& from, const Vector3& to) {
+	const Vector3 direction = to - from;
+	for (const AABB& box : boxes) {
+		float enter = 0.0f;
+		float exit = 0.999f;
+		bool isHit = true;
+		for (int axis = 0; axis < 3 && isHit; axis++) {
+			const float origin = (&from.x)[axis];
+			const float delta = (&direction.x)[axis];
+			const float minimum = (&box.minimum.x)[axis];
+			const float maximum = (&box.maximum.x)[axis];
+			if (std::fabs(delta) < 1e-12f) {
+				isHit = origin >= minimum && origin <= maximum;
+				continue;
+			}
+			float t0 = (minimum - origin) / delta;
+			float t1 = (maximum - origin) / delta;
+			if (t0 > t1) {
+				std::swap(t0, t1);
+			}
+			enter = (std::max)(enter, t0);
+			exit = (std::min)(exit, t1);
+			isHit = enter <= exit;
+		}
+		if (isHit) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/// <summary>
+/// 柵のように並べた壁の奥にランダムな小さな箱を置き、隠れていると判定した箱を7x7x7の点からの光線で確かめる
+/// 視錐台の中にあってどの壁にも遮られない点が1つでもあれば、見える物体を取り除いたことになる
+/// </summary>
+void TestNoFalseCulling(uint32_t seed) {
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+	std::vector<AABB> walls;
+	for (int row = 0; row < 6; row++) {
+		for (float x = -40.0f; x < 40.0f; x += 5.0f) {
+			const float z = 8.0f + 6.0f * float(row) + distribution(random);
+			walls.push_back(MakeBox({x, 0.0f, z}, {x + 3.0f + distribution(random), 2.0f + distribution(random) * 2.0f, z + 0.2f}));
+		}
+	}
+	const Vector3 eye = {distribution(random) * 4.0f - 2.0f, 1.5f, -5.0f};
+	const Matrix4x4 viewProjection = MakeCamera(eye, {0.05f, distribution(random) * 0.4f - 0.2f, 0.0f});
+	const Frustum frustum = MakeFrustum(viewProjection);
+
+	std::vector<AABB> objects(4000);
+	for (AABB& object : objects) {
+		const Vector3 center = {distribution(random) * 80.0f - 40.0f, distribution(random) * 3.0f, 5.0f + distribution(random) * 45.0f};
+		const float size = 0.15f + distribution(random) * 0.4f;
+		object = MakeBox(center - Vector3{size, size, size}, center + Vector3{size, size, size});
+	}
+
+	OcclusionBuffer buffer;
+	buffer.Initialize(kBufferWidth, kBufferHeight);
+	RenderBoxes(buffer, walls, viewProjection);
+	std::vector<uint32_t> visibleIndices(objects.size());
+	const size_t frustumCount = CullAABBs(frustum, objects.data(), objects.size(), visibleIndices.data());
+	std::vector<uint32_t> frustumIndices(visibleIndices.begin(), visibleIndices.begin() + frustumCount);
+	const size_t visibleCount = buffer.FilterVisible(objects.data(), viewProjection, visibleIndices.data(), frustumCount);
+
+	std::vector<bool> isKept(objects.size(), false);
+	for (size_t i = 0; i < visibleCount; i++) {
+		isKept[visibleIndices[i]] = true;
+	}
+	int falseCullCount = 0;
+	for (uint32_t index : frustumIndices) {
+		if (isKept[index]) {
+			continue;
+		}
+		const AABB& object = objects[index];
+		bool isSeen = false;
+		for (int i = 0; i <= 6 && !isSeen; i++) {
+			for (int j = 0; j <= 6 && !isSeen; j++) {
+				for (int k = 0; k <= 6 && !isSeen; k++) {
+					const Vector3 point = {object.minimum.x + (object.maximum.x - object.minimum.x) * float(i) / 6.0f, object.minimum.y + (object.maximum.y - object.minimum.y) * float(j) / 6.0f,
+					                       object.minimum.z + (object.maximum.z - object.minimum.z) * float(k) / 6.0f};
+					isSeen = IsVisible(frustum, Sphere{point, 0.0f}) && !IsSegmentBlocked(walls, eye, point);
+				}
+			}
+		}
+		falseCullCount += isSeen ? 1 : 0;
+	}
+	const float cullRate = float(frustumCount - visibleCount) / float(frustumCount);
+	std::printf("  seed %u: %zu in frustum -> %zu visible, cull rate %.1f%%\n", seed, frustumCount, visibleCount, cullRate * 100.0f);
+	CHECK(falseCullCount == 0);
+	// 壁の奥の物体の大半は取り除ける
+	CHECK(cullRate > 0.5f);
+}
+
+/// <summary>
+/// 画面全体を覆う壁は、どのピクセルにも同じ深度を書く
+/// 境目が画面を横切るときは、境目に掛かるピクセルは描かれないか、裏側の面の深度になる(どちらも前面より奥なので安全側)
+/// </summary>
+void TestFullScreenDepth() {
+	const Matrix4x4 viewProjection = MakeCamera({0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f});
+	const float expected = Transform({0.0f, 0.0f, 3.0f}, viewProjection).z;
+	const int pixelCount = int(kBufferWidth * kBufferHeight);
+	OcclusionBuffer buffer;
+	buffer.Initialize(kBufferWidth, kBufferHeight);
+	// mismatchCountは前面より手前の深度を書いたピクセルの数、backCountは前面より奥の深度を書いたピクセルの数
+	auto countPixels = [&](const AABB& wall, int& writtenCount, int& mismatchCount, int& backCount) {
+		RenderBoxes(buffer, {wall}, viewProjection);
+		writtenCount = 0;
+		mismatchCount = 0;
+		backCount = 0;
+		for (uint32_t y = 0; y < buffer.GetHeight(); y++) {
+			for (uint32_t x = 0; x < buffer.GetWidth(); x++) {
+				const float depth = buffer.GetDepth(x, y);
+				writtenCount += depth < 1.0f ? 1 : 0;
+				mismatchCount += depth < expected - 1e-6f ? 1 : 0;
+				backCount += depth < 1.0f && depth > expected + 1e-6f ? 1 : 0;
+			}
+		}
+	};
+	int writtenCount = 0;
+	int mismatchCount = 0;
+	int backCount = 0;
+	countPixels(kFullScreenWall, writtenCount, mismatchCount, backCount);
+	CHECK(writtenCount == pixelCount);
+	CHECK(mismatchCount == 0 && backCount == 0);
+	// 対角線が画面の中央を通る壁
+	countPixels(MakeBox({-50.0f, -50.0f, 3.0f}, {50.0f, 50.0f, 3.1f}), writtenCount, mismatchCount, backCount);
+	std::printf("  diagonal across the screen: %d/%d pixels written, %d of them from the back face\n", writtenCount, pixelCount, backCount);
+	CHECK(writtenCount > pixelCount * 98 / 100);
+	CHECK(mismatchCount == 0);
+}
+
+/// <summary>
+/// 近クリップ面をまたぐ遮蔽物は描かず、近クリップ面をまたぐ物体は壁の奥でも見えるとする
+/// </summary>
+void TestNearPlane() {
+	const Matrix4x4 viewProjection = MakeCamera({0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f});
+	OcclusionBuffer buffer;
+	buffer.Initialize(kBufferWidth, kBufferHeight);
+
+	// カメラの後ろから前へ続く床(どの三角形も近クリップ面をまたぐ)
+	const std::vector<Vector4> floor = {Vector4(-5.0f, -1.0f, -5.0f), Vector4(5.0f, -1.0f, -5.0f), Vector4(5.0f, -1.0f, 20.0f), Vector4(-5.0f, -1.0f, 20.0f)};
+	const std::vector<uint32_t> floorIndices = {0, 2, 1, 0, 3, 2};
+	buffer.Clear();
+	buffer.RenderTriangles(floor.data(), floor.size(), sizeof(Vector4), floorIndices.data(), floorIndices.size(), viewProjection);
+	int writtenCount = 0;
+	for (uint32_t y = 0; y < buffer.GetHeight(); y++) {
+		for (uint32_t x = 0; x < buffer.GetWidth(); x++) {
+			writtenCount += buffer.GetDepth(x, y) < 1.0f ? 1 : 0;
+		}
+	}
+	CHECK(writtenCount == 0);
+
+	RenderBoxes(buffer, {kFullScreenWall}, viewProjection);
+	CHECK(!buffer.IsVisible(MakeBox({-0.5f, -0.5f, 5.0f}, {0.5f, 0.5f, 6.0f}), viewProjection));
+	CHECK(buffer.IsVisible(MakeBox({-0.5f, -0.5f, -1.0f}, {0.5f, 0.5f, 6.0f}), viewProjection));
+	CHECK(buffer.IsVisible(MakeBox({-0.5f, -0.5f, 0.05f}, {0.5f, 0.5f, 6.0f}), viewProjection));
+}
+
+/// <summary>
+/// 画面から一部はみ出す物体は、画面内の部分だけで判定する
+/// </summary>
+void TestPartlyOffScreen() {
+	const Matrix4x4 viewProjection = MakeCamera({0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f});
+	OcclusionBuffer buffer;
+	buffer.Initialize(kBufferWidth, kBufferHeight);
+	// z = 8での画面の半分の幅はおよそ3.3
+	const AABB leftObject = MakeBox({-10.0f, -0.5f, 8.0f}, {-2.0f, 0.5f, 9.0f});
+	const AABB rightObject = MakeBox({2.0f, -0.5f, 8.0f}, {10.0f, 0.5f, 9.0f});
+	const AABB offScreenObject = MakeBox({-30.0f, -0.5f, 8.0f}, {-20.0f, 0.5f, 9.0f});
+
+	// 画面全体を覆う壁の奥なら、はみ出していても隠れる
+	RenderBoxes(buffer, {kFullScreenWall}, viewProjection);
+	CHECK(!buffer.IsVisible(leftObject, viewProjection));
+	CHECK(!buffer.IsVisible(rightObject, viewProjection));
+
+	// 右半分だけを覆う壁なら、左の物体は見え、右の物体は隠れる
+	RenderBoxes(buffer, {MakeBox({0.0f, -50.0f, 3.0f}, {50.0f, 50.0f, 3.1f})}, viewProjection);
+	CHECK(buffer.IsVisible(leftObject, viewProjection));
+	CHECK(!buffer.IsVisible(rightObject, viewProjection));
+
+	// 遮蔽物がなくても、画面の外の物体は見えない
+	buffer.Clear();
+	buffer.BuildHierarchy();
+	CHECK(buffer.IsVisible(leftObject, viewProjection));
+	CHECK(!buffer.IsVisible(offScreenObject, viewProjection));
+}
+
+/// <summary>
+/// モデルを遮蔽物として描いても、モデル自身のAABBと、カメラを向いた面(描いた深度とちょうど同じ深さ)は隠れない
+/// </summary>
+void TestSelfOcclusion() {
+	const AABB localBox = MakeBox({-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f});
+	std::vector<Vector4> positions;
+	ModelData modelData;
+	AddBox(localBox, positions, modelData.indices);
+	for (const Vector4& position : positions) {
+		modelData.vertices.push_back({position, {0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}});
+	}
+
+	const Vector3 cameraPosition = {0.0f, 0.5f, 0.0f};
+	const Matrix4x4 viewProjection = MakeCamera(cameraPosition, {0.1f, 0.0f, 0.0f});
+	OcclusionBuffer buffer;
+	buffer.Initialize(kBufferWidth, kBufferHeight);
+	int facingCount = 0;
+	for (float angle : {0.0f, 0.4f, 0.785f, 1.2f, 2.5f}) {
+		const Matrix4x4 world = MakeAffineMatrix({1.0f, 1.0f, 1.0f}, {angle * 0.3f, angle, angle * 0.5f}, {0.5f, 0.0f, 6.0f});
+		const Matrix4x4 worldViewProjection = Multiply(world, viewProjection);
+		buffer.Clear();
+		buffer.RenderOccluder(modelData, 0, worldViewProjection);
+		buffer.BuildHierarchy();
+		CHECK(buffer.GetDepth(kBufferWidth / 2 + 20, kBufferHeight / 2 + 10) < 1.0f);
+		CHECK(buffer.IsVisible(localBox, worldViewProjection));
+		// 面ごとの厚さのないAABB
+		for (int axis = 0; axis < 3; axis++) {
+			for (float side : {-1.0f, 1.0f}) {
+				AABB face = localBox;
+				(&face.minimum.x)[axis] = side;
+				(&face.maximum.x)[axis] = side;
+				Vector3 center = {0.0f, 0.0f, 0.0f};
+				(&center.x)[axis] = side;
+				const Vector3 worldCenter = Transform(center, world);
+				const Vector3 normal = {world.m[axis][0] * side, world.m[axis][1] * side, world.m[axis][2] * side};
+				if (Dot(normal, cameraPosition - worldCenter) > 0.0f) {
+					facingCount++;
+					CHECK(buffer.IsVisible(face, worldViewProjection));
+				}
+			}
+		}
+	}
+	CHECK(facingCount >= 5);
+}
+
+} // namespace
+
+int main() {
+	std::printf("ENGINE_USE_SSE=%d\n", ENGINE_USE_SSE);
+	TestFramework::Run("full-screen wall writes a constant depth", TestFullScreenDepth);
+	TestFramework::Run("culled objects are hidden from every sample point (seed 1)", [] { TestNoFalseCulling(1); });
+	TestFramework::Run("culled objects are hidden from every sample point (seed 2)", [] { TestNoFalseCulling(2); });
+	TestFramework::Run("culled objects are hidden from every sample point (seed 3)", [] { TestNoFalseCulling(3); });
+	TestFramework::Run("near-plane straddling occluders and occludees", TestNearPlane);
+	TestFramework::Run("partly off-screen occludees", TestPartlyOffScreen);
+	TestFramework::Run("a model does not occlude itself", TestSelfOcclusion);
+	return TestFramework::Finish();
+}
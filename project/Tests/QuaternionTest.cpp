@@ -0,0 +1,198 @@
+#include "Engine/3d/Quaternion.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// 成分の差の最大
+float MaxDifference(const Matrix4x4& a, const Matrix4x4& b) {
+	float difference = 0.0f;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			difference = (std::max)(difference, std::fabs(a.m[i][j] - b.m[i][j]));
+		}
+	}
+	return difference;
+}
+
+// 2つの単位クォータニオンの回転の違い(同じ回転なら0。qと-qは同じ回転)
+float RotationDifference(const Quaternion& a, const Quaternion& b) { return 1.0f - std::fabs(Dot(a, b)); }
+
+// 2つの単位クォータニオンの間の回転角(同じ回転の近くではacosの誤差が大きいので、倍精度でatan2から求める)
+double AngleBetween(const Quaternion& a, const Quaternion& b) {
+	const double dot = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z + double(a.w) * b.w;
+	const double sine = std::sqrt((std::max)(0.0, (double(a.x) * a.x + double(a.y) * a.y + double(a.z) * a.z + double(a.w) * a.w) * (double(b.x) * b.x + double(b.y) * b.y + double(b.z) * b.z + double(b.w) * b.w) - dot * dot));
+	return 2.0 * std::atan2(sine, std::fabs(dot));
+}
+
+/// <summary>
+/// ランダムなオイラー角と、同じ回転のクォータニオン
+/// </summary>
+struct RandomRotation {
+	Vector3 euler;
+	Quaternion quaternion;
+};
+
+class RotationGenerator {
+public:
+	RotationGenerator() : random(9), angle(-3.14f, 3.14f) {}
+	RandomRotation Next() {
+		Vector3 euler = NextVector();
+		return {euler, MakeRotateXYZQuaternion(euler)};
+	}
+	Vector3 NextVector() { return {angle(random), angle(random), angle(random)}; }
+	float NextUnit() { return unit(random); }
+
+private:
+	std::mt19937 random;
+	std::uniform_real_distribution<float> angle;
+	std::uniform_real_distribution<float> unit;
+};
+
+const int kIterationCount = 100000;
+
+/// <summary>
+/// オイラー角から作ったクォータニオンは、MakeRotateXYZMatrixと同じ回転になる
+/// </summary>
+void TestMatchesEulerMatrix() {
+	RotationGenerator generator;
+	float matrixError = 0.0f;
+	float vectorError = 0.0f;
+	float unitError = 0.0f;
+	for (int i = 0; i < kIterationCount; i++) {
+		RandomRotation rotation = generator.Next();
+		Matrix4x4 eulerMatrix = MakeRotateXYZMatrix(rotation.euler);
+		matrixError = (std::max)(matrixError, MaxDifference(MakeRotateMatrix(rotation.quaternion), eulerMatrix));
+		Vector3 vector = generator.NextVector();
+		vectorError = (std::max)(vectorError, Length(RotateVector(vector, rotation.quaternion) - Transform(vector, eulerMatrix)) / (std::max)(Length(vector), 1e-3f));
+		unitError = (std::max)(unitError, std::fabs(Length(rotation.quaternion) - 1.0f));
+	}
+	std::printf("  max error: matrix %.2e, rotated vector %.2e, length %.2e\n", matrixError, vectorError, unitError);
+	CHECK(matrixError < 1e-5f);
+	CHECK(vectorError < 1e-5f);
+	CHECK(unitError < 1e-6f);
+}
+
+/// <summary>
+/// 回転行列から戻したクォータニオンは、元のクォータニオンと同じ回転になる(4通りの分岐を全て通る)
+/// </summary>
+void TestFromMatrix() {
+	RotationGenerator generator;
+	float error = 0.0f;
+	for (int i = 0; i < kIterationCount; i++) {
+		RandomRotation rotation = generator.Next();
+		error = (std::max)(error, RotationDifference(MakeQuaternionFromMatrix(MakeRotateXYZMatrix(rotation.euler)), rotation.quaternion));
+	}
+	// 軸周りに180度回す行列(トレースが-1になる場合)
+	for (const Vector3& euler : {Vector3{3.14159265f, 0.0f, 0.0f}, Vector3{0.0f, 3.14159265f, 0.0f}, Vector3{0.0f, 0.0f, 3.14159265f}}) {
+		error = (std::max)(error, RotationDifference(MakeQuaternionFromMatrix(MakeRotateXYZMatrix(euler)), MakeRotateXYZQuaternion(euler)));
+	}
+	std::printf("  max error %.2e\n", error);
+	CHECK(error < 1e-6f);
+}
+
+/// <summary>
+/// クォータニオンの積は、回転行列の積と同じ順で回転を合成する
+/// </summary>
+void TestMultiplyMatchesMatrixMultiply() {
+	RotationGenerator generator;
+	float error = 0.0f;
+	for (int i = 0; i < kIterationCount; i++) {
+		RandomRotation first = generator.Next();
+		RandomRotation second = generator.Next();
+		Matrix4x4 expected = Multiply(MakeRotateXYZMatrix(first.euler), MakeRotateXYZMatrix(second.euler));
+		error = (std::max)(error, MaxDifference(MakeRotateMatrix(Multiply(first.quaternion, second.quaternion)), expected));
+	}
+	std::printf("  max error %.2e\n", error);
+	CHECK(error < 1e-5f);
+	RandomRotation rotation = generator.Next();
+	CHECK(RotationDifference(Multiply(rotation.quaternion, Inverse(rotation.quaternion)), MakeIdentityQuaternion()) < 1e-6f);
+	CHECK(RotationDifference(Multiply(rotation.quaternion, Conjugate(rotation.quaternion)), MakeIdentityQuaternion()) < 1e-6f);
+}
+
+/// <summary>
+/// クォータニオンの回転で作ったアフィン変換は、オイラー角で作ったものと同じ
+/// </summary>
+void TestAffineMatchesEuler() {
+	RotationGenerator generator;
+	float error = 0.0f;
+	for (int i = 0; i < kIterationCount; i++) {
+		RandomRotation rotation = generator.Next();
+		Vector3 scale = {generator.NextUnit() + 0.5f, generator.NextUnit() + 0.5f, generator.NextUnit() + 0.5f};
+		Vector3 translate = generator.NextVector();
+		Matrix4x4 expected = MakeAffineMatrix(scale, rotation.euler, translate);
+		error = (std::max)(error, MaxDifference(MakeAffineMatrix(QuaternionTransforms{scale, rotation.quaternion, translate}), expected));
+		error = (std::max)(error, MaxDifference(ToMatrix4x4(MakeAffineTransform(scale, rotation.quaternion, translate)), expected));
+	}
+	std::printf("  max error %.2e\n", error);
+	CHECK(error < 1e-5f);
+}
+
+/// <summary>
+/// Slerpは回転角を補間係数に比例して進め、Nlerpと同じく単位クォータニオンを返す
+/// </summary>
+void TestInterpolation() {
+	RotationGenerator generator;
+	double angleError = 0.0;
+	float unitError = 0.0f;
+	for (int i = 0; i < kIterationCount; i++) {
+		Quaternion q0 = generator.Next().quaternion;
+		Quaternion q1 = generator.Next().quaternion;
+		float t = generator.NextUnit();
+		Quaternion slerp = Slerp(q0, q1, t);
+		angleError = (std::max)(angleError, std::fabs(AngleBetween(q0, slerp) - t * AngleBetween(q0, q1)));
+		unitError = (std::max)(unitError, std::fabs(Length(slerp) - 1.0f));
+		unitError = (std::max)(unitError, std::fabs(Length(Nlerp(q0, q1, t)) - 1.0f));
+	}
+	std::printf("  max error: angle %.2e rad, length %.2e\n", angleError, unitError);
+	CHECK(angleError < 1e-4);
+	CHECK(unitError < 1e-5f);
+	// 端点と、ほぼ同じ回転どうし(Nlerpに切り替わる場合)
+	Quaternion q = generator.Next().quaternion;
+	Quaternion nearQ = Normalize(Quaternion{q.x + 1e-5f, q.y, q.z, q.w});
+	CHECK(RotationDifference(Slerp(q, nearQ, 0.0f), q) < 1e-6f);
+	CHECK(RotationDifference(Slerp(q, nearQ, 1.0f), nearQ) < 1e-6f);
+	CHECK(std::fabs(Length(Slerp(q, nearQ, 0.5f)) - 1.0f) < 1e-5f);
+	// 内積が負でも近い方を回る
+	Quaternion negated = {-q.x, -q.y, -q.z, -q.w};
+	CHECK(RotationDifference(Slerp(q, negated, 0.5f), q) < 1e-6f);
+}
+
+/// <summary>
+/// ひねりは軸周りの回転で、振りは軸方向の成分を持たず、ひねりの後に振ると元の回転になる
+/// </summary>
+void TestSwingTwist() {
+	RotationGenerator generator;
+	float composeError = 0.0f;
+	float swingAxisError = 0.0f;
+	float twistAxisError = 0.0f;
+	for (int i = 0; i < kIterationCount; i++) {
+		Quaternion quaternion = generator.Next().quaternion;
+		Vector3 axis = Normalize(generator.NextVector());
+		Quaternion swing;
+		Quaternion twist;
+		DecomposeSwingTwist(quaternion, axis, swing, twist);
+		composeError = (std::max)(composeError, RotationDifference(Multiply(twist, swing), quaternion));
+		swingAxisError = (std::max)(swingAxisError, std::fabs(Dot(Vector3{swing.x, swing.y, swing.z}, axis)));
+		Vector3 twistVector = {twist.x, twist.y, twist.z};
+		twistAxisError = (std::max)(twistAxisError, Length(twistVector - Dot(twistVector, axis) * axis));
+	}
+	std::printf("  max error: composed %.2e, swing along axis %.2e, twist off axis %.2e\n", composeError, swingAxisError, twistAxisError);
+	CHECK(composeError < 1e-6f);
+	CHECK(swingAxisError < 1e-5f);
+	CHECK(twistAxisError < 1e-5f);
+}
+
+} // namespace
+
+int main() {
+	TestFramework::Run("MakeRotateXYZQuaternion matches MakeRotateXYZMatrix", TestMatchesEulerMatrix);
+	TestFramework::Run("MakeQuaternionFromMatrix inverts the Euler matrix", TestFromMatrix);
+	TestFramework::Run("Multiply composes like the matrix product", TestMultiplyMatchesMatrixMultiply);
+	TestFramework::Run("MakeAffineMatrix matches the Euler path", TestAffineMatchesEuler);
+	TestFramework::Run("Slerp and Nlerp", TestInterpolation);
+	TestFramework::Run("DecomposeSwingTwist", TestSwingTwist);
+	return TestFramework::Finish();
+}
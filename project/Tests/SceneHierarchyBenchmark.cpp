@@ -0,0 +1,126 @@
+#include "Engine/Scene/SceneHierarchy.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// <summary>
+/// 子へのポインタで持つ木の節(比較用。ヒープのばらばらな位置に確保する)
+/// </summary>
+struct Node {
+	AffineTransform local;
+	AffineTransform world;
+	std::vector<Node*> children;
+};
+
+void UpdateRecursive(Node* node, const AffineTransform* parentWorld) {
+	node->world = parentWorld ? Multiply(node->local, *parentWorld) : node->local;
+	for (Node* child : node->children) {
+		UpdateRecursive(child, &node->world);
+	}
+}
+
+Transforms MakeRandomTransforms(std::mt19937& random) {
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	return {{1.0f + 0.05f * distribution(random), 1.0f + 0.05f * distribution(random), 1.0f + 0.05f * distribution(random)},
+	        {distribution(random), distribution(random), distribution(random)},
+	        {distribution(random), distribution(random), distribution(random)}};
+}
+
+/// <summary>
+/// count個の物体の木で、変更した割合ごとにSceneHierarchy::Updateと、ポインタの木を根から全て再帰でなめる場合の時間を測る
+/// </summary>
+void BenchmarkTree(uint32_t count, bool isDeep, uint32_t frameCount) {
+	std::mt19937 random(7);
+	SceneHierarchy hierarchy;
+	hierarchy.Reserve(count);
+	std::vector<int32_t> parents(count);
+	for (uint32_t i = 0; i < count; i++) {
+		int32_t parent = SceneHierarchy::kNoParent;
+		if (i > 0 && random() % 1000 != 0) {
+			parent = isDeep ? int32_t(i) - 1 - int32_t(random() % (std::min)(i, 4u)) : int32_t(random() % i);
+		}
+		parents[i] = parent;
+		hierarchy.Add(parent, MakeRandomTransforms(random));
+	}
+	// 節を確保する順をばらばらにする
+	std::vector<uint32_t> allocationOrder(count);
+	for (uint32_t i = 0; i < count; i++) {
+		allocationOrder[i] = i;
+	}
+	std::shuffle(allocationOrder.begin(), allocationOrder.end(), random);
+	std::vector<std::unique_ptr<Node>> nodes(count);
+	for (uint32_t i : allocationOrder) {
+		nodes[i] = std::make_unique<Node>();
+	}
+	std::vector<Node*> roots;
+	for (uint32_t i = 0; i < count; i++) {
+		nodes[i]->local = hierarchy.GetLocal(i);
+		if (parents[i] == SceneHierarchy::kNoParent) {
+			roots.push_back(nodes[i].get());
+		} else {
+			nodes[parents[i]]->children.push_back(nodes[i].get());
+		}
+	}
+
+	std::printf("%s tree, %u objects\n", isDeep ? "deep" : "wide", count);
+	size_t updatedCount = 0;
+	double flatTime = TestFramework::MeasureMilliseconds([&] { updatedCount = hierarchy.Update(); });
+	double recursiveTime = TestFramework::MeasureMilliseconds([&] {
+		for (Node* root : roots) {
+			UpdateRecursive(root, nullptr);
+		}
+	});
+	std::printf("  all dirty:   Update %8.3f ms (%6zu recomputed), recursion %8.3f ms\n", flatTime, updatedCount, recursiveTime);
+
+	for (double dirtyRatio : {0.0, 0.0001, 0.01, 0.1}) {
+		const uint32_t dirtyCount = uint32_t(double(count) * dirtyRatio);
+		std::vector<uint32_t> dirtyIndices(dirtyCount * frameCount);
+		std::vector<AffineTransform> dirtyLocals(dirtyIndices.size());
+		for (size_t k = 0; k < dirtyIndices.size(); k++) {
+			dirtyIndices[k] = uint32_t(random() % count);
+			const Transforms transforms = MakeRandomTransforms(random);
+			dirtyLocals[k] = MakeAffineTransform(transforms.scale, transforms.rotate, transforms.translate);
+		}
+		flatTime = 0.0;
+		recursiveTime = 0.0;
+		updatedCount = 0;
+		for (uint32_t frame = 0; frame < frameCount; frame++) {
+			flatTime += TestFramework::MeasureMilliseconds([&] {
+				for (uint32_t k = frame * dirtyCount; k < (frame + 1) * dirtyCount; k++) {
+					hierarchy.SetLocal(dirtyIndices[k], dirtyLocals[k]);
+				}
+				updatedCount += hierarchy.Update();
+			});
+			// 素朴な方法は、どこが変わったかを持たずに毎フレーム全体をなめる
+			recursiveTime += TestFramework::MeasureMilliseconds([&] {
+				for (uint32_t k = frame * dirtyCount; k < (frame + 1) * dirtyCount; k++) {
+					nodes[dirtyIndices[k]]->local = dirtyLocals[k];
+				}
+				for (Node* root : roots) {
+					UpdateRecursive(root, nullptr);
+				}
+			});
+		}
+		std::printf("  %6.2f%% dirty: Update %8.3f ms (%6zu recomputed), recursion %8.3f ms\n", dirtyRatio * 100.0, flatTime / frameCount, updatedCount / frameCount, recursiveTime / frameCount);
+	}
+}
+
+} // namespace
+
+/// <summary>
+/// SceneHierarchy::Updateと、ポインタでつないだ木を再帰でなめる場合の1フレームあたりの時間を比べる
+/// EngineにリンクしたSceneHierarchyBenchmark(SSE)とEngineScalarにリンクしたSceneHierarchyBenchmarkScalarを比べる
+/// 使い方: SceneHierarchyBenchmark [物体の数(既定200000)]
+/// </summary>
+int main(int argc, char** argv) {
+	const uint32_t count = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 200000;
+	std::printf("ENGINE_USE_SSE=%d\n", ENGINE_USE_SSE);
+	BenchmarkTree(count, false, 10);
+	BenchmarkTree(count, true, 10);
+	return TestFramework::Finish();
+}
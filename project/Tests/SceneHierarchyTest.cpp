@@ -0,0 +1,188 @@
+#include "Engine/Scene/SceneHierarchy.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+/// <summary>
+/// 子の番号の配列で持つ比較用の木。根から再帰でワールド変換を求める
+/// </summary>
+struct ReferenceTree {
+	std::vector<std::vector<uint32_t>> children;
+	std::vector<uint32_t> roots;
+	std::vector<AffineTransform> localTransforms;
+	std::vector<AffineTransform> worldTransforms;
+	std::vector<uint8_t> isDirty;
+	std::vector<uint8_t> isChanged;
+
+	uint32_t Add(int32_t parent, const AffineTransform& local) {
+		const uint32_t index = uint32_t(localTransforms.size());
+		children.emplace_back();
+		(parent == SceneHierarchy::kNoParent ? roots : children[parent]).push_back(index);
+		localTransforms.push_back(local);
+		worldTransforms.push_back(local);
+		isDirty.push_back(1);
+		isChanged.push_back(0);
+		return index;
+	}
+
+	/// <summary>
+	/// 全ての物体のワールド変換を求め直し、変更した物体とその子孫に印を付ける
+	/// </summary>
+	void Update() {
+		for (uint32_t root : roots) {
+			Walk(root, nullptr, false);
+		}
+		std::fill(isDirty.begin(), isDirty.end(), uint8_t(0));
+	}
+
+	void Walk(uint32_t index, const AffineTransform* parentWorld, bool isParentChanged) {
+		worldTransforms[index] = parentWorld ? Multiply(localTransforms[index], *parentWorld) : localTransforms[index];
+		isChanged[index] = isDirty[index] || isParentChanged;
+		for (uint32_t child : children[index]) {
+			Walk(child, &worldTransforms[index], isChanged[index] != 0);
+		}
+	}
+};
+
+Transforms MakeRandomTransforms(std::mt19937& random) {
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+	return {{1.0f + 0.05f * distribution(random), 1.0f + 0.05f * distribution(random), 1.0f + 0.05f * distribution(random)},
+	        {distribution(random), distribution(random), distribution(random)},
+	        {distribution(random), distribution(random), distribution(random)}};
+}
+
+/// <summary>
+/// Updateの結果(ワールド変換、変わった印、計算し直した数)が比較用の木と一致するか
+/// </summary>
+bool MatchesReference(const SceneHierarchy& hierarchy, const ReferenceTree& reference, size_t updatedCount) {
+	size_t changedCount = 0;
+	int worldMismatchCount = 0;
+	int changedMismatchCount = 0;
+	for (uint32_t i = 0; i < hierarchy.GetCount(); i++) {
+		// 同じ順で同じ関数を呼ぶので、ビットまで一致する
+		worldMismatchCount += std::memcmp(&hierarchy.GetWorld(i), &reference.worldTransforms[i], sizeof(AffineTransform)) == 0 ? 0 : 1;
+		changedMismatchCount += hierarchy.IsWorldChanged(i) == (reference.isChanged[i] != 0) ? 0 : 1;
+		changedCount += reference.isChanged[i];
+	}
+	CHECK(worldMismatchCount == 0);
+	CHECK(changedMismatchCount == 0);
+	CHECK(updatedCount == changedCount);
+	return worldMismatchCount == 0 && changedMismatchCount == 0 && updatedCount == changedCount;
+}
+
+/// <summary>
+/// 横に広い木(親は前の物体からランダム)と縦に深い木(親は直前の数個から)を作り、
+/// 何フレームか一部の物体を変更して、Updateを再帰で求めた結果と比べる
+/// 変更する位置をフレームごとに前後させ、前回立てた印を下ろす範囲(firstChanged)と計算する範囲(firstDirty)が食い違う場合も確かめる
+/// </summary>
+void TestRandomTree(uint32_t seed, bool isDeep) {
+	const uint32_t kCount = 5000;
+	std::mt19937 random(seed);
+	SceneHierarchy hierarchy;
+	ReferenceTree reference;
+	hierarchy.Reserve(kCount);
+	for (uint32_t i = 0; i < kCount; i++) {
+		int32_t parent = SceneHierarchy::kNoParent;
+		if (i > 0 && random() % 200 != 0) {
+			parent = isDeep ? int32_t(i) - 1 - int32_t(random() % (std::min)(i, 4u)) : int32_t(random() % i);
+		}
+		hierarchy.Add(parent, MakeRandomTransforms(random));
+		reference.Add(parent, hierarchy.GetLocal(i));
+	}
+	size_t updatedCount = hierarchy.Update();
+	reference.Update();
+	CHECK(updatedCount == kCount);
+	if (!MatchesReference(hierarchy, reference, updatedCount)) {
+		return;
+	}
+
+	// 変更する物体の数と、番号の範囲(前半、後半、全体)
+	struct Frame {
+		uint32_t dirtyCount;
+		uint32_t begin;
+		uint32_t end;
+	};
+	const Frame frames[] = {
+	    {0, 0, kCount},     {1, kCount - 1, kCount}, {3, kCount / 2, kCount}, {5, 0, kCount / 10}, {2, kCount * 9 / 10, kCount}, {0, 0, kCount},
+	    {50, 0, kCount},    {1, 0, 1},               {0, 0, kCount},          {500, 0, kCount},    {4, kCount / 3, kCount / 2},   {1, kCount - 1, kCount},
+	};
+	for (const Frame& frame : frames) {
+		for (uint32_t k = 0; k < frame.dirtyCount; k++) {
+			const uint32_t index = frame.begin + uint32_t(random() % (frame.end - frame.begin));
+			hierarchy.SetLocal(index, MakeRandomTransforms(random));
+			reference.localTransforms[index] = hierarchy.GetLocal(index);
+			reference.isDirty[index] = 1;
+		}
+		updatedCount = hierarchy.Update();
+		reference.Update();
+		if (!MatchesReference(hierarchy, reference, updatedCount)) {
+			return;
+		}
+	}
+
+	// Updateの後に追加した物体は、次のUpdateで計算される
+	const uint32_t added = hierarchy.Add(int32_t(kCount / 2), MakeRandomTransforms(random));
+	reference.Add(int32_t(kCount / 2), hierarchy.GetLocal(added));
+	updatedCount = hierarchy.Update();
+	reference.Update();
+	CHECK(updatedCount == 1);
+	MatchesReference(hierarchy, reference, updatedCount);
+}
+
+/// <summary>
+/// 親の変更は子孫にだけ伝わり、変更のないフレームでは印が全て下りる
+/// </summary>
+void TestChangePropagation() {
+	SceneHierarchy hierarchy;
+	const Transforms identity = {{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+	const uint32_t root = hierarchy.Add(SceneHierarchy::kNoParent, identity);
+	const uint32_t child = hierarchy.Add(int32_t(root), {{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}});
+	const uint32_t sibling = hierarchy.Add(int32_t(root), identity);
+	const uint32_t grandchild = hierarchy.Add(int32_t(child), {{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 2.0f, 0.0f}});
+	const uint32_t other = hierarchy.Add(SceneHierarchy::kNoParent, identity);
+	CHECK(hierarchy.Update() == 5);
+
+	hierarchy.SetLocal(root, Transforms{{2.0f, 2.0f, 2.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 5.0f}});
+	CHECK(hierarchy.Update() == 4);
+	CHECK(hierarchy.IsWorldChanged(root) && hierarchy.IsWorldChanged(child) && hierarchy.IsWorldChanged(sibling) && hierarchy.IsWorldChanged(grandchild));
+	CHECK(!hierarchy.IsWorldChanged(other));
+	// 孫のワールド座標は(1, 2, 0)を2倍して(0, 0, 5)ずらした位置
+	const AffineTransform& world = hierarchy.GetWorld(grandchild);
+	CHECK(world.translate.x == 2.0f && world.translate.y == 4.0f && world.translate.z == 5.0f);
+
+	hierarchy.SetLocal(grandchild, identity);
+	CHECK(hierarchy.Update() == 1);
+	CHECK(!hierarchy.IsWorldChanged(root) && !hierarchy.IsWorldChanged(child) && !hierarchy.IsWorldChanged(sibling));
+	CHECK(hierarchy.IsWorldChanged(grandchild));
+
+	CHECK(hierarchy.Update() == 0);
+	for (uint32_t i = 0; i < hierarchy.GetCount(); i++) {
+		CHECK(!hierarchy.IsWorldChanged(i));
+	}
+
+	hierarchy.Clear();
+	CHECK(hierarchy.GetCount() == 0);
+	CHECK(hierarchy.Update() == 0);
+	hierarchy.Add(SceneHierarchy::kNoParent, identity);
+	CHECK(hierarchy.Update() == 1 && hierarchy.IsWorldChanged(0));
+}
+
+} // namespace
+
+/// <summary>
+/// SceneHierarchyを再帰で求めた結果と比べる
+/// ENGINE_USE_SSEを1にしたEngineと0にしたEngineScalarの両方にリンクしてビルドし、どちらの実装も確かめる
+/// </summary>
+int main() {
+	std::printf("ENGINE_USE_SSE=%d\n", ENGINE_USE_SSE);
+	TestFramework::Run("changes propagate to descendants only", TestChangePropagation);
+	TestFramework::Run("wide random tree matches recursion (seed 1)", [] { TestRandomTree(1, false); });
+	TestFramework::Run("wide random tree matches recursion (seed 2)", [] { TestRandomTree(2, false); });
+	TestFramework::Run("deep random tree matches recursion (seed 1)", [] { TestRandomTree(1, true); });
+	TestFramework::Run("deep random tree matches recursion (seed 2)", [] { TestRandomTree(2, true); });
+	return TestFramework::Finish();
+}
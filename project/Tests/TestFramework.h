@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+
+/// <summary>
+/// テストとベンチマークで使う最小限の道具
+/// </summary>
+namespace TestFramework {
+
+// 失敗したチェックの数
+inline int& GetFailureCount() {
+	static int failureCount = 0;
+	return failureCount;
+}
+
+inline bool Check(bool condition, const char* expression, const char* file, int line) {
+	if (!condition) {
+		std::printf("%s(%d): CHECK failed: %s\n", file, line, expression);
+		GetFailureCount()++;
+	}
+	return condition;
+}
+
+/// <summary>
+/// テストを1つ実行し、失敗の数が増えたかを表示する
+/// </summary>
+template<class Function> void Run(const char* name, Function function) {
+	int failureCount = GetFailureCount();
+	function();
+	std::printf("[%s] %s\n", GetFailureCount() == failureCount ? "  OK  " : "FAILED", name);
+}
+
+// mainの戻り値(失敗があれば1)
+inline int Finish() {
+	std::printf("%d failure(s)\n", GetFailureCount());
+	return GetFailureCount() == 0 ? 0 : 1;
+}
+
+/// <summary>
+/// 処理にかかった時間を測る(ミリ秒)
+/// </summary>
+template<class Function> double MeasureMilliseconds(Function function) {
+	auto start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace TestFramework
+
+#define CHECK(condition) TestFramework::Check((condition), #condition, __FILE__, __LINE__)
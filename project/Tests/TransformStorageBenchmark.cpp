@@ -0,0 +1,95 @@
+#include "Engine/Scene/TransformStorage.h"
+#include "TestFramework.h"
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 定数バッファとして使うときの物体ごとの間隔
+const size_t kStride = 256;
+
+Matrix4x4 MakeViewProjection(float yaw) {
+	const Matrix4x4 view = ToMatrix4x4(InverseRigid(MakeAffineTransform({1.0f, 1.0f, 1.0f}, {0.1f, yaw, 0.0f}, {0.0f, 0.0f, -50.0f})));
+	return Multiply(view, MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 1000.0f));
+}
+
+} // namespace
+
+/// <summary>
+/// TransformStorage::Updateの1回あたりの時間を、変更のある物体とカメラの動きの組み合わせごとに測る
+/// 比較のため、物体ごとにMakeAffineMatrixとMultiplyで求めて書き込む場合も測る
+/// EngineにリンクしたTransformStorageBenchmark(SSE)とEngineScalarにリンクしたTransformStorageBenchmarkScalarを比べる
+/// 使い方: TransformStorageBenchmark [物体の数(既定100000)]
+/// </summary>
+int main(int argc, char** argv) {
+	const uint32_t count = argc > 1 ? uint32_t(std::strtoul(argv[1], nullptr, 10)) : 100000;
+	const int kRepeatCount = 20;
+	std::printf("ENGINE_USE_SSE=%d, %u objects, stride %zu, %d repeats\n", ENGINE_USE_SSE, count, kStride, kRepeatCount);
+	std::mt19937 random(4);
+	std::uniform_real_distribution<float> distribution(-3.0f, 3.0f);
+	std::vector<Transforms> transforms(count);
+	for (Transforms& value : transforms) {
+		value = {{distribution(random) + 4.0f, distribution(random) + 4.0f, distribution(random) + 4.0f},
+		         {distribution(random), distribution(random), distribution(random)},
+		         {distribution(random) * 10.0f, distribution(random), distribution(random)}};
+	}
+	std::vector<unsigned char> destination(kStride * count);
+	TransformStorage storage;
+	storage.Reserve(count);
+	for (const Transforms& value : transforms) {
+		storage.Add(value);
+	}
+	float yaw = 0.0f;
+	storage.Update(MakeViewProjection(yaw), destination.data(), kStride);
+
+	// prepareで物体とカメラを変えてから、Updateだけを測る
+	auto measure = [&](const char* label, auto prepare) {
+		double time = 0.0;
+		size_t writeCount = 0;
+		for (int r = 0; r < kRepeatCount; r++) {
+			const Matrix4x4 viewProjection = prepare(r);
+			time += TestFramework::MeasureMilliseconds([&] { writeCount = storage.Update(viewProjection, destination.data(), kStride); });
+		}
+		std::printf("%-32s %8.3f ms (%zu written)\n", label, time / kRepeatCount, writeCount);
+	};
+	auto touch = [&](uint32_t step) {
+		for (uint32_t i = 0; i < count; i += step) {
+			transforms[i].rotate.y += 0.01f;
+			storage.SetRotate(i, transforms[i].rotate);
+		}
+	};
+	measure("all dirty, static camera", [&](int) {
+		touch(1);
+		return MakeViewProjection(yaw);
+	});
+	measure("camera moved, none dirty", [&](int) {
+		yaw += 0.01f;
+		return MakeViewProjection(yaw);
+	});
+	measure("1% dirty, static camera", [&](int) {
+		touch(100);
+		return MakeViewProjection(yaw);
+	});
+	measure("nothing changed", [&](int) { return MakeViewProjection(yaw); });
+	measure("all dirty, camera moved", [&](int) {
+		touch(1);
+		yaw += 0.01f;
+		return MakeViewProjection(yaw);
+	});
+
+	// 変更の有無を持たず、毎フレーム物体ごとに求める
+	const Matrix4x4 viewProjection = MakeViewProjection(yaw);
+	const double naiveTime = TestFramework::MeasureMilliseconds([&] {
+		for (int r = 0; r < kRepeatCount; r++) {
+			for (uint32_t i = 0; i < count; i++) {
+				TransformationMatrix* output = reinterpret_cast<TransformationMatrix*>(destination.data() + kStride * i);
+				const Matrix4x4 world = MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+				output->world = world;
+				output->WVP = Multiply(world, viewProjection);
+			}
+		}
+	});
+	std::printf("%-32s %8.3f ms\n", "naive per-object loop", naiveTime / kRepeatCount);
+	return TestFramework::Finish();
+}
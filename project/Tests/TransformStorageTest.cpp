@@ -0,0 +1,261 @@
+#include "Engine/Scene/TransformStorage.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 定数バッファとして使うときの物体ごとの間隔
+const size_t kStride = 256;
+
+/// <summary>
+/// 2つの行列の差の最大値(大きい成分では相対誤差)
+/// </summary>
+double MaxError(const Matrix4x4& actual, const Matrix4x4& expected) {
+	double maxError = 0.0;
+	for (int i = 0; i < 4; i++) {
+		for (int j = 0; j < 4; j++) {
+			maxError = (std::max)(maxError, std::fabs(double(actual.m[i][j]) - expected.m[i][j]) / (1.0 + std::fabs(expected.m[i][j])));
+		}
+	}
+	return maxError;
+}
+
+Matrix4x4 MakeViewProjection(float yaw) {
+	const Matrix4x4 view = ToMatrix4x4(InverseRigid(MakeAffineTransform({1.0f, 1.0f, 1.0f}, {0.1f, yaw, 0.0f}, {0.0f, 0.0f, -50.0f})));
+	return Multiply(view, MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 1000.0f));
+}
+
+/// <summary>
+/// TransformStorageと同じ物体を持ち、MakeAffineMatrixとMultiplyで1つずつ期待値を求める
+/// </summary>
+struct Scene {
+	TransformStorage storage;
+	std::vector<Transforms> transforms;
+	std::vector<Matrix4x4> localMatrices;
+	std::vector<bool> hasLocalMatrix;
+
+	void Add(const Transforms& value) {
+		storage.Add(value);
+		transforms.push_back(value);
+		localMatrices.push_back(MakeIdentity4x4());
+		hasLocalMatrix.push_back(false);
+	}
+
+	void SetLocalMatrix(uint32_t index, const Matrix4x4& localMatrix) {
+		storage.SetLocalMatrix(index, localMatrix);
+		localMatrices[index] = localMatrix;
+		hasLocalMatrix[index] = true;
+	}
+
+	/// <summary>
+	/// 書き込み先のindex番目が期待値と合っているか(誤差の最大値を返す)
+	/// </summary>
+	double Compare(const unsigned char* destination, size_t stride, uint32_t index, const Matrix4x4& viewProjection) const {
+		const Transforms& value = transforms[index];
+		const Matrix4x4 world = MakeAffineMatrix(value.scale, value.rotate, value.translate);
+		Matrix4x4 wvp = Multiply(world, viewProjection);
+		if (hasLocalMatrix[index]) {
+			wvp = Multiply(localMatrices[index], wvp);
+		}
+		TransformationMatrix output;
+		std::memcpy(&output, destination + stride * index, sizeof(output));
+		return (std::max)({MaxError(output.world, world), MaxError(output.WVP, wvp), MaxError(storage.GetWorldMatrix(index), world)});
+	}
+
+	double CompareAll(const unsigned char* destination, size_t stride, const Matrix4x4& viewProjection) const {
+		double maxError = 0.0;
+		for (uint32_t i = 0; i < transforms.size(); i++) {
+			maxError = (std::max)(maxError, Compare(destination, stride, i, viewProjection));
+		}
+		return maxError;
+	}
+};
+
+Transforms MakeRandomTransforms(std::mt19937& random) {
+	std::uniform_real_distribution<float> distribution(-3.0f, 3.0f);
+	return {{distribution(random) + 4.0f, distribution(random) + 4.0f, distribution(random) + 4.0f},
+	        {distribution(random), distribution(random), distribution(random)},
+	        {distribution(random) * 10.0f, distribution(random), distribution(random)}};
+}
+
+// 書き込まれていないことを確かめるために埋めておく値
+const unsigned char kUnwritten = 0xcd;
+
+/// <summary>
+/// 全ての物体を変更したとき、一部だけ変更したとき(詰めて計算する)、カメラだけ動いたときの行列を、
+/// MakeAffineMatrixとMultiplyで1つずつ求めたものと比べる
+/// 一部だけのときは、変更のない物体の書き込み先に触らない
+/// </summary>
+void TestUpdate(uint32_t count) {
+	const double kTolerance = 1e-5;
+	std::mt19937 random(count);
+	Scene scene;
+	scene.storage.Reserve(count);
+	for (uint32_t i = 0; i < count; i++) {
+		scene.Add(MakeRandomTransforms(random));
+	}
+	std::vector<unsigned char> destination(kStride * count, kUnwritten);
+
+	// 全て変更
+	Matrix4x4 viewProjection = MakeViewProjection(0.0f);
+	CHECK(scene.storage.Update(viewProjection, destination.data(), kStride) == count);
+	double maxError = scene.CompareAll(destination.data(), kStride, viewProjection);
+	CHECK(maxError < kTolerance);
+
+	// 一部だけ変更(同じ値を設定した物体は変更に数えない)
+	std::vector<uint32_t> dirtyIndices;
+	for (uint32_t i = 0; i < count; i++) {
+		if (random() % 16 == 0) {
+			dirtyIndices.push_back(i);
+		}
+	}
+	for (uint32_t index : dirtyIndices) {
+		Transforms& value = scene.transforms[index];
+		value.translate.x += 1.0f;
+		value.rotate.y += 0.25f;
+		switch (index % 3) {
+		case 0: scene.storage.Set(index, value); break;
+		case 1: scene.storage.SetTranslate(index, value.translate); scene.storage.SetRotate(index, value.rotate); break;
+		default: scene.storage.SetRotate(index, value.rotate); scene.storage.SetTranslate(index, value.translate); scene.storage.SetScale(index, value.scale); break;
+		}
+	}
+	scene.storage.Set(count / 2, scene.transforms[count / 2]);
+	scene.storage.SetScale(count - 1, scene.transforms[count - 1].scale);
+	std::fill(destination.begin(), destination.end(), kUnwritten);
+	const size_t writeCount = scene.storage.Update(viewProjection, destination.data(), kStride);
+	CHECK(writeCount == dirtyIndices.size());
+	std::vector<bool> isDirty(count, false);
+	for (uint32_t index : dirtyIndices) {
+		isDirty[index] = true;
+		maxError = (std::max)(maxError, scene.Compare(destination.data(), kStride, index, viewProjection));
+	}
+	int touchedCount = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		if (!isDirty[i]) {
+			const unsigned char* slot = destination.data() + kStride * i;
+			touchedCount += std::all_of(slot, slot + sizeof(TransformationMatrix), [](unsigned char value) { return value == kUnwritten; }) ? 0 : 1;
+		}
+	}
+	CHECK(touchedCount == 0);
+	CHECK(maxError < kTolerance);
+
+	// 何も変わらなければ何も書かない
+	CHECK(scene.storage.Update(viewProjection, destination.data(), kStride) == 0);
+
+	// カメラだけ動いた
+	viewProjection = MakeViewProjection(0.05f);
+	CHECK(scene.storage.Update(viewProjection, destination.data(), kStride) == count);
+	maxError = (std::max)(maxError, scene.CompareAll(destination.data(), kStride, viewProjection));
+	CHECK(maxError < kTolerance);
+	std::printf("  %u objects, %zu dirty: max error %.2e\n", count, dirtyIndices.size(), maxError);
+}
+
+/// <summary>
+/// 書き込み先、間隔、ビュープロジェクション行列のどれかが前回と違えば、変更がなくても全ての物体を書き込む
+/// </summary>
+void TestFullUpdateConditions() {
+	const uint32_t kCount = 37;
+	std::mt19937 random(3);
+	Scene scene;
+	for (uint32_t i = 0; i < kCount; i++) {
+		scene.Add(MakeRandomTransforms(random));
+	}
+	const Matrix4x4 viewProjection = MakeViewProjection(0.0f);
+	std::vector<unsigned char> first(kStride * 2 * kCount, kUnwritten);
+	std::vector<unsigned char> second(kStride * 2 * kCount, kUnwritten);
+	CHECK(scene.storage.Update(viewProjection, first.data(), kStride) == kCount);
+	CHECK(scene.storage.Update(viewProjection, first.data(), kStride) == 0);
+
+	// 書き込み先が変わった(フレームごとに別のバッファを使うとき)
+	CHECK(scene.storage.Update(viewProjection, second.data(), kStride) == kCount);
+	CHECK(scene.CompareAll(second.data(), kStride, viewProjection) < 1e-5);
+	CHECK(scene.storage.Update(viewProjection, second.data(), kStride) == 0);
+
+	// 間隔が変わった
+	std::fill(second.begin(), second.end(), kUnwritten);
+	CHECK(scene.storage.Update(viewProjection, second.data(), kStride * 2) == kCount);
+	CHECK(scene.CompareAll(second.data(), kStride * 2, viewProjection) < 1e-5);
+	CHECK(scene.storage.Update(viewProjection, second.data(), kStride * 2) == 0);
+
+	// 詰めて並べる
+	CHECK(scene.storage.Update(viewProjection, second.data(), sizeof(TransformationMatrix)) == kCount);
+	CHECK(scene.CompareAll(second.data(), sizeof(TransformationMatrix), viewProjection) < 1e-5);
+
+	// ビュープロジェクション行列が1成分だけ変わった
+	Matrix4x4 moved = viewProjection;
+	moved.m[3][0] += 1e-3f;
+	CHECK(scene.storage.Update(moved, second.data(), sizeof(TransformationMatrix)) == kCount);
+	CHECK(scene.CompareAll(second.data(), sizeof(TransformationMatrix), moved) < 1e-5);
+
+	// Clearの後は前回の書き込み先を覚えていない
+	scene.storage.Clear();
+	CHECK(scene.storage.GetCount() == 0);
+	scene.storage.Add(scene.transforms[0]);
+	CHECK(scene.storage.Update(moved, second.data(), sizeof(TransformationMatrix)) == 1);
+}
+
+/// <summary>
+/// モデル座標の変換はWVPにだけ掛かり、ワールド行列には含まない
+/// 変更した物体だけを書くとき、カメラが動いて全て書くときのどちらでも掛かる
+/// </summary>
+void TestLocalMatrix() {
+	const uint32_t kCount = 11;
+	std::mt19937 random(5);
+	Scene scene;
+	for (uint32_t i = 0; i < kCount; i++) {
+		scene.Add(MakeRandomTransforms(random));
+	}
+	// 量子化した頂点を展開する行列のようなもの
+	const Matrix4x4 decode = MakeAffineMatrix({2.0f, 3.0f, 4.0f}, {0.0f, 0.0f, 0.0f}, {1.0f, 2.0f, 3.0f});
+	scene.SetLocalMatrix(2, decode);
+	scene.SetLocalMatrix(9, MakeScaleMatrix({0.5f, 0.5f, 0.5f}));
+	std::vector<unsigned char> destination(kStride * kCount, kUnwritten);
+	Matrix4x4 viewProjection = MakeViewProjection(0.0f);
+	CHECK(scene.storage.Update(viewProjection, destination.data(), kStride) == kCount);
+	CHECK(scene.CompareAll(destination.data(), kStride, viewProjection) < 1e-5);
+
+	// ワールド行列はSRTだけから求めた値のまま
+	TransformationMatrix output;
+	std::memcpy(&output, destination.data() + kStride * 2, sizeof(output));
+	const Transforms& value = scene.transforms[2];
+	CHECK(MaxError(output.world, MakeAffineMatrix(value.scale, value.rotate, value.translate)) < 1e-5);
+	CHECK(MaxError(output.WVP, Multiply(MakeAffineMatrix(value.scale, value.rotate, value.translate), viewProjection)) > 1e-2);
+
+	// 行列だけ変えても、その物体を書き直す
+	scene.SetLocalMatrix(2, MakeTranslateMatrix({0.0f, -1.0f, 0.0f}));
+	CHECK(scene.storage.Update(viewProjection, destination.data(), kStride) == 1);
+	CHECK(scene.Compare(destination.data(), kStride, 2, viewProjection) < 1e-5);
+
+	// 変更した物体だけを書く
+	scene.transforms[9].translate.y += 2.0f;
+	scene.storage.SetTranslate(9, scene.transforms[9].translate);
+	scene.transforms[4].translate.y += 2.0f;
+	scene.storage.SetTranslate(4, scene.transforms[4].translate);
+	CHECK(scene.storage.Update(viewProjection, destination.data(), kStride) == 2);
+	CHECK(scene.CompareAll(destination.data(), kStride, viewProjection) < 1e-5);
+
+	// カメラが動いて全て書く
+	viewProjection = MakeViewProjection(0.3f);
+	CHECK(scene.storage.Update(viewProjection, destination.data(), kStride) == kCount);
+	CHECK(scene.CompareAll(destination.data(), kStride, viewProjection) < 1e-5);
+}
+
+} // namespace
+
+/// <summary>
+/// TransformStorageの行列を、MakeAffineMatrixとMultiplyで1つずつ求めたものと比べる
+/// ENGINE_USE_SSEを1にしたEngineと0にしたEngineScalarの両方にリンクしてビルドし、どちらの実装も確かめる
+/// </summary>
+int main() {
+	std::printf("ENGINE_USE_SSE=%d\n", ENGINE_USE_SSE);
+	for (uint32_t count : {1u, 7u, 1000u, 1003u}) {
+		TestFramework::Run("all-dirty, partial and camera-moved updates match MakeAffineMatrix", [count] { TestUpdate(count); });
+	}
+	TestFramework::Run("a new destination, stride or view projection rewrites every object", TestFullUpdateConditions);
+	TestFramework::Run("local matrices apply only to WVP", TestLocalMatrix);
+	return TestFramework::Finish();
+}
@@ -0,0 +1,133 @@
+#include "Engine/Model/VertexQuantization.h"
+#include "TestFramework.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+
+namespace {
+
+// 半精度浮動小数点数の値を定義どおりに求める(比較用)
+float ReferenceHalfToFloat(uint16_t half) {
+	const float sign = (half & 0x8000) != 0 ? -1.0f : 1.0f;
+	const int exponent = (half >> 10) & 0x1F;
+	const int mantissa = half & 0x3FF;
+	if (exponent == 0) {
+		return sign * std::ldexp(float(mantissa), -24);
+	}
+	if (exponent == 0x1F) {
+		return mantissa != 0 ? std::numeric_limits<float>::quiet_NaN() : sign * std::numeric_limits<float>::infinity();
+	}
+	return sign * std::ldexp(float(0x400 + mantissa), exponent - 25);
+}
+
+/// <summary>
+/// 全ての半精度の値の展開が定義どおりで、圧縮し直すと同じ値に戻る
+/// </summary>
+void TestHalfDecodeAllValues() {
+	int mismatchCount = 0;
+	for (uint32_t half = 0; half <= 0xFFFF; half++) {
+		const float expected = ReferenceHalfToFloat(uint16_t(half));
+		const float decoded = HalfToFloat(uint16_t(half));
+		if (std::isnan(expected)) {
+			// NaNはNaNのまま(仮数部の値は問わない)
+			const uint16_t encoded = FloatToHalf(decoded);
+			mismatchCount += (!std::isnan(decoded) || (encoded & 0x7C00) != 0x7C00 || (encoded & 0x3FF) == 0) ? 1 : 0;
+			continue;
+		}
+		mismatchCount += std::memcmp(&expected, &decoded, sizeof(float)) != 0 ? 1 : 0;
+		mismatchCount += FloatToHalf(decoded) != half ? 1 : 0;
+	}
+	CHECK(mismatchCount == 0);
+}
+
+/// <summary>
+/// 隣り合う全ての半精度の値の中点の前後と中点で、最近接偶数丸めになる(非正規化数と無限大への桁あふれを含む)
+/// </summary>
+void TestHalfEncodeRoundsToNearestEven() {
+	int mismatchCount = 0;
+	for (uint32_t half = 0; half < 0x7C00; half++) {
+		const uint16_t next = uint16_t(half + 1);
+		const float lower = ReferenceHalfToFloat(uint16_t(half));
+		// 最大の有限値の次は、指数を1つ進めた値を上側として扱う(65536、この中点以上は無限大)
+		const float upper = next == 0x7C00 ? 65536.0f : ReferenceHalfToFloat(next);
+		const float middle = (lower + upper) * 0.5f; // 半精度より仮数部が長いので正確に表せる
+		const uint16_t even = (half & 1) == 0 ? uint16_t(half) : next;
+		for (float sign : {1.0f, -1.0f}) {
+			const uint16_t signBit = sign < 0.0f ? 0x8000 : 0;
+			mismatchCount += FloatToHalf(sign * std::nextafter(middle, 0.0f)) != (half | signBit) ? 1 : 0;
+			mismatchCount += FloatToHalf(sign * std::nextafter(middle, upper)) != (next | signBit) ? 1 : 0;
+			mismatchCount += FloatToHalf(sign * middle) != (even | signBit) ? 1 : 0;
+		}
+	}
+	CHECK(mismatchCount == 0);
+	CHECK(FloatToHalf(std::numeric_limits<float>::max()) == 0x7C00);
+	CHECK(FloatToHalf(-std::numeric_limits<float>::infinity()) == 0xFC00);
+	CHECK(FloatToHalf(std::numeric_limits<float>::denorm_min()) == 0x0000);
+	CHECK(FloatToHalf(-0.0f) == 0x8000);
+}
+
+/// <summary>
+/// 八面体に写した法線は、どの向きでも角度の誤差が小さく単位長で戻る
+/// </summary>
+void TestOctahedralNormalRoundTrip() {
+	std::mt19937 random(3);
+	std::normal_distribution<float> distribution;
+	float maxErrorDegrees = 0.0f;
+	float maxLengthError = 0.0f;
+	auto roundTrip = [&](const Vector3& normal) {
+		int16_t encoded[2];
+		EncodeOctahedralNormal(normal, encoded);
+		Vector3 decoded = DecodeOctahedralNormal(encoded);
+		float cosine = std::clamp(Dot(normal, decoded) / Length(decoded), -1.0f, 1.0f);
+		maxErrorDegrees = (std::max)(maxErrorDegrees, std::acos(cosine) * 180.0f / 3.14159265f);
+		maxLengthError = (std::max)(maxLengthError, std::fabs(Length(decoded) - 1.0f));
+	};
+	for (int i = 0; i < 1000000; i++) {
+		Vector3 normal = {distribution(random), distribution(random), distribution(random)};
+		if (Length(normal) > 1e-6f) {
+			roundTrip(Normalize(normal));
+		}
+	}
+	// 軸と、八面体の折り返しの境目(z = 0と対角線)
+	const float diagonal = 1.0f / std::sqrt(2.0f);
+	for (const Vector3& normal : {Vector3{1, 0, 0}, Vector3{-1, 0, 0}, Vector3{0, 1, 0}, Vector3{0, -1, 0}, Vector3{0, 0, 1}, Vector3{0, 0, -1}, Vector3{diagonal, diagonal, 0}, Vector3{-diagonal, 0, -diagonal},
+	                              Vector3{0, -diagonal, -diagonal}}) {
+		roundTrip(normal);
+	}
+	std::printf("  octahedral normal: max error %.4f deg, max length error %.2e\n", maxErrorDegrees, maxLengthError);
+	CHECK(maxErrorDegrees < 0.05f);
+	CHECK(maxLengthError < 1e-5f);
+}
+
+/// <summary>
+/// PackVerticesの位置の誤差は、報告した上限に収まる
+/// </summary>
+void TestPackVerticesErrorBound() {
+	std::mt19937 random(5);
+	std::normal_distribution<float> distribution;
+	std::vector<VertexData> vertices;
+	for (int i = 0; i < 10000; i++) {
+		Vector3 normal = Normalize(Vector3{distribution(random), distribution(random), distribution(random)});
+		vertices.push_back({Vector4(distribution(random) * 10.0f, distribution(random), 5.0f, 1.0f), {float(random() % 1000) / 1000.0f, 0.5f}, normal});
+	}
+	QuantizationBounds bounds{};
+	std::vector<PackedVertexData> packedVertices;
+	QuantizationErrorReport report = PackVertices(vertices, bounds, packedVertices);
+	CHECK(packedVertices.size() == vertices.size());
+	CHECK(report.maxPositionError <= report.positionErrorBound);
+	CHECK(report.maxTexcoordError < 1e-3f);
+	CHECK(report.maxNormalErrorDegrees < 0.05f);
+}
+
+} // namespace
+
+int main() {
+	static_assert(sizeof(PackedVertexData) == 16);
+	TestFramework::Run("HalfToFloat decodes every half exactly", TestHalfDecodeAllValues);
+	TestFramework::Run("FloatToHalf rounds to nearest even at every midpoint", TestHalfEncodeRoundsToNearestEven);
+	TestFramework::Run("octahedral normals round-trip", TestOctahedralNormalRoundTrip);
+	TestFramework::Run("PackVertices stays within the position error bound", TestPackVerticesErrorBound);
+	return TestFramework::Finish();
+}
@@ -1,26 +1,44 @@
+#include "Engine/3d/Frustum.h"
 #include "Engine/3d/Matrix.h"
 #include "Engine/3d/Screen.h"
 #include "Engine/3d/Vector3.h"
+#include "Engine/3d/Vector4.h"
+#include "Engine/Base/AsyncLoader.h"
+#include "Engine/Base/LinearUploadAllocator.h"
+#include "Engine/Model/MaterialLibrary.h"
+#include "Engine/Model/MeshCache.h"
+#include "Engine/Model/MeshSimplifier.h"
+#include "Engine/Model/VertexQuantization.h"
+#include "Engine/Scene/InstanceBatcher.h"
+#include "Engine/Scene/OcclusionBuffer.h"
+#include "Engine/Scene/TransformStorage.h"
+#include "DescriptorHeap.h"
 #include "Input.h"
+#include "PlacedResourceAllocator.h"
 #include "Resource.h"
 #include "WinApp.h"
 #include "extenals/DirectXTex/DirectXTex.h"
 #include <Windows.h>
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <codecvt>
 #include <cstdint>
+#include <cstring>
 #include <d3d12.h>
 #include <dbghelp.h>
 #include <dxcapi.h>
 #include <dxgi1_6.h>
 #include <dxgidebug.h>
+#include <filesystem>
 #include <format>
 #include <fstream>
 #include <locale>
 #include <math.h>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <strsafe.h>
 #include <wrl.h>
 
@@ -36,12 +54,12 @@ extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hwnd, UINT msg
 #pragma comment(lib, "dxguid.lib")
 #pragma comment(lib, "dxcompiler.lib")
 
-struct Vector4 {
-	float x, y, z, w;
-	Vector4(float x = 0.0f, float y = 0.0f, float z = 0.0f, float w = 1.0f) : x(x), y(y), z(z), w(w) {}
-	Vector4 operator+(const Vector4& other) const { return Vector4(x + other.x, y + other.y, z + other.z, w + other.w); }
-	Vector4 operator-(const Vector4& other) const { return Vector4(x - other.x, y - other.y, z - other.z, w - other.w); }
-};
+// 1フレームでGPUに転送する読み込み済みアセットの最大数
+const uint32_t kMaxAssetUploadsPerFrame = 4;
+// モデルの頂点を圧縮(PackedVertexData)してGPUに送るか
+const bool kUsePackedVertexModel = true;
+// モデルのLODを選ぶときに許容する画面上の誤差(ピクセル)
+const float kLodPixelError = 1.0f;
 
 enum BlendMode {
 	kBlendModeNone,
@@ -53,11 +71,6 @@ enum BlendMode {
 	kBlendCountblend,
 };
 
-struct VertexData {
-	Vector4 position;
-	Vector2 texcoord;
-	Vector3 normal;
-};
 struct Material {
 	Vector4 color;          // 色
 	int32_t enableLighting; // ライティングの有効化フラグ
@@ -65,26 +78,12 @@ struct Material {
 	Matrix4x4 uvTransform;  // UV変換行列
 };
 
-struct TransformationMatrix {
-	Matrix4x4 WVP;
-	Matrix4x4 world;
-};
-
 struct DirectionalLight {
 	Vector4 color;     // 光の色
 	Vector3 direction; // 光の方向
 	float intensity;   // 光の強度
 };
 
-struct MaterialData {
-	std::string textureFilePath; // テクスチャファイルのパス
-};
-
-struct ModelData {
-	std::vector<VertexData> vertices; // 頂点データ
-	MaterialData material;
-};
-
 std::string ConvertString(const std::wstring& wstr) {
 	if (wstr.empty())
 		return {};
@@ -185,9 +184,7 @@ void UploadTextureData(const Microsoft::WRL::ComPtr<ID3D12Resource>& texture, co
 	}
 }
 
-Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureResource(const Microsoft::WRL::ComPtr<ID3D12Device>& device, const DirectX::TexMetadata& metaData) {
-	assert(device != nullptr);
-
+PlacedResource CreateTextureResource(PlacedResourceAllocator& resourceAllocator, const DirectX::TexMetadata& metaData) {
 	// バッファリソースの設定
 	D3D12_RESOURCE_DESC resourceDesc{};
 	resourceDesc.Width = UINT(metaData.width);
@@ -204,25 +201,19 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureResource(const Microsoft::WR
 	heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK; // CPUからの書き込みを許可
 	heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_L0;          // メモリプールの設定
 
-	// リソースの設定
-	Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
-	HRESULT hr = device->CreateCommittedResource(
-	    &heapProperties,                   // ヒープのプロパティ
-	    D3D12_HEAP_FLAG_NONE,              // ヒープのフラグ
-	    &resourceDesc,                     // リソースの設定
+	// リソースの設定(ヒープから切り出して置く)
+	PlacedResource resource = resourceAllocator.CreateResource(
+	    heapProperties,                    // ヒープのプロパティ
+	    resourceDesc,                      // リソースの設定
 	    D3D12_RESOURCE_STATE_GENERIC_READ, // 初期状態
-	    nullptr,                           // クリア値はなし
-	    IID_PPV_ARGS(&resource)            // リソースのポインタを取得
+	    nullptr                            // クリア値はなし
 	);
 
-	assert(SUCCEEDED(hr));
+	assert(!resource.IsNull());
 	return resource;
 }
 
-Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(const Microsoft::WRL::ComPtr<ID3D12Device>& device, size_t sizeInBytes) {
-	assert(device != nullptr);
-	Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
-
+PlacedResource CreateBufferResource(PlacedResourceAllocator& resourceAllocator, size_t sizeInBytes) {
 	// アップロードヒープの設定
 	D3D12_HEAP_PROPERTIES heapProps{};
 	heapProps.Type = D3D12_HEAP_TYPE_UPLOAD;
@@ -237,8 +228,8 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(const Microsoft::WRL
 	resourceDesc.SampleDesc.Count = 1;
 	resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 
-	HRESULT hr = device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&resource));
-	assert(SUCCEEDED(hr));
+	PlacedResource resource = resourceAllocator.CreateResource(heapProps, resourceDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
+	assert(!resource.IsNull());
 	return resource;
 }
 
@@ -289,7 +280,7 @@ DirectX::ScratchImage LoadTexture(const std::string& filepath) {
 	return mipImage;
 }
 
-Microsoft::WRL::ComPtr<ID3D12Resource> CreateDepthStenecilTextureResource(const Microsoft::WRL::ComPtr<ID3D12Device>& device, int32_t width, int32_t height) {
+PlacedResource CreateDepthStenecilTextureResource(PlacedResourceAllocator& resourceAllocator, int32_t width, int32_t height) {
 	// 生成するリソースの設定
 	D3D12_RESOURCE_DESC resourceDesc{};
 	resourceDesc.Width = width;
@@ -310,115 +301,18 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateDepthStenecilTextureResource(const
 	depthClearValue.DepthStencil.Depth = 1.0f;
 	depthClearValue.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
 
-	// リソースの生成
-	Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
-	HRESULT hr = device->CreateCommittedResource(
-	    &heapProperties,                  // ヒープの設定
-	    D3D12_HEAP_FLAG_NONE,             // ヒープの特殊設定
-	    &resourceDesc,                    // リソースの設定
+	// リソースの生成(ヒープから切り出して置く)
+	PlacedResource resource = resourceAllocator.CreateResource(
+	    heapProperties,                   // ヒープの設定
+	    resourceDesc,                     // リソースの設定
 	    D3D12_RESOURCE_STATE_DEPTH_WRITE, // 深度値の書き込み可
-	    &depthClearValue,                 // クリア最適値
-	    IID_PPV_ARGS(&resource));
-	assert(SUCCEEDED(hr));
+	    &depthClearValue);                // クリア最適値
+	assert(!resource.IsNull());
 
 	return resource;
 }
 
-D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandle(const Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>& descriptorHeap, uint32_t descriptorSize, uint32_t index) {
-	D3D12_CPU_DESCRIPTOR_HANDLE handleCPU = descriptorHeap->GetCPUDescriptorHandleForHeapStart();
-	handleCPU.ptr += (descriptorSize * index);
-	return handleCPU;
-}
-
-D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandle(const Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>& descriptorHeap, uint32_t descriptorSize, uint32_t index) {
-	D3D12_GPU_DESCRIPTOR_HANDLE handleGPU = descriptorHeap->GetGPUDescriptorHandleForHeapStart();
-	handleGPU.ptr += (descriptorSize * index);
-	return handleGPU;
-}
-
-MaterialData LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename) {
-	MaterialData materialData;
-	std::string line;
-	std::ifstream file(directoryPath + "/" + filename);
-	assert(file.is_open());
-
-	while (std::getline(file, line)) {
-		std::string idenfire;
-		std::istringstream s(line);
-		s >> idenfire;
-
-		if (idenfire == "map_Kd") {
-			std::string textureFilename;
-			s >> textureFilename;
-			materialData.textureFilePath = directoryPath + "/" + textureFilename;
-		}
-	}
-	return materialData;
-}
-
-ModelData LoadObjFile(const std::string& directoryPath, const std::string& filename) {
-	ModelData modelData;
-	std::vector<Vector4> positions; // 頂点位置
-	std::vector<Vector3> normals;   // 法線ベクトル
-	std::vector<Vector2> texcoords; // テクスチャ座標
-	std::string line;
-
-	std::ifstream file(directoryPath + "/" + filename);
-	assert(file.is_open() && "Failed to open the OBJ file");
-
-	while (std::getline(file, line)) {
-		std::string identifier;
-		std::istringstream s(line);
-		s >> identifier;
-		if (identifier == "v") { // 頂点位置
-			Vector4 position;
-			s >> position.x >> position.y >> position.z;
-			position.x *= -1; // X軸を反転
-
-			position.w = 1.0f; // Homogeneous coordinate
-			positions.push_back(position);
-		} else if (identifier == "vt") { // テクスチャ座標
-			Vector2 texcoord;
-			s >> texcoord.x >> texcoord.y;
-			texcoord.x = 1.0f - texcoord.x; // X軸はそのまま
-			texcoord.y = 1.0f - texcoord.y; // Y軸を反転
-			texcoords.push_back(texcoord);
-		} else if (identifier == "vn") { // 法線ベクトル
-			Vector3 normal;
-			s >> normal.x >> normal.y >> normal.z;
-			normal.x *= -1; // X軸を反転
-			normals.push_back(normal);
-		} else if (identifier == "f") { // 面情報
-			// 面は三角形限定、他未対応
-			for (int32_t faceVertex = 0; faceVertex < 3; faceVertex++) {
-				std::string vertexDefinition;
-				s >> vertexDefinition;
-				// 頂点の情報を分解
-				std::istringstream v(vertexDefinition);
-				uint32_t elementsIndices[3]; // 頂点、テクスチャ座標、法線のインデックス
-				for (int32_t element = 0; element < 3; element++) {
-					std::string index;
-					std::getline(v, index, '/'); // '/'で区切ってインデックスを取得
-					elementsIndices[element] = std::stoi(index);
-				}
-				// 要素へのIndexから、実際の要素の値を取得して、頂点を構築する
-				Vector4 position = positions[elementsIndices[0] - 1];
-				Vector2 texcoord = texcoords[elementsIndices[1] - 1];
-				Vector3 normal = normals[elementsIndices[2] - 1];
-				VertexData vertex = {position, texcoord, normal};
-				modelData.vertices.push_back(vertex);
-			}
-		} else if (identifier == "mtllib") {
-			std::string materialFilename;
-			s >> materialFilename;
-			modelData.material = LoadMaterialTemplateFile(directoryPath, materialFilename);
-		}
-	}
-
-	return modelData;
-}
-
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR commandLine, int) {
 	SetUnhandledExceptionFilter(ExportDump); // 例外ハンドラーを設定44
 
 	HRESULT hr = CoInitializeEx(0, COINIT_MULTITHREADED);
@@ -487,6 +381,10 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// 修正: Log関数の呼び出しを正しい形式に変更
 	Log("Comlete create D3D12 Device\n");
 
+	// バッファとテクスチャは大きなヒープから切り出して置く(リソースより後に解放されるように、ここで作る)
+	PlacedResourceAllocator resourceAllocator;
+	resourceAllocator.Initialize(device);
+
 #ifdef Debug
 
 	Microsoft::WRL::ComPtr<ID3D12InfoQueue> infoQueue = nullptr;
@@ -515,7 +413,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	// 初期値0でFenceを生成
 	Microsoft::WRL::ComPtr<ID3D12Fence> fence = nullptr;
-	uint16_t fenceValue = 0;
+	uint64_t fenceValue = 0;
 	hr = device->CreateFence(fenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
 	assert(SUCCEEDED(hr));
 
@@ -593,7 +491,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	descriptionRootSignature.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT; // 入力アセンブラーでの使用を許可
 
 	// RootParameterの設定。複数設定できるので配列、今回は結果1つだけなので長さ1の配列
-	D3D12_ROOT_PARAMETER rootParameters[4] = {};
+	D3D12_ROOT_PARAMETER rootParameters[5] = {};
 	// ルートパラメーターの設定
 	rootParameters[0].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;     // ルートパラメーターのタイプ（CBV）
 	rootParameters[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;  // シェーダーの可視性（ピクセルシェーダー）
@@ -608,6 +506,9 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	rootParameters[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
 	rootParameters[3].DescriptorTable.pDescriptorRanges = descriptorRange;
 	rootParameters[3].DescriptorTable.NumDescriptorRanges = _countof(descriptorRange);
+	rootParameters[4].ParameterType = D3D12_ROOT_PARAMETER_TYPE_SRV;     // インスタンスごとの変換行列(StructuredBuffer)
+	rootParameters[4].ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX; // シェーダーの可視性（バーテックスシェーダー）
+	rootParameters[4].Descriptor.ShaderRegister = 1;                     // シェーダーレジスタのインデックス
 	descriptionRootSignature.pParameters = rootParameters;             // ルートパラメーターの配列
 	descriptionRootSignature.NumParameters = _countof(rootParameters); // ルートパラメーターの数
 
@@ -623,32 +524,55 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	descriptionRootSignature.pStaticSamplers = staticSamplers;
 	descriptionRootSignature.NumStaticSamplers = _countof(staticSamplers);
 
-	// WVP用のリソースを作る。Matrix4x4
-	Microsoft::WRL::ComPtr<ID3D12Resource> wvpResorceModel = CreateBufferResource(device.Get(), sizeof(TransformationMatrix));
-	// DepthStenecilResourceをウィンドウサイズで作成
-	Microsoft::WRL::ComPtr<ID3D12Resource> depthStenecilResourceModel = CreateDepthStenecilTextureResource(device.Get(), WinApp::kClientWidth, WinApp::kClientHeight);
-
-	// データを書き込む
-	TransformationMatrix* wvpDataModel = nullptr;
-	// M書き込むためのアドレスを取得
-	wvpResorceModel->Map(0, nullptr, reinterpret_cast<void**>(&wvpDataModel));
-	// 初期値を設定
-
-	wvpDataModel->world = MakeIdentity4x4(); // 単位行列を設定
-	wvpDataModel->WVP = MakeIdentity4x4();   // 単位行列を設定
-	// WVP用のリソースを作る。Matrix4x4
-	Microsoft::WRL::ComPtr<ID3D12Resource> wvpResorce = CreateBufferResource(device.Get(), sizeof(TransformationMatrix));
+	// フレームごとの定数はアップロード用の大きなページから切り出す(GPUが読んでいる途中のフレームの分は上書きしない)
+	const uint32_t kUploadFrameCount = 2;
+	const size_t kUploadPageSize = 64 * 1024;
+	std::vector<PlacedResource> uploadPageResources;
+	LinearUploadAllocator uploadAllocator(kUploadFrameCount, kUploadPageSize, [&](size_t size) {
+		uploadPageResources.push_back(CreateBufferResource(resourceAllocator, size));
+		UploadPage page{nullptr, uploadPageResources.back()->GetGPUVirtualAddress(), size};
+		uploadPageResources.back()->Map(0, nullptr, &page.cpuAddress);
+		return page;
+	});
+	uint32_t uploadFrameIndex = 0;
+	size_t uploadUsedSize = 0; // 前のフレームで切り出したバイト数(表示用)
+
+	// 物体ごとのWVPとワールド行列はCPU側の1つのブロックに並べ、TransformStorageが変更のあった物体の分だけ書き込む
+	// 定数バッファとして参照するアドレスは256バイト単位なので、物体ごとに256バイトずつ空ける
+	const size_t kTransformStride = (sizeof(TransformationMatrix) + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) / D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT * D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+	TransformStorage transformStorage;
+	const uint32_t sphereTransformIndex = transformStorage.Add({{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}});
+	const uint32_t modelTransformIndex = transformStorage.Add({{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}});
+	std::vector<uint8_t> transformBlock(kTransformStride * transformStorage.GetCount());
+	// 視錐台カリング用の物体ごとのワールド座標の境界球と、見える物体の番号(番号はtransformStorageと同じ)
+	std::vector<Sphere> cullingSpheres(transformStorage.GetCount());
+	std::vector<AABB> cullingAABBs(transformStorage.GetCount());
+	std::vector<uint32_t> visibleIndices(transformStorage.GetCount());
+	size_t visibleCount = 0;
+	// オクルージョンカリング用の深度(画面の1/4の解像度)
+	OcclusionBuffer occlusionBuffer;
+	occlusionBuffer.Initialize(WinApp::kClientWidth / 4, WinApp::kClientHeight / 4);
+
+	// 並べて置くフェンス。見えるものの変換行列を1つのStructuredBufferに詰め、まとめて描く
+	const uint32_t kFenceInstanceCountX = 16;
+	const uint32_t kFenceInstanceCountZ = 16;
+	const float kFenceInstanceSpacing = 3.0f;
+	const uint32_t kFenceMaterialId = 0; // InstanceBatcherに渡すマテリアルの番号(メッシュの番号にはインスタンスごとに選んだLODを渡す)
+	TransformStorage fenceTransformStorage;
+	for (uint32_t z = 0; z < kFenceInstanceCountZ; z++) {
+		for (uint32_t x = 0; x < kFenceInstanceCountX; x++) {
+			fenceTransformStorage.Add({{1.0f, 1.0f, 1.0f}, {0.0f, 0.0f, 0.0f}, {(float(x) - float(kFenceInstanceCountX - 1) * 0.5f) * kFenceInstanceSpacing, 0.0f, 5.0f + float(z) * kFenceInstanceSpacing}});
+		}
+	}
+	std::vector<TransformationMatrix> fenceTransforms(fenceTransformStorage.GetCount()); // インスタンスの番号順の変換行列(CPU側)
+	std::vector<Sphere> fenceCullingSpheres(fenceTransformStorage.GetCount());
+	std::vector<AABB> fenceCullingAABBs(fenceTransformStorage.GetCount());
+	std::vector<uint32_t> fenceVisibleIndices(fenceTransformStorage.GetCount());
+	InstanceBatcher instanceBatcher;
+	bool isFenceInstancingEnabled = true;
 	// DepthStenecilResourceをウィンドウサイズで作成
-	Microsoft::WRL::ComPtr<ID3D12Resource> depthStenecilResource = CreateDepthStenecilTextureResource(device.Get(), WinApp::kClientWidth, WinApp::kClientHeight);
-
-	// データを書き込む
-	TransformationMatrix* wvpData = nullptr;
-	// M書き込むためのアドレスを取得
-	wvpResorce->Map(0, nullptr, reinterpret_cast<void**>(&wvpData));
-	// 初期値を設定
-
-	wvpData->world = MakeIdentity4x4(); // 単位行列を設定
-	wvpData->WVP = MakeIdentity4x4();   // 単位行列を設定
+	PlacedResource depthStenecilResourceModel = CreateDepthStenecilTextureResource(resourceAllocator, WinApp::kClientWidth, WinApp::kClientHeight);
+	PlacedResource depthStenecilResource = CreateDepthStenecilTextureResource(resourceAllocator, WinApp::kClientWidth, WinApp::kClientHeight);
 	// シリアライズしてバイナリにする
 	ID3DBlob* signatureBlob = nullptr;
 	ID3DBlob* errorBlob = nullptr;
@@ -768,6 +692,42 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	hr = device->CreateGraphicsPipelineState(&graphicsPipelineStateDesc, IID_PPV_ARGS(&graphicsPipelineState));
 	assert(SUCCEEDED(hr)); // パイプラインステートの生成が成功したか確認
 
+	// 圧縮した頂点(PackedVertexData)用のPSO。入力レイアウトと頂点シェーダー以外は同じ
+	D3D12_INPUT_ELEMENT_DESC inputElementDescsPacked[3] = {};
+	inputElementDescsPacked[0].SemanticName = "POSITION";
+	inputElementDescsPacked[0].Format = DXGI_FORMAT_R16G16B16A16_UNORM;
+	inputElementDescsPacked[0].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+	inputElementDescsPacked[1].SemanticName = "TEXCOORD";
+	inputElementDescsPacked[1].Format = DXGI_FORMAT_R16G16_FLOAT;
+	inputElementDescsPacked[1].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+	inputElementDescsPacked[2].SemanticName = "NORMAL";
+	inputElementDescsPacked[2].Format = DXGI_FORMAT_R16G16_SNORM;
+	inputElementDescsPacked[2].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+	IDxcBlob* vertexShaderBlobPacked = CompileShader(L"Resources/Shader/Object3dPacked.VS.hlsl", L"vs_6_0", dxcUtils, dxcCompiler, includeHandler);
+	assert(vertexShaderBlobPacked != nullptr);
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineStateDescPacked = graphicsPipelineStateDesc;
+	graphicsPipelineStateDescPacked.InputLayout = {inputElementDescsPacked, _countof(inputElementDescsPacked)};
+	graphicsPipelineStateDescPacked.VS = {vertexShaderBlobPacked->GetBufferPointer(), vertexShaderBlobPacked->GetBufferSize()};
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> graphicsPipelineStatePacked = nullptr;
+	hr = device->CreateGraphicsPipelineState(&graphicsPipelineStateDescPacked, IID_PPV_ARGS(&graphicsPipelineStatePacked));
+	assert(SUCCEEDED(hr));
+
+	// インスタンス描画用のPSO。頂点シェーダーが変換行列をSV_InstanceIDでStructuredBufferから読む
+	IDxcBlob* vertexShaderBlobInstanced = CompileShader(L"Resources/Shader/Object3dInstanced.VS.hlsl", L"vs_6_0", dxcUtils, dxcCompiler, includeHandler);
+	assert(vertexShaderBlobInstanced != nullptr);
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineStateDescInstanced = graphicsPipelineStateDesc;
+	graphicsPipelineStateDescInstanced.VS = {vertexShaderBlobInstanced->GetBufferPointer(), vertexShaderBlobInstanced->GetBufferSize()};
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> graphicsPipelineStateInstanced = nullptr;
+	hr = device->CreateGraphicsPipelineState(&graphicsPipelineStateDescInstanced, IID_PPV_ARGS(&graphicsPipelineStateInstanced));
+	assert(SUCCEEDED(hr));
+	IDxcBlob* vertexShaderBlobPackedInstanced = CompileShader(L"Resources/Shader/Object3dPackedInstanced.VS.hlsl", L"vs_6_0", dxcUtils, dxcCompiler, includeHandler);
+	assert(vertexShaderBlobPackedInstanced != nullptr);
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineStateDescPackedInstanced = graphicsPipelineStateDescPacked;
+	graphicsPipelineStateDescPackedInstanced.VS = {vertexShaderBlobPackedInstanced->GetBufferPointer(), vertexShaderBlobPackedInstanced->GetBufferSize()};
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> graphicsPipelineStatePackedInstanced = nullptr;
+	hr = device->CreateGraphicsPipelineState(&graphicsPipelineStateDescPackedInstanced, IID_PPV_ARGS(&graphicsPipelineStatePackedInstanced));
+	assert(SUCCEEDED(hr));
+
 	// 頂点リソース用のヒープの設定
 	D3D12_HEAP_PROPERTIES uploadHeapProperties{};
 	uploadHeapProperties.Type = D3D12_HEAP_TYPE_UPLOAD; // アップロード用のヒープタイプ
@@ -785,16 +745,13 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// 実際に頂点リソースを生成
 	// 頂点リソースにデータを書き込む
 	// 出力リソース
-	// 平行光のバッファにデータを入れる
-	Microsoft::WRL::ComPtr<ID3D12Resource> lightResource = CreateBufferResource(device.Get(), sizeof(DirectionalLight));
-	assert(SUCCEEDED(hr)); // ライトリソースの生成が成功したか確認
-	DirectionalLight* directionallightData = nullptr;
-	lightResource->Map(0, nullptr, reinterpret_cast<void**>(&directionallightData));
+	// 平行光のデータ(毎フレームuploadAllocatorから切り出した定数バッファに書き込む)
+	DirectionalLight directionallightData{};
 
 	// 値を設定（白くて上から照らす光）
-	directionallightData->color = {1.0f, 1.0f, 1.0f, 1.0f};
-	directionallightData->direction = NormalizeReturnVector(Vector3(0.0f, -1.0f, 0.0f));
-	directionallightData->intensity = 1.0f;
+	directionallightData.color = {1.0f, 1.0f, 1.0f, 1.0f};
+	directionallightData.direction = NormalizeReturnVector(Vector3(0.0f, -1.0f, 0.0f));
+	directionallightData.intensity = 1.0f;
 
 #pragma region マテリアルの描画に必要なデータの作成
 	const float pi = 3.1415f;                         // 円周率
@@ -805,10 +762,10 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	uint32_t lonIndex = 16;
 	uint32_t startIndex = (kSubdivision * kSubdivision) * 6;
 	Vector2 tex{};
-	Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource = CreateBufferResource(device.Get(), sizeof(VertexData) * kSubdivision * kSubdivision * 6);
+	PlacedResource vertexResource = CreateBufferResource(resourceAllocator, sizeof(VertexData) * kSubdivision * kSubdivision * 6);
 	assert(SUCCEEDED(hr)); // 頂点リソースの生成が成功したか確認
 
-	Microsoft::WRL::ComPtr<ID3D12Resource> indexResource = CreateBufferResource(device.Get(), sizeof(uint32_t) * kSubdivision * kSubdivision * 6);
+	PlacedResource indexResource = CreateBufferResource(resourceAllocator, sizeof(uint32_t) * kSubdivision * kSubdivision * 6);
 	D3D12_INDEX_BUFFER_VIEW indexBufferView{};
 	assert(SUCCEEDED(hr)); // インデックスリソースの生成が成功したか確認
 	// リソースの先頭のアドレスから使う
@@ -875,60 +832,35 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			indexData[start + 5] = start + 2; // 三角形2の3頂点目
 		}
 	}
-	// マテリアル用のリソースを作る
-	Microsoft::WRL::ComPtr<ID3D12Resource> materialResource = CreateBufferResource(device.Get(), sizeof(Material));
-	Material* materialData = nullptr;
-	// マテリアルリソースにデータを書き込む
-	materialResource->Map(0, nullptr, reinterpret_cast<void**>(&materialData));
+	// マテリアルのデータ(毎フレームuploadAllocatorから切り出した定数バッファに書き込む)
+	Material materialData{};
 	// マテリアルの色を設定
-	materialData->color = Vector4(1.0f, 1.0f, 1.0f, 1.0f); // 赤色
-	materialData->enableLighting = true;                   // ライティングを有効化
-	materialData->uvTransform = MakeIdentity4x4();
+	materialData.color = Vector4(1.0f, 1.0f, 1.0f, 1.0f); // 赤色
+	materialData.enableLighting = true;                   // ライティングを有効化
+	materialData.uvTransform = MakeIdentity4x4();
 
 #pragma endregion
 
 #pragma region モデルの描画に必要なデータの作成
 
-	// モデルの読み込み
-
-	ModelData modelData = LoadObjFile("Resources", "fence.obj");
-
-	Microsoft::WRL::ComPtr<ID3D12Resource> vertexResourceModel = CreateBufferResource(device.Get(), sizeof(VertexData) * modelData.vertices.size());
-	assert(SUCCEEDED(hr)); // 頂点リソースの生成が成功したか確認
-
-	// 頂点バッファビューの作成
+	// モデルの頂点とインデックスのバッファは、非同期の読み込みが終わったときに作る
+	PlacedResource vertexResourceModel;
+	PlacedResource indexResourceModel;
 	D3D12_VERTEX_BUFFER_VIEW vertexBufferViewModel{};
-	// リソースの先頭のアドレスから使う
-	vertexBufferViewModel.BufferLocation = vertexResourceModel->GetGPUVirtualAddress(); // GPU仮想アドレス
-	// 使用するリソースのサイズは頂点のサイズ * 頂点数
-	vertexBufferViewModel.SizeInBytes = UINT(sizeof(VertexData) * modelData.vertices.size()); // 頂点バッファのサイズ
-	// 1頂点のサイズ
-	vertexBufferViewModel.StrideInBytes = sizeof(VertexData); // 1頂点のサイズ
-
-	VertexData* vertexDataModel = nullptr;
-	// 書き込むためのアドレスを取得
-	vertexResourceModel->Map(0, nullptr, reinterpret_cast<void**>(&vertexDataModel));
-	std::memcpy(vertexDataModel, modelData.vertices.data(), sizeof(VertexData) * modelData.vertices.size());
+	D3D12_INDEX_BUFFER_VIEW indexBufferViewModel{};
 
-	uint32_t* indexDataModel = nullptr;
-	// 書き込むためのアドレスを取得
-	Microsoft::WRL::ComPtr<ID3D12Resource> indexResourceModel = CreateBufferResource(device.Get(), sizeof(uint32_t) * modelData.vertices.size());
-
-	// マテリアル用のリソースを作る
-	Microsoft::WRL::ComPtr<ID3D12Resource> materialResourceModel = CreateBufferResource(device.Get(), sizeof(Material));
-	Material* materialDataModel = nullptr;
-	// マテリアルリソースにデータを書き込む
-	materialResourceModel->Map(0, nullptr, reinterpret_cast<void**>(&materialDataModel));
+	// マテリアルのデータ(毎フレームuploadAllocatorから切り出した定数バッファに書き込む)
+	Material materialDataModel{};
 	// マテリアルの色を設定
-	materialDataModel->color = Vector4(1.0f, 1.0f, 1.0f, 1.0f); // 赤色
-	materialDataModel->enableLighting = true;                   // ライティングを有効化
-	materialDataModel->uvTransform = MakeIdentity4x4();
+	materialDataModel.color = Vector4(1.0f, 1.0f, 1.0f, 1.0f); // 赤色
+	materialDataModel.enableLighting = true;                   // ライティングを有効化
+	materialDataModel.uvTransform = MakeIdentity4x4();
 
 #pragma endregion
 
 #pragma region スプライトの描画に必要なデータの作成
 #pragma region インデックスを使った描画
-	Microsoft::WRL::ComPtr<ID3D12Resource> indexResourceSprite = CreateBufferResource(device.Get(), sizeof(uint32_t) * 6);
+	PlacedResource indexResourceSprite = CreateBufferResource(resourceAllocator, sizeof(uint32_t) * 6);
 	D3D12_INDEX_BUFFER_VIEW indexBufferViewSprite{};
 	assert(SUCCEEDED(hr)); // インデックスリソースの生成が成功したか確認
 	// リソースの先頭のアドレスから使う
@@ -953,7 +885,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	indexDataSprite[4] = 3; // 三角形2枚目の2頂点目
 	indexDataSprite[5] = 2; // 三角形2枚目の3頂点目
 #pragma endregion
-	Microsoft::WRL::ComPtr<ID3D12Resource> vertexResourceSprite = CreateBufferResource(device.Get(), sizeof(VertexData) * 6);
+	PlacedResource vertexResourceSprite = CreateBufferResource(resourceAllocator, sizeof(VertexData) * 6);
 	assert(SUCCEEDED(hr)); // 頂点リソースの生成が成功したか確認
 
 	// 頂点バッファビューを作成する
@@ -981,24 +913,16 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	vertexDataSprite[3].texcoord = {1.0f, 0.0f};
 	vertexDataSprite[3].normal = {0.0f, 0.0f, -1.0f};
 
-	// スプライト用のマテリアルリソースを作成
-	Microsoft::WRL::ComPtr<ID3D12Resource> materialResourceSprite = CreateBufferResource(device.Get(), sizeof(Material) * kSubdivision * kSubdivision * 6);
-	assert(SUCCEEDED(hr)); // マテリアルリソースの生成が成功したか確認
-	Material* materialDataSprite = nullptr;
-	// スプライト用のマテリアルリソースにデータを書き込む
-	materialResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&materialDataSprite));
+	// スプライト用のマテリアルのデータ(毎フレームuploadAllocatorから切り出した定数バッファに書き込む)
+	Material materialDataSprite{};
 	// スプライトの色を設定
-	materialDataSprite->color = Vector4(1.0f, 1.0f, 1.0f, 1.0f); // 白色
-	materialDataSprite->enableLighting = false;                  // ライティングを無効化
-	materialDataSprite->uvTransform = MakeIdentity4x4();
-
-	// Sprite用のTransformationMatrix用リソースを作る
-	Microsoft::WRL::ComPtr<ID3D12Resource> transformationMatrixResourceSprite = CreateBufferResource(device.Get(), sizeof(Matrix4x4));
-	// データを書き込む
-	Matrix4x4* transformationMatrixDataSprite = nullptr;
-	transformationMatrixResourceSprite->Map(0, nullptr, reinterpret_cast<void**>(&transformationMatrixDataSprite));
+	materialDataSprite.color = Vector4(1.0f, 1.0f, 1.0f, 1.0f); // 白色
+	materialDataSprite.enableLighting = false;                  // ライティングを無効化
+	materialDataSprite.uvTransform = MakeIdentity4x4();
+
+	// Sprite用のTransformationMatrixのデータ
 	// 単位行列を入れておく
-	*transformationMatrixDataSprite = MakeIdentity4x4();
+	Matrix4x4 transformationMatrixDataSprite = MakeIdentity4x4();
 
 	Transforms transformSprite{
 	    {1.0f, 1.0f, 1.0f},
@@ -1029,10 +953,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	scissorRect.right = WinApp::kClientWidth;   // シザー矩形の右端
 	scissorRect.bottom = WinApp::kClientHeight; // シザー矩形の下端
 
-	// ディスクリプタヒープの生成
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> rtvDescriptorHeap = CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 2, false);
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> srvDescriptorHeap = CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128, true);
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsvDescriptorHeap = CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1, false);
+	// ディスクリプタヒープの生成(番号は決め打ちせず、DescriptorHeapで確保する)
+	// SRVはシェーダーから見えるヒープ、RTVとDSVはシェーダーから見えないヒープに作る
+	// SRVはまずシェーダーから見えない置き場(srvStagingHeap)に作り、見えるヒープへコピーする
+	DescriptorHeap rtvDescriptorHeap;
+	rtvDescriptorHeap.Initialize(device, CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, 2, false));
+	DescriptorHeap srvDescriptorHeap;
+	srvDescriptorHeap.Initialize(device, CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 128, true));
+	DescriptorHeap srvStagingHeap;
+	srvStagingHeap.Initialize(device, CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 16, false));
+	DescriptorHeap dsvDescriptorHeap;
+	dsvDescriptorHeap.Initialize(device, CreateDescriptorHeap(device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1, false));
 
 	// DSVの設定
 	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc{};
@@ -1043,9 +974,9 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	DirectX::ScratchImage mipImage = LoadTexture("Resources/uvChecker.png");
 	const DirectX::TexMetadata& metaData = mipImage.GetMetadata();
 	// テクスチャリソースの生成
-	Microsoft::WRL::ComPtr<ID3D12Resource> textureResource = CreateTextureResource(device, metaData);
+	PlacedResource textureResource = CreateTextureResource(resourceAllocator, metaData);
 	// テクスチャにデータをアップロード
-	UploadTextureData(textureResource, mipImage);
+	UploadTextureData(textureResource.GetResource(), mipImage);
 
 	// metaDataを基にSRVを生成
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
@@ -1054,64 +985,238 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;                      // テクスチャの次元
 	srvDesc.Texture2D.MipLevels = UINT(metaData.mipLevels);                     // ミップレベルの数
 
-	const uint32_t descroptorSizeSRV = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	const uint32_t descroptorSizeRTV = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-	const uint32_t descroptorSizeDSV = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
-
-	// SRVを生成するためのディスクリプタヒープを取得
-	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU = GetCPUDescriptorHandle(srvDescriptorHeap, descroptorSizeSRV, 1);
-	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU = GetGPUDescriptorHandle(srvDescriptorHeap, descroptorSizeSRV, 1);
-
-	// SRVを生成
-	device->CreateShaderResourceView(textureResource.Get(), &srvDesc, textureSrvHandleCPU); // テクスチャリソースにSRVを設定
-
-#pragma endregion
-
-#pragma region 別の画像の読み込み
-	DirectX::ScratchImage mipImage2 = LoadTexture("Resources/monsterBall.png");
-	const DirectX::TexMetadata& metaData2 = mipImage2.GetMetadata();
-	// テクスチャリソースの生成
-	Microsoft::WRL::ComPtr<ID3D12Resource> textureResource2 = CreateTextureResource(device, metaData2);
-	// テクスチャにデータをアップロード
-	UploadTextureData(textureResource2, mipImage2);
-
-	// metaDataを基にSRVを生成
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc2{};
-	srvDesc2.Format = metaData2.format;                                          // テクスチャのフォーマット
-	srvDesc2.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING; // シェーダーコンポーネントのマッピング
-	srvDesc2.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;                      // テクスチャの次元
-	srvDesc2.Texture2D.MipLevels = UINT(metaData2.mipLevels);                    // ミップレベルの数
-
-	// SRVを生成するためのディスクリプタヒープを取得
-	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU2 = GetCPUDescriptorHandle(srvDescriptorHeap, descroptorSizeSRV, 2);
-	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU2 = GetGPUDescriptorHandle(srvDescriptorHeap, descroptorSizeSRV, 2);
+	// SRVを置き場に作り、シェーダーから見えるヒープで確保した位置へコピーする
+	// (コピーはCPUですぐに終わり、GPUは置き場を読まないので、置き場の番号はすぐに使い直してよい)
+	auto createShaderResourceView = [&](ID3D12Resource* resource, const D3D12_SHADER_RESOURCE_VIEW_DESC& desc) {
+		const DescriptorHandle stagingDescriptor = srvStagingHeap.Allocate();
+		device->CreateShaderResourceView(resource, &desc, srvStagingHeap.GetCPUHandle(stagingDescriptor));
+		const DescriptorHandle descriptor = srvDescriptorHeap.Allocate();
+		srvDescriptorHeap.CopyFrom(descriptor, srvStagingHeap, stagingDescriptor);
+		srvStagingHeap.Free(stagingDescriptor, 0);
+		srvStagingHeap.ReleaseCompleted(0);
+		return descriptor;
+	};
 
 	// SRVを生成
-	device->CreateShaderResourceView(textureResource2.Get(), &srvDesc2, textureSrvHandleCPU2); // テクスチャリソースにSRVを設定
+	const DescriptorHandle textureSrvDescriptor = createShaderResourceView(textureResource.Get(), srvDesc); // テクスチャリソースにSRVを設定
+	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU = srvDescriptorHeap.GetGPUHandle(textureSrvDescriptor);
 
 #pragma endregion
 
-#pragma region 別の画像の読み込み
-	DirectX::ScratchImage mipImage3 = LoadTexture(modelData.material.textureFilePath);
-	const DirectX::TexMetadata& metaData3 = mipImage3.GetMetadata();
-	// テクスチャリソースの生成
-	Microsoft::WRL::ComPtr<ID3D12Resource> textureResource3 = CreateTextureResource(device, metaData3);
-	// テクスチャにデータをアップロード
-	UploadTextureData(textureResource3, mipImage3);
-
-	// metaDataを基にSRVを生成
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc3{};
-	srvDesc3.Format = metaData3.format;                                          // テクスチャのフォーマット
-	srvDesc3.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING; // シェーダーコンポーネントのマッピング
-	srvDesc3.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;                      // テクスチャの次元
-	srvDesc3.Texture2D.MipLevels = UINT(metaData3.mipLevels);                    // ミップレベルの数
+#pragma region 非同期の読み込み
+	// uvChecker以外のテクスチャとモデルはワーカースレッドで読み込み、フレームループの先頭で転送する
+	// 読み込みが終わるまで、テクスチャはuvCheckerで代用し、モデルは描画しない
+	AsyncLoader assetLoader;
+	// テクスチャの読み込み(WICを使うのでワーカースレッドでもCOMを初期化する)
+	auto loadTextureAsync = [](const std::string& filepath) {
+		HRESULT hrCom = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+		DirectX::ScratchImage image = LoadTexture(filepath);
+		if (SUCCEEDED(hrCom)) {
+			CoUninitialize();
+		}
+		return image;
+	};
+	// 読み込んだテクスチャをアップロードしてtextureResourceAsyncに入れ、SRVを作る
+	auto createTexture = [&](const DirectX::ScratchImage& mipImageAsync, PlacedResource& textureResourceAsync) {
+		const DirectX::TexMetadata& metaDataAsync = mipImageAsync.GetMetadata();
+		// テクスチャリソースの生成
+		textureResourceAsync = CreateTextureResource(resourceAllocator, metaDataAsync);
+		// テクスチャにデータをアップロード
+		UploadTextureData(textureResourceAsync.GetResource(), mipImageAsync);
+
+		// metaDataを基にSRVを生成
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDescAsync{};
+		srvDescAsync.Format = metaDataAsync.format;                                      // テクスチャのフォーマット
+		srvDescAsync.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING; // シェーダーコンポーネントのマッピング
+		srvDescAsync.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;                      // テクスチャの次元
+		srvDescAsync.Texture2D.MipLevels = UINT(metaDataAsync.mipLevels);                // ミップレベルの数
+		return createShaderResourceView(textureResourceAsync.Get(), srvDescAsync);
+	};
+	// 最後まで使うテクスチャ
+	std::vector<PlacedResource> textureResourcesAsync;
+	std::vector<DescriptorHandle> textureSrvDescriptorsAsync;
+	auto uploadTexture = [&](const DirectX::ScratchImage& mipImageAsync) {
+		textureResourcesAsync.emplace_back();
+		textureSrvDescriptorsAsync.push_back(createTexture(mipImageAsync, textureResourcesAsync.back()));
+		return srvDescriptorHeap.GetGPUHandle(textureSrvDescriptorsAsync.back());
+	};
 
-	// SRVを生成するためのディスクリプタヒープを取得
-	D3D12_CPU_DESCRIPTOR_HANDLE textureSrvHandleCPU3 = GetCPUDescriptorHandle(srvDescriptorHeap, descroptorSizeSRV, 3);
-	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU3 = GetGPUDescriptorHandle(srvDescriptorHeap, descroptorSizeSRV, 3);
+	// 別の画像(ImGuiから読み込み直せるので、リソースとSRVを自分で持ち、入れ替えるときに前のものを解放する)
+	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandleGPU2 = textureSrvHandleGPU;
+	PlacedResource textureResource2;
+	DescriptorHandle textureSrvDescriptor2;
+	auto requestTexture2 = [&] {
+		assetLoader.Request<DirectX::ScratchImage>([loadTextureAsync] { return loadTextureAsync("Resources/monsterBall.png"); }, [&](AssetHandle, DirectX::ScratchImage& mipImageAsync) {
+			// 前のSRVを最後に使ったのは前のフレームなので、そのフェンスの値で解放する(番号はReleaseCompletedで値を過ぎてから使い直す)
+			// リソースはフレームの終わりでGPUを待っているので、ここで破棄してよい
+			if (!textureSrvDescriptor2.IsNull()) {
+				srvDescriptorHeap.Free(textureSrvDescriptor2, fenceValue);
+			}
+			textureSrvDescriptor2 = createTexture(mipImageAsync, textureResource2);
+			textureSrvHandleGPU2 = srvDescriptorHeap.GetGPUHandle(textureSrvDescriptor2);
+		});
+	};
+	requestTexture2();
+
+	// モデルのマテリアルのテクスチャは、MaterialLibraryのテクスチャ番号ごとに1回だけ読み込み、SRVを作る
+	// (同じテクスチャを使うマテリアルは同じSRVを使う)
+	MaterialLibrary& materialLibrary = GetMaterialLibrary();
+	std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> textureSrvHandlesGPUByTexture; // テクスチャ番号ごと(ptrが0なら読み込み中)
+	std::vector<bool> isTextureRequested;
+	auto requestMaterialTexture = [&](uint32_t textureId) {
+		if (textureId == kNoTexture) {
+			return;
+		}
+		if (textureId >= isTextureRequested.size()) {
+			isTextureRequested.resize(textureId + 1, false);
+			textureSrvHandlesGPUByTexture.resize(textureId + 1, D3D12_GPU_DESCRIPTOR_HANDLE{0});
+		}
+		if (isTextureRequested[textureId]) {
+			return;
+		}
+		isTextureRequested[textureId] = true;
+		std::string texturePath = materialLibrary.GetTexturePath(textureId);
+		assetLoader.Request<DirectX::ScratchImage>([loadTextureAsync, texturePath] { return loadTextureAsync(texturePath); }, [&, textureId](AssetHandle, DirectX::ScratchImage& mipImageAsync) {
+			textureSrvHandlesGPUByTexture[textureId] = uploadTexture(mipImageAsync);
+		});
+	};
+	// テクスチャ番号に対応するSRV(読み込み中やテクスチャがなければuvChecker)
+	auto getMaterialTextureHandle = [&](uint32_t textureId) {
+		if (textureId == kNoTexture || textureId >= textureSrvHandlesGPUByTexture.size() || textureSrvHandlesGPUByTexture[textureId].ptr == 0) {
+			return textureSrvHandleGPU;
+		}
+		return textureSrvHandlesGPUByTexture[textureId];
+	};
 
-	// SRVを生成
-	device->CreateShaderResourceView(textureResource3.Get(), &srvDesc3, textureSrvHandleCPU3); // テクスチャリソースにSRVを設定
+	// サブメッシュはマテリアル順に並んでいるので、同じテクスチャで連続する範囲は1回の描画にまとめる
+	struct ModelDrawBatch {
+		uint32_t indexStart;
+		uint32_t indexCount;
+		uint32_t textureId;
+	};
+	std::vector<std::vector<ModelDrawBatch>> modelDrawBatchesByLod; // LODごとの描画の単位
+	std::vector<LodData> modelLods;
+	uint32_t modelLod = 0; // 今のフレームで描画するLOD
+	Sphere modelSphere{};  // モデル座標の境界球
+	AABB modelAABB{};      // モデル座標のAABB
+	// 遮蔽物としてCPUで描くモデルの位置とLOD0のインデックス
+	std::vector<Vector4> occluderPositions;
+	std::vector<uint32_t> occluderIndices;
+
+	// モデル
+	// クックドメッシュがあれば解析せずに読み込む(warm)、なければobjを解析して書き出す(cold)
+	const bool isWarmLoad = IsCookedMeshUpToDate("Resources", "fence.obj");
+	// クックドメッシュと元のobjの比較はobjを解析し直すので、起動時に--validate-cooked-meshを指定したときだけ行う
+	const bool validateCookedMesh = std::string_view(commandLine).find("--validate-cooked-mesh") != std::string_view::npos;
+	auto loadStart = std::chrono::steady_clock::now();
+	AssetHandle modelHandle = assetLoader.Request<ModelAsset>(
+	    [validateCookedMesh] {
+		    MeshOptimizationReport optimizationReport{};
+		    ModelAsset loadedModel = LoadModelFile("Resources", "fence.obj", 0, &optimizationReport);
+		    if (optimizationReport.before.acmr > 0.0f) {
+			    Log(std::format("OptimizeMesh: fence.obj ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}, {} clusters\n", optimizationReport.before.acmr, optimizationReport.after.acmr, optimizationReport.before.atvr, optimizationReport.after.atvr, optimizationReport.clusterCount));
+		    }
+		    // クックドメッシュが元のobjと一致しているか確認
+		    if (validateCookedMesh) {
+			    std::string cookedMeshReport;
+			    bool isValid = ValidateCookedMesh("Resources", "fence.obj", cookedMeshReport);
+			    Log("ValidateCookedMesh: fence.obj " + std::string(isValid ? "OK\n" : "mismatch\n") + cookedMeshReport);
+		    }
+		    return loadedModel;
+	    },
+	    [&](AssetHandle, ModelAsset& modelAsset) {
+		    // クックドメッシュから読み込んだときは、頂点とインデックスはマップしたファイルから直接アップロードする
+		    std::span<const VertexData> verticesModel = modelAsset.GetVertices();
+		    std::span<const uint32_t> indicesModel = modelAsset.GetIndices();
+		    double loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+		    Log(std::format("LoadModelFile({}): fence.obj {} vertices, {} indices, ready after {:.3f} ms\n", isWarmLoad ? "warm" : "cold", verticesModel.size(), indicesModel.size(), loadMilliseconds));
+		    Log(std::format("Meshlets: fence.obj {} meshlets ({} vertices, {} triangles per meshlet at most)\n", modelAsset.GetMeshlets().size(), kMeshletMaxVertices, kMeshletMaxTriangles));
+		    Log(std::format("Bounds: fence.obj ({:.3f}, {:.3f}, {:.3f}) - ({:.3f}, {:.3f}, {:.3f}), radius {:.3f}\n", modelAsset.GetAABB().minimum.x, modelAsset.GetAABB().minimum.y, modelAsset.GetAABB().minimum.z, modelAsset.GetAABB().maximum.x, modelAsset.GetAABB().maximum.y, modelAsset.GetAABB().maximum.z, modelAsset.GetSphere().radius));
+
+		    // 圧縮する場合は、位置を戻す行列をWVPに含めて描画する
+		    const void* vertexSourceModel = verticesModel.data();
+		    size_t vertexSizeModel = sizeof(VertexData);
+		    std::vector<PackedVertexData> packedVerticesModel;
+		    if (kUsePackedVertexModel) {
+			    QuantizationBounds bounds{};
+			    QuantizationErrorReport quantizationReport = PackVertices(verticesModel, bounds, packedVerticesModel);
+			    // 圧縮した頂点の位置(0～1)をモデル座標に戻す行列
+			    Matrix4x4 dequantizeMatrix = MakeAffineMatrix(bounds.extent, {0.0f, 0.0f, 0.0f}, bounds.minimum);
+			    transformStorage.SetLocalMatrix(modelTransformIndex, dequantizeMatrix);
+			    for (uint32_t i = 0; i < fenceTransformStorage.GetCount(); i++) {
+				    fenceTransformStorage.SetLocalMatrix(i, dequantizeMatrix);
+			    }
+			    vertexSourceModel = packedVerticesModel.data();
+			    vertexSizeModel = sizeof(PackedVertexData);
+			    Log(std::format("PackVertices: fence.obj {} -> {} bytes/vertex, position error {:.6f} (bound {:.6f}), texcoord error {:.6f}, normal error {:.3f} deg\n", sizeof(VertexData), sizeof(PackedVertexData), quantizationReport.maxPositionError, quantizationReport.positionErrorBound, quantizationReport.maxTexcoordError, quantizationReport.maxNormalErrorDegrees));
+		    }
+
+		    vertexResourceModel = CreateBufferResource(resourceAllocator, vertexSizeModel * verticesModel.size());
+		    // リソースの先頭のアドレスから使う
+		    vertexBufferViewModel.BufferLocation = vertexResourceModel->GetGPUVirtualAddress(); // GPU仮想アドレス
+		    // 使用するリソースのサイズは頂点のサイズ * 頂点数
+		    vertexBufferViewModel.SizeInBytes = UINT(vertexSizeModel * verticesModel.size()); // 頂点バッファのサイズ
+		    // 1頂点のサイズ
+		    vertexBufferViewModel.StrideInBytes = UINT(vertexSizeModel); // 1頂点のサイズ
+
+		    void* vertexDataModel = nullptr;
+		    // 書き込むためのアドレスを取得
+		    vertexResourceModel->Map(0, nullptr, &vertexDataModel);
+		    std::memcpy(vertexDataModel, vertexSourceModel, vertexSizeModel * verticesModel.size());
+
+		    // 頂点数が16bitに収まる場合はインデックスも16bitにする
+		    const bool useIndex16Model = verticesModel.size() <= UINT16_MAX;
+		    const size_t indexSizeModel = useIndex16Model ? sizeof(uint16_t) : sizeof(uint32_t);
+		    indexResourceModel = CreateBufferResource(resourceAllocator, indexSizeModel * indicesModel.size());
+		    // リソースの先頭のアドレスから使う
+		    indexBufferViewModel.BufferLocation = indexResourceModel->GetGPUVirtualAddress(); // GPU仮想アドレス
+		    // 使用するリソースのサイズはインデックスのサイズ * インデックス数
+		    indexBufferViewModel.SizeInBytes = UINT(indexSizeModel * indicesModel.size()); // インデックスバッファのサイズ
+		    // インデックスの型
+		    indexBufferViewModel.Format = useIndex16Model ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+		    void* indexDataModel = nullptr;
+		    // 書き込むためのアドレスを取得
+		    indexResourceModel->Map(0, nullptr, &indexDataModel);
+		    if (useIndex16Model) {
+			    uint16_t* indexData16 = static_cast<uint16_t*>(indexDataModel);
+			    for (size_t i = 0; i < indicesModel.size(); i++) {
+				    indexData16[i] = uint16_t(indicesModel[i]);
+			    }
+		    } else {
+			    std::memcpy(indexDataModel, indicesModel.data(), sizeof(uint32_t) * indicesModel.size());
+		    }
+
+		    // マテリアルのテクスチャの読み込みを依頼し、LODごとに描画の単位を作る
+		    modelLods = modelAsset.GetLods();
+		    modelSphere = modelAsset.GetSphere();
+		    modelAABB = modelAsset.GetAABB();
+		    occluderPositions.resize(verticesModel.size());
+		    for (size_t i = 0; i < verticesModel.size(); i++) {
+			    occluderPositions[i] = verticesModel[i].position;
+		    }
+		    const uint32_t occluderIndexCount = modelLods.empty() ? uint32_t(indicesModel.size()) : modelLods[0].indexCount;
+		    occluderIndices.assign(indicesModel.begin(), indicesModel.begin() + occluderIndexCount);
+		    modelDrawBatchesByLod.resize(std::max<size_t>(modelLods.size(), 1));
+		    for (size_t lod = 0; lod < modelDrawBatchesByLod.size(); lod++) {
+			    std::vector<ModelDrawBatch>& modelDrawBatches = modelDrawBatchesByLod[lod];
+			    for (size_t i = 0; i < modelAsset.GetSubMeshes().size(); i++) {
+				    const SubMeshData& subMesh = modelAsset.GetSubMeshes()[i];
+				    LodSubMeshData range = modelLods.empty() ? LodSubMeshData{subMesh.indexStart, subMesh.indexCount} : modelAsset.GetLodSubMeshes()[modelLods[lod].subMeshStart + i];
+				    uint32_t textureId = materialLibrary.GetMaterial(modelAsset.GetMaterials()[subMesh.materialIndex].materialId).diffuseTexture;
+				    requestMaterialTexture(textureId);
+				    if (!modelDrawBatches.empty() && modelDrawBatches.back().textureId == textureId && modelDrawBatches.back().indexStart + modelDrawBatches.back().indexCount == range.indexStart) {
+					    modelDrawBatches.back().indexCount += range.indexCount;
+				    } else {
+					    modelDrawBatches.push_back({range.indexStart, range.indexCount, textureId});
+				    }
+			    }
+		    }
+		    Log(std::format("fence.obj: {} submeshes, {} materials, {} draws\n", modelAsset.GetSubMeshes().size(), modelAsset.GetMaterials().size(), modelDrawBatchesByLod[0].size()));
+		    for (const LodData& lod : modelLods) {
+			    Log(std::format("  LOD: {} triangles, error {:.6f}\n", lod.indexCount / 3, lod.error));
+		    }
+	    });
 
 #pragma endregion
 	// スワップチェーンからリソースをもらう
@@ -1124,17 +1229,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	// DSVHeapの先頭にDSVを作る
 
 	// RTVの設定
-	device->CreateDepthStencilView(depthStenecilResourceModel.Get(), &dsvDesc, dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
+	const DescriptorHandle dsvDescriptor = dsvDescriptorHeap.Allocate();
+	device->CreateDepthStencilView(depthStenecilResourceModel.Get(), &dsvDesc, dsvDescriptorHeap.GetCPUHandle(dsvDescriptor));
 	D3D12_RENDER_TARGET_VIEW_DESC rtvDesc{};
 	rtvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;      // レンダーターゲットビューのフォーマット
 	rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D; // レンダーターゲットビューの次元
-	// ディスクリプタの先頭を取得
-	D3D12_CPU_DESCRIPTOR_HANDLE rtvStartHandle = rtvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
-	// RTVを2つ作るからディスクリプタも2つ
+	// RTVを2つ作るから、連続したディスクリプタを2つ確保する
+	const DescriptorHandle rtvDescriptors = rtvDescriptorHeap.Allocate(2);
 	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles[2];
-	rtvHandles[0] = rtvStartHandle;
+	rtvHandles[0] = rtvDescriptorHeap.GetCPUHandle(rtvDescriptors, 0);
 	device->CreateRenderTargetView(swapChainResources->GetAddressOf()[0], &rtvDesc, rtvHandles[0]);
-	rtvHandles[1] = {rtvStartHandle.ptr + device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV)};
+	rtvHandles[1] = rtvDescriptorHeap.GetCPUHandle(rtvDescriptors, 1);
 	device->CreateRenderTargetView(swapChainResources->GetAddressOf()[1], &rtvDesc, rtvHandles[1]);
 
 	// 指定した色で画面全体をクリアにする
@@ -1161,15 +1266,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 	ImGui::CreateContext();                  // ImGuiのコンテキストを作成
 	ImGui::StyleColorsDark();                // ImGuiのスタイルをダークに設定
 	ImGui_ImplWin32_Init(winApp->GetHwnd()); // ImGuiのWin32バックエンドを初期化
+	// ImGuiのフォントのSRV
+	const DescriptorHandle imguiSrvDescriptor = srvDescriptorHeap.Allocate();
 	ImGui_ImplDX12_Init(
 	    device.Get(),
-	    swapChainDesc.BufferCount,                               // スワップチェーンのバッファ数
-	    rtvDesc.Format,                                          // レンダーターゲットビューのフォーマット
-	    srvDescriptorHeap.Get(),                                 // レンダーターゲットビューのディスクリプタヒープ
-	    srvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), // CPUディスクリプタハンドル
-	    srvDescriptorHeap->GetGPUDescriptorHandleForHeapStart()  // GPUディスクリプタハンドル
+	    swapChainDesc.BufferCount,                          // スワップチェーンのバッファ数
+	    rtvDesc.Format,                                     // レンダーターゲットビューのフォーマット
+	    srvDescriptorHeap.GetHeap(),                        // レンダーターゲットビューのディスクリプタヒープ
+	    srvDescriptorHeap.GetCPUHandle(imguiSrvDescriptor), // CPUディスクリプタハンドル
+	    srvDescriptorHeap.GetGPUHandle(imguiSrvDescriptor)  // GPUディスクリプタハンドル
 	);
-	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = dsvDescriptorHeap->GetCPUDescriptorHandleForHeapStart();
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = dsvDescriptorHeap.GetCPUHandle(dsvDescriptor);
 
 	commandList->OMSetRenderTargets(1, &rtvHandles[0], false, &dsvHandle);
 
@@ -1177,7 +1284,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 
 	MSG msg = {};
 
-	ResourceObject depthStencilResource = CreateDepthStenecilTextureResource(device, WinApp::kClientWidth, WinApp::kClientHeight);
+	PlacedResource depthStencilResource = CreateDepthStenecilTextureResource(resourceAllocator, WinApp::kClientWidth, WinApp::kClientHeight);
 
 	int currentMode = static_cast<int>(blendMode); // 初期値
 
@@ -1192,6 +1299,15 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			// キーボード情報の取得開始
 			input->Update();
 
+			// 読み込みが終わったアセットをGPUに転送する(1フレームで転送する数を抑える)
+			assetLoader.Update(kMaxAssetUploadsPerFrame);
+
+			// このフレームの定数を書き込むページを使い直す(フレームの終わりでGPUを待っているので、前に使ったときの分は読み終わっている)
+			uploadAllocator.BeginFrame(uploadFrameIndex);
+			uploadFrameIndex = (uploadFrameIndex + 1) % kUploadFrameCount;
+			// GPUが使い終わったディスクリプタを使い直せるようにする
+			srvDescriptorHeap.ReleaseCompleted(fence->GetCompletedValue());
+
 			if (input->TriggerKey(DIK_0)) {
 				OutputDebugStringA("Hit 0\n");
 			}
@@ -1201,27 +1317,73 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			ImGui_ImplWin32_NewFrame();
 			ImGui::NewFrame();
 
-			Matrix4x4 worldMatrixModel = MakeAffineMatrix(transformModel.scale, transformModel.rotate, transformModel.translate);
-			Matrix4x4 cameraMatrixModel = MakeAffineMatrix(Vector3{1.0f, 1.0f, 1.0f}, cameraRotate, cameraPosition);
-			Matrix4x4 viewMatrixModel = Inverse(cameraMatrixModel);
-			Matrix4x4 projectionMatrixModel = MakePerspectiveFovMatrix(0.45f, float(WinApp::kClientWidth) / float(WinApp::kClientHeight), 0.1f, 100.0f);
-			Matrix4x4 wvpMatrixModel = Multiply(worldMatrixModel, Multiply(viewMatrixModel, projectionMatrixModel));
-			wvpDataModel->WVP = wvpMatrixModel;
-			wvpDataModel->world = worldMatrixModel;
-
-			Matrix4x4 worldMatrix = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
-			Matrix4x4 cameraMatrix = MakeAffineMatrix(Vector3{1.0f, 1.0f, 1.0f}, cameraRotate, cameraPosition);
-			Matrix4x4 viewMatrix = Inverse(cameraMatrix);
+			// カメラのビュー行列とプロジェクション行列はフレームごとに1度だけ作り、全ての物体で共有する
+			Matrix4x4 viewMatrix = ToMatrix4x4(InverseRigid(MakeAffineTransform(Vector3{1.0f, 1.0f, 1.0f}, cameraRotate, cameraPosition)));
 			Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, float(WinApp::kClientWidth) / float(WinApp::kClientHeight), 0.1f, 100.0f);
-			Matrix4x4 wvpMatrix = Multiply(worldMatrix, Multiply(viewMatrix, projectionMatrix));
-			wvpData->WVP = wvpMatrix;
-			wvpData->world = worldMatrix;
+			Matrix4x4 viewProjectionMatrix = Multiply(viewMatrix, projectionMatrix);
+
+			// カメラからの距離で、誤差が画面上でkLodPixelError以下に収まる一番粗いLODを選ぶ
+			float lodDistance = Length(transformModel.translate - cameraPosition);
+			float lodScale = (std::max)({transformModel.scale.x, transformModel.scale.y, transformModel.scale.z});
+			modelLod = SelectLod(modelLods, GetAllowedLodError(kLodPixelError, lodDistance, lodScale, 0.45f, float(WinApp::kClientHeight)));
+
+			transformStorage.Set(sphereTransformIndex, transform);
+			transformStorage.Set(modelTransformIndex, transformModel);
+			transformStorage.Update(viewProjectionMatrix, transformBlock.data(), kTransformStride);
+
+			// 視錐台の外にある物体は描画しない(スプライトは画面に固定なので対象外)
+			Frustum frustum = MakeFrustum(viewProjectionMatrix);
+			cullingSpheres[sphereTransformIndex] = TransformSphere({{0.0f, 0.0f, 0.0f}, 1.0f}, transformStorage.GetWorldMatrix(sphereTransformIndex));
+			cullingSpheres[modelTransformIndex] = TransformSphere(modelSphere, transformStorage.GetWorldMatrix(modelTransformIndex));
+			visibleCount = CullSpheres(frustum, cullingSpheres.data(), cullingSpheres.size(), visibleIndices.data());
+
+			// 遮蔽物(モデル)の深度を低解像度で描き、その奥に隠れている物体も描画しない
+			cullingAABBs[sphereTransformIndex] = TransformAABB({{-1.0f, -1.0f, -1.0f}, {1.0f, 1.0f, 1.0f}}, transformStorage.GetWorldMatrix(sphereTransformIndex));
+			cullingAABBs[modelTransformIndex] = TransformAABB(modelAABB, transformStorage.GetWorldMatrix(modelTransformIndex));
+			occlusionBuffer.Clear();
+			if (!occluderIndices.empty()) {
+				Matrix4x4 occluderMatrix = Multiply(transformStorage.GetWorldMatrix(modelTransformIndex), viewProjectionMatrix);
+				occlusionBuffer.RenderTriangles(occluderPositions.data(), occluderPositions.size(), sizeof(Vector4), occluderIndices.data(), occluderIndices.size(), occluderMatrix);
+			}
+			occlusionBuffer.BuildHierarchy();
+			visibleCount = occlusionBuffer.FilterVisible(cullingAABBs.data(), viewProjectionMatrix, visibleIndices.data(), visibleCount);
+
+			// 見えるフェンスをメッシュとマテリアルの組ごとにまとめ、変換行列をインスタンスの順に詰める
+			fenceTransformStorage.Update(viewProjectionMatrix, fenceTransforms.data());
+			instanceBatcher.Clear();
+			if (isFenceInstancingEnabled && assetLoader.IsReady(modelHandle)) {
+				for (uint32_t i = 0; i < fenceTransformStorage.GetCount(); i++) {
+					fenceCullingSpheres[i] = TransformSphere(modelSphere, fenceTransformStorage.GetWorldMatrix(i));
+					fenceCullingAABBs[i] = TransformAABB(modelAABB, fenceTransformStorage.GetWorldMatrix(i));
+				}
+				size_t fenceVisibleCount = CullSpheres(frustum, fenceCullingSpheres.data(), fenceCullingSpheres.size(), fenceVisibleIndices.data());
+				fenceVisibleCount = occlusionBuffer.FilterVisible(fenceCullingAABBs.data(), viewProjectionMatrix, fenceVisibleIndices.data(), fenceVisibleCount);
+				// LODはフェンスごとにカメラからの距離で選び、同じLODのフェンスを1つのまとまりにする
+				for (size_t visible = 0; visible < fenceVisibleCount; visible++) {
+					const uint32_t fenceIndex = fenceVisibleIndices[visible];
+					const Transforms fenceTransform = fenceTransformStorage.Get(fenceIndex);
+					const float fenceDistance = Length(fenceTransform.translate - cameraPosition);
+					const float fenceScale = (std::max)({fenceTransform.scale.x, fenceTransform.scale.y, fenceTransform.scale.z});
+					const uint32_t fenceLod = SelectLod(modelLods, GetAllowedLodError(kLodPixelError, fenceDistance, fenceScale, 0.45f, float(WinApp::kClientHeight)));
+					instanceBatcher.Add(fenceLod, kFenceMaterialId, fenceIndex);
+				}
+			}
+			instanceBatcher.Build();
+			UploadAllocation instanceAllocation{};
+			if (instanceBatcher.GetInstanceCount() != 0) {
+				instanceAllocation = uploadAllocator.Allocate(sizeof(TransformationMatrix) * instanceBatcher.GetInstanceCount());
+				instanceBatcher.PackInstances(fenceTransforms.data(), sizeof(TransformationMatrix), static_cast<TransformationMatrix*>(instanceAllocation.cpuAddress));
+			}
+			size_t instancedDrawCount = 0;
+			for (const InstanceBatch& instanceBatch : instanceBatcher.GetBatches()) {
+				instancedDrawCount += modelDrawBatchesByLod[instanceBatch.meshId].size();
+			}
 
 			Matrix4x4 worldMatrixSprite = MakeAffineMatrix(transformSprite.scale, transformSprite.rotate, transformSprite.translate);
 			Matrix4x4 viewMatrixSprite = MakeIdentity4x4();
 			Matrix4x4 projectionMatrixSprite = MakeOrthographicMatrix(0.0f, 0.0f, float(WinApp::kClientWidth), float(WinApp::kClientHeight), 0.0f, 100.0f);
 			Matrix4x4 wvpMatrixSprite = Multiply(worldMatrixSprite, Multiply(viewMatrixSprite, projectionMatrixSprite));
-			*transformationMatrixDataSprite = wvpMatrixSprite;
+			transformationMatrixDataSprite = wvpMatrixSprite;
 			const char* modeNames[] = {"Normal", "Add", "Sub", "Multiply"};
 			// ImGui::Combo("Select Mode", &currentMode, modeNames, 4);
 			//  もしくは
@@ -1237,21 +1399,34 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			ImGui::SliderAngle("model rotate x", &transformModel.rotate.x);
 			ImGui::SliderAngle("model rotate y", &transformModel.rotate.y);
 			ImGui::SliderAngle("model rotate z", &transformModel.rotate.z);
+			ImGui::Text("model LOD %u", modelLod);
+			ImGui::Checkbox("fence instancing", &isFenceInstancingEnabled);
+			ImGui::Text("fences %zu/%zu visible, %zu instanced draws", instanceBatcher.GetInstanceCount(), fenceTransformStorage.GetCount(), instancedDrawCount);
+			for (const InstanceBatch& instanceBatch : instanceBatcher.GetBatches()) {
+				ImGui::Text("  fence LOD %u: %u instances", instanceBatch.meshId, instanceBatch.instanceCount);
+			}
+			ImGui::Text("upload %zu bytes/frame, %zu pages", uploadUsedSize, uploadAllocator.GetPageCount());
+			ImGui::Text("SRV descriptors %u/%u, %u waiting for the GPU", srvDescriptorHeap.GetAllocator().GetUsedCount(), srvDescriptorHeap.GetAllocator().GetCapacity(), srvDescriptorHeap.GetAllocator().GetPendingCount());
+			const HeapStatistics heapStatistics = resourceAllocator.GetStatistics();
+			ImGui::Text("heaps %u, %.1f/%.1f MB used, %.1f KB wasted, fragmentation %.1f%%", heapStatistics.heapCount, double(heapStatistics.usedSize) / (1024.0 * 1024.0), double(heapStatistics.heapSize) / (1024.0 * 1024.0), double(heapStatistics.wastedSize) / 1024.0, heapStatistics.fragmentation);
 			ImGui::Checkbox("useTexture", &useTexture);
+			if (ImGui::Button("reload monsterBall.png")) {
+				requestTexture2();
+			}
 			ImGui::DragFloat3("sphere pos", &transform.translate.x, 0.3f);
 			ImGui::SliderAngle("sphere rotate x", &transform.rotate.x);
 			ImGui::SliderAngle("sphere rotate y", &transform.rotate.y);
 			ImGui::SliderAngle("sphere rotate z", &transform.rotate.z);
-			ImGui::ColorEdit4("sphere color", &materialData->color.x, 1.0f); // クリアカラーの編集
+			ImGui::ColorEdit4("sphere color", &materialData.color.x, 1.0f); // クリアカラーの編集
 			ImGui::DragFloat3("sprite pos", &transformSprite.translate.x, 0.3f);
-			ImGui::ColorEdit4("sprite color", &materialDataSprite->color.x, 1.0f); // クリアカラーの編集
+			ImGui::ColorEdit4("sprite color", &materialDataSprite.color.x, 1.0f); // クリアカラーの編集
 			ImGui::DragFloat2("UV translate", &uvTransformSprite.translate.x, 0.01f, -10.0f, 10.0f);
 			ImGui::DragFloat2("UV scale", &uvTransformSprite.scale.x, 0.01f, 0.0f, 10.0f);
 			ImGui::SliderAngle("UV rotate", &uvTransformSprite.rotate.z);
-			ImGui::ColorEdit4("lighr color", &directionallightData->color.x, 1.0f); // クリアカラーの編
-			ImGui::DragFloat3("light direction", &directionallightData->direction.x, 0.1f);
-			directionallightData->direction = NormalizeReturnVector(directionallightData->direction); // 正規化
-			ImGui::SliderFloat("intensity", &directionallightData->intensity, 0.0f, 1.0f);
+			ImGui::ColorEdit4("lighr color", &directionallightData.color.x, 1.0f); // クリアカラーの編
+			ImGui::DragFloat3("light direction", &directionallightData.direction.x, 0.1f);
+			directionallightData.direction = NormalizeReturnVector(directionallightData.direction); // 正規化
+			ImGui::SliderFloat("intensity", &directionallightData.intensity, 0.0f, 1.0f);
 			// ImGuiのウィンドウを作成
 			ImGui::ShowDemoWindow(); // デモウィンドウを表示
 			ImGui::Render();         // ImGuiの描画を実行
@@ -1260,7 +1435,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			uvTransformSpriteMatrix = Multiply(uvTransformSpriteMatrix, MakeRotateZMatrix(uvTransformSprite.rotate.z));
 			uvTransformSpriteMatrix = Multiply(uvTransformSpriteMatrix, MakeTranslateMatrix(uvTransformSprite.translate));
 			// UV変換行列をマテリアルに設定
-			materialDataSprite->uvTransform = uvTransformSpriteMatrix;
+			materialDataSprite.uvTransform = uvTransformSpriteMatrix;
+
+			// 物体ごとの定数をこのフレームのページに書き込む(変換行列は変更のあった物体の分だけ更新したブロックをまとめて写す)
+			const UploadAllocation transformAllocation = uploadAllocator.Allocate(transformBlock.size());
+			std::memcpy(transformAllocation.cpuAddress, transformBlock.data(), transformBlock.size());
+			const UploadAllocation lightAllocation = uploadAllocator.AllocateConstant(directionallightData);
+			const UploadAllocation materialAllocation = uploadAllocator.AllocateConstant(materialData);
+			const UploadAllocation materialAllocationModel = uploadAllocator.AllocateConstant(materialDataModel);
+			const UploadAllocation materialAllocationSprite = uploadAllocator.AllocateConstant(materialDataSprite);
+			const UploadAllocation transformationMatrixAllocationSprite = uploadAllocator.AllocateConstant(transformationMatrixDataSprite);
+			uploadUsedSize = uploadAllocator.GetUsedSize();
 
 #pragma region コマンドリストのリセット
 
@@ -1284,37 +1469,59 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int) {
 			commandList->ClearRenderTargetView(rtvHandles[backBufferIndex], clearColor, 0, nullptr);
 			commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
 			// 描画用のDescriptorHeapを設定
-			Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeaps[] = {srvDescriptorHeap};
-			commandList->SetDescriptorHeaps(1, descriptorHeaps->GetAddressOf()); // ディスクリプタヒープの設定
+			ID3D12DescriptorHeap* descriptorHeaps[] = {srvDescriptorHeap.GetHeap()};
+			commandList->SetDescriptorHeaps(1, descriptorHeaps); // ディスクリプタヒープの設定
 			commandList->RSSetViewports(1, &viewport);
 			commandList->RSSetScissorRects(1, &scissorRect);
 			commandList->SetGraphicsRootSignature(rootSignature.Get());
-			// インデックスを使った描画
-			commandList->SetGraphicsRootConstantBufferView(0, materialResource->GetGPUVirtualAddress());
-			commandList->SetGraphicsRootConstantBufferView(1, wvpResorce->GetGPUVirtualAddress());
-			commandList->SetGraphicsRootConstantBufferView(2, lightResource->GetGPUVirtualAddress());
-			commandList->SetGraphicsRootDescriptorTable(3, useTexture ? textureSrvHandleGPU2 : textureSrvHandleGPU);
-			commandList->SetPipelineState(graphicsPipelineState.Get());
-			commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
-			commandList->IASetIndexBuffer(&indexBufferView);
+			// 視錐台に掛かっている物体だけを描画する
+			commandList->SetGraphicsRootConstantBufferView(2, lightAllocation.gpuAddress);
 			commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			commandList->DrawIndexedInstanced(startIndex, 1, 0, 0, 0);
+			for (size_t visible = 0; visible < visibleCount; visible++) {
+				const uint32_t index = visibleIndices[visible];
+				commandList->SetGraphicsRootConstantBufferView(1, transformAllocation.gpuAddress + kTransformStride * index);
+				if (index == sphereTransformIndex) {
+					// インデックスを使った描画
+					commandList->SetGraphicsRootConstantBufferView(0, materialAllocation.gpuAddress);
+					commandList->SetGraphicsRootDescriptorTable(3, useTexture ? textureSrvHandleGPU2 : textureSrvHandleGPU);
+					commandList->SetPipelineState(graphicsPipelineState.Get());
+					commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
+					commandList->IASetIndexBuffer(&indexBufferView);
+					commandList->DrawIndexedInstanced(startIndex, 1, 0, 0, 0);
+				} else if (index == modelTransformIndex && assetLoader.IsReady(modelHandle)) {
+					// モデルの描画
+					commandList->SetGraphicsRootConstantBufferView(0, materialAllocationModel.gpuAddress);
+					commandList->SetPipelineState(kUsePackedVertexModel ? graphicsPipelineStatePacked.Get() : graphicsPipelineState.Get());
+					commandList->IASetVertexBuffers(0, 1, &vertexBufferViewModel);
+					commandList->IASetIndexBuffer(&indexBufferViewModel);
+					for (const ModelDrawBatch& batch : modelDrawBatchesByLod[modelLod]) {
+						commandList->SetGraphicsRootDescriptorTable(3, getMaterialTextureHandle(batch.textureId));
+						commandList->DrawIndexedInstanced(batch.indexCount, 1, batch.indexStart, 0, 0);
+					}
+				}
+			}
 
-			// モデルの描画
+			// 並べたフェンスは、LODとマテリアルの組ごとにインスタンス数を指定して1回で描く
+			if (!instanceBatcher.GetBatches().empty()) {
+				commandList->SetGraphicsRootConstantBufferView(0, materialAllocationModel.gpuAddress);
+				commandList->SetPipelineState(kUsePackedVertexModel ? graphicsPipelineStatePackedInstanced.Get() : graphicsPipelineStateInstanced.Get());
+				commandList->IASetVertexBuffers(0, 1, &vertexBufferViewModel);
+				commandList->IASetIndexBuffer(&indexBufferViewModel);
+				for (const InstanceBatch& instanceBatch : instanceBatcher.GetBatches()) {
+					// SV_InstanceIDは0から数えるので、まとまりの先頭のインスタンスをSRVのアドレスで指す
+					commandList->SetGraphicsRootShaderResourceView(4, instanceAllocation.gpuAddress + sizeof(TransformationMatrix) * instanceBatch.firstInstance);
+					for (const ModelDrawBatch& batch : modelDrawBatchesByLod[instanceBatch.meshId]) {
+						commandList->SetGraphicsRootDescriptorTable(3, getMaterialTextureHandle(batch.textureId));
+						commandList->DrawIndexedInstanced(batch.indexCount, instanceBatch.instanceCount, batch.indexStart, 0, 0);
+					}
+				}
+			}
 
-			commandList->SetGraphicsRootConstantBufferView(0, materialResourceModel->GetGPUVirtualAddress());
-			commandList->SetGraphicsRootConstantBufferView(1, wvpResorceModel->GetGPUVirtualAddress());
-			commandList->SetGraphicsRootConstantBufferView(2, lightResource->GetGPUVirtualAddress());
-			commandList->SetGraphicsRootDescriptorTable(3, textureSrvHandleGPU3);
 			commandList->SetPipelineState(graphicsPipelineState.Get());
-			commandList->IASetVertexBuffers(0, 1, &vertexBufferViewModel);
-			commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			commandList->DrawInstanced(UINT(modelData.vertices.size()), 1, 0, 0);
-
 			commandList->IASetVertexBuffers(0, 1, &vertexBufferBiewSprite);
 			commandList->IASetIndexBuffer(&indexBufferViewSprite);
-			commandList->SetGraphicsRootConstantBufferView(0, materialResourceSprite->GetGPUVirtualAddress());
-			commandList->SetGraphicsRootConstantBufferView(1, transformationMatrixResourceSprite->GetGPUVirtualAddress());
+			commandList->SetGraphicsRootConstantBufferView(0, materialAllocationSprite.gpuAddress);
+			commandList->SetGraphicsRootConstantBufferView(1, transformationMatrixAllocationSprite.gpuAddress);
 			commandList->SetGraphicsRootDescriptorTable(3, textureSrvHandleGPU);
 			commandList->DrawIndexedInstanced(6, 1, 0, 0, 0);
 